@@ -0,0 +1,101 @@
+// Compares getting a module's AST by lexing and parsing it against loading
+// it from a cached snapshot (map + validate, then materialize).
+//
+//   bench_ast_snapshot [file.bz] [-lines <n>] [-reps <n>]
+
+#include <ether/module/module.hpp>
+#include <ether/module/module_cache.hpp>
+#include <ether/nodes/node_snapshot.hpp>
+#include <ether/support/hash.hpp>
+
+#include "synthetic.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+namespace fs = std::filesystem;
+
+int main(int argc, char** argv) {
+  std::string file;
+  size_t lines = 50000;
+  int reps = 10;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "-lines" && i + 1 < argc) {
+      lines = std::strtoul(argv[++i], nullptr, 10);
+    } else if (arg == "-reps" && i + 1 < argc) {
+      reps = std::max(1, std::atoi(argv[++i]));
+    } else {
+      file = arg;
+    }
+  }
+
+  std::string source;
+  if (file.empty()) {
+    file = "synthetic.bz";
+    source = synthetic_module(lines);
+  } else {
+    std::ifstream in(file, std::ios::binary);
+    if (!in) {
+      std::fprintf(stderr, "bench_ast_snapshot: could not read `%s`\n", file.c_str());
+      return 1;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    source = buffer.str();
+  }
+
+  auto cache_dir = fs::temp_directory_path() / "ether_bench_ast_snapshot";
+  ModuleCache cache(cache_dir);
+  uint64_t source_hash = hash_bytes(source);
+
+  Module reference(file, source);
+  reference.generate_ast();
+  if (!cache.store_ast("bench", source_hash, reference.get_root())) {
+    std::fprintf(stderr, "bench_ast_snapshot: could not write to `%s`\n", cache_dir.string().c_str());
+    return 1;
+  }
+
+  double parse_ms = time_ms(reps, [&] {
+    Module mod(file, source);
+    mod.generate_ast();
+  });
+
+  double load_ms = time_ms(reps, [&] {
+    cache.load_ast("bench", source_hash);
+  });
+
+  auto snapshot = cache.load_ast("bench", source_hash);
+  if (!snapshot) {
+    std::fprintf(stderr, "bench_ast_snapshot: snapshot did not load back\n");
+    return 1;
+  }
+  double materialize_ms = time_ms(reps, [&] {
+    Module mod(file, source);
+    mod.set_ast(snapshot->view.materialize());
+  });
+
+  size_t lines_in = std::ranges::count(source, '\n');
+  std::printf("%s: %zu lines, %zu bytes\n", file.c_str(), lines_in, source.size());
+  std::printf(
+    "snapshot: %zu bytes, %zu nodes, %zu tokens\n",
+    static_cast<size_t>(fs::file_size(cache.ast_file_for("bench"))),
+    snapshot->view.nodes().size(),
+    snapshot->view.tokens().size()
+  );
+  std::printf("  lex + parse (generate_ast)     %9.3f ms\n", parse_ms);
+  std::printf("  snapshot map + validate        %9.3f ms\n", load_ms);
+  std::printf("  snapshot materialize           %9.3f ms\n", materialize_ms);
+  std::printf("  snapshot total                 %9.3f ms  (%.1fx)\n",
+              load_ms + materialize_ms, parse_ms / (load_ms + materialize_ms));
+
+  std::error_code ec;
+  fs::remove_all(cache_dir, ec);
+  return 0;
+}
@@ -0,0 +1,83 @@
+// Times DiagnosticEngine::print_all over many diagnostics spread across a
+// large module, plain and colored, writing into memory and to /dev/null,
+// against the JSON Lines emitter over the same diagnostics.
+//
+//   bench_diagnostic_render [-diagnostics <n>] [-lines <n>]
+
+#include <ether/diagnostics/diagnostic_eng.hpp>
+#include <ether/diagnostics/diagnostic_stream.hpp>
+
+#include "synthetic.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+// Column 3 of lines spread over the module.
+void fill(DiagnosticEngine& eng, size_t count, const std::vector<size_t>& line_starts) {
+  size_t lines = line_starts.size();
+  for (size_t i = 0; i < count; ++i) {
+    Diagnostic d;
+    d.level = i % 3 == 0 ? DiagnosticLevel::Fail : DiagnosticLevel::Warn;
+    d.phase = i % 2 == 0 ? DiagnosticPhase::Resolver : DiagnosticPhase::Parser;
+    d.range = SourceRange::at(line_starts[(i * 7919) % lines] + 2, 1 + i % 4);
+    d.message = "Unresolved symbol `" + synthetic_name(i) + "`";
+    if (i % 10 == 0) {
+      eng.report(std::move(d), { DiagnosticNote{ SourceRange::at(0, 1), "declared here" } });
+    } else {
+      eng.report(std::move(d));
+    }
+  }
+}
+}
+
+int main(int argc, char** argv) {
+  size_t count = 100000, lines = 50000;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "-diagnostics" && i + 1 < argc) count = std::strtoul(argv[++i], nullptr, 10);
+    if (arg == "-lines" && i + 1 < argc) lines = std::strtoul(argv[++i], nullptr, 10);
+  }
+
+  auto source = synthetic_module(lines);
+  std::vector<size_t> line_starts{ 0 };
+  for (size_t at = 0; at + 1 < source.size(); ++at) {
+    if (source[at] == '\n') line_starts.push_back(at + 1);
+  }
+  size_t source_lines = line_starts.size();
+
+  DiagnosticEngine eng;
+  eng.set_source("synthetic.bz", source);
+  fill(eng, count, line_starts);
+
+  size_t bytes = 0;
+  double memory_ms = time_ms(5, [&] {
+    std::ostringstream out;
+    eng.print_all(out);
+    bytes = out.str().size();
+  });
+
+  double color_ms = time_ms(5, [&] {
+    std::ostringstream out;
+    eng.print_all(out, ColorMode::Always);
+  });
+
+  std::ofstream null("/dev/null");
+  double null_ms = time_ms(5, [&] { eng.print_all(null, ColorMode::Always); });
+
+  double jsonl_ms = time_ms(5, [&] {
+    std::ostringstream out;
+    DiagnosticStream(DiagnosticFormat::JsonLines, out).write(eng);
+  });
+
+  std::printf("%zu diagnostics over %zu lines, %.1f MB of text\n", count, source_lines, bytes / 1e6);
+  std::printf("  print_all to memory     %8.1f ms\n", memory_ms);
+  std::printf("  ... with color          %8.1f ms\n", color_ms);
+  std::printf("  ... to /dev/null        %8.1f ms\n", null_ms);
+  std::printf("  jsonl to memory         %8.1f ms\n", jsonl_ms);
+}
@@ -0,0 +1,102 @@
+// Times Module::apply_edit against a full check(): types an expression into
+// a function body halfway down the module one keystroke at a time, deletes it
+// again, then renames that function, which changes a declaration and makes
+// the whole module resolve again. Body keystrokes that keep the function's
+// signature infer only that function's types again. Last, cancels full checks part way
+// through with a deadline and reports how long they ran past it, which is
+// mostly freeing the partial tree and symbols.
+//
+//   bench_module_edit [-lines <n>]
+
+#include <ether/module/module.hpp>
+
+#include "synthetic.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+struct Timings {
+  std::vector<double> ms;
+  // The most top-level declarations one edit inferred again.
+  size_t inferred = 0;
+
+  void add(double took) { this->ms.push_back(took); }
+  double mean() const {
+    double sum = 0;
+    for (double t : this->ms) sum += t;
+    return this->ms.empty() ? 0 : sum / this->ms.size();
+  }
+  double max() const { return this->ms.empty() ? 0 : *std::ranges::max_element(this->ms); }
+};
+
+void timed_edit(Timings& into, Module& mod, TextEdit edit) {
+  auto start = std::chrono::steady_clock::now();
+  auto stats = mod.apply_edit(edit);
+  std::chrono::duration<double, std::milli> took = std::chrono::steady_clock::now() - start;
+  into.add(took.count());
+  into.inferred = std::max(into.inferred, stats.declarations_inferred);
+}
+}
+
+int main(int argc, char** argv) {
+  size_t lines = 50000;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "-lines" && i + 1 < argc) lines = std::strtoul(argv[++i], nullptr, 10);
+  }
+
+  auto source = synthetic_module(lines);
+  double check_ms = time_ms(3, [&] {
+    Module mod("synthetic.bz", source);
+    mod.check();
+  });
+
+  Module mod("synthetic.bz", source);
+  mod.check();
+
+  const std::string body_anchor = "  let x = a * 2";
+  size_t at = source.find(body_anchor, source.size() / 2) + body_anchor.size();
+  const std::string typed = " + b * limit";
+
+  Timings typing;
+  for (size_t i = 0; i < typed.size(); ++i) {
+    timed_edit(typing, mod, TextEdit{ .offset = at + i, .length = 0, .text = typed.substr(i, 1) });
+  }
+  for (size_t i = typed.size(); i > 0; --i) {
+    timed_edit(typing, mod, TextEdit{ .offset = at + i - 1, .length = 1, .text = "" });
+  }
+
+  size_t name_at = source.rfind("func f", at) + 6;
+  Timings rename;
+  timed_edit(rename, mod, TextEdit{ .offset = name_at, .length = 0, .text = "z" });
+  timed_edit(rename, mod, TextEdit{ .offset = name_at, .length = 1, .text = "" });
+
+  // Deadlines spread over the lex, parse and resolve stages.
+  Timings overrun;
+  for (int k = 1; k < 10; ++k) {
+    Module cancelled("synthetic.bz", source);
+    auto deadline = std::chrono::steady_clock::now()
+                  + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                      std::chrono::duration<double, std::milli>(check_ms * k / 10));
+    bool finished = cancelled.check(nullptr, CancellationToken().with_deadline(deadline));
+    std::chrono::duration<double, std::milli> late = std::chrono::steady_clock::now() - deadline;
+    if (!finished) overrun.add(late.count());
+  }
+
+  std::printf("synthetic.bz: %zu lines, %zu bytes\n", static_cast<size_t>(std::ranges::count(source, '\n')), source.size());
+  std::printf("  full check                     %9.3f ms\n", check_ms);
+  std::printf("  keystroke in a body (mean)     %9.3f ms  over %zu edits\n", typing.mean(), typing.ms.size());
+  std::printf("  keystroke in a body (max)      %9.3f ms\n", typing.max());
+  std::printf("  declarations inferred (max)    %9zu     per body keystroke\n", typing.inferred);
+  std::printf("  keystroke in a name (mean)     %9.3f ms\n", rename.mean());
+  std::printf("  cancelled check, past deadline %9.3f ms  mean, %.3f ms max over %zu\n",
+              overrun.mean(), overrun.max(), overrun.ms.size());
+  std::printf("  unchanged after the round trip %9s\n", mod.get_source() == source ? "yes" : "NO");
+  return 0;
+}
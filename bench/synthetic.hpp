@@ -0,0 +1,70 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <string>
+
+// Shared by the benchmarks: a generated module and a best-of-n timer.
+
+inline std::string synthetic_name(size_t n) {
+  std::string s;
+  do {
+    s.push_back(static_cast<char>('a' + n % 26));
+    n /= 26;
+  } while (n);
+  return s;
+}
+
+// About `lines` lines of functions touching every node kind.
+inline std::string synthetic_module(size_t lines) {
+  std::string src = "const limit: Int = 10\n\n";
+  for (size_t i = 0; i * 10 < lines; ++i) {
+    auto name = synthetic_name(i);
+    src += "func f" + name + "(a: Int, b) :> Int\n"
+           "  let x = a * 2 + -b\n"
+           "  let y = { x }\n"
+           "  g(x, y) |=> g(y, x)\n"
+           "  case x > limit:\n"
+           "    True :> x\n"
+           "    False :> y\n"
+           "  end\n"
+           "end\n\n";
+  }
+  return src;
+}
+
+// `functions` functions that type-check cleanly, each calling the one
+// `chains` before it and a generic helper, so every body constrains its
+// parameters through a call. The call graph is `chains` independent chains.
+inline std::string synthetic_program(size_t functions, size_t chains = 1) {
+  std::string src = "func id(x)\n  x\nend\n\n";
+  for (size_t i = 0; i < functions; ++i) {
+    // `f_` keeps names such as "unc" clear of the keywords.
+    auto name = "f_" + synthetic_name(i);
+    if (i < chains) {
+      src += "func " + name + "(a, b)\n  a + b\nend\n\n";
+      continue;
+    }
+    src += "func " + name + "(a, b)\n"
+           "  let x = f_" + synthetic_name(i - chains) + "(a, b) * 2\n"
+           "  let y = id(b) |=> id()\n"
+           "  let z = { x - -y }\n"
+           "  z > a == a < 3\n"
+           "  id(z)\n"
+           "end\n\n";
+  }
+  return src;
+}
+
+// Best of `reps` runs, in milliseconds.
+inline double time_ms(int reps, const std::function<void()>& fn) {
+  double best = 1e300;
+  for (int i = 0; i < reps; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    std::chrono::duration<double, std::milli> took = std::chrono::steady_clock::now() - start;
+    best = std::min(best, took.count());
+  }
+  return best;
+}
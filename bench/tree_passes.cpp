@@ -0,0 +1,83 @@
+// Times k lightweight tree passes run one walk each against the same passes
+// fused into a single walk (run_tree_passes), for k = 1, 2, 4, 8.
+//
+//   bench_tree_passes [-lines <n>] [-reps <n>]
+
+#include <ether/module/module.hpp>
+#include <ether/nodes/tree_pass.hpp>
+
+#include "synthetic.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+// Three kinds of cheap pass, the sort a lint or statistics pass would be.
+class CountCalls final : public TreePass {
+public:
+  size_t calls = 0;
+  std::string_view name() const override { return "calls"; }
+  void enter(NDCallExpr&) override { this->calls++; }
+};
+
+class MaxDepth final : public TreePass {
+public:
+  size_t depth = 0, deepest = 0;
+  std::string_view name() const override { return "depth"; }
+  void enter(Node&) override { this->deepest = std::max(this->deepest, ++this->depth); }
+  void exit(Node&) override { this->depth--; }
+};
+
+class IdentifierBytes final : public TreePass {
+public:
+  size_t bytes = 0;
+  std::string_view name() const override { return "ids"; }
+  void enter(NDIdentifier& n) override { this->bytes += n.identifier.token_value.size(); }
+};
+
+std::vector<std::unique_ptr<TreePass>> make_passes(size_t k) {
+  std::vector<std::unique_ptr<TreePass>> out;
+  for (size_t i = 0; i < k; ++i) {
+    switch (i % 3) {
+      case 0: out.push_back(std::make_unique<CountCalls>()); break;
+      case 1: out.push_back(std::make_unique<MaxDepth>()); break;
+      default: out.push_back(std::make_unique<IdentifierBytes>()); break;
+    }
+  }
+  return out;
+}
+}
+
+int main(int argc, char** argv) {
+  size_t lines = 50000;
+  int reps = 10;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "-lines" && i + 1 < argc) lines = std::strtoul(argv[++i], nullptr, 10);
+    if (arg == "-reps" && i + 1 < argc) reps = std::atoi(argv[++i]);
+  }
+
+  Module mod("synthetic.bz", synthetic_module(lines));
+  mod.generate_ast();
+  auto& root = mod.get_root();
+
+  std::printf("synthetic.bz: %zu lines, %zu top-level items\n", lines, root.children.size());
+  std::printf("  passes   one walk each      fused   speedup\n");
+  for (size_t k : { 1, 2, 4, 8 }) {
+    auto owned = make_passes(k);
+    std::vector<TreePass*> passes;
+    for (auto& p : owned) passes.push_back(p.get());
+
+    double separate = time_ms(reps, [&] {
+      for (auto* p : passes) run_tree_passes(root, { p });
+    });
+    double fused = time_ms(reps, [&] { run_tree_passes(root, passes); });
+    std::printf("  %6zu %12.3f ms %8.3f ms %8.2fx\n", k, separate, fused, separate / fused);
+  }
+  return 0;
+}
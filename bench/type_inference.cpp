@@ -0,0 +1,63 @@
+// Times type inference alone over generated modules of growing size, to
+// show it stays close to linear in the number of functions; then over one
+// module of independent call chains with more and more threads, to show
+// how checking components concurrently scales.
+//
+//   bench_type_inference [-reps <n>] [-chains <n>]
+
+#include <ether/ast/symbol_resolver/symbol_resolver.hpp>
+#include <ether/ast/type_check/type_check.hpp>
+#include <ether/module/module.hpp>
+
+#include "synthetic.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+
+int main(int argc, char** argv) {
+  int reps = 5;
+  size_t chains = 64;
+  for (int i = 1; i < argc; ++i) {
+    std::string_view arg = argv[i];
+    if (arg == "-reps" && i + 1 < argc) reps = std::atoi(argv[++i]);
+    if (arg == "-chains" && i + 1 < argc) chains = std::strtoull(argv[++i], nullptr, 10);
+  }
+
+  std::printf("  functions   infer (ms)   per function (us)   errors\n");
+  for (size_t functions : { 1000, 2000, 4000, 8000, 16000 }) {
+    Module mod("synthetic.bz", synthetic_program(functions));
+    mod.generate_ast();
+    SymbolResolver resolver(mod.get_symbol_storage(), mod.get_diag_engine());
+    mod.attach_visitor(resolver);
+    mod.apply_visitors();
+
+    DiagnosticEngine diags;
+    double took = time_ms(reps, [&] {
+      TypeChecker checker(diags);
+      checker.check_module(mod.get_root());
+    });
+    std::printf("  %9zu %12.3f %19.3f %8zu\n", functions, took, took * 1000 / functions, diags.all().size());
+  }
+
+  constexpr size_t functions = 16000;
+  Module mod("synthetic.bz", synthetic_program(functions, chains));
+  mod.generate_ast();
+  SymbolResolver resolver(mod.get_symbol_storage(), mod.get_diag_engine());
+  mod.attach_visitor(resolver);
+  mod.apply_visitors();
+
+  std::printf("\n  %zu functions in %zu chains\n", functions, chains);
+  std::printf("  jobs   infer (ms)   speedup   errors\n");
+  double serial = 0;
+  for (size_t jobs : { 1, 2, 4, 8 }) {
+    DiagnosticEngine diags;
+    double took = time_ms(reps, [&] {
+      TypeChecker checker(diags, jobs);
+      checker.check_module(mod.get_root());
+    });
+    if (jobs == 1) serial = took;
+    std::printf("  %4zu %12.3f %8.2fx %8zu\n", jobs, took, serial / took, diags.all().size());
+  }
+  return 0;
+}
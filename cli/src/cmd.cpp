@@ -5,12 +5,37 @@
 #include "commands/create/create.hpp"
 #include "commands/help/help.hpp"
 #include "commands/init/init.hpp"
+#include "commands/lsp/lsp.hpp"
 #include "commands/run/run.hpp"
 
+#include <ether/support/parallel.hpp>
+
+#include <charconv>
 #include <stdexcept>
 #include <string>
 #include <string_view>
 
+namespace {
+// `0` means "one per hardware thread".
+size_t ParseJobs(std::string_view tok) {
+  size_t jobs = 0;
+  auto [end, ec] = std::from_chars(tok.data(), tok.data() + tok.size(), jobs);
+  if (ec != std::errc() || end != tok.data() + tok.size()) {
+    throw std::invalid_argument("invalid thread count: `" + std::string(tok) + "`");
+  }
+  return jobs == 0 ? hardware_jobs() : jobs;
+}
+
+size_t ParseLimit(std::string_view flag, std::string_view tok) {
+  size_t limit = 0;
+  auto [end, ec] = std::from_chars(tok.data(), tok.data() + tok.size(), limit);
+  if (ec != std::errc() || end != tok.data() + tok.size()) {
+    throw std::invalid_argument("invalid `" + std::string(flag) + "` count: `" + std::string(tok) + "`");
+  }
+  return limit;
+}
+}
+
 Args GetArgs(int argc, char* argv[]) {
   if (argc < 2) return ArgHelp{};
 
@@ -29,6 +54,42 @@ Args GetArgs(int argc, char* argv[]) {
       std::string_view tok = argv[i];
       if (tok == "-show-ast") {
         a.show_ast = true;
+      } else if (tok == "-stats") {
+        a.show_stats = true;
+      } else if (tok == "-time-passes") {
+        a.time_passes = true;
+      } else if (tok == "-warn-unused") {
+        a.warn_unused = true;
+      } else if (tok == "-stop-at-limit") {
+        a.stop_at_limit = true;
+      } else if (tok == "-max-errors" || tok == "-max-errors-per-phase") {
+        if (i + 1 >= argc) throw std::invalid_argument("`" + std::string(tok) + "` expects a count");
+        size_t limit = ParseLimit(tok, argv[++i]);
+        (tok == "-max-errors" ? a.max_errors : a.max_errors_per_phase) = limit;
+      } else if (tok == "-stop-after") {
+        if (i + 1 >= argc) throw std::invalid_argument("`-stop-after` expects a pass name");
+        a.stop_after = argv[++i];
+      } else if (tok == "-format") {
+        if (i + 1 >= argc) throw std::invalid_argument("`-format` expects text, jsonl or sarif");
+        auto format = diagnostic_format_from(argv[++i]);
+        if (!format) throw std::invalid_argument("unknown diagnostic format: `" + std::string(argv[i]) + "` (expected text, jsonl or sarif)");
+        a.format = *format;
+      } else if (tok == "-color") {
+        if (i + 1 >= argc) throw std::invalid_argument("`-color` expects auto, always or never");
+        std::string_view mode = argv[++i];
+        if (mode == "auto") a.color = ColorMode::Auto;
+        else if (mode == "always") a.color = ColorMode::Always;
+        else if (mode == "never") a.color = ColorMode::Never;
+        else throw std::invalid_argument("unknown color mode: `" + std::string(mode) + "` (expected auto, always or never)");
+      } else if (tok == "-root") {
+        if (i + 1 >= argc) throw std::invalid_argument("`-root` expects a directory");
+        a.root = argv[++i];
+      } else if (tok == "-cache") {
+        if (i + 1 >= argc) throw std::invalid_argument("`-cache` expects a directory");
+        a.cache_dir = argv[++i];
+      } else if (tok == "-j") {
+        if (i + 1 >= argc) throw std::invalid_argument("`-j` expects a thread count");
+        a.jobs = ParseJobs(argv[++i]);
       } else if (!tok.empty() && tok.front() == '-') {
         throw std::invalid_argument("unknown check flag: `" + std::string(tok) + "`");
       } else if (a.path.empty()) {
@@ -37,7 +98,23 @@ Args GetArgs(int argc, char* argv[]) {
         throw std::invalid_argument("unexpected positional: `" + std::string(tok) + "`");
       }
     }
-    if (a.path.empty()) throw std::invalid_argument("usage: ether check <file> [-show-ast]");
+    if (a.path.empty()) throw std::invalid_argument("usage: ether check <file|dir> [-root <dir>] [-cache <dir>] [-show-ast] [-stats] [-time-passes] [-stop-after <pass>] [-warn-unused] [-max-errors <n>] [-max-errors-per-phase <n>] [-stop-at-limit] [-format <text|jsonl|sarif>] [-color <auto|always|never>] [-j <n>]");
+    return a;
+  }
+  if (sub == "lsp") {
+    ArgLsp a;
+    for (int i = 2; i < argc; ++i) {
+      std::string_view tok = argv[i];
+      if (tok == "-root") {
+        if (i + 1 >= argc) throw std::invalid_argument("`-root` expects a directory");
+        a.root = argv[++i];
+      } else if (tok == "-j") {
+        if (i + 1 >= argc) throw std::invalid_argument("`-j` expects a thread count");
+        a.jobs = ParseJobs(argv[++i]);
+      } else {
+        throw std::invalid_argument("unknown lsp flag: `" + std::string(tok) + "`");
+      }
+    }
     return a;
   }
   if (sub == "help" || sub == "--help" || sub == "-h") return ArgHelp{};
@@ -52,6 +129,7 @@ struct Dispatcher {
   int operator()(const ArgBuild&  a) const { return HandleBuild(a);  }
   int operator()(const ArgRun&    a) const { return HandleRun(a);    }
   int operator()(const ArgCheck&  a) const { return HandleCheck(a);  }
+  int operator()(const ArgLsp&    a) const { return HandleLsp(a);    }
   int operator()(const ArgHelp&   a) const { return HandleHelp(a);   }
 };
 }
@@ -1,4 +1,6 @@
 #pragma once
+#include <ether/diagnostics/diagnostic_stream.hpp>
+#include <cstddef>
 #include <string>
 #include <variant>
 
@@ -8,7 +10,29 @@ struct ArgBuild  {};
 struct ArgRun    {};
 struct ArgCheck  {
   std::string path;
+  // Project root that `Load` paths are resolved against; defaults to the
+  // checked directory, or the checked file's directory.
+  std::string root;
+  // Module interface cache directory; empty disables caching.
+  std::string cache_dir;
+  // Last pass to run; empty runs them all.
+  std::string stop_after;
   bool show_ast = false;
+  bool show_stats = false;
+  bool time_passes = false;
+  bool warn_unused = false;
+  // Diagnostics kept per module and per phase; 0 is no limit.
+  size_t max_errors = 0;
+  size_t max_errors_per_phase = 0;
+  bool stop_at_limit = false;
+  DiagnosticFormat format = DiagnosticFormat::Text;
+  ColorMode color = ColorMode::Auto;
+  size_t jobs = 1;
+};
+struct ArgLsp    {
+  // Like `check -root`; defaults to the client's workspace root.
+  std::string root;
+  size_t jobs = 1;
 };
 struct ArgHelp   {};
 
@@ -18,6 +42,7 @@ using Args = std::variant<
   ArgRun,
   ArgCheck,
   ArgCreate,
+  ArgLsp,
   ArgHelp
 >;
 
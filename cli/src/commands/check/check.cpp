@@ -1,33 +1,110 @@
 #include "check.hpp"
-#include "files.hpp"
 
 #include <ether/ast/print/print.hpp>
-#include <ether/ast/symbol_resolver/symbol_resolver.hpp>
-#include <ether/module/module.hpp>
+#include <ether/diagnostics/diagnostic_stream.hpp>
+#include <ether/import_res/import_res.hpp>
+#include <ether/module/module_loader.hpp>
 
+#include <algorithm>
 #include <cstdio>
+#include <filesystem>
+#include <iostream>
 #include <string>
-#include <utility>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+// Every module file under `dir`, in a stable order.
+std::vector<fs::path> ModuleFilesIn(const fs::path& dir) {
+  std::vector<fs::path> files;
+  for (const auto& entry : fs::recursive_directory_iterator(dir)) {
+    if (entry.is_regular_file() && entry.path().extension() == module_file_extension) {
+      files.push_back(entry.path());
+    }
+  }
+  std::ranges::sort(files);
+  return files;
+}
+}
 
 int HandleCheck(const ArgCheck& a) {
-  std::string source = FileToString(a.path);
-  if (source.empty()) {
+  fs::path target = a.path;
+  std::error_code ec;
+  bool is_dir = fs::is_directory(target, ec);
+
+  fs::path root = !a.root.empty() ? fs::path(a.root)
+                : is_dir ? target
+                : fs::absolute(target).parent_path();
+
+  ModuleLoader loader(root, LoaderOptions{
+    .jobs = a.jobs,
+    .warn_unused = a.warn_unused,
+    .cache_dir = a.cache_dir,
+    .keep_ast = a.show_ast,
+    .stop_after = a.stop_after,
+    .time_passes = a.time_passes,
+    .diagnostic_limits = {
+      .total = a.max_errors,
+      .per_phase = a.max_errors_per_phase,
+      .stop_early = a.stop_at_limit,
+    },
+  });
+
+  if (!a.stop_after.empty() && !loader.get_passes().contains(a.stop_after)) {
+    std::string known;
+    for (const auto& name : loader.get_passes().names()) known += (known.empty() ? "" : ", ") + name;
+    std::fprintf(stderr, "ether: unknown pass `%s` (passes: %s)\n", a.stop_after.c_str(), known.c_str());
+    return 1;
+  }
+
+  if (is_dir) {
+    for (const auto& file : ModuleFilesIn(target)) loader.add_entry(file);
+  } else if (!loader.add_entry(target)) {
     std::fprintf(stderr, "ether: could not read source file `%s`\n", a.path.c_str());
     return 1;
   }
 
-  Module mod(a.path, std::move(source));
-  mod.generate_ast();
+  loader.load();
 
+  DiagnosticStream diagnostics(a.format, std::cout, a.color);
   TreePrinter printer;
-  SymbolResolver resolver(mod.get_symbol_storage(), mod.get_diag_engine());
+  size_t cached = 0, symbols = 0, exports = 0, references = 0, index_bytes = 0;
+  for (const auto& loaded : loader.modules()) {
+    auto& mod = *loaded.module;
+    if (a.show_ast) {
+      mod.attach_visitor(printer);
+      mod.apply_visitors();
+    }
+    diagnostics.write(mod.get_diag_engine());
+
+    if (loaded.from_cache) {
+      cached++;
+      continue;
+    }
 
-  if (a.show_ast) mod.attach_visitor(printer);
-  mod.attach_visitor(resolver);
-  mod.apply_visitors();
+    symbols += mod.get_symbol_storage().size();
+    exports += mod.get_exported_symbols().size();
+    references += mod.get_use_index().size();
+    index_bytes += mod.get_use_index().memory_bytes();
+  }
+
+  diagnostics.finish();
+
+  if (a.show_stats) {
+    std::printf(
+      "stats: %zu modules (%zu cached), %zu symbols, %zu exports, %zu references (use-def index: %zu bytes)\n",
+      loader.modules().size(),
+      cached,
+      symbols,
+      exports,
+      references,
+      index_bytes
+    );
+  }
 
-  mod.set_exports(resolver.take_exports());
-  mod.print_errors();
+  if (a.time_passes) loader.get_passes().print_stats();
 
   return 0;
 }
@@ -21,8 +21,23 @@ int HandleHelp(const ArgHelp&) {
     "%s%sCOMMANDS:%s\n"
     "  %screate%s %s<name>%s    Scaffold a new project\n"
     "  %sinit%s             Initialize a project in the current directory\n"
-    "  %scheck%s %s<file>%s     Parse and resolve a source file\n"
-    "      %s-show-ast%s    also print the AST\n"
+    "  %scheck%s %s<path>%s     Parse and resolve a file or directory and the modules it loads\n"
+    "      %s-root%s %s<dir>%s  resolve `Load` paths under dir (default: the file's directory)\n"
+    "      %s-cache%s %s<dir>%s keep check results in dir and replay unchanged modules\n"
+    "      %s-show-ast%s    also print the AST, as written\n"
+    "      %s-stats%s       print symbol and reference counts\n"
+    "      %s-time-passes%s print time, allocations and AST nodes per pass\n"
+    "      %s-stop-after%s %s<pass>%s  skip the passes after lex, parse, resolve, type-check or fold\n"
+    "      %s-warn-unused%s warn about unused bindings, parameters and functions\n"
+    "      %s-max-errors%s %s<n>%s  keep at most n errors and warnings per module\n"
+    "      %s-max-errors-per-phase%s %s<n>%s  ... and at most n from each phase\n"
+    "      %s-stop-at-limit%s stop lexing and parsing a module once a limit is reached\n"
+    "      %s-format%s %s<fmt>%s print diagnostics as text, jsonl (a JSON object per line) or sarif\n"
+    "      %s-color%s %s<when>%s  color text diagnostics: auto (on a terminal), always or never\n"
+    "      %s-j%s %s<n>%s       load modules on n threads (0 = all cores)\n"
+    "  %slsp%s              Serve the language server protocol on stdin/stdout\n"
+    "      %s-root%s %s<dir>%s  resolve `Load` paths under dir (default: the workspace root)\n"
+    "      %s-j%s %s<n>%s       check documents on n threads (0 = all cores)\n"
     "  %sbuild%s            Compile the project %s(not yet implemented)%s\n"
     "  %srun%s              Build and execute %s(not yet implemented)%s\n"
     "  %shelp%s             Show this help\n",
@@ -33,7 +48,22 @@ int HandleHelp(const ArgHelp&) {
     YELLOW, RESET, MAGENTA, RESET,
     YELLOW, RESET,
     YELLOW, RESET, MAGENTA, RESET,
+    CYAN, RESET, MAGENTA, RESET,
+    CYAN, RESET, MAGENTA, RESET,
     CYAN, RESET,
+    CYAN, RESET,
+    CYAN, RESET,
+    CYAN, RESET, MAGENTA, RESET,
+    CYAN, RESET,
+    CYAN, RESET, MAGENTA, RESET,
+    CYAN, RESET, MAGENTA, RESET,
+    CYAN, RESET,
+    CYAN, RESET, MAGENTA, RESET,
+    CYAN, RESET, MAGENTA, RESET,
+    CYAN, RESET, MAGENTA, RESET,
+    YELLOW, RESET,
+    CYAN, RESET, MAGENTA, RESET,
+    CYAN, RESET, MAGENTA, RESET,
     YELLOW, RESET, DIM, RESET,
     YELLOW, RESET, DIM, RESET,
     YELLOW, RESET
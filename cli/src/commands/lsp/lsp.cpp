@@ -0,0 +1,23 @@
+#include "lsp.hpp"
+
+#include <ether/lsp/lsp_server.hpp>
+
+#include <iostream>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <cstdio>
+#endif
+
+int HandleLsp(const ArgLsp& a) {
+#ifdef _WIN32
+  // Content-Length counts bytes; text mode would rewrite line endings.
+  _setmode(_fileno(stdin), _O_BINARY);
+  _setmode(_fileno(stdout), _O_BINARY);
+#endif
+  std::ios::sync_with_stdio(false);
+
+  LspServer server(std::cin, std::cout, LspOptions{ .root = a.root, .jobs = a.jobs });
+  return server.run();
+}
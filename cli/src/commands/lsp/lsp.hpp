@@ -0,0 +1,4 @@
+#pragma once
+#include "cmd.hpp"
+
+int HandleLsp(const ArgLsp&);
@@ -0,0 +1,28 @@
+#include <ether/support/alloc_stats.hpp>
+#include <cstdlib>
+#include <new>
+
+namespace {
+const bool enabled = (enable_alloc_counting(), true);
+}
+
+// Array, nothrow and sized forms go through these; over-aligned allocations
+// keep the standard library's own (uncounted) pair.
+void* operator new(std::size_t size) {
+  count_allocation(size);
+  if (size == 0) size = 1;
+  while (true) {
+    if (void* p = std::malloc(size)) return p;
+    auto handler = std::get_new_handler();
+    if (!handler) throw std::bad_alloc();
+    handler();
+  }
+}
+
+void operator delete(void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+  std::free(p);
+}
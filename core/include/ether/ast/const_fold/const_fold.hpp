@@ -0,0 +1,74 @@
+#pragma once
+#include <ether/diagnostics/diagnostic_eng.hpp>
+#include <ether/nodes/node_visitor.hpp>
+#include <ether/nodes/node_expr.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Evaluates operators and scoped expressions whose operands are all
+// literals, replacing each such subtree with the NDLiteral it comes to:
+// `{ 10 * 12 + 3 }` becomes `123`. Int is 64-bit and Float a double; `+`
+// also joins two strings. An operation that overflows, divides by zero or
+// takes a literal too large for Int is reported and left as written, as
+// is anything whose operand types the type checker would reject, so it
+// runs after the checker without changing what it found. Poisoned nodes
+// are left alone.
+class ConstantFolder: public Visitor {
+public:
+  explicit ConstantFolder(DiagnosticEngine& diag) : diag_eng(diag) {}
+
+  // Folds every top-level node of `root`.
+  void fold_module(Parent& root);
+  // Reports what fold_module would, leaving the tree as it is.
+  void check_module(Parent& root);
+  // How many subtrees the folds so far replaced.
+  size_t folded() const { return folded_count; }
+
+  void visit(NDLiteral&) override;
+  void visit(NDImportDirective&) override;
+  void visit(NDIdentifier&) override;
+  void visit(NDLetBindExpr&) override;
+  void visit(NDConstExpr&) override;
+  void visit(NDCallExpr&) override;
+  void visit(NDCallChain&) override;
+  void visit(NDFuncDeclExpr&) override;
+  void visit(NDCaseExpr&) override;
+  void visit(NDBinaryExpr&) override;
+  void visit(NDUnaryExpr&) override;
+  void visit(NDScopeExpr&) override;
+
+private:
+  enum class ValueKind : uint8_t { Int, Float, String, Bool, Nil };
+
+  // What a literal or a folded subtree evaluates to.
+  struct Value {
+    ValueKind kind;
+    int64_t i = 0;
+    double f = 0;
+    bool b = false;
+    std::string s;
+  };
+
+  DiagnosticEngine& diag_eng;
+  size_t folded_count = 0;
+  bool rewrite = true;
+  // What the last visit evaluated to, if anything, and where that
+  // expression is in the source: its byte range and where it starts.
+  std::optional<Value> value;
+  SourceRange at{};
+  size_t line = 0;
+  size_t column = 0;
+
+  // Folds `node` and replaces it with a literal if it evaluated to one.
+  void fold(NDPtr& node);
+  void fold(std::vector<NDPtr>& nodes);
+
+  std::optional<Value> binary(const Value& lhs, const Token& op, const Value& rhs);
+  std::optional<Value> unary(const Token& op, const Value& rhs);
+  // A literal token for `v`, where the last visited expression starts.
+  Token literal_token(const Value& v) const;
+  void report(SourceRange where, std::string message);
+};
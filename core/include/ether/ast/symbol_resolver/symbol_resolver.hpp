@@ -1,11 +1,18 @@
 #pragma once
 #include <ether/diagnostics/diagnostic_eng.hpp>
+#include <ether/module/module_registry.hpp>
+#include <ether/module/text_edit.hpp>
 #include <ether/nodes/node_expr.hpp>
 #include <ether/nodes/node_visitor.hpp>
 #include <ether/symbols/symbol_types.hpp>
 #include <ether/symbols/symtable.hpp>
+#include <ether/symbols/use_index.hpp>
+#include <cstddef>
+#include <mutex>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 enum class SymbolErrorKind {
   InvalidDeclaration,
@@ -25,7 +32,7 @@ inline std::string symbol_error_to_str(SymbolErrorKind err) {
 class SymbolResolver : public Visitor {
 public:
   SymbolResolver(SymbolStorage& arena, DiagnosticEngine& diag)
-    : diag_eng(diag), sym_table(arena) {}
+    : diag_eng(diag), arena(arena), sym_table(arena) {}
 
   void visit(NDLiteral&)         override;
   void visit(NDImportDirective&) override;
@@ -40,12 +47,107 @@ public:
   void visit(NDUnaryExpr&)       override;
   void visit(NDScopeExpr&)       override;
 
+  // Declares every top-level `func` and `const` (and fills the export table)
+  // before any body is resolved, so module-level names may be used ahead of
+  // their declaration. Top-level `Load` directives are bound here too. Only
+  // the root's direct children are inspected.
+  void begin_module(Parent&)     override;
+
+  // Lets `Load` directives bind other modules' exports. Names not declared
+  // in this module are then looked up in the loaded modules, in `Load`
+  // order. Without a registry, imports are only scope-checked.
+  void set_module_registry(const ModuleRegistry& reg) { registry = &reg; }
+
+  // Resolves every top-level node of `root` after hoisting its declarations.
+  // Function bodies only read the module scope, so with jobs > 1 they are
+  // resolved concurrently, each with its own scope stack, symbol arena and
+  // diagnostic buffer, merged back in declaration order. Bodies share one
+  // proxy per imported name they use, placed in the arena in order of first
+  // use, as if they had been resolved one after another.
+  void resolve_module(Parent& root, size_t jobs = 1);
+
   std::unordered_map<std::string, SymbolAttr*> take_exports() {
     return std::move(exports);
   }
 
+  // Warns about `let` bindings and parameters that are never read and about
+  // top-level functions other than `main` that are never called. Uses the
+  // reference counts kept during resolution, so call it after resolution
+  // and before take_exports(). With `functions` false the functions are
+  // left to the caller, which may know of calls from other modules (see
+  // uncalled_functions()).
+  void report_unused_symbols(bool functions = true);
+
+  // The top-level functions other than `main` that this module never calls,
+  // in declaration order. Same preconditions as report_unused_symbols().
+  std::vector<const SymbolAttr*> uncalled_functions() const;
+
+  // Each imported name this module uses, with the path of the module it was
+  // found in, in order of first use.
+  struct ImportedUse {
+    std::string import_path;
+    std::string name;
+  };
+  std::vector<ImportedUse> used_imports() const;
+
+  // Builds the reverse index of every reference recorded so far. Call after
+  // resolution has finished; the recorded uses are consumed.
+  UseDefIndex take_use_index();
+
+  // For re-resolving part of a module after an edit (Module::apply_edit).
+  // The index is built without consuming the recorded uses.
+  UseDefIndex build_use_index() const;
+  // Drops the uses recorded at byte offsets in [begin, end), taking back
+  // the references they counted.
+  void forget_uses(size_t begin, size_t end);
+  // Moves recorded uses and the symbols declared in this module to where
+  // `shift` put the text they point at.
+  void shift_positions(const SourceShift& shift);
+  // Points a reparsed top-level declaration at the symbol its previous
+  // version declared under the same name, refreshing the recorded position
+  // and (for functions) parameters and return type.
+  void redeclare(NDFuncDeclExpr&, SymbolAttr&);
+  void redeclare(NDConstExpr&, SymbolAttr&);
+
 private:
+  // Resolver for a single function body. Lookups that miss its own scopes
+  // fall through to `module_scope`, which it never writes.
+  SymbolResolver(SymbolStorage& arena, DiagnosticEngine& diag, const SymTable& module_scope)
+    : diag_eng(diag), arena(arena), sym_table(arena, module_scope), shares_module_scope(true) {}
+
+  void bind_import(NDImportDirective&);
+  SymbolAttr* lookup(const std::string&);
+  SymbolAttr* lookup_import(const std::string&);
+
+  SymbolAttr* declare_function(NDFuncDeclExpr&);
+  SymbolAttr* declare_const(NDConstExpr&);
+  void resolve_function_body(NDFuncDeclExpr&);
+  void note_use(SymbolAttr*, const Token&);
+
   DiagnosticEngine& diag_eng;
+  SymbolStorage& arena;
   SymbolTable sym_table;
   std::unordered_map<std::string, SymbolAttr*> exports;
+  std::vector<SymbolUse> uses;
+
+  const ModuleRegistry* registry = nullptr;
+  std::vector<const ModuleExports*> imports;
+  // The `Load` path of each of `imports`.
+  std::vector<std::string> import_paths;
+  // Local stand-ins for imported symbols, so uses of them are counted and
+  // indexed in this module without writing to the exporting module.
+  std::unordered_map<std::string, SymbolAttr*> imported_symbols;
+  // Which of `imports` each proxy came from, in allocation order.
+  std::vector<std::pair<SymbolAttr*, size_t>> proxy_origins;
+  // While bodies resolve in parallel, the module resolver makes proxies
+  // under `proxy_mutex` into `parallel_proxies` for them, and each body
+  // resolver lists the ones it looked up in `proxies_looked_up`, so they
+  // can be placed in a fixed order once all are done.
+  SymbolResolver* module_resolver = nullptr;
+  std::mutex proxy_mutex;
+  SymbolStorage* parallel_proxies = nullptr;
+  std::vector<SymbolAttr*> proxies_looked_up;
+  // Body resolvers running in parallel must not bump counts on shared
+  // module-level symbols; their uses are counted when chunks are merged.
+  bool shares_module_scope = false;
 };
@@ -1,9 +1,66 @@
 #pragma once
+#include <ether/ast/type_check/type_store.hpp>
+#include <ether/diagnostics/diagnostic_eng.hpp>
+#include <ether/module/text_edit.hpp>
 #include <ether/nodes/node_visitor.hpp>
 #include <ether/nodes/node_expr.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
+// Hindley-Milner inference over a resolved module. Literals, operators,
+// calls, pipes (`a() |=> b(x)` is `b(a(), x)`), case branches and
+// annotations constrain the types; functions and `let` bindings are
+// generalized, so a function that works for any type can be used at
+// several.
+//
+// Top-level functions and constants are checked in the order of the call
+// graph's strongly connected components, callees first, so they may be
+// used ahead of their declaration. The functions of one component are
+// inferred together and generalized once, which makes (mutually) recursive
+// functions monomorphic within their cycle. Components that do not depend
+// on each other are checked concurrently with jobs > 1, each with its own
+// TypeStore and diagnostic buffer; diagnostics are merged in declaration
+// order, so the output does not depend on jobs.
+//
+// Symbols are typed through their resolved SymbolAttr, and what is inferred
+// for them is left in its type_info. Symbols of other modules and of
+// components already checked are used at fresh instances of their
+// type_info. Operators whose operand type is still open once their
+// component is done (inside a generic function) are not checked.
+//
+// A checker kept for later checks of the same module (Module::apply_edit)
+// infers again only what may have changed. A component keeps its types and
+// diagnostics if none of its declarations was forget()-ten and every
+// function and constant it uses still has the signature it had last time.
+// Signatures are compared by TypeId, which alpha-equivalent types share, so
+// an edit to a function's body that leaves its signature alone does not
+// recheck its callers.
 class TypeChecker: public Visitor {
 public:
+  explicit TypeChecker(DiagnosticEngine& diag, size_t jobs = 1)
+  : diag_eng(&diag), jobs(jobs) {}
+
+  // Infers every top-level node of `root`, after the resolver has run.
+  void check_module(Parent& root);
+
+  // The inferred type of one of the module's symbols, e.g. "(Int, 'a) :> 'a";
+  // empty if it has none.
+  std::string type_of(const SymbolAttr& sym) const;
+
+  // Drops what the last check found for the top-level declaration `decl`,
+  // which was parsed again, so the next check infers it anew.
+  void forget(const SymbolAttr& decl);
+  // Moves the diagnostics kept for unchanged declarations to where `shift`
+  // put their text.
+  void shift_positions(const SourceShift& shift);
+  // How many top-level declarations the last check_module() inferred; the
+  // others kept their types.
+  size_t inferred() const { return inferred_count; }
+
   void visit(NDLiteral&) override;
   void visit(NDImportDirective&) override;
   void visit(NDIdentifier&) override;
@@ -16,4 +73,94 @@ public:
   void visit(NDBinaryExpr&) override;
   void visit(NDUnaryExpr&) override;
   void visit(NDScopeExpr&) override;
+
+private:
+  // Kept: typed by an earlier check, so only its type_info holds its type.
+  enum class SymbolState : uint8_t { Unknown, InProgress, Done, Kept };
+
+  // Indexed by SymbolAttr::id. `sym` tells the module's symbols from other
+  // modules' ones with the same id; `task` is the component whose TypeStore
+  // `type` belongs to.
+  struct SymbolType {
+    SymbolAttr* sym = nullptr;
+    SymbolState state = SymbolState::Unknown;
+    TypeRef type = 0;
+    uint32_t task = module_task;
+  };
+
+  // An operator whose operand type was still open when it was met.
+  struct OperandCheck {
+    TypeRef type;
+    uint8_t allowed;
+    const Token* op;
+  };
+
+  // A function or constant a declaration uses, and the signature it had.
+  struct Use {
+    SymbolAttr* sym;
+    TypeId type = TypeTable::unknown;
+  };
+
+  // What the last check found for one top-level declaration. `defined` and
+  // `diagnostics` are the whole component's, kept by its first declaration,
+  // the `leader`.
+  struct Checked {
+    std::vector<Use> uses;
+    uint32_t max_id = 0;
+    const SymbolAttr* leader = nullptr;
+    uint32_t component_size = 0;
+    std::vector<SymbolAttr*> defined;
+    DiagnosticList diagnostics;
+  };
+
+  static constexpr uint32_t module_task = UINT32_MAX;
+
+  // Checks one component for `module`.
+  TypeChecker(TypeChecker& module, uint32_t task)
+  : jobs(1), symbol_types(module.symbol_types), task(task) {}
+
+  DiagnosticEngine* diag_eng = nullptr;
+  size_t jobs;
+  // The module's symbols, shared by its tasks: each task writes only the
+  // slots of the symbols its component declares.
+  std::vector<SymbolType> module_symbols;
+  std::vector<SymbolType>* symbol_types = &module_symbols;
+  std::unordered_map<const SymbolAttr*, Checked> checked;
+  size_t inferred_count = 0;
+  DiagnosticList* out = nullptr;
+  uint32_t task = module_task;
+
+  TypeStore types;
+  // Symbols typed by this task, to leave their types in type_info.
+  std::vector<SymbolAttr*> defined;
+  std::vector<OperandCheck> operand_checks;
+  uint32_t level = 0;
+  // What the last visit inferred, and where that expression is.
+  TypeRef result = TypeStore::nil_type;
+  SourceRange at{};
+
+  // Infers the top-level declarations `component` together, generalizing
+  // them once, unless what `found` kept for them still holds. `found` is
+  // parallel to `component`; `fresh` marks declarations it holds nothing
+  // for yet. False if it kept them.
+  bool check_component(const std::vector<Node*>& component, const std::vector<Checked*>& found,
+                       const std::vector<bool>& fresh);
+  // Checks the operators left open and leaves every defined symbol's type
+  // in its type_info.
+  void finish();
+
+  TypeRef infer(Node& node);
+  TypeRef infer_call(NDCallExpr& call, std::optional<TypeRef> piped, SourceRange piped_at);
+  // Unifies `self` with the function's type, inferred at the current level.
+  void infer_function(NDFuncDeclExpr& expr, TypeRef self);
+  SymbolType& slot(const SymbolAttr& sym) { return (*this->symbol_types)[sym.id]; }
+  // The type a use of `sym` has.
+  TypeRef use(SymbolAttr* sym);
+  TypeRef annotation(const Token& name);
+  void define(SymbolAttr& sym, TypeRef type, SymbolState state = SymbolState::Done);
+
+  // Reports unless `found` unifies with `expected`.
+  void expect(TypeRef expected, TypeRef found, SourceRange where);
+  void check_operand(TypeRef type, uint8_t allowed, const Token& op);
+  void report(SourceRange where, std::string message);
 };
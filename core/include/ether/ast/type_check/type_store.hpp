@@ -0,0 +1,95 @@
+#pragma once
+#include <ether/symbols/type_table.hpp>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// A type within one TypeStore; unlike a TypeRef it may be a variable that
+// is bound later.
+using TypeRef = uint32_t;
+
+// The types of one inference, as a union-find forest over dense ids.
+// Unifying a variable links it to the other type; find() follows links to
+// the representative and compresses the path it took.
+//
+// Every variable records the let-depth (level) it was made at, and binding
+// it lowers the levels of the variables in what it is bound to, so a
+// variable's level is the outermost binding that can still see it.
+// generalize() marks the variables deeper than a level as generic, and
+// instantiate() copies a type with fresh variables in place of them: no
+// scan of the environment is needed to find what may be generalized.
+class TypeStore {
+public:
+  static constexpr TypeRef int_type = 0;
+  static constexpr TypeRef float_type = 1;
+  static constexpr TypeRef string_type = 2;
+  static constexpr TypeRef bool_type = 3;
+  static constexpr TypeRef nil_type = 4;
+
+  TypeStore();
+
+  TypeRef fresh(uint32_t level);
+  // The same id for the same name.
+  TypeRef named(std::string_view name);
+  TypeRef function(std::span<const TypeRef> params, TypeRef result);
+
+  TypeRef find(TypeRef type);
+  TypeKind kind(TypeRef type) { return this->nodes[this->find(type)].kind; }
+  // Of a function type (after find).
+  std::span<const TypeRef> params(TypeRef func) const;
+  TypeRef result(TypeRef func) const;
+
+  // False if the two cannot be made equal, or only as an infinite type.
+  // What was unified before the clash stays unified.
+  bool unify(TypeRef a, TypeRef b);
+
+  void generalize(TypeRef type, uint32_t level);
+  TypeRef instantiate(TypeRef type, uint32_t level);
+
+  // A symbol's type from the table, with fresh variables at `level` for
+  // its variables and for unknown parts.
+  TypeRef import(TypeId type, const TypeTable& table, uint32_t level);
+  // The type as the table keeps it: variables, bound or not, numbered in
+  // order of appearance.
+  TypeId export_type(TypeRef type, TypeTable& table);
+
+  // "Int", "(Int, 'a) :> 'a", ...; variables are lettered in order of
+  // appearance.
+  std::string to_string(TypeRef type);
+
+  size_t size() const { return this->nodes.size(); }
+
+private:
+  static constexpr uint32_t generic = UINT32_MAX;
+
+  struct Node {
+    TypeKind kind;
+    // Var: what it is bound to, itself while unbound. Others: themselves.
+    TypeRef link;
+    // Var: let-depth, or `generic`.
+    uint32_t level;
+    // Func: where its parameters then result start in `args`. Named: the
+    // index of its name.
+    uint32_t first;
+    // Func: number of parameters.
+    uint32_t count;
+  };
+
+  std::vector<Node> nodes;
+  std::vector<TypeRef> args;
+  std::vector<std::string> names;
+  std::unordered_map<std::string, TypeRef> named_types;
+
+  TypeRef add(Node node);
+  bool bind(TypeRef var, TypeRef type);
+  // Lowers variable levels in `type` to `level`; false if `var` occurs in it.
+  bool adjust(TypeRef type, TypeRef var, uint32_t level);
+  TypeRef copy(TypeRef type, uint32_t level, std::vector<std::pair<TypeRef, TypeRef>>& fresh_for);
+  void append(std::string& out, TypeRef type, std::vector<TypeRef>& vars);
+  TypeRef import(TypeId type, const TypeTable& table, uint32_t level, std::vector<std::pair<TypeId, TypeRef>>& vars);
+  TypeId export_type(TypeRef type, TypeTable& table, std::vector<TypeRef>& vars);
+};
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <span>
 #include <string>
+#include <utility>
 #include <vector>
+
 enum class DiagnosticLevel {
   Note,
   Warn,
@@ -14,18 +20,75 @@ enum class DiagnosticPhase {
   Parser,
   Resolver,
   TypeChecker,
+  Folder,
   CodeGen,
 };
 
-struct SourceLocation {
-  size_t line;
-  size_t column;
+// The source bytes [begin, end) a diagnostic is about. Lines and columns are
+// worked out from the offsets only when printing (see LineIndex).
+struct SourceRange {
+  static constexpr uint32_t none = UINT32_MAX;
+
+  uint32_t begin = none;
+  uint32_t end = none;
+
+  static SourceRange at(size_t offset, size_t length) {
+    return { static_cast<uint32_t>(offset), static_cast<uint32_t>(offset + length) };
+  }
+  bool has_location() const { return begin != none; }
+};
+
+struct DiagnosticNote {
+  SourceRange range;
+  std::string message;
 };
 
 struct Diagnostic {
   DiagnosticLevel level;
   DiagnosticPhase phase;
-  SourceLocation  location;
+  SourceRange     range;
   std::string     message;
-  std::vector<Diagnostic> related;
+  // Its related notes: a stretch of the notes of the DiagnosticList that
+  // holds it.
+  uint32_t        first_note = 0;
+  uint32_t        note_count = 0;
+};
+
+// Diagnostics in report order, with every diagnostic's notes kept in one flat
+// side vector rather than nested in it. Reads like a vector of the
+// diagnostics; notes_of() gives a diagnostic's notes.
+class DiagnosticList {
+public:
+  void push_back(Diagnostic diag, std::span<const DiagnosticNote> notes = {});
+  void push_back(Diagnostic diag, std::initializer_list<DiagnosticNote> notes) {
+    this->push_back(std::move(diag), std::span(notes.begin(), notes.size()));
+  }
+  // Moves diagnostics [first, first + count) of `from` here, with their
+  // notes; `from` is only good for clearing or dropping afterwards.
+  void append(DiagnosticList& from, size_t first, size_t count);
+  void append(DiagnosticList& from) { this->append(from, 0, from.size()); }
+
+  std::span<const DiagnosticNote> notes_of(const Diagnostic& diag) const {
+    return { this->notes.data() + diag.first_note, diag.note_count };
+  }
+  std::span<DiagnosticNote> notes_of(const Diagnostic& diag) {
+    return { this->notes.data() + diag.first_note, diag.note_count };
+  }
+
+  size_t size() const { return this->items.size(); }
+  bool empty() const { return this->items.empty(); }
+  void clear();
+  Diagnostic& operator[](size_t i) { return this->items[i]; }
+  const Diagnostic& operator[](size_t i) const { return this->items[i]; }
+  auto begin() { return this->items.begin(); }
+  auto end() { return this->items.end(); }
+  auto begin() const { return this->items.begin(); }
+  auto end() const { return this->items.end(); }
+
+  const std::vector<Diagnostic>& diagnostics() const { return this->items; }
+  const std::vector<DiagnosticNote>& all_notes() const { return this->notes; }
+
+private:
+  std::vector<Diagnostic> items;
+  std::vector<DiagnosticNote> notes;
 };
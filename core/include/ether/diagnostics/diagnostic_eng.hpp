@@ -1,26 +1,147 @@
 #pragma once
 #include <ether/diagnostics/diagnostic.hpp>
+#include <ether/support/line_index.hpp>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <iosfwd>
 #include <iostream>
+#include <span>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
+// The order diagnostics are printed in: those without a location first, then
+// by where they start, then phase, level and message so that ties do not
+// depend on report order.
+bool diagnostic_before(const Diagnostic& a, const Diagnostic& b);
+
+// "error", "warning", "note"; "lexer", "parser", "type-checker", ...
+const char* level_to_string(DiagnosticLevel level);
+const char* phase_to_string(DiagnosticPhase phase);
+
+// Auto colors output only when it goes to a terminal (std::cout or std::cerr
+// attached to one) and NO_COLOR is not set.
+enum class ColorMode { Auto, Always, Never };
+bool use_color(ColorMode mode, const std::ostream& out);
+
+// Bounds on what an engine keeps, for inputs that would otherwise produce a
+// diagnostic per byte. Notes are not counted. 0 means no limit.
+struct DiagnosticLimits {
+  size_t total = 0;
+  size_t per_phase = 0;
+  // The lexer and parser stop once a limit their phase counts against is
+  // reached, leaving the rest of the module unread.
+  bool stop_early = false;
+};
+
+// Any number of threads may report() at once; each appends to a buffer of its
+// own, found without locking. The buffers are merged into one list when it is
+// next read, so everything else (absorb, splice, all, print_all, ...) must not
+// overlap with reports from other threads. Diagnostics from one thread keep
+// their report order; those from different threads are merged in no
+// particular order, which print_all() and sorted() do not depend on.
 class DiagnosticEngine {
 public:
-  void report(Diagnostic);
+  DiagnosticEngine();
+  ~DiagnosticEngine();
+
+  // Reporting threads cache where their buffer is.
+  DiagnosticEngine(const DiagnosticEngine&) = delete;
+  DiagnosticEngine& operator=(const DiagnosticEngine&) = delete;
+
+  // Past a limit the diagnostic is dropped and only counted, notes and all.
+  void report(Diagnostic, std::initializer_list<DiagnosticNote> notes = {});
+
+  void set_limits(DiagnosticLimits limits) { this->limits = limits; }
+  // Whether reports from `phase` are now dropped.
+  bool limit_reached(DiagnosticPhase phase) const;
+  // Whether the lexer or parser should stop, see DiagnosticLimits::stop_early.
+  bool should_stop(DiagnosticPhase phase) const {
+    return this->limits.stop_early && this->limit_reached(phase);
+  }
+  size_t dropped() const { return this->dropped_count.load(std::memory_order_relaxed); }
+
+  // Appends every diagnostic held by `other`, preserving its report order
+  // and counting them against the limits as if reported here.
+  // Used to merge per-task buffers back into a module's engine.
+  void absorb(DiagnosticEngine&& other);
+  void absorb(DiagnosticList&& diagnostics);
+
+  // For owners that keep their diagnostics in the engine in an order of
+  // their own and rework parts of it (Module::apply_edit): replaces
+  // [first, last) with `with`, gives in-place access to a stretch, or moves
+  // everything out. Printing does not reorder what is stored.
+  void splice(size_t first, size_t last, DiagnosticList with);
+  std::span<Diagnostic> range(size_t first, size_t last) {
+    this->merge_shards();
+    return { diagnostics.begin() + first, diagnostics.begin() + last };
+  }
+  std::span<DiagnosticNote> notes_of(const Diagnostic& diag) { return diagnostics.notes_of(diag); }
+  DiagnosticList take_all() {
+    this->merge_shards();
+    return std::exchange(diagnostics, {});
+  }
 
   // Provides the source for line/caret rendering. Call once per module after
-  // reading the file. The engine takes ownership of the text.
+  // reading the file (or after editing it). The engine takes ownership of the text and indexes
+  // its lines when it first needs a line or column.
   void set_source(std::string path, std::string text);
+  const std::string& path() const { return source_path; }
+  // Line and column of a byte offset in the source.
+  SourcePosition position(size_t offset);
 
-  void print_all(std::ostream& out = std::cout);
+  // Renders into one buffer reused across prints, written out in large
+  // pieces rather than per token.
+  void print_all(std::ostream& out = std::cout, ColorMode color = ColorMode::Auto);
 
   bool has_errors() const;
 
-  const std::vector<Diagnostic>& all() const { return diagnostics; }
+  // In report order (see above), with their notes.
+  const DiagnosticList& all() const {
+    this->merge_shards();
+    return diagnostics;
+  }
+  // In the order print_all() prints them.
+  std::vector<const Diagnostic*> sorted() const;
 
 private:
-  std::vector<Diagnostic> diagnostics{};
+  // One reporting thread's buffer. Shards are only ever pushed onto the
+  // front of the list and live as long as the engine.
+  struct Shard {
+    std::thread::id owner;
+    DiagnosticList diagnostics;
+    Shard* next;
+  };
+
+  static constexpr size_t phase_count = static_cast<size_t>(DiagnosticPhase::CodeGen) + 1;
+
+  DiagnosticLimits limits{};
+  // Diagnostics counted against each phase's limit and against the total;
+  // a report dropped for its phase does not count against the total.
+  std::array<std::atomic<size_t>, phase_count> phase_counts{};
+  std::atomic<size_t> total_count{ 0 };
+  std::atomic<size_t> dropped_count{ 0 };
+  std::atomic<bool> dropped_error{ false };
+
+  // Identifies the engine in the reporting threads' caches; unlike its
+  // address it is never reused.
+  uint64_t id;
+  std::atomic<Shard*> shards{ nullptr };
+  mutable DiagnosticList diagnostics{};
   std::string source_path{};
-  std::vector<std::string> source_lines{};
+  std::string source_text{};
+  // Built when first needed.
+  LineIndex lines{};
+  bool lines_indexed = true;
+  std::string render_buffer{};
+
+  const LineIndex& line_index();
+  Shard& shard_for_this_thread();
+  // Counts `diag` against the limits; false if it is to be dropped.
+  bool admit(const Diagnostic& diag);
+  // Moves what the shards hold onto the end of `diagnostics`.
+  void merge_shards() const;
 };
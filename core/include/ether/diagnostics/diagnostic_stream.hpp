@@ -0,0 +1,52 @@
+#pragma once
+#include <ether/diagnostics/diagnostic_eng.hpp>
+#include <iosfwd>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+
+enum class DiagnosticFormat {
+  // print_all()'s colored text.
+  Text,
+  // One JSON object per line and diagnostic.
+  JsonLines,
+  // A SARIF 2.1.0 log with one run.
+  Sarif,
+};
+
+// "text", "jsonl" or "sarif".
+std::optional<DiagnosticFormat> diagnostic_format_from(std::string_view name);
+
+// Writes the diagnostics of one module after another to `out` as each is
+// handed in, in print_all() order. Structured formats are written straight
+// to the stream, one diagnostic at a time; a SARIF log is opened on the first
+// write and closed by finish() (or the destructor).
+class DiagnosticStream {
+public:
+  // `color` applies to Text.
+  explicit DiagnosticStream(DiagnosticFormat format, std::ostream& out = std::cout, ColorMode color = ColorMode::Auto)
+  : format(format), out(out), color(color) {}
+  ~DiagnosticStream() { this->finish(); }
+
+  DiagnosticStream(const DiagnosticStream&) = delete;
+  DiagnosticStream& operator=(const DiagnosticStream&) = delete;
+
+  // Every diagnostic `eng` holds, located in eng.path().
+  void write(DiagnosticEngine& eng);
+  void finish();
+
+private:
+  DiagnosticFormat format;
+  std::ostream& out;
+  ColorMode color;
+  bool opened = false;
+  bool finished = false;
+  size_t results = 0;
+  // Reused for every diagnostic.
+  std::string line{};
+
+  void open();
+  void write_json_line(const Diagnostic& d, DiagnosticEngine& eng);
+  void write_sarif_result(const Diagnostic& d, DiagnosticEngine& eng, const std::string& uri);
+};
@@ -1,4 +1,17 @@
 #pragma once
 #include <ether/tokens/token_types.hpp>
+#include <filesystem>
+#include <string>
+#include <string_view>
 
 bool is_valid_import_path(Token);
+
+// Source file extension for Benzene modules.
+inline constexpr std::string_view module_file_extension = ".bz";
+
+// `a.b.c` -> `<root>/a/b/c.bz`.
+std::filesystem::path import_path_to_file(const std::filesystem::path& root, std::string_view import_path);
+
+// Inverse of import_path_to_file: `<root>/a/b/c.bz` -> `a.b.c`. Files outside
+// `root` fall back to their stem.
+std::string file_to_import_path(const std::filesystem::path& root, const std::filesystem::path& file);
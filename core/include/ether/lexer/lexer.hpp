@@ -1,17 +1,30 @@
 #pragma once
 #include <cstddef>
+#include <functional>
 #include <iosfwd>
 #include <iostream>
+#include <optional>
 #include <string>
 #include <string_view>
+#include <utility>
 #include <vector>
 #include <ether/tokens/token_types.hpp>
 #include <ether/lexer/lexer_diag.hpp>
+#include <ether/support/cancellation.hpp>
+
+// A point in the input where the main loop may start a token.
+struct LexPosition {
+  size_t offset;
+  size_t line;
+  size_t column;
+};
 
 class Lexer {
 public:
-  Lexer(std::string_view input, DiagnosticEngine& eng)
-  : lex_diag(eng) {
+  // Once `cancel` fires the scanning calls stop early and end the tokens
+  // with EoF there.
+  Lexer(std::string_view input, DiagnosticEngine& eng, CancellationToken cancel = {})
+  : lex_diag(eng), cancel(std::move(cancel)) {
     this->input = input;
     this->line_number = 1;
     this->column_number = 1;
@@ -20,13 +33,30 @@ public:
 
   void scan_tokens();
 
+  // Import-only pre-scan: lexes the leading `Load` directives (skipping
+  // whitespace and comments) and stops at the first token of any other kind,
+  // leaving the rest of the input unread. get_tokens() then holds
+  // ImportKeyword/ImportModule pairs and no EoF token.
+  void scan_imports();
+
+  // Relexes from `from`, which must be where a token started when the same
+  // text up to there was last lexed. Before each token it asks `stop` about
+  // the token's offset and, on true, returns where it stopped without lexing
+  // further (get_tokens() then has no EoF token). Otherwise it runs to the
+  // end like scan_tokens() and returns nullopt.
+  std::optional<LexPosition> rescan(LexPosition from, const std::function<bool(size_t)>& stop);
+
   void print_tokens(std::ostream& out = std::cout) const;
 
   std::vector<Token> get_tokens();
+  // Moves the tokens out, for callers done with the lexer.
+  std::vector<Token> take_tokens() { return std::move(this->tokens); }
 
 private: 
   LexerDiagnostics lex_diag;
 
+  CancellationToken cancel;
+
   size_t position{};
 
   size_t line_number{};
@@ -37,6 +67,10 @@ private:
 
   size_t token_start_column{};
 
+  size_t token_start_offset{};
+
+  std::optional<LexPosition> scan_from_here(const std::function<bool(size_t)>* stop);
+
   void scan_string();
 
   void scan_number();
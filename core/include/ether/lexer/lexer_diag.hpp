@@ -1,14 +1,32 @@
 #pragma once
 #include <ether/diagnostics/diagnostic_eng.hpp>
 #include <ether/tokens/token_types.hpp>
+#include <optional>
 
 class LexerDiagnostics {
 public:
   LexerDiagnostics(DiagnosticEngine& eng)
   : diag_eng(eng) {};
 
-  void unknown_character(Token&);
+  // Unknown characters are held back so that a run of them, with no other
+  // token in between on the same line, is reported once for the whole run.
+  // `index` is the unknown token's position in the token list.
+  void unknown_character(Token&, size_t index);
+  // Reports the run held back, if any.
+  void flush();
+  // Whether the lexer should stop (see DiagnosticLimits::stop_early); if so
+  // the run held back is reported first.
+  bool should_stop();
 
 private:
   DiagnosticEngine& diag_eng;
+
+  struct UnknownRun {
+    Diagnostic diag;
+    std::string characters;
+    size_t count;
+    size_t last_index;
+    size_t line;
+  };
+  std::optional<UnknownRun> run;
 };
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+// A JSON value, as much of JSON as the language server protocol needs.
+// Objects keep their members in insertion order, which keeps what the server
+// writes stable and easy to compare in tests.
+class Json {
+public:
+  using Array = std::vector<Json>;
+  using Object = std::vector<std::pair<std::string, Json>>;
+
+  Json() = default;
+  Json(std::nullptr_t) {}
+  Json(bool b) : value(b) {}
+  Json(int n) : value(static_cast<double>(n)) {}
+  Json(int64_t n) : value(static_cast<double>(n)) {}
+  Json(size_t n) : value(static_cast<double>(n)) {}
+  Json(double n) : value(n) {}
+  Json(const char* s) : value(std::string(s)) {}
+  Json(std::string s) : value(std::move(s)) {}
+  Json(std::string_view s) : value(std::string(s)) {}
+  Json(Array a) : value(std::move(a)) {}
+  Json(Object o) : value(std::move(o)) {}
+
+  // Parses a whole document; nullopt if `text` is not valid JSON.
+  static std::optional<Json> parse(std::string_view text);
+  std::string dump() const;
+
+  bool is_null() const { return std::holds_alternative<std::monostate>(value); }
+  bool is_object() const { return std::holds_alternative<Object>(value); }
+
+  // Typed access; null/nullopt when the value has another type.
+  std::optional<bool> boolean() const;
+  std::optional<double> number() const;
+  // Numbers with no fractional part that fit an int64_t.
+  std::optional<int64_t> integer() const;
+  const std::string* string() const { return std::get_if<std::string>(&value); }
+  const Array* array() const { return std::get_if<Array>(&value); }
+  const Object* object() const { return std::get_if<Object>(&value); }
+
+  // The member `key` of an object; nullptr if absent or not an object.
+  const Json* find(std::string_view key) const;
+  // Walks `keys` through nested objects; a null value if any step is missing.
+  const Json& at(std::initializer_list<std::string_view> keys) const;
+
+  // Builders. set() replaces an existing member; both turn a null value
+  // into an object/array first.
+  Json& set(std::string key, Json member);
+  Json& push(Json element);
+
+  bool operator==(const Json&) const = default;
+
+private:
+  std::variant<std::monostate, bool, double, std::string, Array, Object> value;
+
+  void write(std::string& out) const;
+};
+
+// Appends `s` to `out` as a quoted, escaped JSON string.
+void append_json_string(std::string& out, std::string_view s);
@@ -0,0 +1,110 @@
+#pragma once
+#include <ether/lsp/json.hpp>
+#include <ether/module/module.hpp>
+#include <ether/module/module_loader.hpp>
+#include <ether/module/text_edit.hpp>
+#include <ether/support/task_pool.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Reads one message framed by a `Content-Length` header; nullopt at the end
+// of the input or on a frame without a length.
+std::optional<std::string> read_lsp_message(std::istream& in);
+void write_lsp_message(std::ostream& out, std::string_view body);
+
+struct LspOptions {
+  // Where `Load` paths resolve. Empty means the client's workspace root, or
+  // each document's directory if the client sent none.
+  std::filesystem::path root{};
+  // Worker threads checking documents.
+  size_t jobs = 1;
+};
+
+// A language server speaking LSP over a pair of streams (stdio for
+// `ether lsp`). Open documents stay resident as checked Modules: the reader
+// thread turns each change into TextEdits and hands them to a worker pool,
+// which applies them with Module::apply_edit and publishes the module's
+// diagnostics. Changes that arrive while a document waits or is being
+// checked are merged into its next round, and cancel the round in progress
+// so that it stops at its next top-level item and publishes nothing.
+//
+// A document's `Load`s are loaded from disk under the root with a
+// ModuleLoader, again whenever its imports change or any file is saved.
+class LspServer {
+public:
+  LspServer(std::istream& in, std::ostream& out, LspOptions opts = {});
+  ~LspServer();
+
+  LspServer(const LspServer&) = delete;
+  LspServer& operator=(const LspServer&) = delete;
+
+  // Serves messages until `exit` or the end of the input. Returns 0 if
+  // `exit` followed `shutdown` and 1 otherwise, as the protocol asks.
+  int run();
+
+private:
+  struct Document {
+    std::string uri;
+    std::filesystem::path path;
+    std::filesystem::path root;
+
+    // Reader thread only: the text as of the latest change, for turning
+    // positions in later changes into byte offsets.
+    std::string text;
+
+    // Guarded by `mutex`: what the next check has to catch up on.
+    std::mutex mutex;
+    int64_t version = 0;
+    // Start over from this text, then apply `pending`.
+    std::optional<std::string> reload;
+    std::vector<TextEdit> pending;
+    bool refresh_imports = false;
+    bool scheduled = false;
+    bool closed = false;
+    // Stops the round in progress; each round starts a new one.
+    std::stop_source stop;
+
+    // Only the worker running the document's check touches these.
+    std::unique_ptr<Module> module;
+    std::unique_ptr<ModuleLoader> dependencies;
+    std::vector<std::string> imports;
+  };
+
+  std::istream& in;
+  std::ostream& out;
+  LspOptions options;
+
+  std::mutex out_mutex;
+  bool initialized = false;
+  bool shutdown_requested = false;
+  std::filesystem::path workspace_root;
+  std::unordered_map<std::string, std::shared_ptr<Document>> documents;
+  std::unique_ptr<TaskPool> pool;
+
+  void send(const Json& message);
+  void reply(const Json& id, Json result);
+  void reply_error(const Json& id, int code, std::string message);
+
+  // Returns false once `exit` has been handled.
+  bool handle(const Json& message);
+  Json initialize(const Json& params);
+  void did_open(const Json& params);
+  void did_change(const Json& params);
+  void did_close(const Json& params);
+  void did_save();
+
+  void schedule(const std::shared_ptr<Document>& doc);
+  void check_document(const std::shared_ptr<Document>& doc);
+  // Caller holds doc.mutex.
+  void publish(Document& doc, int64_t version, const Module* mod);
+};
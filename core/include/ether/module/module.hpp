@@ -1,11 +1,24 @@
 #pragma once
 #include <ether/diagnostics/diagnostic_eng.hpp>
+#include <ether/lexer/lexer.hpp>
+#include <ether/module/text_edit.hpp>
 #include <ether/nodes/node_expr.hpp>
+#include <ether/support/cancellation.hpp>
 #include <ether/symbols/symbol_types.hpp>
+#include <ether/symbols/use_index.hpp>
+#include <cstddef>
 #include <iosfwd>
 #include <iostream>
+#include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
+
+class ModuleRegistry;
+class TreePass;
+class SymbolResolver;
+class TypeChecker;
+struct ParserState;
 
 // A Module owns the AST, symbol storage, and diagnostics for one source unit.
 // It is filesystem-agnostic: callers (CLI, LSP, tests) read the source bytes
@@ -13,19 +26,67 @@
 // for diagnostic rendering and registry keys; it is not opened by Module.
 class Module {
 public:
-  Module(std::string path, std::string source)
-  : module_path(std::move(path)),
-    source_text(std::move(source)) {}
+  Module(std::string path, std::string source);
+  ~Module();
+
+  // A checked module's resolver points into its own arena.
+  Module(const Module&) = delete;
+  Module& operator=(const Module&) = delete;
 
   void attach_visitor(Visitor&);
+  // Runs in apply_visitors(), sharing walks with the other attached passes.
+  void attach_pass(TreePass&);
+  // lex() then parse(); passes that time the two apart call them in turn.
   void generate_ast();
-  void apply_visitors();
+  void lex();
+  // Parses the tokens lex() left, consuming them.
+  void parse();
+  // False if `cancel` fired first; see Parent::apply_visitors.
+  bool apply_visitors(const CancellationToken& cancel = {});
+  // Runs `resolver` over the whole module; see SymbolResolver::resolve_module.
+  void resolve(SymbolResolver&, size_t jobs = 1);
+  // Reports diagnostics recorded by an earlier check of the same source in
+  // place of lexing, parsing and resolving it again.
+  void replay_diagnostics(DiagnosticList diags);
+  // Installs a tree built elsewhere (e.g. materialized from a snapshot) in
+  // place of generate_ast(). Attached visitors are kept.
+  void set_ast(Parent root);
   void print_errors(std::ostream& out = std::cout);
+
+  // Parses, resolves and type-checks the module, keeping what apply_edit()
+  // needs to redo only the part of the work an edit touches. `registry` binds `Load`s as
+  // the module loader does. If `cancel` fires first, returns false and
+  // leaves the module unchecked: no AST, symbols or diagnostics.
+  bool check(const ModuleRegistry* registry = nullptr, const CancellationToken& cancel = {});
+  bool is_checked() const { return resolver != nullptr; }
+
+  // Applies `edit` to the source and brings the AST, symbols, exports, use
+  // index, types and diagnostics up to date as if check() had run on the new
+  // text. Only the top-level items whose tokens or parse the edit could
+  // change are relexed and reparsed; if their declarations kept their
+  // signatures only their bodies are resolved again, else the whole module
+  // is. Types are inferred again for the reparsed declarations and for those
+  // using a signature that changed (see TypeChecker). Items after the edit
+  // keep their nodes and have their positions moved. Symbols declared in
+  // replaced bodies stay in the arena, unreferenced. Runs check() first if
+  // it has not run.
+  //
+  // If `cancel` fires first the edit's text is still applied but the module
+  // is left unchecked, as by a cancelled check(); the next apply_edit()
+  // checks it in full.
+  EditStats apply_edit(const TextEdit& edit, const CancellationToken& cancel = {});
   Parent get_ast();
+  // In-place access to the AST for passes that run after generate_ast().
+  Parent& get_root() { return module_root; }
 
   SymbolStorage& get_symbol_storage() { return arena; }
   DiagnosticEngine& get_diag_engine() { return diag; }
+  const DiagnosticEngine& get_diag_engine() const { return diag; }
   const std::string& get_path() const { return module_path; }
+  const std::string& get_source() const { return source_text; }
+  // For a module made before its source was read (see ModuleLoader); call
+  // before lex() or replay_diagnostics().
+  void set_source(std::string source) { source_text = std::move(source); }
 
   const std::unordered_map<std::string, SymbolAttr*>& get_exported_symbols() const {
     return exported_symbols;
@@ -34,15 +95,74 @@ public:
     exported_symbols = std::move(syms);
   }
 
+  const UseDefIndex& get_use_index() const { return use_index; }
+  void set_use_index(UseDefIndex index) { use_index = std::move(index); }
+
 private:
+  // A top-level child of the root plus the source up to the next one; kept
+  // parallel to module_root.children by check() and apply_edit().
+  struct Item {
+    // Position of the item's first token.
+    LexPosition start;
+    // Start of the token after the last one parsing the item (or the junk
+    // skipped after it) looked at: an edit at or before it may change what
+    // parses here.
+    size_t lookahead_end;
+    // The item's stretch of the module's diagnostics: what resolving it
+    // reported, then lexer and parser diagnostics from its text.
+    size_t resolve_count = 0;
+    size_t syntax_count = 0;
+  };
+
+  // What parsing a stretch of tokens produced.
+  struct ParsedRun {
+    std::vector<NDPtr> nodes;
+    std::vector<Item> items;
+    // Syntax diagnostics from ahead of the first item (`lead_count` of
+    // them), then each item's.
+    DiagnosticList diagnostics;
+    size_t lead_count = 0;
+    // How far parsing the text ahead of the first item looked.
+    size_t lead_lookahead_end = 0;
+  };
+
   std::string module_path;
   std::string source_text;
   DiagnosticEngine diag;
 
   SymbolStorage arena;
   std::unordered_map<std::string, SymbolAttr*> exported_symbols;
+  UseDefIndex use_index;
 
   Parent module_root;
+  std::vector<Token> tokens;
+
+  // State kept by check() for apply_edit(). After a check `diag` holds the
+  // module-level diagnostics, those ahead of the first item, then each
+  // item's stretch, in item order, then the `type_diag_count` of the type
+  // checker and the constant folder.
+  const ModuleRegistry* registry = nullptr;
+  DiagnosticEngine resolver_diag;
+  std::unique_ptr<SymbolResolver> resolver;
+  DiagnosticEngine checker_diag;
+  std::unique_ptr<TypeChecker> checker;
+  size_t type_diag_count = 0;
+  std::vector<Item> items;
+  size_t module_diag_count = 0;
+  size_t lead_diag_count = 0;
+  size_t lead_lookahead_end = 0;
 
-  void make_module_ast();
+  ParsedRun collect_run(
+    Parent parsed,
+    const ParserState& state,
+    size_t lexed_end,
+    DiagnosticList lex_diags
+  );
+  // False if `cancel` fired before every item was resolved.
+  bool resolve_items(const CancellationToken& cancel);
+  void discard_check();
+  // Infers what changed since the last call and lays the type checker's
+  // and the constant folder's diagnostics out again.
+  void type_check();
+  DiagnosticList resolve_item(size_t index);
 };
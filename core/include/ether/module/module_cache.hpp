@@ -0,0 +1,130 @@
+#pragma once
+#include <ether/diagnostics/diagnostic.hpp>
+#include <ether/module/module_interface.hpp>
+#include <ether/module/module_registry.hpp>
+#include <ether/nodes/node_snapshot.hpp>
+#include <ether/support/mapped_file.hpp>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A mapped interface file together with the view reading it in place.
+struct CachedInterface {
+  MappedFile file;
+  InterfaceView view;
+};
+
+// A mapped AST snapshot together with the view reading it in place.
+struct CachedAst {
+  MappedFile file;
+  AstSnapshotView view;
+};
+
+// A source file's size and modification time. A check record whose stamp
+// matches the file's is taken to be for the same bytes without reading them.
+struct SourceStamp {
+  uint64_t size = 0;
+  int64_t mtime = 0;
+
+  // The empty stamp if `file` can't be examined or was modified in the last
+  // two seconds: a write within the same mtime tick could then go unseen.
+  static SourceStamp of(const std::filesystem::path& file);
+
+  bool empty() const { return size == 0 && mtime == 0; }
+  bool operator==(const SourceStamp&) const = default;
+};
+
+// What checking one module produced, so an unchanged module whose imports'
+// interfaces are also unchanged can be replayed instead of re-checked.
+struct CheckRecord {
+  struct Dependency {
+    std::string import_path;
+    // Where the `Load` is, so discovery can work from the record alone.
+    size_t line;
+    size_t column;
+    size_t offset;
+    // Interface hash of the imported module when this record was made; 0 if
+    // it was missing.
+    uint64_t interface_hash;
+  };
+
+  // A top-level function the module never calls itself.
+  struct Uncalled {
+    std::string name;
+    SourceRange range;
+  };
+
+  // An imported name the module uses, and the module it came from.
+  struct ImportedName {
+    std::string import_path;
+    std::string name;
+  };
+
+  uint64_t source_hash = 0;
+  // The file as it was when read; empty if it was too fresh to trust.
+  SourceStamp stamp{};
+  // Fingerprint of the options that affect diagnostics (e.g. -warn-unused).
+  uint64_t options_hash = 0;
+  uint64_t interface_hash = 0;
+  // Every valid `Load`, in source order.
+  std::vector<Dependency> dependencies;
+  DiagnosticList diagnostics;
+  // Filled under -warn-unused. Whether another module calls one of
+  // `uncalled` depends on modules other than this one, so those warnings
+  // are not among `diagnostics`; the loader reports them once every module
+  // is loaded.
+  std::vector<Uncalled> uncalled;
+  std::vector<ImportedName> used_imports;
+};
+
+// Directory of per-module cache files: `<dir>/<import.path>.bzi` holds the
+// module interface, `<import.path>.bzc` its check record and
+// `<import.path>.bza` its AST snapshot, each tagged with the content hash of
+// the source it was built from.
+class ModuleCache {
+public:
+  explicit ModuleCache(std::filesystem::path dir) : dir(std::move(dir)) {}
+
+  // The interface for `import_path` if one was stored for a source with
+  // `source_hash`; nullptr when missing, stale or malformed.
+  std::unique_ptr<CachedInterface> load(std::string_view import_path, uint64_t source_hash) const;
+
+  // Writes through a temporary file and a rename, so readers (including
+  // other processes) never see a partial interface. Returns false on I/O
+  // failure; the cache is best-effort.
+  bool store(std::string_view import_path, uint64_t source_hash, const ExportTable& exports) const;
+
+  // The check record for `import_path` if it was made for a source with
+  // `source_hash` under the same options; nullopt otherwise.
+  std::optional<CheckRecord> load_record(
+    std::string_view import_path,
+    uint64_t source_hash,
+    uint64_t options_hash
+  ) const;
+  // The check record for `import_path` if its source had `stamp` (which
+  // must not be empty) under the same options.
+  std::optional<CheckRecord> load_record(
+    std::string_view import_path,
+    const SourceStamp& stamp,
+    uint64_t options_hash
+  ) const;
+  bool store_record(std::string_view import_path, const CheckRecord& record) const;
+
+  // Same contract as load/store, for AST snapshots.
+  std::unique_ptr<CachedAst> load_ast(std::string_view import_path, uint64_t source_hash) const;
+  bool store_ast(std::string_view import_path, uint64_t source_hash, const Parent& root) const;
+
+  std::filesystem::path file_for(std::string_view import_path) const;
+  std::filesystem::path record_file_for(std::string_view import_path) const;
+  std::filesystem::path ast_file_for(std::string_view import_path) const;
+
+private:
+  std::filesystem::path dir;
+
+  std::optional<CheckRecord> read_record(std::string_view import_path) const;
+  bool write_atomically(const std::filesystem::path& target, std::string_view bytes) const;
+};
@@ -0,0 +1,90 @@
+#pragma once
+#include <ether/module/module_registry.hpp>
+#include <ether/symbols/symbol_types.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+// Binary module interface: what importers need from a module (its export
+// table and function signatures), laid out so a mapped file can be read in
+// place. All records are 4-byte aligned, in host byte order:
+//
+//   InterfaceHeader
+//   InterfaceSymbol[symbol_count]   sorted by name
+//   InterfaceParam[param_count]     each symbol's params are contiguous
+//   char[strings_size]              string pool referenced by InterfaceStr
+
+inline constexpr uint32_t interface_magic = 0x46495a42;  // "BZIF"
+inline constexpr uint32_t interface_version = 3;
+
+struct InterfaceStr {
+  uint32_t offset;
+  uint32_t length;
+};
+
+struct InterfaceHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t source_hash;
+  uint64_t interface_hash;
+  uint32_t symbol_count;
+  uint32_t param_count;
+  uint32_t strings_size;
+  uint32_t reserved;
+};
+
+struct InterfaceSymbol {
+  InterfaceStr name;
+  InterfaceStr type;
+  InterfaceStr return_type;
+  uint32_t first_param;
+  uint32_t param_count;
+  uint32_t line;
+  uint32_t column;
+  uint32_t offset;
+  uint32_t kind;
+};
+
+struct InterfaceParam {
+  InterfaceStr name;
+  InterfaceStr type;
+};
+
+// Serializes `exports` into the interface format.
+std::string write_interface(const ExportTable& exports, uint64_t source_hash);
+
+// Fingerprint of what importers can observe: names, kinds, types and
+// parameters, but not source positions, so edits that only move
+// declarations don't invalidate importers.
+uint64_t interface_hash(const ExportTable& exports);
+
+// Zero-copy reader over interface bytes; the bytes must outlive the view.
+class InterfaceView {
+public:
+  // Checks magic, version and the bounds of every record; nullopt if the
+  // bytes are not a well-formed interface.
+  static std::optional<InterfaceView> parse(std::span<const std::byte> bytes);
+
+  uint64_t source_hash() const { return header->source_hash; }
+  uint64_t interface_hash() const { return header->interface_hash; }
+  std::span<const InterfaceSymbol> symbols() const { return { syms, header->symbol_count }; }
+  std::span<const InterfaceParam> params(const InterfaceSymbol& sym) const {
+    return { prms + sym.first_param, sym.param_count };
+  }
+  std::string_view str(InterfaceStr s) const { return { strings + s.offset, s.length }; }
+
+  // Binary search by name; nullptr if not exported.
+  const InterfaceSymbol* find(std::string_view name) const;
+
+  // Builds a standalone SymbolAttr (e.g. for an importer's proxy).
+  SymbolAttr materialize(const InterfaceSymbol& sym) const;
+
+private:
+  const InterfaceHeader* header = nullptr;
+  const InterfaceSymbol* syms = nullptr;
+  const InterfaceParam* prms = nullptr;
+  const char* strings = nullptr;
+};
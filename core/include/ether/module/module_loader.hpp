@@ -0,0 +1,151 @@
+#pragma once
+#include <ether/module/module.hpp>
+#include <ether/module/module_cache.hpp>
+#include <ether/module/module_registry.hpp>
+#include <ether/module/pass_manager.hpp>
+#include <ether/tokens/token_types.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct LoaderOptions {
+  // Worker threads shared by parsing and resolution.
+  size_t jobs = 1;
+  // Run SymbolResolver::report_unused_symbols on every module. A function
+  // is only reported once no loaded module calls it.
+  bool warn_unused = false;
+  // Interface and check-record cache; empty disables it.
+  std::filesystem::path cache_dir{};
+  // Callers that walk every module's tree (e.g. `check -ast`) set this: the
+  // cache then also keeps AST snapshots, and replayed modules get their tree
+  // back from them. A module without a usable snapshot is checked again.
+  // The tree is kept as written: the fold pass only reports.
+  bool keep_ast = false;
+  // Last pass to run on each module (see ModuleLoader::get_passes()); empty
+  // runs them all, as does a name get_passes() does not contain. A run that
+  // stops early neither reads nor writes the cache.
+  std::string stop_after{};
+  // Record PassStats for every module.
+  bool time_passes = false;
+  // Applied to every module's diagnostics. A module that reaches a limit is
+  // not cached, so the next run reports it in full under other limits.
+  DiagnosticLimits diagnostic_limits{};
+};
+
+struct LoadedModule {
+  std::string import_path;
+  std::unique_ptr<Module> module;
+  // Replayed from the cache: its diagnostics come from the previous check
+  // and it was never parsed or resolved this run. Its AST is empty unless
+  // LoaderOptions::keep_ast is set, and its source is only read if it has
+  // diagnostics to show.
+  bool from_cache = false;
+};
+
+// Loads a project: starting from the entry files, follows `Load` directives
+// to files under `root` (`a.b` -> `<root>/a/b.bz`), builds the import DAG from
+// import-only pre-scans, then runs the passes (lex, parse, resolve,
+// type-check, fold) over each module as soon as every module it imports has
+// published its exports to the registry. Independent modules run in
+// parallel.
+//
+// Missing modules and import cycles are reported at the offending `Load` in
+// the importing module; the resolver then skips those imports.
+//
+// With a cache directory, each checked module stores its interface and a
+// check record (source hash, size and mtime, imported interface hashes,
+// diagnostics). A later run takes an unchanged module's imports from its
+// record instead of scanning it, and if every import's interface hash still
+// matches, replays the recorded diagnostics and publishes the mapped
+// interface instead of parsing and resolving it. A file whose size and
+// mtime match its record is not even read.
+class ModuleLoader {
+public:
+  // An empty `root` is the current directory.
+  explicit ModuleLoader(std::filesystem::path root, LoaderOptions opts = {});
+
+  ModuleLoader(const ModuleLoader&) = delete;
+  ModuleLoader& operator=(const ModuleLoader&) = delete;
+
+  // Registers `file` as a root of the import graph. Returns false if it is
+  // not a regular file.
+  bool add_entry(const std::filesystem::path& file);
+
+  // Discovers, parses and resolves every reachable module.
+  void load();
+
+  // Entries first, then imports in discovery order.
+  const std::vector<LoadedModule>& modules() const { return loaded; }
+  Module* find(std::string_view import_path) const;
+
+  const ModuleRegistry& get_registry() const { return registry; }
+  const PassManager& get_passes() const { return passes; }
+  const std::filesystem::path& get_root() const { return root; }
+
+private:
+  static constexpr size_t npos = static_cast<size_t>(-1);
+
+  struct Import {
+    std::string path;
+    Token token;
+    // Index into `loaded`, or npos once the edge has been cut.
+    size_t target;
+  };
+
+  struct Node {
+    std::filesystem::path file;
+    uint64_t source_hash = 0;
+    SourceStamp stamp{};
+    // False while the module's source is taken from its record's stamp.
+    bool source_read = false;
+    // Set once the module has been resolved or replayed (cache only).
+    uint64_t interface_hash = 0;
+    std::optional<CheckRecord> record;
+    std::unique_ptr<CachedInterface> cached;
+    // Valid `Load`s in source order, found or not.
+    std::vector<Token> import_tokens;
+    std::vector<Import> imports;
+    // Import paths the resolver must skip because they were already
+    // reported (missing file, cycle).
+    std::vector<std::string> broken;
+    // Under warn_unused (see CheckRecord::uncalled).
+    std::vector<CheckRecord::Uncalled> uncalled;
+    std::vector<CheckRecord::ImportedName> used_imports;
+  };
+
+  std::filesystem::path root;
+  LoaderOptions options;
+  std::optional<ModuleCache> cache;
+  uint64_t options_hash = 0;
+  ModuleRegistry registry;
+  PassManager passes;
+  // Threads for one module's function bodies and type-check components.
+  size_t body_jobs = 1;
+
+  std::vector<LoadedModule> loaded;
+  std::vector<Node> graph;
+  std::unordered_map<std::string, size_t> by_path;
+  std::unordered_map<const Module*, size_t> index_of;
+
+  size_t add_module(std::string import_path, const std::filesystem::path& file);
+  void discover();
+  void scan_one(size_t index, std::vector<Token>& imports);
+  void read_source(size_t index);
+  void collect_imports(size_t index, std::vector<Token> tokens);
+  void break_cycles();
+  void resolve_all();
+  void resolve_one(size_t index);
+  void poison_broken_imports(Module& mod);
+  void resolve_symbols(Module& mod);
+  bool try_replay(size_t index);
+  void store_in_cache(size_t index);
+  void report_uncalled_functions();
+
+  void report_import(size_t index, const Token& at, std::string message);
+};
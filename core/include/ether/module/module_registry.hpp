@@ -0,0 +1,81 @@
+#pragma once
+#include <ether/symbols/symbol_types.hpp>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using ExportTable = std::unordered_map<std::string, SymbolAttr*>;
+
+class InterfaceView;
+
+// What a published module offers importers: the live symbols of a module
+// resolved in this run, or a cached interface (see module_interface.hpp).
+class ModuleExports {
+public:
+  explicit ModuleExports(ExportTable table) : table(std::move(table)) {}
+  explicit ModuleExports(const InterfaceView& view) : view(&view) {}
+
+  // A copy of the exported symbol `name` for an importer's proxy; nullopt if
+  // the module doesn't export it.
+  std::optional<SymbolAttr> find(const std::string& name) const;
+
+  // Live symbols; empty for cached interfaces.
+  const ExportTable& symbols() const { return table; }
+  bool is_cached() const { return view != nullptr; }
+  size_t size() const;
+
+private:
+  ExportTable table;
+  const InterfaceView* view = nullptr;
+};
+
+// Shared map from dotted import path (`benzene.list`) to a module's exports,
+// used to resolve `Load`ed names across modules.
+//
+// Entries are insert-only and immutable once published, so lookups walk
+// atomic bucket chains without taking any lock; only publishers serialize.
+// A module must be published only after its symbols are final, and the
+// registry must not outlive the modules (or cached interfaces) it points at.
+class ModuleRegistry {
+public:
+  explicit ModuleRegistry(size_t bucket_count = 1024);
+
+  ModuleRegistry(const ModuleRegistry&) = delete;
+  ModuleRegistry& operator=(const ModuleRegistry&) = delete;
+
+  // Returns false (and leaves the registry unchanged) if `path` is already
+  // published.
+  bool publish(std::string path, ExportTable exports);
+  // Publishes a cached interface; `view` must outlive the registry.
+  bool publish_interface(std::string path, const InterfaceView& view);
+
+  // nullptr until `path` has been published. Safe to call concurrently with
+  // publish() from any thread.
+  const ModuleExports* find(std::string_view path) const;
+
+  size_t size() const { return published.load(std::memory_order_acquire); }
+
+private:
+  struct Entry {
+    std::string path;
+    ModuleExports exports;
+    const Entry* next;
+  };
+
+  bool publish_entry(std::string path, ModuleExports exports);
+
+  std::atomic<const Entry*>& bucket_for(std::string_view path) const;
+
+  size_t mask;
+  std::unique_ptr<std::atomic<const Entry*>[]> buckets;
+  std::atomic<size_t> published{0};
+
+  std::mutex publish_mutex;
+  std::vector<std::unique_ptr<Entry>> entries;
+};
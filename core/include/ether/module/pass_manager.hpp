@@ -0,0 +1,73 @@
+#pragma once
+#include <ether/module/module.hpp>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iosfwd>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// What one pass cost, summed over the modules it ran on.
+struct PassStats {
+  std::string name;
+  size_t modules = 0;
+  // Time inside the pass. Modules checked in parallel add up, so with
+  // several jobs this can exceed the run's own wall time.
+  std::chrono::nanoseconds wall{};
+  // Heap allocations made on the module's thread during the pass (see
+  // thread_alloc_counts); threads a pass fans out to are not counted.
+  size_t allocations = 0;
+  size_t allocated_bytes = 0;
+  // AST nodes in the module after the pass.
+  size_t nodes = 0;
+};
+
+// The per-module pipeline: an ordered list of named passes run over each
+// module, optionally stopping after a given one and recording PassStats.
+// ModuleLoader builds the standard one (lex, parse, resolve, type-check,
+// fold); tests and tools can assemble their own.
+class PassManager {
+public:
+  using PassFn = std::function<void(Module&)>;
+
+  // Passes run in the order they were added.
+  void add(std::string name, PassFn run);
+
+  bool contains(std::string_view name) const;
+  std::vector<std::string> names() const;
+
+  // Skips every pass after `name`. Returns false, changing nothing, if
+  // there is no such pass.
+  bool stop_after(std::string_view name);
+  // Whether run() gets to the pass named `name`.
+  bool runs(std::string_view name) const;
+
+  // Records PassStats from now on; off by default, since counting nodes
+  // walks the tree after every pass.
+  void enable_stats() { this->record = true; }
+
+  // Runs the passes over `mod`. May be called for several modules at once.
+  void run(Module& mod);
+
+  std::vector<PassStats> stats() const;
+  // A table of stats(), one row per pass that ran, plus a total.
+  void print_stats(std::ostream& out = std::cout) const;
+
+private:
+  struct Pass {
+    std::string name;
+    PassFn run;
+  };
+
+  std::vector<Pass> passes;
+  // Index one past the last pass to run.
+  std::optional<size_t> last;
+  bool record = false;
+
+  mutable std::mutex stats_mutex;
+  std::vector<PassStats> totals;
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <ether/diagnostics/diagnostic.hpp>
+#include <ether/tokens/token_types.hpp>
+#include <cstddef>
+#include <string>
+
+// Replaces `length` bytes at byte `offset` of a module's source with `text`.
+struct TextEdit {
+  size_t offset = 0;
+  size_t length = 0;
+  std::string text;
+};
+
+// Where an edit moved the unchanged text after it. Positions at or after old
+// byte `offset` move by `delta` bytes and `lines` lines; those still on old
+// line `line` also move `columns` columns.
+struct SourceShift {
+  size_t offset = 0;
+  size_t line = 0;
+  std::ptrdiff_t delta = 0;
+  std::ptrdiff_t lines = 0;
+  std::ptrdiff_t columns = 0;
+
+  bool is_identity() const { return delta == 0 && lines == 0 && columns == 0; }
+
+  void apply(Token& tok) const {
+    if (tok.offset < this->offset) return;
+    tok.offset += this->delta;
+    if (tok.line_number == this->line) tok.column_number += this->columns;
+    tok.line_number += this->lines;
+  }
+
+  void apply(SourceRange& range) const {
+    if (!range.has_location() || range.begin < this->offset) return;
+    range.begin += this->delta;
+    range.end += this->delta;
+  }
+};
+
+// What Module::apply_edit had to redo.
+struct EditStats {
+  // Top-level items that were parsed again.
+  size_t items_reparsed = 0;
+  // The edit changed top-level declarations, so every item was resolved
+  // again rather than only the reparsed ones.
+  bool resolved_module = false;
+  // Top-level declarations whose types were inferred again; the others
+  // kept theirs.
+  size_t declarations_inferred = 0;
+  // The check was cancelled; the module holds the new text, unchecked.
+  bool cancelled = false;
+};
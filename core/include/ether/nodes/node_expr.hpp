@@ -1,4 +1,6 @@
 #pragma once
+#include <ether/nodes/node_visitor.hpp>
+#include <ether/support/cancellation.hpp>
 #include <ether/symbols/symbol_types.hpp>
 #include <ether/tokens/token_types.hpp>
 #include <memory>
@@ -18,7 +20,7 @@ using NDPtr = std::unique_ptr<Node>;
 struct FuncParam {
   Token param_token;
   std::optional<Token> param_type;
-  SymbolAttr *param_sym;
+  SymbolAttr *param_sym = nullptr;
 };
 
 struct NDLiteral : Node {
@@ -51,7 +53,7 @@ struct NDImportDirective : Node {
 };
 
 struct NDIdentifier : Node {
-  SymbolAttr *identifier_symbol;
+  SymbolAttr *identifier_symbol = nullptr;
   Token identifier;
   void accept(Visitor &) override;
 };
@@ -82,7 +84,7 @@ struct NDCallChain : Node {
 
 struct NDFuncDeclExpr : Node {
   Token func_identifier;
-  SymbolAttr *func_sym;
+  SymbolAttr *func_sym = nullptr;
   std::optional<Token> return_type;
   std::vector<FuncParam> func_params;
   std::vector<NDPtr> func_body;
@@ -100,9 +102,12 @@ struct NDCaseExpr : Node {
   void accept(Visitor &) override;
 };
 
+class TreePass;
+
 struct Parent {
   std::vector<NDPtr> children;
   std::vector<Visitor *> visitors;
+  std::vector<TreePass *> passes;
 
   Parent() = default;
 
@@ -113,12 +118,9 @@ struct Parent {
   Parent &operator=(Parent &&) = default;
 
   void add_visitor(Visitor &v) { this->visitors.push_back(&v); }
+  void add_pass(TreePass &p) { this->passes.push_back(&p); }
 
-  void apply_visitors() {
-    for (auto &node : children) {
-      for (auto &visitor : visitors) {
-        node->accept(*visitor);
-      }
-    }
-  }
+  // Runs each visitor over every top-level node, then the passes in shared
+  // walks (see run_tree_passes). Returns false if `cancel` fired first.
+  bool apply_visitors(const CancellationToken &cancel = {});
 };
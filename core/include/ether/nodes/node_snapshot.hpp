@@ -0,0 +1,128 @@
+#pragma once
+#include <ether/nodes/node_expr.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+// Binary snapshot of a module's AST: node kinds, tokens (with positions) and
+// child links, laid out so a mapped file can be walked in place. Symbol
+// pointers are not kept; a materialized tree looks like fresh parser output
+// plus the poison flags it had when written. All records are 4-byte aligned,
+// in host byte order:
+//
+//   SnapshotHeader
+//   SnapshotNode[node_count]     preorder: children come after their parent
+//   SnapshotToken[token_count]
+//   uint32_t[link_count]         child and token lists named by SnapshotRange
+//   char[strings_size]           string pool referenced by SnapshotStr
+
+inline constexpr uint32_t ast_snapshot_magic = 0x53415a42;  // "BZAS"
+inline constexpr uint32_t ast_snapshot_version = 1;
+
+// An absent optional token or null child in a link list or token field.
+inline constexpr uint32_t snapshot_none = UINT32_MAX;
+
+// What each kind keeps in `token`, `children` and `tokens`:
+//
+//   Literal, ImportDirective, Identifier   token
+//   UnaryExpr     token = op (may be none)    children {rhs}
+//   BinaryExpr    token = op                  children {lhs, rhs}
+//   ScopeExpr     token = open brace          children = expressions
+//   LetBindExpr                               children {identifier, value}
+//   ConstExpr                                 children {identifier, literal}
+//   CallExpr                                  children {callee, args...}
+//   CallChain     token = start               children = calls
+//   FuncDecl      token = name                children = body
+//                 tokens {return type, then a (name, type) pair per param}
+//   CaseExpr      token = keyword             children {conditions..., branches...}
+//   CaseBranch                                children {result, pattern...}
+enum class SnapshotKind : uint16_t {
+  Literal,
+  ImportDirective,
+  Identifier,
+  UnaryExpr,
+  BinaryExpr,
+  ScopeExpr,
+  LetBindExpr,
+  ConstExpr,
+  CallExpr,
+  CallChain,
+  FuncDecl,
+  CaseExpr,
+  CaseBranch,
+};
+
+inline constexpr uint16_t snapshot_poisoned = 1;
+
+struct SnapshotStr {
+  uint32_t offset;
+  uint32_t length;
+};
+
+struct SnapshotRange {
+  uint32_t first;
+  uint32_t count;
+};
+
+struct SnapshotHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t source_hash;
+  uint32_t node_count;
+  uint32_t token_count;
+  uint32_t link_count;
+  uint32_t strings_size;
+  // Top-level items, as a link list.
+  SnapshotRange roots;
+};
+
+struct SnapshotNode {
+  uint16_t kind;
+  uint16_t flags;
+  uint32_t token;
+  // Node::type, the type annotation.
+  uint32_t type;
+  SnapshotRange children;
+  SnapshotRange tokens;
+};
+
+struct SnapshotToken {
+  uint32_t type;
+  uint32_t line;
+  uint32_t column;
+  uint32_t offset;
+  SnapshotStr value;
+};
+
+// Serializes the tree under `root` into the snapshot format.
+std::string write_ast_snapshot(const Parent& root, uint64_t source_hash);
+
+// Zero-copy reader over snapshot bytes; the bytes must outlive the view.
+class AstSnapshotView {
+public:
+  // Checks magic, version, the bounds of every record and each node's shape,
+  // so walking or materializing a parsed view can't go out of bounds;
+  // nullopt if the bytes are not a well-formed snapshot.
+  static std::optional<AstSnapshotView> parse(std::span<const std::byte> bytes);
+
+  uint64_t source_hash() const { return header->source_hash; }
+  std::span<const SnapshotNode> nodes() const { return { node_records, header->node_count }; }
+  std::span<const SnapshotToken> tokens() const { return { token_records, header->token_count }; }
+  std::span<const uint32_t> links(SnapshotRange r) const { return { link_records + r.first, r.count }; }
+  std::span<const uint32_t> roots() const { return links(header->roots); }
+  std::string_view str(SnapshotStr s) const { return { strings + s.offset, s.length }; }
+
+  // Rebuilds an owning tree equal to the one that was written.
+  Parent materialize() const;
+  Token token(uint32_t index) const;
+
+private:
+  const SnapshotHeader* header = nullptr;
+  const SnapshotNode* node_records = nullptr;
+  const SnapshotToken* token_records = nullptr;
+  const uint32_t* link_records = nullptr;
+  const char* strings = nullptr;
+};
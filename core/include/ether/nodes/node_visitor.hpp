@@ -12,11 +12,17 @@ struct NDCaseExpr;
 struct NDBinaryExpr;
 struct NDUnaryExpr;
 struct NDScopeExpr;
+struct Parent;
 
 class Visitor {
 public:
   virtual ~Visitor() = default;
 
+  // Called once with the module root before any top-level node is visited.
+  // Passes that need a cheap look at the whole module first (e.g. hoisting
+  // top-level declarations) override this; it must not walk into bodies.
+  virtual void begin_module(Parent&) {}
+
   virtual void visit(NDLiteral&) = 0;
   virtual void visit(NDImportDirective&) = 0;
   virtual void visit(NDIdentifier&) = 0;
@@ -0,0 +1,66 @@
+#pragma once
+#include <ether/nodes/node_expr.hpp>
+#include <ether/support/cancellation.hpp>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// A pass over the whole tree that does not walk it itself. Passes attached
+// to a Parent share one preorder walk: for every node each pass's enter()
+// runs, then the node's children are walked, then each pass's exit() in
+// reverse order. A pass overrides only the hooks it needs: the typed ones,
+// or enter(Node&)/exit(Node&) for every kind at once.
+//
+// A pass that needs another to have seen the whole module first names it
+// in after(); it then runs in a later walk, whichever of the two was
+// attached first. Names no attached pass has are ignored.
+class TreePass {
+public:
+  virtual ~TreePass() = default;
+
+  virtual std::string_view name() const = 0;
+  virtual std::vector<std::string_view> after() const { return {}; }
+
+  virtual void begin_module(Parent&) {}
+  virtual void end_module(Parent&) {}
+
+  // What the typed hooks below fall back to.
+  virtual void enter(Node&) {}
+  virtual void exit(Node&) {}
+
+  virtual void enter(NDLiteral& n) { this->enter(static_cast<Node&>(n)); }
+  virtual void enter(NDImportDirective& n) { this->enter(static_cast<Node&>(n)); }
+  virtual void enter(NDIdentifier& n) { this->enter(static_cast<Node&>(n)); }
+  virtual void enter(NDLetBindExpr& n) { this->enter(static_cast<Node&>(n)); }
+  virtual void enter(NDConstExpr& n) { this->enter(static_cast<Node&>(n)); }
+  virtual void enter(NDCallExpr& n) { this->enter(static_cast<Node&>(n)); }
+  virtual void enter(NDCallChain& n) { this->enter(static_cast<Node&>(n)); }
+  virtual void enter(NDFuncDeclExpr& n) { this->enter(static_cast<Node&>(n)); }
+  virtual void enter(NDCaseExpr& n) { this->enter(static_cast<Node&>(n)); }
+  virtual void enter(NDBinaryExpr& n) { this->enter(static_cast<Node&>(n)); }
+  virtual void enter(NDUnaryExpr& n) { this->enter(static_cast<Node&>(n)); }
+  virtual void enter(NDScopeExpr& n) { this->enter(static_cast<Node&>(n)); }
+
+  virtual void exit(NDLiteral& n) { this->exit(static_cast<Node&>(n)); }
+  virtual void exit(NDImportDirective& n) { this->exit(static_cast<Node&>(n)); }
+  virtual void exit(NDIdentifier& n) { this->exit(static_cast<Node&>(n)); }
+  virtual void exit(NDLetBindExpr& n) { this->exit(static_cast<Node&>(n)); }
+  virtual void exit(NDConstExpr& n) { this->exit(static_cast<Node&>(n)); }
+  virtual void exit(NDCallExpr& n) { this->exit(static_cast<Node&>(n)); }
+  virtual void exit(NDCallChain& n) { this->exit(static_cast<Node&>(n)); }
+  virtual void exit(NDFuncDeclExpr& n) { this->exit(static_cast<Node&>(n)); }
+  virtual void exit(NDCaseExpr& n) { this->exit(static_cast<Node&>(n)); }
+  virtual void exit(NDBinaryExpr& n) { this->exit(static_cast<Node&>(n)); }
+  virtual void exit(NDUnaryExpr& n) { this->exit(static_cast<Node&>(n)); }
+  virtual void exit(NDScopeExpr& n) { this->exit(static_cast<Node&>(n)); }
+};
+
+// Which walk each of `passes` runs in: a pass runs one walk after the
+// latest of the passes it names in after(). Throws std::invalid_argument if
+// passes name each other in a cycle, which no order of walks satisfies.
+std::vector<size_t> schedule_tree_passes(const std::vector<TreePass*>& passes);
+
+// Runs `passes` over `root` in as few walks as their after() allows.
+// Returns false if `cancel` fired first; it is polled between top-level
+// items.
+bool run_tree_passes(Parent& root, const std::vector<TreePass*>& passes, const CancellationToken& cancel = {});
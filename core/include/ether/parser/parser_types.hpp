@@ -5,9 +5,21 @@
 #include <cstdio>
 #include <functional>
 #include <string>
+#include <utility>
 #include <ether/nodes/node_expr.hpp>
 #include <ether/tokens/token_types.hpp>
 #include <ether/diagnostics/diagnostic_eng.hpp>
+#include <ether/support/cancellation.hpp>
+
+// Where run_parser started a top-level item.
+struct TopLevelMark {
+  // Index of the item's first token.
+  size_t token;
+  // Diagnostics reported before the item started.
+  size_t diagnostics;
+  // ParserState::high_water when the item started.
+  size_t high_water;
+};
 
 struct ParserState {
   ParserState(DiagnosticEngine& eng)
@@ -19,6 +31,22 @@ struct ParserState {
 
   size_t pos{};
 
+  // Highest token index any parser has looked at, and whether one tried to
+  // look past the last token. Module::apply_edit uses them to tell which
+  // tokens an item's parse depended on.
+  size_t high_water{};
+  bool reached_end = false;
+
+  // Filled by run_parser, one per top-level item it produced.
+  std::vector<TopLevelMark> top_level;
+
+  // When set, run_parser stops before a top-level item starting at a token
+  // for which it returns true.
+  std::function<bool(const Token&)> resync;
+
+  // run_parser stops before the next top-level item once this fires.
+  CancellationToken cancel;
+
   bool logs_on = false;
 
   void activate_logs() {
@@ -30,15 +58,18 @@ struct ParserState {
   }
 
   bool is_at_end() {
-    return pos >= tokens.size();
+    if (pos < tokens.size()) return false;
+    reached_end = true;
+    return true;
   }
 
   void set_state(std::vector<Token> tokens) {
-    this->tokens = tokens;
+    this->tokens = std::move(tokens);
   }
 
   std::optional<Token> peek() { 
     if (is_at_end()) return std::nullopt;
+    if (pos > high_water) high_water = pos;
     return tokens[pos];
   }
 
@@ -49,7 +80,10 @@ struct ParserState {
   }
 
   Token advance() {
-    if (!this->is_at_end()) return this->tokens[pos++];
+    if (!this->is_at_end()) {
+      if (pos > high_water) high_water = pos;
+      return this->tokens[pos++];
+    }
     return tokens.back();
   }
 
@@ -208,8 +242,7 @@ std::optional<Token> inline expect(
   }
 
   auto diag = Diagnostic();
-  diag.location.line = tok->line_number;
-  diag.location.column = tok->column_number;
+  diag.range = token_range(*tok);
   diag.phase = DiagnosticPhase::Parser;
   diag.level = DiagnosticLevel::Fail;
   diag.message = message;
@@ -231,8 +264,7 @@ PResult<T> inline expect_wp(
     auto tok = state.peek();
 
     auto diag = Diagnostic();
-    diag.location.line = tok->line_number;
-    diag.location.column = tok->column_number;
+    diag.range = token_range(*tok);
     diag.phase = DiagnosticPhase::Parser;
     diag.level = DiagnosticLevel::Fail;
     diag.message = message;
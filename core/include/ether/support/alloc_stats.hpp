@@ -0,0 +1,20 @@
+#pragma once
+#include <cstddef>
+
+// Heap allocations made through operator new on the calling thread since it
+// started. Only programs that link ether_alloc_counter, which replaces the
+// global operator new, count them: the CLI and the tests when built with
+// ETHER_COUNT_ALLOCATIONS (the default). Elsewhere both stay 0 and
+// ether_core leaves the embedder's allocator alone.
+struct AllocCounts {
+  size_t allocations = 0;
+  size_t bytes = 0;
+};
+
+AllocCounts thread_alloc_counts();
+// Whether this program counts allocations at all.
+bool alloc_counting_enabled();
+
+// For the replacement operator new.
+void enable_alloc_counting();
+void count_allocation(size_t bytes);
@@ -0,0 +1,35 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <optional>
+#include <stop_token>
+#include <utility>
+
+// Asks a long front-end pass to give up: fires once its stop_source is asked
+// to stop or its deadline passes, and stays fired. Passes poll it between
+// top-level items (the lexer every few hundred tokens) and return early
+// with partial results, which the caller must throw away. A default token
+// never fires and costs one branch per poll.
+class CancellationToken {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  CancellationToken() = default;
+  explicit CancellationToken(std::stop_token stop) : stop(std::move(stop)) {}
+
+  // This token, also firing at `at` (or at its own deadline if earlier).
+  CancellationToken with_deadline(Clock::time_point at) const {
+    auto out = *this;
+    out.deadline = this->deadline ? std::min(*this->deadline, at) : at;
+    return out;
+  }
+
+  bool is_cancelled() const {
+    if (this->stop.stop_requested()) return true;
+    return this->deadline && Clock::now() >= *this->deadline;
+  }
+
+private:
+  std::stop_token stop;
+  std::optional<Clock::time_point> deadline;
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs `fn(i)` for every node of a DAG on up to `jobs` threads, starting each
+// node as soon as all of its prerequisites have finished rather than in
+// whole-level waves. `dependents[i]` lists the nodes that wait on i and
+// `pending[i]` is how many prerequisites i has. Ready nodes start in index
+// order, so jobs <= 1 gives a deterministic topological order.
+//
+// Nodes that sit on (or behind) a cycle never become ready and are skipped;
+// callers are expected to break cycles first.
+template <typename F>
+void run_dag(
+  const std::vector<std::vector<size_t>>& dependents,
+  std::vector<size_t> pending,
+  size_t jobs,
+  F&& fn
+) {
+  const size_t n = pending.size();
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<size_t> ready;
+  size_t finished = 0;
+  size_t running = 0;
+
+  for (size_t i = 0; i < n; ++i) {
+    if (pending[i] == 0) ready.push_back(i);
+  }
+
+  auto worker = [&]() {
+    std::unique_lock lock(mutex);
+    while (true) {
+      cv.wait(lock, [&]() {
+        return !ready.empty() || finished == n || running == 0;
+      });
+      if (ready.empty()) return;
+
+      size_t node = ready.front();
+      ready.pop_front();
+      ++running;
+      lock.unlock();
+
+      fn(node);
+
+      lock.lock();
+      --running;
+      ++finished;
+      for (size_t d : dependents[node]) {
+        if (--pending[d] == 0) ready.push_back(d);
+      }
+      cv.notify_all();
+    }
+  };
+
+  std::vector<std::jthread> threads;
+  for (size_t t = 1; t < jobs && t < n; ++t) threads.emplace_back(worker);
+  worker();
+}
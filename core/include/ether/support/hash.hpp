@@ -0,0 +1,78 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// Fast non-cryptographic 64-bit hashing for content fingerprints (module
+// caches, incremental checks). Multiply-fold mixing in the wyhash family:
+// 16 bytes per round, good avalanche, not stable across major versions of
+// this header — persisted hashes must be stored next to a format version.
+
+inline uint64_t hash_mix(uint64_t a, uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+  __uint128_t r = static_cast<__uint128_t>(a) * b;
+  return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+#else
+  uint64_t a_lo = a & 0xffffffffu, a_hi = a >> 32;
+  uint64_t b_lo = b & 0xffffffffu, b_hi = b >> 32;
+  uint64_t lo_lo = a_lo * b_lo, hi_lo = a_hi * b_lo;
+  uint64_t lo_hi = a_lo * b_hi, hi_hi = a_hi * b_hi;
+  uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffffu) + lo_hi;
+  uint64_t lo = (cross << 32) | (lo_lo & 0xffffffffu);
+  uint64_t hi = hi_hi + (hi_lo >> 32) + (cross >> 32);
+  return lo ^ hi;
+#endif
+}
+
+namespace hash_detail {
+inline constexpr uint64_t k0 = 0xa0761d6478bd642full;
+inline constexpr uint64_t k1 = 0xe7037ed1a0b428dbull;
+inline constexpr uint64_t k2 = 0x8ebc6af09c88c6e3ull;
+
+inline uint64_t read64(const char* p) {
+  uint64_t v;
+  std::memcpy(&v, p, sizeof v);
+  return v;
+}
+
+inline uint64_t read32(const char* p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof v);
+  return v;
+}
+}
+
+inline uint64_t hash_bytes(std::string_view data, uint64_t seed = 0) {
+  using namespace hash_detail;
+
+  const char* p = data.data();
+  size_t n = data.size();
+  uint64_t h = seed ^ hash_mix(seed ^ k0, k1);
+
+  while (n > 16) {
+    h = hash_mix(read64(p) ^ k1, read64(p + 8) ^ h);
+    p += 16;
+    n -= 16;
+  }
+
+  uint64_t a = 0, b = 0;
+  if (n >= 8) {
+    a = read64(p);
+    b = read64(p + n - 8);
+  } else if (n >= 4) {
+    a = read32(p);
+    b = read32(p + n - 4);
+  } else if (n > 0) {
+    a = (static_cast<uint64_t>(static_cast<unsigned char>(p[0])) << 16)
+      | (static_cast<uint64_t>(static_cast<unsigned char>(p[n >> 1])) << 8)
+      | static_cast<uint64_t>(static_cast<unsigned char>(p[n - 1]));
+  }
+
+  return hash_mix(k2 ^ data.size(), hash_mix(a ^ k1, b ^ h));
+}
+
+// Order-dependent combination of two hashes.
+inline uint64_t hash_combine(uint64_t seed, uint64_t value) {
+  return hash_mix(seed ^ hash_detail::k0, value ^ hash_detail::k2);
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+// 1-based line and byte column.
+struct SourcePosition {
+  size_t line;
+  size_t column;
+};
+
+// Where each line of a text starts, for turning byte offsets into lines and
+// columns. Does not keep the text.
+class LineIndex {
+public:
+  LineIndex() = default;
+  explicit LineIndex(std::string_view text);
+
+  size_t line_count() const { return this->starts.size(); }
+  // Offsets past the end land on the last line.
+  SourcePosition position(size_t offset) const;
+  // Line `line` (1-based) of `text` without its line break.
+  std::string_view line(std::string_view text, size_t line) const;
+
+private:
+  std::vector<size_t> starts{ 0 };
+};
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+// Read-only memory map of a whole file. A file that can't be opened (or is
+// empty) gives a closed map with no bytes.
+class MappedFile {
+public:
+  MappedFile() = default;
+  explicit MappedFile(const std::filesystem::path& file);
+  ~MappedFile();
+
+  MappedFile(MappedFile&& other) noexcept;
+  MappedFile& operator=(MappedFile&& other) noexcept;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  bool is_open() const { return data != nullptr; }
+  std::span<const std::byte> bytes() const { return { data, length }; }
+
+private:
+  const std::byte* data = nullptr;
+  size_t length = 0;
+
+  void close();
+};
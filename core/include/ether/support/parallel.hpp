@@ -0,0 +1,39 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Calls `fn(i)` for every i in [0, count) using up to `jobs` threads. Indices
+// are handed out dynamically, so uneven work still balances; callers that
+// need deterministic output should write results into per-index slots and
+// combine them afterwards. With jobs <= 1 everything runs on the caller.
+template <typename F>
+void parallel_for(size_t count, size_t jobs, F&& fn) {
+  if (jobs <= 1 || count <= 1) {
+    for (size_t i = 0; i < count; ++i) fn(i);
+    return;
+  }
+
+  std::atomic<size_t> next{0};
+  auto worker = [&]() {
+    for (size_t i = next.fetch_add(1, std::memory_order_relaxed);
+         i < count;
+         i = next.fetch_add(1, std::memory_order_relaxed)) {
+      fn(i);
+    }
+  };
+
+  size_t n_threads = std::min(jobs, count);
+  std::vector<std::jthread> threads;
+  threads.reserve(n_threads - 1);
+  for (size_t t = 1; t < n_threads; ++t) threads.emplace_back(worker);
+  worker();
+}
+
+// Number of worker threads to use when the caller asked for "all cores".
+inline size_t hardware_jobs() {
+  auto n = std::thread::hardware_concurrency();
+  return n == 0 ? 1 : n;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads running submitted tasks in submission order
+// (several at a time). For long-lived owners such as the language server;
+// one-shot fan-out should use parallel_for or run_dag instead.
+//
+// Destroying the pool drops tasks that have not started and waits for the
+// running ones.
+class TaskPool {
+public:
+  explicit TaskPool(size_t threads) {
+    if (threads == 0) threads = 1;
+    for (size_t t = 0; t < threads; ++t) {
+      this->workers.emplace_back([this] { this->work(); });
+    }
+  }
+
+  ~TaskPool() {
+    {
+      std::lock_guard lock(this->mutex);
+      this->stopping = true;
+      this->queue.clear();
+    }
+    this->wake.notify_all();
+  }
+
+  TaskPool(const TaskPool&) = delete;
+  TaskPool& operator=(const TaskPool&) = delete;
+
+  void submit(std::function<void()> task) {
+    {
+      std::lock_guard lock(this->mutex);
+      this->queue.push_back(std::move(task));
+    }
+    this->wake.notify_one();
+  }
+
+  // Blocks until every submitted task, including ones submitted by tasks
+  // while waiting, has finished.
+  void wait_idle() {
+    std::unique_lock lock(this->mutex);
+    this->idle.wait(lock, [this] { return this->queue.empty() && this->running == 0; });
+  }
+
+private:
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable idle;
+  std::deque<std::function<void()>> queue;
+  size_t running = 0;
+  bool stopping = false;
+  // Last member: its threads must stop before the state above goes away.
+  std::vector<std::jthread> workers;
+
+  void work() {
+    std::unique_lock lock(this->mutex);
+    while (true) {
+      this->wake.wait(lock, [this] { return this->stopping || !this->queue.empty(); });
+      if (this->stopping) return;
+
+      auto task = std::move(this->queue.front());
+      this->queue.pop_front();
+      ++this->running;
+      lock.unlock();
+
+      task();
+
+      lock.lock();
+      --this->running;
+      if (this->queue.empty() && this->running == 0) this->idle.notify_all();
+    }
+  }
+};
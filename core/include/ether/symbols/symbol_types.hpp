@@ -1,9 +1,11 @@
 #pragma once
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <variant>
 #include <vector>
+#include <ether/symbols/type_table.hpp>
 #include <ether/tokens/token_types.hpp>
 
 enum class SymbolKind {
@@ -18,11 +20,9 @@ enum class SymbolKind {
 
 /* Symbol Data structs. Used in storing information about certain symbols*/
 struct TypeData {
-  // We should store other information here. For instance,
-  // user defined types should be referenced in definitions
-  // somewhere. Perhaps we will keep a table that refrences,
-  // user generated types.
-  std::string type_name;
+  // What the annotation names, in TypeTable::shared(); unknown if there is
+  // none.
+  TypeId type = TypeTable::unknown;
 };
 
 struct FuncParamData {
@@ -52,8 +52,10 @@ using SymbolData = std::variant<
   FuncParamData
 >;
 
+// The symbol's type in TypeTable::shared(): what its annotations say once
+// resolved, what was inferred once type-checked.
 struct TypeInfo {
-  std::string type_name{};
+  TypeId type = TypeTable::unknown;
 };
 
 enum class SymbolErrorType {
@@ -74,6 +76,10 @@ struct SymbolAttr {
   Token symbol_token;
   SymbolData symbol_data;
   std::vector<SymbolError> symbol_errors{};
+  // Dense index of this symbol within its module's SymbolStorage.
+  uint32_t id = 0;
+  // Number of resolved references, maintained by the SymbolResolver.
+  uint32_t ref_count = 0;
 };
 
 // Scope visibility maps name -> non-owning pointer into the module's
@@ -91,12 +97,46 @@ public:
   SymbolAttr* allocate(SymbolAttr&& attr) {
     auto owned = std::make_unique<SymbolAttr>(std::move(attr));
     SymbolAttr* raw = owned.get();
+    raw->id = static_cast<uint32_t>(storage.size());
     storage.push_back(std::move(owned));
     return raw;
   }
 
   size_t size() const { return storage.size(); }
 
+  // Visits symbols in allocation order.
+  template <typename F>
+  void for_each(F&& fn) const {
+    for (const auto& owned : storage) fn(*owned);
+  }
+
+  template <typename F>
+  void for_each(F&& fn) {
+    for (auto& owned : storage) fn(*owned);
+  }
+
+  // Moves every symbol owned by `other` into this arena. Pointers previously
+  // handed out by `other` stay valid; their ids are renumbered to stay dense.
+  void absorb(SymbolStorage&& other) {
+    storage.reserve(storage.size() + other.storage.size());
+    for (auto& owned : other.storage) {
+      owned->id = static_cast<uint32_t>(storage.size());
+      storage.push_back(std::move(owned));
+    }
+    other.storage.clear();
+  }
+
+  // The same, placing them in `order`, which lists each of them once.
+  void absorb(SymbolStorage&& other, const std::vector<SymbolAttr*>& order) {
+    storage.reserve(storage.size() + order.size());
+    for (auto* sym : order) {
+      auto& owned = other.storage[sym->id];
+      owned->id = static_cast<uint32_t>(storage.size());
+      storage.push_back(std::move(owned));
+    }
+    other.storage.clear();
+  }
+
 private:
   std::vector<std::unique_ptr<SymbolAttr>> storage;
 };
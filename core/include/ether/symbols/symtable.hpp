@@ -11,14 +11,26 @@ public:
   explicit SymbolTable(SymbolStorage& arena) : arena(arena) {
     new_scope(ScopeType::Module);
   }
+
+  // A table whose lookups fall back to `outer` once its own scopes are
+  // exhausted. `outer` is never written through, so several tables may share
+  // one module scope across threads while it is not being modified.
+  SymbolTable(SymbolStorage& arena, const SymTable& outer)
+  : arena(arena), outer(&outer) {
+    new_scope(ScopeType::Module);
+  }
+
   SymbolAttr* declare(const Token&, SymbolKind);
   SymbolAttr* lookup(const std::string&);
   std::optional<ScopeType> get_current_scope_type() const ;
   void new_scope(ScopeType);
   void pop_scope();
 
+  const SymTable& module_scope() const { return scopes.front().scope_sym_table; }
+
 private:
   SymbolStorage& arena;
+  const SymTable* outer = nullptr;
   std::vector<Scope> scopes;
 };
 
@@ -0,0 +1,108 @@
+#pragma once
+#include <cstdint>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using TypeId = uint32_t;
+
+enum class TypeKind : uint8_t {
+  // No annotation, or nothing inferred.
+  Unknown,
+  Int,
+  Float,
+  String,
+  Bool,
+  Nil,
+  // A type named in an annotation that is none of the above.
+  Named,
+  Func,
+  // A signature's n-th type variable, numbered in order of appearance.
+  Var,
+};
+
+// Hash-consed types: each distinct type is stored once and named by a
+// dense TypeId, so two types are equal exactly when their ids are, and
+// symbols with the same type share it. Signatures number their variables
+// in order of appearance, so `(a) :> a` for any two functions is one id.
+//
+// Entries are never removed. shared() is the table every module's symbols
+// use, so ids compare across modules; any thread may add to it.
+class TypeTable {
+public:
+  static constexpr TypeId unknown = 0;
+  static constexpr TypeId int_type = 1;
+  static constexpr TypeId float_type = 2;
+  static constexpr TypeId string_type = 3;
+  static constexpr TypeId bool_type = 4;
+  static constexpr TypeId nil_type = 5;
+
+  static TypeTable& shared();
+
+  TypeTable();
+
+  TypeTable(const TypeTable&) = delete;
+  TypeTable& operator=(const TypeTable&) = delete;
+
+  // What an annotation names: Int, Float, String, Bool and Nil are built
+  // in, an empty name is unknown and any other is a Named type.
+  TypeId annotation(std::string_view name);
+  TypeId named(std::string_view name);
+  TypeId function(std::span<const TypeId> params, TypeId result);
+  TypeId var(uint32_t index);
+
+  TypeKind kind(TypeId type) const;
+  // Of a function type.
+  std::vector<TypeId> params(TypeId func) const;
+  TypeId result(TypeId func) const;
+  // Of a Named type.
+  std::string name(TypeId named) const;
+  // Of a Var.
+  uint32_t var_index(TypeId var) const;
+
+  // "Int", "(Int, 'a) :> 'a", ...; empty for unknown.
+  std::string to_string(TypeId type) const;
+  // The inverse of to_string; unknown for text it cannot read.
+  TypeId parse(std::string_view text);
+
+  size_t size() const;
+
+private:
+  struct Entry {
+    TypeKind kind;
+    // Func: where its parameters then result start in `args`. Named: the
+    // index of its name. Var: its index.
+    uint32_t first;
+    // Func: number of parameters.
+    uint32_t count;
+    uint64_t hash;
+  };
+
+  // A type being looked up; `args` are a function's parameters then result.
+  struct Key {
+    TypeKind kind;
+    std::span<const TypeId> args{};
+    std::string_view name{};
+    uint32_t index = 0;
+
+    uint64_t hash() const;
+  };
+
+  static constexpr TypeId empty_slot = UINT32_MAX;
+
+  mutable std::shared_mutex mutex;
+  std::vector<Entry> entries;
+  std::vector<TypeId> args;
+  std::vector<std::string> names;
+  // Open addressing over `entries`, at most half full.
+  std::vector<TypeId> slots;
+
+  TypeId intern(const Key& key);
+  TypeId find(const Key& key, uint64_t hash) const;
+  bool matches(const Entry& entry, const Key& key) const;
+  void insert_slot(TypeId id);
+  void append(std::string& out, TypeId type) const;
+  TypeId parse_type(std::string_view& text);
+};
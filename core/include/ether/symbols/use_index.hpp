@@ -0,0 +1,46 @@
+#pragma once
+#include <ether/symbols/symbol_types.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// One resolved reference: the symbol it binds to and the byte offset of the
+// referencing token.
+struct SymbolUse {
+  SymbolAttr* symbol;
+  uint32_t offset;
+};
+
+// Reverse of NDIdentifier::identifier_symbol: for every symbol in a module's
+// SymbolStorage, the source offsets of all references to it. Stored as two
+// flat arrays indexed by SymbolAttr::id (CSR layout), so a query is two loads
+// and the whole index is `symbols + 1 + references` 32-bit words.
+class UseDefIndex {
+public:
+  UseDefIndex() = default;
+
+  // `symbol_count` must cover every id appearing in `uses`.
+  static UseDefIndex build(const std::vector<SymbolUse>& uses, size_t symbol_count);
+
+  // Offsets of every reference to `sym`, ascending.
+  std::span<const uint32_t> references(const SymbolAttr& sym) const;
+
+  size_t reference_count(const SymbolAttr& sym) const {
+    return references(sym).size();
+  }
+
+  bool is_unused(const SymbolAttr& sym) const {
+    return reference_count(sym) == 0;
+  }
+
+  size_t symbol_count() const { return starts.empty() ? 0 : starts.size() - 1; }
+  size_t size() const { return offsets.size(); }
+  size_t memory_bytes() const {
+    return (starts.capacity() + offsets.capacity()) * sizeof(uint32_t);
+  }
+
+private:
+  std::vector<uint32_t> starts;
+  std::vector<uint32_t> offsets;
+};
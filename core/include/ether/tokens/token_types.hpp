@@ -1,4 +1,5 @@
 #pragma once
+#include <ether/diagnostics/diagnostic.hpp>
 #include <string>
 
 enum class TokenType {
@@ -69,8 +70,15 @@ struct Token {
   std::string token_value;
   size_t line_number;
   size_t column_number;
+  // Byte offset of the token's first character in the source text.
+  size_t offset{};
 };
 
+// The token's text in the source, for diagnostics.
+inline SourceRange token_range(const Token& tok) {
+  return SourceRange::at(tok.offset, tok.token_value.size());
+}
+
 
 inline std::string token_type_to_str(TokenType type) {
   using t = TokenType;
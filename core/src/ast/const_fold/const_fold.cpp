@@ -0,0 +1,348 @@
+#include <ether/ast/const_fold/const_fold.hpp>
+#include <charconv>
+#include <cmath>
+#include <format>
+#include <limits>
+#include <memory>
+#include <utility>
+
+namespace {
+
+// The shortest text that reads back as `f`, with a decimal point so it
+// still reads as a Float.
+std::string float_text(double f) {
+  char buf[64];
+  auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), f);
+  std::string text(buf, end);
+  if (text.find_first_of(".en") == std::string::npos) text += ".0";
+  return text;
+}
+
+}
+
+void ConstantFolder::fold_module(Parent& root) {
+  this->rewrite = true;
+  this->fold(root.children);
+}
+
+void ConstantFolder::check_module(Parent& root) {
+  this->rewrite = false;
+  this->fold(root.children);
+}
+
+void ConstantFolder::fold(NDPtr& node) {
+  this->value.reset();
+  if (!node || node->is_poisoned) return;
+
+  node->accept(*this);
+  if (!this->rewrite || !this->value || dynamic_cast<NDLiteral*>(node.get())) return;
+
+  auto literal = std::make_unique<NDLiteral>();
+  literal->type = std::move(node->type);
+  literal->literal = this->literal_token(*this->value);
+  node = std::move(literal);
+  this->folded_count++;
+}
+
+void ConstantFolder::fold(std::vector<NDPtr>& nodes) {
+  for (auto& node : nodes) this->fold(node);
+}
+
+void ConstantFolder::visit(NDLiteral& expr) {
+  const auto& tok = expr.literal;
+  this->at = token_range(tok);
+  this->line = tok.line_number;
+  this->column = tok.column_number;
+
+  const auto& text = tok.token_value;
+  Value v{ .kind = ValueKind::Nil };
+  switch (tok.token_type) {
+    case TokenType::IntegerLiteral: {
+      v.kind = ValueKind::Int;
+      auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), v.i);
+      if (ec == std::errc::result_out_of_range) {
+        this->report(this->at, std::format("`{}` does not fit in `Int`", text));
+        return;
+      }
+      if (ec != std::errc() || end != text.data() + text.size()) return;
+      break;
+    }
+    case TokenType::FloatLiteral: {
+      v.kind = ValueKind::Float;
+      auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), v.f);
+      if (ec == std::errc::result_out_of_range) {
+        this->report(this->at, std::format("`{}` does not fit in `Float`", text));
+        return;
+      }
+      if (ec != std::errc() || end != text.data() + text.size()) return;
+      break;
+    }
+    case TokenType::StringLiteral:
+      v.kind = ValueKind::String;
+      v.s = text;
+      break;
+    case TokenType::TrueLiteral:
+    case TokenType::FalseLiteral:
+      v.kind = ValueKind::Bool;
+      v.b = tok.token_type == TokenType::TrueLiteral;
+      break;
+    case TokenType::NilLiteral: break;
+    // An unterminated string was already reported.
+    default: return;
+  }
+  this->value = std::move(v);
+}
+
+void ConstantFolder::visit(NDImportDirective&) {
+  this->value.reset();
+}
+
+void ConstantFolder::visit(NDIdentifier&) {
+  this->value.reset();
+}
+
+void ConstantFolder::visit(NDLetBindExpr& expr) {
+  this->fold(expr.bound_value);
+  this->value.reset();
+}
+
+// Only to report a literal too large for its type.
+void ConstantFolder::visit(NDConstExpr& expr) {
+  if (!expr.literal.is_poisoned) expr.literal.accept(*this);
+  this->value.reset();
+}
+
+void ConstantFolder::visit(NDCallExpr& expr) {
+  this->fold(expr.args);
+  this->value.reset();
+}
+
+void ConstantFolder::visit(NDCallChain& expr) {
+  this->fold(expr.calls);
+  this->value.reset();
+}
+
+void ConstantFolder::visit(NDFuncDeclExpr& expr) {
+  this->fold(expr.func_body);
+  this->value.reset();
+}
+
+// Patterns are matched against, not evaluated.
+void ConstantFolder::visit(NDCaseExpr& expr) {
+  this->fold(expr.conditions);
+  for (auto& branch : expr.branches) this->fold(branch.result);
+  this->value.reset();
+}
+
+void ConstantFolder::visit(NDBinaryExpr& expr) {
+  this->fold(expr.lhs);
+  auto lhs = std::move(this->value);
+  auto lhs_at = this->at;
+  auto lhs_line = this->line;
+  auto lhs_column = this->column;
+
+  this->fold(expr.rhs);
+  auto rhs = std::move(this->value);
+  auto rhs_at = this->at;
+
+  this->at = SourceRange{ lhs_at.begin, rhs_at.end };
+  this->line = lhs_line;
+  this->column = lhs_column;
+  this->value.reset();
+  if (lhs && rhs) this->value = this->binary(*lhs, expr.op, *rhs);
+}
+
+void ConstantFolder::visit(NDUnaryExpr& expr) {
+  // `-9223372036854775808` fits though its magnitude alone does not, so
+  // a negated integer literal is read with its sign.
+  auto* lit = dynamic_cast<NDLiteral*>(expr.rhs.get());
+  if (expr.op && expr.op->token_type == TokenType::MinusOp && lit && !lit->is_poisoned &&
+      lit->literal.token_type == TokenType::IntegerLiteral) {
+    auto text = "-" + lit->literal.token_value;
+    this->at = SourceRange{ token_range(*expr.op).begin, token_range(lit->literal).end };
+    this->line = expr.op->line_number;
+    this->column = expr.op->column_number;
+    this->value.reset();
+
+    Value v{ .kind = ValueKind::Int };
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), v.i);
+    if (ec == std::errc::result_out_of_range) {
+      this->report(this->at, std::format("`{}` does not fit in `Int`", text));
+      return;
+    }
+    if (ec == std::errc() && end == text.data() + text.size()) this->value = std::move(v);
+    return;
+  }
+
+  this->fold(expr.rhs);
+  if (!expr.op) return;
+
+  auto rhs = std::move(this->value);
+  this->at = SourceRange{ token_range(*expr.op).begin, this->at.end };
+  this->line = expr.op->line_number;
+  this->column = expr.op->column_number;
+  this->value.reset();
+  if (rhs) this->value = this->unary(*expr.op, *rhs);
+}
+
+// A scope of nothing but literals is its last one.
+void ConstantFolder::visit(NDScopeExpr& expr) {
+  bool pure = !expr.expressions.empty();
+  for (auto& e : expr.expressions) {
+    this->fold(e);
+    pure = pure && this->value;
+  }
+
+  auto last = std::move(this->value);
+  this->at = SourceRange{ token_range(expr.open_brace).begin, this->at.end };
+  this->line = expr.open_brace.line_number;
+  this->column = expr.open_brace.column_number;
+  this->value.reset();
+  if (pure) this->value = std::move(last);
+}
+
+// Operand types the checker rejects give nothing, as do overflows and
+// division by zero, which are reported.
+std::optional<ConstantFolder::Value> ConstantFolder::binary(const Value& lhs, const Token& op, const Value& rhs) {
+  if (lhs.kind != rhs.kind) return std::nullopt;
+  auto kind = lhs.kind;
+  using t = TokenType;
+
+  auto as_bool = [](bool b) { return Value{ .kind = ValueKind::Bool, .b = b }; };
+  auto text = [](const Value& v) {
+    return v.kind == ValueKind::Int ? std::to_string(v.i) : float_text(v.f);
+  };
+  auto fail = [&](std::string_view what) {
+    this->report(this->at, std::format("`{} {} {}` {}", text(lhs), op.token_value, text(rhs), what));
+    return std::nullopt;
+  };
+
+  switch (op.token_type) {
+    case t::EqEq:
+    case t::NtEq: {
+      bool equal = false;
+      switch (kind) {
+        case ValueKind::Int: equal = lhs.i == rhs.i; break;
+        case ValueKind::Float: equal = lhs.f == rhs.f; break;
+        case ValueKind::String: equal = lhs.s == rhs.s; break;
+        case ValueKind::Bool: equal = lhs.b == rhs.b; break;
+        case ValueKind::Nil: equal = true; break;
+      }
+      return as_bool(op.token_type == t::EqEq ? equal : !equal);
+    }
+    case t::AndOp:
+    case t::OrOp:
+      if (kind != ValueKind::Bool) return std::nullopt;
+      return as_bool(op.token_type == t::AndOp ? lhs.b && rhs.b : lhs.b || rhs.b);
+    case t::PlusOp:
+      if (kind == ValueKind::String) return Value{ .kind = ValueKind::String, .s = lhs.s + rhs.s };
+      break;
+    default: break;
+  }
+
+  if (kind == ValueKind::Int) {
+    int64_t a = lhs.i, b = rhs.i, r = 0;
+    switch (op.token_type) {
+      case t::PlusOp:
+        if (__builtin_add_overflow(a, b, &r)) return fail("overflows `Int`");
+        break;
+      case t::MinusOp:
+        if (__builtin_sub_overflow(a, b, &r)) return fail("overflows `Int`");
+        break;
+      case t::MultiplyOp:
+        if (__builtin_mul_overflow(a, b, &r)) return fail("overflows `Int`");
+        break;
+      case t::DivideOp:
+      case t::PercentOp:
+        if (b == 0) return fail("divides by zero");
+        if (a == std::numeric_limits<int64_t>::min() && b == -1) {
+          if (op.token_type == t::DivideOp) return fail("overflows `Int`");
+          r = 0;
+        } else {
+          r = op.token_type == t::DivideOp ? a / b : a % b;
+        }
+        break;
+      case t::Lt: return as_bool(a < b);
+      case t::Le: return as_bool(a <= b);
+      case t::Gt: return as_bool(a > b);
+      case t::Ge: return as_bool(a >= b);
+      default: return std::nullopt;
+    }
+    return Value{ .kind = ValueKind::Int, .i = r };
+  }
+
+  if (kind == ValueKind::Float) {
+    double a = lhs.f, b = rhs.f, r = 0;
+    switch (op.token_type) {
+      case t::PlusOp: r = a + b; break;
+      case t::MinusOp: r = a - b; break;
+      case t::MultiplyOp: r = a * b; break;
+      case t::DivideOp:
+      case t::PercentOp:
+        if (b == 0) return fail("divides by zero");
+        r = op.token_type == t::DivideOp ? a / b : std::fmod(a, b);
+        break;
+      case t::Lt: return as_bool(a < b);
+      case t::Le: return as_bool(a <= b);
+      case t::Gt: return as_bool(a > b);
+      case t::Ge: return as_bool(a >= b);
+      default: return std::nullopt;
+    }
+    if (!std::isfinite(r)) return fail("overflows `Float`");
+    return Value{ .kind = ValueKind::Float, .f = r };
+  }
+
+  return std::nullopt;
+}
+
+std::optional<ConstantFolder::Value> ConstantFolder::unary(const Token& op, const Value& rhs) {
+  if (op.token_type == TokenType::NotOp) {
+    if (rhs.kind != ValueKind::Bool) return std::nullopt;
+    return Value{ .kind = ValueKind::Bool, .b = !rhs.b };
+  }
+  if (op.token_type != TokenType::MinusOp) return std::nullopt;
+
+  if (rhs.kind == ValueKind::Float) return Value{ .kind = ValueKind::Float, .f = -rhs.f };
+  if (rhs.kind != ValueKind::Int) return std::nullopt;
+  if (rhs.i == std::numeric_limits<int64_t>::min()) {
+    this->report(this->at, std::format("`-{}` overflows `Int`", rhs.i));
+    return std::nullopt;
+  }
+  return Value{ .kind = ValueKind::Int, .i = -rhs.i };
+}
+
+Token ConstantFolder::literal_token(const Value& v) const {
+  Token tok{ .line_number = this->line, .column_number = this->column, .offset = this->at.begin };
+  switch (v.kind) {
+    case ValueKind::Int:
+      tok.token_type = TokenType::IntegerLiteral;
+      tok.token_value = std::to_string(v.i);
+      break;
+    case ValueKind::Float:
+      tok.token_type = TokenType::FloatLiteral;
+      tok.token_value = float_text(v.f);
+      break;
+    case ValueKind::String:
+      tok.token_type = TokenType::StringLiteral;
+      tok.token_value = v.s;
+      break;
+    case ValueKind::Bool:
+      tok.token_type = v.b ? TokenType::TrueLiteral : TokenType::FalseLiteral;
+      tok.token_value = v.b ? "True" : "False";
+      break;
+    case ValueKind::Nil:
+      tok.token_type = TokenType::NilLiteral;
+      tok.token_value = "Nil";
+      break;
+  }
+  return tok;
+}
+
+void ConstantFolder::report(SourceRange where, std::string message) {
+  auto diag = Diagnostic();
+  diag.level = DiagnosticLevel::Fail;
+  diag.phase = DiagnosticPhase::Folder;
+  diag.range = where;
+  diag.message = std::move(message);
+  this->diag_eng.report(std::move(diag));
+}
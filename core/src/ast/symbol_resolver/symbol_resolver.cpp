@@ -1,16 +1,76 @@
 #include <ether/ast/symbol_resolver/symbol_resolver.hpp>
+#include <ether/import_res/import_res.hpp>
+#include <ether/support/parallel.hpp>
+#include <algorithm>
+#include <format>
+#include <unordered_set>
+#include <vector>
+
+static TypeId annotation(const std::optional<Token>& type) {
+  return type ? TypeTable::shared().annotation(type->token_value) : TypeTable::unknown;
+}
+
+static FunctionData function_data(const NDFuncDeclExpr& expr) {
+  FunctionData func_data;
+  func_data.function_return_type.type = annotation(expr.return_type);
+
+  func_data.function_params.reserve(expr.func_params.size());
+  for (size_t i = 0; i < expr.func_params.size(); ++i) {
+    const auto& param = expr.func_params[i];
+    func_data.function_params.push_back(FuncParamData{
+      .index = i,
+      .param_name = param.param_token.token_value,
+      .param_type = TypeData{ annotation(param.param_type) },
+    });
+  }
+
+  return func_data;
+}
+
+// The function's type as far as its annotations tell: each part left out
+// may be anything.
+static TypeId annotated_signature(const FunctionData& func_data) {
+  auto& table = TypeTable::shared();
+  uint32_t vars = 0;
+  auto part = [&](const TypeData& data) {
+    return data.type == TypeTable::unknown ? table.var(vars++) : data.type;
+  };
+
+  std::vector<TypeId> params;
+  params.reserve(func_data.function_params.size());
+  for (const auto& param : func_data.function_params) params.push_back(part(param.param_type));
+  return table.function(params, part(func_data.function_return_type));
+}
+
+static void describe_function(SymbolAttr& sym, const NDFuncDeclExpr& expr) {
+  auto func_data = function_data(expr);
+  sym.type_info.type = annotated_signature(func_data);
+  sym.symbol_data = std::move(func_data);
+}
+
+static void describe_const(SymbolAttr& sym, const NDConstExpr& expr) {
+  sym.type_info.type = annotation(expr.type);
+  sym.symbol_data = ConstantData{ .constant_type = { sym.type_info.type } };
+}
+
+// Note pointing a duplicate declaration at the one it clashes with.
+static DiagnosticNote previous_declaration(const SymbolAttr& sym) {
+  return DiagnosticNote{
+    .range = token_range(sym.symbol_token),
+    .message = std::format("previous declaration of `{}` is here", sym.name),
+  };
+}
 
 void SymbolResolver::visit(NDImportDirective& expr) {
   auto cscope_type = this->sym_table.get_current_scope_type();
-  // todo: source files from include
+  // Module-scope imports are bound by begin_module.
   if ( cscope_type && (cscope_type != ScopeType::Module)) {
     expr.is_poisoned = true;
 
     auto diag = Diagnostic();
     diag.level = DiagnosticLevel::Warn;
     diag.phase = DiagnosticPhase::Resolver;
-    diag.location.column = expr.import_directive.column_number;
-    diag.location.line = expr.import_directive.line_number;
+    diag.range = token_range(expr.import_directive);
     diag.message = "Import statements are only allowed in the top Module scope";
 
     this->diag_eng.report(diag);
@@ -18,6 +78,79 @@ void SymbolResolver::visit(NDImportDirective& expr) {
   }
 }
 
+void SymbolResolver::bind_import(NDImportDirective& expr) {
+  // Poisoned imports were already reported (e.g. by the module loader).
+  if (!this->registry || expr.is_poisoned) return;
+
+  const auto& path = expr.import_directive.token_value;
+  if (!is_valid_import_path(expr.import_directive)) {
+    expr.is_poisoned = true;
+
+    auto diag = Diagnostic();
+    diag.level = DiagnosticLevel::Fail;
+    diag.phase = DiagnosticPhase::Resolver;
+    diag.range = token_range(expr.import_directive);
+    diag.message = std::format("Invalid import path `{}`", path);
+
+    this->diag_eng.report(diag);
+    return;
+  }
+
+  auto module_exports = this->registry->find(path);
+  if (!module_exports) {
+    expr.is_poisoned = true;
+
+    auto diag = Diagnostic();
+    diag.level = DiagnosticLevel::Fail;
+    diag.phase = DiagnosticPhase::Resolver;
+    diag.range = token_range(expr.import_directive);
+    diag.message = std::format("Module `{}` has not been loaded", path);
+
+    this->diag_eng.report(diag);
+    return;
+  }
+
+  if (std::ranges::find(this->imports, module_exports) == this->imports.end()) {
+    this->imports.push_back(module_exports);
+    this->import_paths.push_back(path);
+  }
+}
+
+SymbolAttr* SymbolResolver::lookup(const std::string& name) {
+  if (auto sym = this->sym_table.lookup(name)) return sym;
+  return this->lookup_import(name);
+}
+
+SymbolAttr* SymbolResolver::lookup_import(const std::string& name) {
+  if (this->module_resolver) {
+    SymbolAttr* proxy = nullptr;
+    {
+      std::lock_guard lock(this->module_resolver->proxy_mutex);
+      proxy = this->module_resolver->lookup_import(name);
+    }
+    if (proxy) this->proxies_looked_up.push_back(proxy);
+    return proxy;
+  }
+  if (this->imports.empty()) return nullptr;
+
+  if (auto it = this->imported_symbols.find(name); it != this->imported_symbols.end()) {
+    return it->second;
+  }
+
+  for (size_t i = 0; i < this->imports.size(); ++i) {
+    auto origin = this->imports[i]->find(name);
+    if (!origin) continue;
+
+    auto& arena = this->parallel_proxies ? *this->parallel_proxies : this->arena;
+    auto proxy = arena.allocate(std::move(*origin));
+    this->imported_symbols.emplace(name, proxy);
+    this->proxy_origins.emplace_back(proxy, i);
+    return proxy;
+  }
+
+  return nullptr;
+}
+
 void SymbolResolver::visit(NDLiteral& expr) {
   auto cscope_type = this->sym_table.get_current_scope_type();
   if (
@@ -31,8 +164,7 @@ void SymbolResolver::visit(NDLiteral& expr) {
     auto diag = Diagnostic();
     diag.level = DiagnosticLevel::Warn;
     diag.phase = DiagnosticPhase::Resolver;
-    diag.location.column = expr.literal.column_number;
-    diag.location.line = expr.literal.line_number;
+    diag.range = token_range(expr.literal);
     diag.message = std::format(
       "Literal value `{}` not in allowed scope",
       expr.literal.token_value
@@ -56,8 +188,7 @@ void SymbolResolver::visit(NDIdentifier& expr) {
     auto diag = Diagnostic();
     diag.level = DiagnosticLevel::Fail;
     diag.phase = DiagnosticPhase::Resolver;
-    diag.location.column = expr.identifier.column_number;
-    diag.location.line = expr.identifier.line_number;
+    diag.range = token_range(expr.identifier);
     diag.message = std::format(
       "Identifier `{}` not in allowed scope",
       expr.identifier.token_value
@@ -67,9 +198,105 @@ void SymbolResolver::visit(NDIdentifier& expr) {
     return;
   }
 
-  auto ident_sym = this->sym_table.lookup(expr.identifier.token_value);
+  auto ident_sym = this->lookup(expr.identifier.token_value);
   if (!ident_sym) return;
   expr.identifier_symbol = ident_sym;
+  this->note_use(ident_sym, expr.identifier);
+}
+
+void SymbolResolver::note_use(SymbolAttr* sym, const Token& tok) {
+  if (!this->shares_module_scope) sym->ref_count++;
+  this->uses.push_back(SymbolUse{
+    .symbol = sym,
+    .offset = static_cast<uint32_t>(tok.offset),
+  });
+}
+
+// A top-level function no call in its module reaches. `main` is where a
+// program starts, so nothing calls it.
+static bool is_uncalled(const SymbolAttr& sym, const std::unordered_map<std::string, SymbolAttr*>& exports) {
+  if (sym.ref_count > 0 || sym.symbol_kind != SymbolKind::Function || sym.name == "main") return false;
+  auto exported = exports.find(sym.name);
+  return exported != exports.end() && exported->second == &sym;
+}
+
+void SymbolResolver::report_unused_symbols(bool functions) {
+  this->arena.for_each([&](const SymbolAttr& sym) {
+    if (sym.ref_count > 0) return;
+
+    std::string message;
+    switch (sym.symbol_kind) {
+      case SymbolKind::Binding:
+        message = std::format("Unused binding `{}`", sym.name);
+        break;
+      case SymbolKind::FuncParam:
+        message = std::format("Unused function parameter `{}`", sym.name);
+        break;
+      case SymbolKind::Function:
+        if (!functions || !is_uncalled(sym, this->exports)) return;
+        message = std::format("Function `{}` is never called", sym.name);
+        break;
+      default:
+        return;
+    }
+
+    auto diag = Diagnostic();
+    diag.level = DiagnosticLevel::Warn;
+    diag.phase = DiagnosticPhase::Resolver;
+    diag.range = token_range(sym.symbol_token);
+    diag.message = message;
+
+    this->diag_eng.report(diag);
+  });
+}
+
+std::vector<const SymbolAttr*> SymbolResolver::uncalled_functions() const {
+  std::vector<const SymbolAttr*> out;
+  this->arena.for_each([&](const SymbolAttr& sym) {
+    if (is_uncalled(sym, this->exports)) out.push_back(&sym);
+  });
+  return out;
+}
+
+std::vector<SymbolResolver::ImportedUse> SymbolResolver::used_imports() const {
+  std::vector<ImportedUse> out;
+  for (const auto& [proxy, from] : this->proxy_origins) {
+    if (proxy->ref_count == 0) continue;
+    out.push_back(ImportedUse{ .import_path = this->import_paths[from], .name = proxy->name });
+  }
+  return out;
+}
+
+UseDefIndex SymbolResolver::take_use_index() {
+  auto index = UseDefIndex::build(this->uses, this->arena.size());
+  this->uses.clear();
+  return index;
+}
+
+UseDefIndex SymbolResolver::build_use_index() const {
+  return UseDefIndex::build(this->uses, this->arena.size());
+}
+
+void SymbolResolver::forget_uses(size_t begin, size_t end) {
+  std::erase_if(this->uses, [&](const SymbolUse& use) {
+    if (use.offset < begin || use.offset >= end) return false;
+    use.symbol->ref_count--;
+    return true;
+  });
+}
+
+void SymbolResolver::shift_positions(const SourceShift& shift) {
+  for (auto& use : this->uses) {
+    if (use.offset >= shift.offset) use.offset = static_cast<uint32_t>(use.offset + shift.delta);
+  }
+
+  // Proxies carry the exporting module's positions.
+  std::unordered_set<const SymbolAttr*> proxies;
+  for (const auto& [name, proxy] : this->imported_symbols) proxies.insert(proxy);
+
+  this->arena.for_each([&](SymbolAttr& sym) {
+    if (!proxies.contains(&sym)) shift.apply(sym.symbol_token);
+  });
 }
 
 void SymbolResolver::visit(NDLetBindExpr& expr) {
@@ -84,8 +311,7 @@ void SymbolResolver::visit(NDLetBindExpr& expr) {
     auto diag = Diagnostic();
     diag.level = DiagnosticLevel::Fail;
     diag.phase = DiagnosticPhase::Resolver;
-    diag.location.column = expr.identifier->identifier.column_number;
-    diag.location.line = expr.identifier->identifier.line_number;
+    diag.range = token_range(expr.identifier->identifier);
     diag.message = "`Let` expression is not in valid scope";
 
     this->diag_eng.report(diag);
@@ -99,36 +325,38 @@ void SymbolResolver::visit(NDLetBindExpr& expr) {
     if (!ident_sym) return;
 
     auto dup_msg = std::format(
-      "Duplicate declaration of `{}` (see Ln {}, Col {} for previous declaration)",
-      expr.identifier->identifier.token_value,
-      ident_sym->symbol_token.line_number,
-      ident_sym->symbol_token.column_number
+      "Duplicate declaration of `{}`",
+      expr.identifier->identifier.token_value
     );
     auto diag = Diagnostic();
     diag.level = DiagnosticLevel::Fail;
     diag.phase = DiagnosticPhase::Resolver;
-    diag.location.column = expr.identifier->identifier.column_number;
-    diag.location.line = expr.identifier->identifier.line_number;
+    diag.range = token_range(expr.identifier->identifier);
     diag.message = dup_msg;
-
-    this->diag_eng.report(diag);
+    this->diag_eng.report(diag, { previous_declaration(*ident_sym) });
     return;
   }
 
   expr_sym->symbol_kind = SymbolKind::Binding;
   expr.identifier->identifier_symbol = expr_sym;
 
-  BindingData binding_data;
-
-  if (expr.type) {
-    binding_data.binding_type.type_name = expr.type->token_value;
-  }
+  expr_sym->type_info.type = annotation(expr.type);
+  expr_sym->symbol_data = BindingData{ .binding_type = { expr_sym->type_info.type } };
 
   expr.bound_value->accept(*this);
   return;
 }
 
 void SymbolResolver::visit(NDConstExpr& expr) {
+  // Module-level constants were already declared by begin_module.
+  if (!expr.identifier->identifier_symbol) {
+    if (expr.is_poisoned || !this->declare_const(expr)) return;
+  }
+
+  expr.literal.accept(*this);
+}
+
+SymbolAttr* SymbolResolver::declare_const(NDConstExpr& expr) {
   auto cscope_type = this->sym_table.get_current_scope_type();
 
   if (
@@ -141,52 +369,47 @@ void SymbolResolver::visit(NDConstExpr& expr) {
     auto diag = Diagnostic();
     diag.level = DiagnosticLevel::Fail;
     diag.phase = DiagnosticPhase::Resolver;
-    diag.location.column = expr.identifier->identifier.column_number;
-    diag.location.line = expr.identifier->identifier.line_number;
+    diag.range = token_range(expr.identifier->identifier);
     diag.message = "`Const` expression is not in valid scope";
 
     this->diag_eng.report(diag);
-    return;
+    return nullptr;
   }
 
   auto const_sym = this->sym_table.declare(expr.identifier->identifier, SymbolKind::Constant);
   if (!const_sym) {
     expr.is_poisoned = true;
     auto ident_sym = this->sym_table.lookup(expr.identifier->identifier.token_value);
-    if (!ident_sym) return;
+    if (!ident_sym) return nullptr;
 
     auto dup_msg = std::format(
-      "Duplicate `const` declaration of `{}` (see Ln {}, Col {} for previous declaration)",
-      expr.identifier->identifier.token_value,
-      ident_sym->symbol_token.line_number,
-      ident_sym->symbol_token.column_number
+      "Duplicate `const` declaration of `{}`",
+      expr.identifier->identifier.token_value
     );
 
     auto diag = Diagnostic();
     diag.level = DiagnosticLevel::Fail;
     diag.phase = DiagnosticPhase::Resolver;
-    diag.location.column = expr.identifier->identifier.column_number;
-    diag.location.line = expr.identifier->identifier.line_number;
+    diag.range = token_range(expr.identifier->identifier);
     diag.message = dup_msg;
-
-    this->diag_eng.report(diag);
-    return;
+    this->diag_eng.report(diag, { previous_declaration(*ident_sym) });
+    return nullptr;
   }
   const_sym->symbol_kind = SymbolKind::Constant;
+  describe_const(*const_sym, expr);
   expr.identifier->identifier_symbol = const_sym;
 
   if (cscope_type == ScopeType::Module) {
     this->exports.emplace(const_sym->name, const_sym);
   }
 
-  expr.literal.accept(*this);
-  return;
+  return const_sym;
 }
 
 
 void SymbolResolver::visit(NDCallExpr& expr) {
   auto ident  = expr.identifier->identifier.token_value;
-  auto sym = this->sym_table.lookup(ident);
+  auto sym = this->lookup(ident);
 
   if (!sym) {
     expr.is_poisoned = true;
@@ -194,8 +417,7 @@ void SymbolResolver::visit(NDCallExpr& expr) {
     auto diag = Diagnostic();
     diag.level = DiagnosticLevel::Fail;
     diag.phase = DiagnosticPhase::Resolver;
-    diag.location.column = expr.identifier->identifier.column_number;
-    diag.location.line = expr.identifier->identifier.line_number;
+    diag.range = token_range(expr.identifier->identifier);
     diag.message = "`Call` expression is not in valid scope";
 
     this->diag_eng.report(diag);
@@ -214,8 +436,7 @@ void SymbolResolver::visit(NDCallExpr& expr) {
     auto diag = Diagnostic();
     diag.level = DiagnosticLevel::Fail;
     diag.phase = DiagnosticPhase::Resolver;
-    diag.location.column = expr.identifier->identifier.column_number;
-    diag.location.line = expr.identifier->identifier.line_number;
+    diag.range = token_range(expr.identifier->identifier);
     diag.message = "Function call is not in valid scope";
 
     this->diag_eng.report(diag);
@@ -223,6 +444,7 @@ void SymbolResolver::visit(NDCallExpr& expr) {
   }
 
   expr.identifier->identifier_symbol = sym;
+  this->note_use(sym, expr.identifier->identifier);
 
   for (auto& arg: expr.args) {
     arg->accept(*this);
@@ -244,8 +466,7 @@ void SymbolResolver::visit(NDCallChain& expr) {
     auto diag = Diagnostic();
     diag.level = DiagnosticLevel::Fail;
     diag.phase = DiagnosticPhase::Resolver;
-    diag.location.line = expr.start_token.line_number;
-    diag.location.column = expr.start_token.column_number;
+    diag.range = token_range(expr.start_token);
     diag.message = "Call chain not in valid scope";
 
     this->diag_eng.report(diag);
@@ -256,6 +477,15 @@ void SymbolResolver::visit(NDCallChain& expr) {
 }
 
 void SymbolResolver::visit(NDFuncDeclExpr& expr) {
+  // Module-level functions were already declared by begin_module.
+  if (!expr.func_sym) {
+    if (expr.is_poisoned || !this->declare_function(expr)) return;
+  }
+
+  this->resolve_function_body(expr);
+}
+
+SymbolAttr* SymbolResolver::declare_function(NDFuncDeclExpr& expr) {
   auto cscope_type = this->sym_table.get_current_scope_type();
   if (
     cscope_type
@@ -268,12 +498,11 @@ void SymbolResolver::visit(NDFuncDeclExpr& expr) {
     auto diag = Diagnostic();
     diag.level = DiagnosticLevel::Fail;
     diag.phase = DiagnosticPhase::Resolver;
-    diag.location.column = expr.func_identifier.column_number;
-    diag.location.line = expr.func_identifier.line_number;
+    diag.range = token_range(expr.func_identifier);
     diag.message = "Function declaration not in valid scope";
 
     this->diag_eng.report(diag);
-    return;
+    return nullptr;
   }
 
   auto func_sym = this->sym_table.declare(expr.func_identifier, SymbolKind::Function);
@@ -281,30 +510,44 @@ void SymbolResolver::visit(NDFuncDeclExpr& expr) {
     // Means this is a redeclaration of another function.
     expr.is_poisoned = true;
     auto ident_sym = this->sym_table.lookup(expr.func_identifier.token_value);
-    if (!ident_sym) return;
+    if (!ident_sym) return nullptr;
 
     auto dup_msg = std::format(
-      "Duplicate function declaration of `{}` (see Ln {}, Col {} for previous declaration)",
-      expr.func_identifier.token_value,
-      ident_sym->symbol_token.line_number,
-      ident_sym->symbol_token.column_number
+      "Duplicate function declaration of `{}`",
+      expr.func_identifier.token_value
     );
 
     auto diag = Diagnostic();
     diag.level = DiagnosticLevel::Fail;
     diag.phase = DiagnosticPhase::Resolver;
-    diag.location.column = expr.func_identifier.column_number;
-    diag.location.line = expr.func_identifier.line_number;
+    diag.range = token_range(expr.func_identifier);
     diag.message = dup_msg;
-
-    this->diag_eng.report(diag);
-    return;
+    this->diag_eng.report(diag, { previous_declaration(*ident_sym) });
+    return nullptr;
   }
 
   if (cscope_type == ScopeType::Module) {
     this->exports.emplace(func_sym->name, func_sym);
   }
 
+  describe_function(*func_sym, expr);
+  expr.func_sym = func_sym;
+  return func_sym;
+}
+
+void SymbolResolver::redeclare(NDFuncDeclExpr& expr, SymbolAttr& sym) {
+  sym.symbol_token = expr.func_identifier;
+  describe_function(sym, expr);
+  expr.func_sym = &sym;
+}
+
+void SymbolResolver::redeclare(NDConstExpr& expr, SymbolAttr& sym) {
+  sym.symbol_token = expr.identifier->identifier;
+  describe_const(sym, expr);
+  expr.identifier->identifier_symbol = &sym;
+}
+
+void SymbolResolver::resolve_function_body(NDFuncDeclExpr& expr) {
   ScopeGuard guard(this->sym_table, ScopeType::FunctionExpression);
 
   for (auto& arg: expr.func_params) {
@@ -313,36 +556,131 @@ void SymbolResolver::visit(NDFuncDeclExpr& expr) {
       auto lkp = sym_table.lookup(arg.param_token.token_value);
       if (!lkp) continue;
       auto dup_msg = std::format(
-        "Duplicate function parameter name `{}` (see Ln {}, Col {} for previous declaration)",
-        arg.param_token.token_value,
-        lkp->symbol_token.line_number,
-        lkp->symbol_token.column_number
+        "Duplicate function parameter name `{}`",
+        arg.param_token.token_value
       );
 
       auto diag = Diagnostic();
       diag.level = DiagnosticLevel::Fail;
       diag.phase = DiagnosticPhase::Resolver;
-      diag.location.column = arg.param_token.column_number;
-      diag.location.line = arg.param_token.line_number;
+      diag.range = token_range(arg.param_token);
       diag.message = dup_msg;
-
-      this->diag_eng.report(diag);
+      this->diag_eng.report(diag, { previous_declaration(*lkp) });
     };
 
     if (!arg.param_sym) arg.param_sym = ptr;
+    if (arg.param_sym) arg.param_sym->type_info.type = annotation(arg.param_type);
   }
 
   for (auto& body_expr: expr.func_body) body_expr->accept(*this);
+}
 
-  FunctionData func_data;
+void SymbolResolver::begin_module(Parent& root) {
+  // `Load`s must lead the module: dependency discovery (Lexer::scan_imports)
+  // stops at the first other item, so a later `Load` would never be loaded.
+  bool past_imports = false;
+
+  for (auto& node : root.children) {
+    if (auto* load = dynamic_cast<NDImportDirective*>(node.get())) {
+      if (!past_imports) {
+        this->bind_import(*load);
+        continue;
+      }
 
-  if (expr.return_type) {
-    func_data.function_return_type.type_name = expr.return_type->token_value;
+      load->is_poisoned = true;
+
+      auto diag = Diagnostic();
+      diag.level = DiagnosticLevel::Fail;
+      diag.phase = DiagnosticPhase::Resolver;
+      diag.range = token_range(load->import_directive);
+      diag.message = std::format(
+        "`Load {}` must come before any other top-level item",
+        load->import_directive.token_value
+      );
+
+      this->diag_eng.report(diag);
+      continue;
+    }
+
+    past_imports = true;
+    if (auto* func = dynamic_cast<NDFuncDeclExpr*>(node.get())) {
+      this->declare_function(*func);
+    } else if (auto* const_expr = dynamic_cast<NDConstExpr*>(node.get())) {
+      this->declare_const(*const_expr);
+    }
   }
+}
 
-  func_sym->symbol_data = func_data;
-  expr.func_sym = func_sym;
-  return;
+void SymbolResolver::resolve_module(Parent& root, size_t jobs) {
+  this->begin_module(root);
+
+  if (jobs <= 1) {
+    for (auto& node : root.children) node->accept(*this);
+    return;
+  }
+
+  std::vector<NDFuncDeclExpr*> bodies;
+  for (auto& node : root.children) {
+    auto* func = dynamic_cast<NDFuncDeclExpr*>(node.get());
+    if (!func) {
+      node->accept(*this);
+      continue;
+    }
+    if (func->func_sym) bodies.push_back(func);
+  }
+
+  // Bodies are handed out in fixed-size chunks; each chunk owns its arena and
+  // diagnostic buffer so merging in chunk order is deterministic regardless
+  // of which thread ran it.
+  constexpr size_t chunk_size = 32;
+  struct Chunk {
+    SymbolStorage arena;
+    DiagnosticEngine diag;
+    std::vector<SymbolUse> uses;
+    std::vector<SymbolAttr*> proxies;
+  };
+
+  // Chunks making proxies of their own would split an imported name's uses
+  // and count across several symbols, so they share this resolver's, made
+  // on first lookup.
+  SymbolStorage proxies;
+  this->parallel_proxies = &proxies;
+
+  size_t n_chunks = (bodies.size() + chunk_size - 1) / chunk_size;
+  std::vector<Chunk> chunks(n_chunks);
+  const SymTable& module_scope = this->sym_table.module_scope();
+
+  parallel_for(n_chunks, jobs, [&](size_t c) {
+    auto& chunk = chunks[c];
+    SymbolResolver task(chunk.arena, chunk.diag, module_scope);
+    task.module_resolver = this;
+    size_t end = std::min(bodies.size(), (c + 1) * chunk_size);
+    for (size_t i = c * chunk_size; i < end; ++i) {
+      task.resolve_function_body(*bodies[i]);
+    }
+    chunk.uses = std::move(task.uses);
+    chunk.proxies = std::move(task.proxies_looked_up);
+  });
+  this->parallel_proxies = nullptr;
+
+  // Which chunk looked a name up first depends on the threads; the chunk
+  // order does not.
+  std::vector<SymbolAttr*> proxy_order;
+  std::unordered_set<SymbolAttr*> placed;
+  for (const auto& chunk : chunks) {
+    for (auto* proxy : chunk.proxies) {
+      if (placed.insert(proxy).second) proxy_order.push_back(proxy);
+    }
+  }
+  this->arena.absorb(std::move(proxies), proxy_order);
+  std::ranges::sort(this->proxy_origins, {}, [](const auto& origin) { return origin.first->id; });
+
+  for (auto& chunk : chunks) {
+    this->arena.absorb(std::move(chunk.arena));
+    this->diag_eng.absorb(std::move(chunk.diag));
+    for (const auto& use : chunk.uses) use.symbol->ref_count++;
+    this->uses.insert(this->uses.end(), chunk.uses.begin(), chunk.uses.end());
+  }
 }
 
 void SymbolResolver::visit(NDScopeExpr& expr) {
@@ -357,8 +695,7 @@ void SymbolResolver::visit(NDScopeExpr& expr) {
     auto diag = Diagnostic();
     diag.level = DiagnosticLevel::Fail;
     diag.phase = DiagnosticPhase::Resolver;
-    diag.location.line = expr.open_brace.line_number;
-    diag.location.column = expr.open_brace.column_number;
+    diag.range = token_range(expr.open_brace);
     diag.message = "Scoped expression is not allowed in current scope";
 
     this->diag_eng.report(diag);
@@ -381,8 +718,7 @@ void SymbolResolver::visit(NDCaseExpr& expr) {
     auto diag = Diagnostic();
     diag.level = DiagnosticLevel::Fail;
     diag.phase = DiagnosticPhase::Resolver;
-    diag.location.line = expr.case_keyword.line_number;
-    diag.location.column = expr.case_keyword.column_number;
+    diag.range = token_range(expr.case_keyword);
     diag.message = "Case expression not allowed in current scope";
 
     this->diag_eng.report(diag);
@@ -1,14 +1,712 @@
 #include <ether/ast/type_check/type_check.hpp>
+#include <ether/support/dag_scheduler.hpp>
+#include <ether/support/parallel.hpp>
+#include <algorithm>
+#include <format>
+#include <functional>
+#include <utility>
 
-void TypeChecker::visit(NDLiteral&) {}
-void TypeChecker::visit(NDImportDirective&) {}
-void TypeChecker::visit(NDIdentifier&) {}
-void TypeChecker::visit(NDLetBindExpr&) {}
-void TypeChecker::visit(NDConstExpr&) {}
-void TypeChecker::visit(NDCallExpr&) {}
-void TypeChecker::visit(NDCallChain&) {}
-void TypeChecker::visit(NDFuncDeclExpr&) {}
-void TypeChecker::visit(NDCaseExpr&) {}
-void TypeChecker::visit(NDBinaryExpr&) {}
-void TypeChecker::visit(NDUnaryExpr&) {}
-void TypeChecker::visit(NDScopeExpr&) {}
+namespace {
+
+// What an operator accepts, as a set of kinds.
+constexpr uint8_t accepts_numbers = 1;
+constexpr uint8_t accepts_strings = 2;
+
+bool accepts(uint8_t allowed, TypeKind kind) {
+  switch (kind) {
+    case TypeKind::Int:
+    case TypeKind::Float: return allowed & accepts_numbers;
+    case TypeKind::String: return allowed & accepts_strings;
+    default: return false;
+  }
+}
+
+// The functions and constants a subtree refers to, and the largest id of
+// any symbol in it.
+class References final : public Visitor {
+public:
+  std::vector<SymbolAttr*> used;
+  uint32_t max_id = 0;
+
+  void visit(NDLiteral&) override {}
+  void visit(NDImportDirective&) override {}
+  void visit(NDIdentifier& n) override { this->use(n.identifier_symbol); }
+
+  void visit(NDLetBindExpr& n) override {
+    this->child(n.identifier.get());
+    this->child(n.bound_value.get());
+  }
+
+  void visit(NDConstExpr& n) override { this->child(n.identifier.get()); }
+
+  void visit(NDCallExpr& n) override {
+    this->child(n.identifier.get());
+    this->children(n.args);
+  }
+
+  void visit(NDCallChain& n) override { this->children(n.calls); }
+
+  void visit(NDFuncDeclExpr& n) override {
+    this->note(n.func_sym);
+    for (const auto& param : n.func_params) this->note(param.param_sym);
+    this->children(n.func_body);
+  }
+
+  void visit(NDCaseExpr& n) override {
+    this->children(n.conditions);
+    for (auto& branch : n.branches) {
+      this->children(branch.pattern);
+      this->child(branch.result.get());
+    }
+  }
+
+  void visit(NDBinaryExpr& n) override {
+    this->child(n.lhs.get());
+    this->child(n.rhs.get());
+  }
+
+  void visit(NDUnaryExpr& n) override { this->child(n.rhs.get()); }
+  void visit(NDScopeExpr& n) override { this->children(n.expressions); }
+
+private:
+  void note(const SymbolAttr* sym) {
+    if (sym) this->max_id = std::max(this->max_id, sym->id);
+  }
+
+  // Only functions and constants can be declared at the top level.
+  void use(SymbolAttr* sym) {
+    if (!sym) return;
+    this->note(sym);
+    if (sym->symbol_kind == SymbolKind::Function || sym->symbol_kind == SymbolKind::Constant) {
+      this->used.push_back(sym);
+    }
+  }
+
+  void child(Node* n) {
+    if (n) n->accept(*this);
+  }
+
+  void children(std::vector<NDPtr>& nodes) {
+    for (auto& n : nodes) this->child(n.get());
+  }
+};
+
+// The symbol a top-level `func` or `const` declares.
+SymbolAttr* declared_symbol(Node& node) {
+  if (auto* func = dynamic_cast<NDFuncDeclExpr*>(&node)) return func->func_sym;
+  if (auto* constant = dynamic_cast<NDConstExpr*>(&node)) return constant->identifier->identifier_symbol;
+  return nullptr;
+}
+
+// Tarjan's strongly connected components of the graph `edges`, iteratively.
+// A component comes after every component it has edges to, with its
+// members in ascending order.
+std::vector<std::vector<uint32_t>> components_of(const std::vector<std::vector<uint32_t>>& edges) {
+  constexpr uint32_t unvisited = UINT32_MAX;
+  size_t n = edges.size();
+  std::vector<uint32_t> index(n, unvisited), low(n, 0);
+  std::vector<bool> on_stack(n, false);
+  std::vector<uint32_t> stack;
+  // A node being visited and the next of its edges to follow.
+  std::vector<std::pair<uint32_t, size_t>> frames;
+  std::vector<std::vector<uint32_t>> components;
+  uint32_t counter = 0;
+
+  auto enter = [&](uint32_t v) {
+    index[v] = low[v] = counter++;
+    stack.push_back(v);
+    on_stack[v] = true;
+    frames.emplace_back(v, 0);
+  };
+
+  for (uint32_t root = 0; root < n; ++root) {
+    if (index[root] != unvisited) continue;
+    enter(root);
+    while (!frames.empty()) {
+      auto [v, next] = frames.back();
+      if (next < edges[v].size()) {
+        frames.back().second++;
+        uint32_t w = edges[v][next];
+        if (index[w] == unvisited) {
+          enter(w);
+        } else if (on_stack[w]) {
+          low[v] = std::min(low[v], index[w]);
+        }
+        continue;
+      }
+
+      frames.pop_back();
+      if (!frames.empty()) {
+        auto parent = frames.back().first;
+        low[parent] = std::min(low[parent], low[v]);
+      }
+      if (low[v] != index[v]) continue;
+
+      auto& component = components.emplace_back();
+      uint32_t w;
+      do {
+        w = stack.back();
+        stack.pop_back();
+        on_stack[w] = false;
+        component.push_back(w);
+      } while (w != v);
+      std::ranges::sort(component);
+    }
+  }
+  return components;
+}
+
+}
+
+// Top-level functions and constants are the call graph's nodes; the rest of
+// the top level is checked once they all are. What a declaration uses is
+// walked for only if the last check did not keep it.
+void TypeChecker::check_module(Parent& root) {
+  std::vector<Node*> declarations, rest;
+  std::vector<SymbolAttr*> declared;
+  for (auto& child : root.children) {
+    auto* sym = declared_symbol(*child);
+    if (child->is_poisoned || !sym) {
+      rest.push_back(child.get());
+    } else {
+      declarations.push_back(child.get());
+      declared.push_back(sym);
+    }
+  }
+
+  std::vector<Checked*> found(declarations.size());
+  std::vector<bool> fresh(declarations.size());
+  std::vector<size_t> unknown;
+  for (size_t i = 0; i < declarations.size(); ++i) {
+    auto [it, inserted] = this->checked.try_emplace(declared[i]);
+    found[i] = &it->second;
+    fresh[i] = inserted;
+    if (inserted) unknown.push_back(i);
+  }
+
+  std::vector<References> refs(unknown.size());
+  parallel_for(unknown.size(), this->jobs, [&](size_t k) {
+    auto& r = refs[k];
+    declarations[unknown[k]]->accept(r);
+    std::ranges::sort(r.used);
+    auto [last, end] = std::ranges::unique(r.used);
+    r.used.erase(last, end);
+
+    auto& entry = *found[unknown[k]];
+    entry.max_id = r.max_id;
+    for (auto* sym : r.used) entry.uses.push_back(Use{ .sym = sym });
+  });
+  References rest_refs;
+  for (auto* node : rest) node->accept(rest_refs);
+
+  uint32_t max_id = rest_refs.max_id;
+  for (const auto* entry : found) max_id = std::max(max_id, entry->max_id);
+  for (const auto* sym : declared) max_id = std::max(max_id, sym->id);
+  this->module_symbols.assign(size_t{max_id} + 1, SymbolType{ .task = module_task });
+  this->types = TypeStore();
+  this->level = 0;
+
+  // Until the components are known, a declaration's slot holds its index.
+  for (uint32_t i = 0; i < declared.size(); ++i) {
+    this->slot(*declared[i]) = SymbolType{ .sym = declared[i], .task = i };
+  }
+  std::vector<std::vector<uint32_t>> edges(declarations.size());
+  for (size_t i = 0; i < declarations.size(); ++i) {
+    for (const auto& use : found[i]->uses) {
+      if (use.sym->id >= this->module_symbols.size()) continue;
+      const auto& s = this->slot(*use.sym);
+      if (s.sym == use.sym && s.task != module_task) edges[i].push_back(s.task);
+    }
+  }
+
+  auto components = components_of(edges);
+  std::vector<uint32_t> component_of(declarations.size());
+  for (uint32_t c = 0; c < components.size(); ++c) {
+    for (auto i : components[c]) {
+      component_of[i] = c;
+      this->slot(*declared[i]).task = c;
+    }
+  }
+
+  std::vector<std::vector<size_t>> dependents(components.size());
+  std::vector<size_t> pending(components.size(), 0);
+  for (uint32_t c = 0; c < components.size(); ++c) {
+    std::vector<uint32_t> deps;
+    for (auto i : components[c]) {
+      for (auto j : edges[i]) {
+        if (component_of[j] != c) deps.push_back(component_of[j]);
+      }
+    }
+    std::ranges::sort(deps);
+    auto [last, end] = std::ranges::unique(deps);
+    deps.erase(last, end);
+    for (auto d : deps) dependents[d].push_back(c);
+    pending[c] = deps.size();
+  }
+
+  // Alone, the module's own TypeStore checks every component, so callees
+  // are instantiated rather than imported again from the TypeTable.
+  std::vector<uint32_t> inferred(components.size(), 0);
+  auto check = [&](TypeChecker& checker, size_t c) {
+    std::vector<Node*> nodes;
+    std::vector<Checked*> entries;
+    std::vector<bool> unchecked;
+    for (auto i : components[c]) {
+      nodes.push_back(declarations[i]);
+      entries.push_back(found[i]);
+      unchecked.push_back(fresh[i]);
+    }
+    if (checker.check_component(nodes, entries, unchecked)) inferred[c] = static_cast<uint32_t>(nodes.size());
+  };
+  if (this->jobs <= 1) {
+    for (size_t c = 0; c < components.size(); ++c) check(*this, c);
+    this->out = nullptr;
+  } else {
+    run_dag(dependents, std::move(pending), this->jobs, [&](size_t c) {
+      TypeChecker task(*this, static_cast<uint32_t>(c));
+      check(task, c);
+    });
+  }
+
+  this->inferred_count = 0;
+  for (auto n : inferred) this->inferred_count += n;
+  // In the order of each component's first declaration.
+  for (size_t i = 0; i < declarations.size(); ++i) {
+    if (found[i]->leader != declared[i]) continue;
+    auto diagnostics = found[i]->diagnostics;
+    this->diag_eng->absorb(std::move(diagnostics));
+  }
+
+  for (auto* node : rest) node->accept(*this);
+  this->finish();
+  this->defined.clear();
+}
+
+// A component is kept as the last check left it if it is the same one, none
+// of its declarations is new, and what they use has the same signatures.
+bool TypeChecker::check_component(const std::vector<Node*>& component, const std::vector<Checked*>& found,
+                                  const std::vector<bool>& fresh) {
+  auto* leader = found.front();
+  const auto* leader_sym = declared_symbol(*component.front());
+  bool kept = std::ranges::none_of(fresh, std::identity{});
+  for (auto* entry : found) {
+    kept = kept && entry->leader == leader_sym && entry->component_size == component.size();
+    for (const auto& use : entry->uses) kept = kept && use.sym->type_info.type == use.type;
+  }
+  if (kept) {
+    for (auto* sym : leader->defined) this->slot(*sym) = SymbolType{ .sym = sym, .state = SymbolState::Kept, .task = this->task };
+    return false;
+  }
+
+  leader->diagnostics.clear();
+  this->out = &leader->diagnostics;
+
+  std::vector<std::pair<NDFuncDeclExpr*, TypeRef>> funcs;
+  ++this->level;
+  for (auto* node : component) {
+    if (auto* func = dynamic_cast<NDFuncDeclExpr*>(node)) {
+      auto self = this->types.fresh(this->level);
+      this->define(*func->func_sym, self, SymbolState::InProgress);
+      funcs.emplace_back(func, self);
+    }
+  }
+  for (auto [func, self] : funcs) this->infer_function(*func, self);
+  --this->level;
+
+  for (auto [func, self] : funcs) {
+    this->types.generalize(self, this->level);
+    this->define(*func->func_sym, self);
+  }
+  for (auto* node : component) {
+    if (!dynamic_cast<NDFuncDeclExpr*>(node)) node->accept(*this);
+  }
+  this->finish();
+
+  for (auto* entry : found) {
+    entry->leader = leader_sym;
+    entry->component_size = static_cast<uint32_t>(component.size());
+    entry->defined.clear();
+    for (auto& use : entry->uses) use.type = use.sym->type_info.type;
+  }
+  leader->defined = std::move(this->defined);
+  this->defined.clear();
+  return true;
+}
+
+void TypeChecker::forget(const SymbolAttr& decl) {
+  this->checked.erase(&decl);
+}
+
+void TypeChecker::shift_positions(const SourceShift& shift) {
+  for (auto& [sym, entry] : this->checked) {
+    for (auto& diag : entry.diagnostics) {
+      shift.apply(diag.range);
+      for (auto& note : entry.diagnostics.notes_of(diag)) shift.apply(note.range);
+    }
+  }
+}
+
+// Generic variables are never bound once their component is generalized,
+// so what is still open here stays open.
+void TypeChecker::finish() {
+  for (const auto& check : this->operand_checks) {
+    auto kind = this->types.kind(check.type);
+    if (kind == TypeKind::Var || accepts(check.allowed, kind)) continue;
+    this->report(token_range(*check.op),
+                 std::format("`{}` is not defined for `{}`", check.op->token_value, this->types.to_string(check.type)));
+  }
+  this->operand_checks.clear();
+
+  auto& table = TypeTable::shared();
+  for (auto* sym : this->defined) sym->type_info.type = this->types.export_type(this->slot(*sym).type, table);
+}
+
+std::string TypeChecker::type_of(const SymbolAttr& sym) const {
+  if (sym.id >= this->module_symbols.size()) return "";
+  const auto& s = this->module_symbols[sym.id];
+  if (s.sym != &sym || (s.state != SymbolState::Done && s.state != SymbolState::Kept)) return "";
+  return TypeTable::shared().to_string(sym.type_info.type);
+}
+
+TypeRef TypeChecker::infer(Node& node) {
+  node.accept(*this);
+  return this->result;
+}
+
+void TypeChecker::define(SymbolAttr& sym, TypeRef type, SymbolState state) {
+  this->slot(sym) = SymbolType{ .sym = &sym, .state = state, .type = type, .task = this->task };
+  if (state == SymbolState::Done) this->defined.push_back(&sym);
+}
+
+// Symbols of other modules and components are used at a fresh instance of
+// their type_info.
+TypeRef TypeChecker::use(SymbolAttr* sym) {
+  if (!sym) return this->types.fresh(this->level);
+  if (sym->id < this->symbol_types->size()) {
+    const auto& s = this->slot(*sym);
+    if (s.sym == sym && s.task == this->task && (s.state == SymbolState::InProgress || s.state == SymbolState::Done)) {
+      return this->types.instantiate(s.type, this->level);
+    }
+  }
+  return this->types.import(sym->type_info.type, TypeTable::shared(), this->level);
+}
+
+TypeRef TypeChecker::annotation(const Token& name) {
+  auto& table = TypeTable::shared();
+  return this->types.import(table.annotation(name.token_value), table, this->level);
+}
+
+void TypeChecker::expect(TypeRef expected, TypeRef found, SourceRange where) {
+  if (this->types.unify(expected, found)) return;
+  this->report(where, std::format("Type mismatch: expected `{}`, found `{}`",
+                                  this->types.to_string(expected), this->types.to_string(found)));
+}
+
+// Checked now if the operand's type is known, else once its component is done.
+void TypeChecker::check_operand(TypeRef type, uint8_t allowed, const Token& op) {
+  auto kind = this->types.kind(type);
+  if (kind == TypeKind::Var) {
+    this->operand_checks.push_back(OperandCheck{ .type = type, .allowed = allowed, .op = &op });
+  } else if (!accepts(allowed, kind)) {
+    this->report(token_range(op),
+                 std::format("`{}` is not defined for `{}`", op.token_value, this->types.to_string(type)));
+  }
+}
+
+void TypeChecker::report(SourceRange where, std::string message) {
+  auto diag = Diagnostic();
+  diag.level = DiagnosticLevel::Fail;
+  diag.phase = DiagnosticPhase::TypeChecker;
+  diag.range = where;
+  diag.message = std::move(message);
+  if (this->out) {
+    this->out->push_back(std::move(diag));
+  } else {
+    this->diag_eng->report(std::move(diag));
+  }
+}
+
+void TypeChecker::visit(NDLiteral& expr) {
+  this->at = token_range(expr.literal);
+  switch (expr.literal.token_type) {
+    case TokenType::IntegerLiteral: this->result = TypeStore::int_type; break;
+    case TokenType::FloatLiteral: this->result = TypeStore::float_type; break;
+    case TokenType::StringLiteral:
+    case TokenType::UTStringLiteral: this->result = TypeStore::string_type; break;
+    case TokenType::TrueLiteral:
+    case TokenType::FalseLiteral: this->result = TypeStore::bool_type; break;
+    case TokenType::NilLiteral: this->result = TypeStore::nil_type; break;
+    default: this->result = this->types.fresh(this->level); break;
+  }
+}
+
+void TypeChecker::visit(NDImportDirective& expr) {
+  this->at = token_range(expr.import_directive);
+  this->result = TypeStore::nil_type;
+}
+
+void TypeChecker::visit(NDIdentifier& expr) {
+  this->result = this->use(expr.identifier_symbol);
+  this->at = token_range(expr.identifier);
+}
+
+// The binding's type is set before its value is inferred, so an annotation
+// is what the value is checked against.
+void TypeChecker::visit(NDLetBindExpr& expr) {
+  auto* sym = expr.identifier->identifier_symbol;
+  if (expr.is_poisoned || !sym) {
+    this->result = TypeStore::nil_type;
+    this->at = token_range(expr.identifier->identifier);
+    return;
+  }
+
+  ++this->level;
+  auto var = expr.type ? this->annotation(*expr.type) : this->types.fresh(this->level);
+  this->define(*sym, var);
+  auto value = this->infer(*expr.bound_value);
+  this->expect(var, value, this->at);
+  --this->level;
+  this->types.generalize(var, this->level);
+
+  this->result = TypeStore::nil_type;
+  this->at = token_range(expr.identifier->identifier);
+}
+
+void TypeChecker::visit(NDConstExpr& expr) {
+  auto* sym = expr.identifier->identifier_symbol;
+  if (!expr.is_poisoned && sym) {
+    auto value = this->infer(expr.literal);
+    if (expr.type) {
+      auto declared = this->annotation(*expr.type);
+      this->expect(declared, value, this->at);
+      value = declared;
+    }
+    this->define(*sym, value);
+  }
+
+  this->result = TypeStore::nil_type;
+  this->at = token_range(expr.identifier->identifier);
+}
+
+TypeRef TypeChecker::infer_call(NDCallExpr& call, std::optional<TypeRef> piped, SourceRange piped_at) {
+  auto name_at = token_range(call.identifier->identifier);
+  if (call.is_poisoned) {
+    this->at = name_at;
+    return this->types.fresh(this->level);
+  }
+
+  auto callee = this->types.find(this->use(call.identifier->identifier_symbol));
+  std::vector<TypeRef> args;
+  std::vector<SourceRange> args_at;
+  args.reserve(call.args.size() + 1);
+  args_at.reserve(call.args.size() + 1);
+  if (piped) {
+    args.push_back(*piped);
+    args_at.push_back(piped_at);
+  }
+  for (auto& arg : call.args) {
+    args.push_back(this->infer(*arg));
+    args_at.push_back(this->at);
+  }
+  this->at = name_at;
+
+  const auto& name = call.identifier->identifier.token_value;
+  switch (this->types.kind(callee)) {
+    case TypeKind::Var: {
+      auto ret = this->types.fresh(this->level);
+      auto func = this->types.function(args, ret);
+      if (!this->types.unify(callee, func)) {
+        this->report(name_at, std::format("`{}` cannot be called with itself as an argument", name));
+      }
+      return ret;
+    }
+    case TypeKind::Func: break;
+    default:
+      this->report(name_at, std::format("`{}` is not a function; its type is `{}`", name, this->types.to_string(callee)));
+      return this->types.fresh(this->level);
+  }
+
+  auto params = this->types.params(callee);
+  auto ret = this->types.result(callee);
+  if (params.size() != args.size()) {
+    this->report(name_at, std::format("`{}` takes {} argument{} but {} {} given", name, params.size(),
+                                      params.size() == 1 ? "" : "s", args.size(), args.size() == 1 ? "was" : "were"));
+    return ret;
+  }
+  // Unifying may grow the store, so the parameters are copied out first.
+  std::vector<TypeRef> expected(params.begin(), params.end());
+  for (size_t i = 0; i < args.size(); ++i) this->expect(expected[i], args[i], args_at[i]);
+  return ret;
+}
+
+void TypeChecker::visit(NDCallExpr& expr) {
+  this->result = this->infer_call(expr, std::nullopt, {});
+}
+
+// Each call's value is the first argument of the next one.
+void TypeChecker::visit(NDCallChain& expr) {
+  std::optional<TypeRef> piped;
+  SourceRange piped_at{};
+  for (auto& link : expr.calls) {
+    if (auto* call = dynamic_cast<NDCallExpr*>(link.get())) {
+      piped = this->infer_call(*call, piped, piped_at);
+    } else {
+      piped = this->infer(*link);
+    }
+    piped_at = this->at;
+  }
+
+  this->result = piped.value_or(TypeStore::nil_type);
+  this->at = token_range(expr.start_token);
+}
+
+// Nested functions are generalized on their own; top-level ones once
+// their whole component is inferred.
+void TypeChecker::visit(NDFuncDeclExpr& expr) {
+  auto* sym = expr.func_sym;
+  if (!expr.is_poisoned && sym) {
+    ++this->level;
+    auto self = this->types.fresh(this->level);
+    this->define(*sym, self, SymbolState::InProgress);
+    this->infer_function(expr, self);
+    --this->level;
+    this->types.generalize(self, this->level);
+    this->define(*sym, self);
+  }
+
+  this->result = TypeStore::nil_type;
+  this->at = token_range(expr.func_identifier);
+}
+
+// A function's value is its last expression. `self` is its own variable,
+// which calls within its component see monomorphically while it is inferred.
+void TypeChecker::infer_function(NDFuncDeclExpr& expr, TypeRef self) {
+  std::vector<TypeRef> params;
+  params.reserve(expr.func_params.size());
+  for (const auto& param : expr.func_params) {
+    auto type = param.param_type ? this->annotation(*param.param_type) : this->types.fresh(this->level);
+    if (param.param_sym) this->define(*param.param_sym, type);
+    params.push_back(type);
+  }
+
+  auto ret = TypeStore::nil_type;
+  auto ret_at = token_range(expr.func_identifier);
+  for (auto& body : expr.func_body) {
+    ret = this->infer(*body);
+    ret_at = this->at;
+  }
+  if (expr.return_type) {
+    auto declared = this->annotation(*expr.return_type);
+    this->expect(declared, ret, ret_at);
+    ret = declared;
+  }
+
+  auto func = this->types.function(params, ret);
+  if (!this->types.unify(self, func)) {
+    this->report(token_range(expr.func_identifier),
+                 std::format("`{}` is used as `{}` but declared as `{}`", expr.func_identifier.token_value,
+                             this->types.to_string(self), this->types.to_string(func)));
+  }
+}
+
+// Patterns take the condition's type; every branch gives the case's.
+void TypeChecker::visit(NDCaseExpr& expr) {
+  auto condition = this->types.fresh(this->level);
+  for (auto& cond : expr.conditions) this->expect(condition, this->infer(*cond), this->at);
+
+  std::optional<TypeRef> value;
+  for (auto& branch : expr.branches) {
+    for (auto& pattern : branch.pattern) {
+      auto type = this->infer(*pattern);
+      this->expect(condition, type, this->at);
+    }
+    if (!branch.result) continue;
+    auto type = this->infer(*branch.result);
+    if (value) {
+      this->expect(*value, type, this->at);
+    } else {
+      value = type;
+    }
+  }
+
+  this->result = value.value_or(TypeStore::nil_type);
+  this->at = token_range(expr.case_keyword);
+}
+
+void TypeChecker::visit(NDBinaryExpr& expr) {
+  auto lhs = this->infer(*expr.lhs);
+  auto lhs_at = this->at;
+  auto rhs = this->infer(*expr.rhs);
+  auto rhs_at = this->at;
+  auto op_at = token_range(expr.op);
+
+  // Both sides of an arithmetic or comparison operator have one type.
+  auto same = [&] {
+    if (!this->types.unify(lhs, rhs)) {
+      this->report(op_at, std::format("`{}` needs operands of one type, found `{}` and `{}`", expr.op.token_value,
+                                      this->types.to_string(lhs), this->types.to_string(rhs)));
+    }
+    return lhs;
+  };
+
+  using t = TokenType;
+  switch (expr.op.token_type) {
+    case t::PlusOp:
+      this->result = same();
+      this->check_operand(this->result, accepts_numbers | accepts_strings, expr.op);
+      break;
+    case t::MinusOp:
+    case t::MultiplyOp:
+    case t::DivideOp:
+    case t::PercentOp:
+      this->result = same();
+      this->check_operand(this->result, accepts_numbers, expr.op);
+      break;
+    case t::Lt:
+    case t::Le:
+    case t::Gt:
+    case t::Ge:
+      this->check_operand(same(), accepts_numbers, expr.op);
+      this->result = TypeStore::bool_type;
+      break;
+    case t::EqEq:
+    case t::NtEq:
+      same();
+      this->result = TypeStore::bool_type;
+      break;
+    case t::AndOp:
+    case t::OrOp:
+      this->expect(TypeStore::bool_type, lhs, lhs_at);
+      this->expect(TypeStore::bool_type, rhs, rhs_at);
+      this->result = TypeStore::bool_type;
+      break;
+    default:
+      this->result = this->types.fresh(this->level);
+      break;
+  }
+  this->at = SourceRange{ lhs_at.begin, rhs_at.end };
+}
+
+void TypeChecker::visit(NDUnaryExpr& expr) {
+  auto rhs = this->infer(*expr.rhs);
+  if (!expr.op) return;
+
+  if (expr.op->token_type == TokenType::NotOp) {
+    this->expect(TypeStore::bool_type, rhs, this->at);
+    this->result = TypeStore::bool_type;
+  } else if (expr.op->token_type == TokenType::MinusOp) {
+    this->check_operand(rhs, accepts_numbers, *expr.op);
+  }
+  this->at = SourceRange{ token_range(*expr.op).begin, this->at.end };
+}
+
+void TypeChecker::visit(NDScopeExpr& expr) {
+  auto value = TypeStore::nil_type;
+  auto value_at = token_range(expr.open_brace);
+  for (auto& e : expr.expressions) {
+    value = this->infer(*e);
+    value_at = this->at;
+  }
+  this->result = value;
+  this->at = value_at;
+}
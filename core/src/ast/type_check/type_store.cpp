@@ -0,0 +1,253 @@
+#include <ether/ast/type_check/type_store.hpp>
+#include <algorithm>
+
+TypeStore::TypeStore() {
+  for (auto kind : { TypeKind::Int, TypeKind::Float, TypeKind::String, TypeKind::Bool, TypeKind::Nil }) {
+    this->add(Node{ .kind = kind });
+  }
+}
+
+TypeRef TypeStore::add(Node node) {
+  auto id = static_cast<TypeRef>(this->nodes.size());
+  node.link = id;
+  this->nodes.push_back(node);
+  return id;
+}
+
+TypeRef TypeStore::fresh(uint32_t level) {
+  return this->add(Node{ .kind = TypeKind::Var, .level = level });
+}
+
+TypeRef TypeStore::named(std::string_view name) {
+  auto [it, inserted] = this->named_types.try_emplace(std::string(name), 0);
+  if (inserted) {
+    it->second = this->add(Node{ .kind = TypeKind::Named, .first = static_cast<uint32_t>(this->names.size()) });
+    this->names.emplace_back(name);
+  }
+  return it->second;
+}
+
+TypeRef TypeStore::function(std::span<const TypeRef> params, TypeRef result) {
+  auto first = static_cast<uint32_t>(this->args.size());
+  this->args.insert(this->args.end(), params.begin(), params.end());
+  this->args.push_back(result);
+  return this->add(Node{ .kind = TypeKind::Func, .first = first, .count = static_cast<uint32_t>(params.size()) });
+}
+
+TypeRef TypeStore::find(TypeRef type) {
+  TypeRef root = type;
+  while (this->nodes[root].link != root) root = this->nodes[root].link;
+  while (type != root) type = std::exchange(this->nodes[type].link, root);
+  return root;
+}
+
+std::span<const TypeRef> TypeStore::params(TypeRef func) const {
+  const auto& node = this->nodes[func];
+  return { this->args.data() + node.first, node.count };
+}
+
+TypeRef TypeStore::result(TypeRef func) const {
+  const auto& node = this->nodes[func];
+  return this->args[node.first + node.count];
+}
+
+bool TypeStore::unify(TypeRef a, TypeRef b) {
+  a = this->find(a);
+  b = this->find(b);
+  if (a == b) return true;
+  if (this->nodes[a].kind == TypeKind::Var) return this->bind(a, b);
+  if (this->nodes[b].kind == TypeKind::Var) return this->bind(b, a);
+
+  const auto& na = this->nodes[a];
+  const auto& nb = this->nodes[b];
+  if (na.kind != nb.kind) return false;
+  if (na.kind == TypeKind::Named) return na.first == nb.first;
+  if (na.kind != TypeKind::Func) return true;
+  if (na.count != nb.count) return false;
+
+  // `args` may grow while unifying, so index rather than hold spans.
+  uint32_t a_first = na.first, b_first = nb.first, count = na.count;
+  for (uint32_t i = 0; i <= count; ++i) {
+    if (!this->unify(this->args[a_first + i], this->args[b_first + i])) return false;
+  }
+  return true;
+}
+
+bool TypeStore::bind(TypeRef var, TypeRef type) {
+  auto& v = this->nodes[var];
+  if (this->nodes[type].kind == TypeKind::Var) {
+    // The outer of the two stays the representative, keeping its level.
+    if (this->nodes[type].level > v.level) {
+      this->nodes[type].link = var;
+    } else {
+      v.link = type;
+    }
+    return true;
+  }
+
+  if (!this->adjust(type, var, v.level)) return false;
+  this->nodes[var].link = type;
+  return true;
+}
+
+bool TypeStore::adjust(TypeRef type, TypeRef var, uint32_t level) {
+  type = this->find(type);
+  auto& node = this->nodes[type];
+  if (node.kind == TypeKind::Var) {
+    if (type == var) return false;
+    node.level = std::min(node.level, level);
+    return true;
+  }
+  if (node.kind != TypeKind::Func) return true;
+
+  uint32_t first = node.first, count = node.count;
+  for (uint32_t i = 0; i <= count; ++i) {
+    if (!this->adjust(this->args[first + i], var, level)) return false;
+  }
+  return true;
+}
+
+void TypeStore::generalize(TypeRef type, uint32_t level) {
+  type = this->find(type);
+  auto& node = this->nodes[type];
+  if (node.kind == TypeKind::Var) {
+    if (node.level > level) node.level = generic;
+    return;
+  }
+  if (node.kind != TypeKind::Func) return;
+
+  uint32_t first = node.first, count = node.count;
+  for (uint32_t i = 0; i <= count; ++i) this->generalize(this->args[first + i], level);
+}
+
+TypeRef TypeStore::instantiate(TypeRef type, uint32_t level) {
+  std::vector<std::pair<TypeRef, TypeRef>> fresh_for;
+  return this->copy(type, level, fresh_for);
+}
+
+TypeRef TypeStore::copy(TypeRef type, uint32_t level, std::vector<std::pair<TypeRef, TypeRef>>& fresh_for) {
+  type = this->find(type);
+  const auto& node = this->nodes[type];
+  if (node.kind == TypeKind::Var) {
+    if (node.level != generic) return type;
+    for (auto [from, to] : fresh_for) {
+      if (from == type) return to;
+    }
+    auto var = this->fresh(level);
+    fresh_for.emplace_back(type, var);
+    return var;
+  }
+  if (node.kind != TypeKind::Func) return type;
+
+  uint32_t first = node.first, count = node.count;
+  std::vector<TypeRef> copied(count + 1);
+  bool changed = false;
+  for (uint32_t i = 0; i <= count; ++i) {
+    copied[i] = this->copy(this->args[first + i], level, fresh_for);
+    changed = changed || copied[i] != this->find(this->args[first + i]);
+  }
+  if (!changed) return type;
+  return this->function(std::span(copied).first(count), copied[count]);
+}
+
+std::string TypeStore::to_string(TypeRef type) {
+  std::string out;
+  std::vector<TypeRef> vars;
+  this->append(out, type, vars);
+  return out;
+}
+
+void TypeStore::append(std::string& out, TypeRef type, std::vector<TypeRef>& vars) {
+  type = this->find(type);
+  const auto& node = this->nodes[type];
+  switch (node.kind) {
+    case TypeKind::Var: {
+      auto at = std::ranges::find(vars, type);
+      size_t n = static_cast<size_t>(at - vars.begin());
+      if (at == vars.end()) vars.push_back(type);
+      out += '\'';
+      out += static_cast<char>('a' + n % 26);
+      if (n >= 26) out += std::to_string(n / 26);
+      return;
+    }
+    case TypeKind::Int: out += "Int"; return;
+    case TypeKind::Float: out += "Float"; return;
+    case TypeKind::String: out += "String"; return;
+    case TypeKind::Bool: out += "Bool"; return;
+    case TypeKind::Nil: out += "Nil"; return;
+    case TypeKind::Named: out += this->names[node.first]; return;
+    case TypeKind::Unknown: return;
+    case TypeKind::Func: break;
+  }
+
+  uint32_t first = node.first, count = node.count;
+  out += '(';
+  for (uint32_t i = 0; i < count; ++i) {
+    if (i) out += ", ";
+    this->append(out, this->args[first + i], vars);
+  }
+  out += ") :> ";
+  this->append(out, this->args[first + count], vars);
+}
+
+TypeRef TypeStore::import(TypeId type, const TypeTable& table, uint32_t level) {
+  std::vector<std::pair<TypeId, TypeRef>> vars;
+  return this->import(type, table, level, vars);
+}
+
+TypeRef TypeStore::import(TypeId type, const TypeTable& table, uint32_t level,
+                          std::vector<std::pair<TypeId, TypeRef>>& vars) {
+  switch (table.kind(type)) {
+    case TypeKind::Unknown: return this->fresh(level);
+    case TypeKind::Int: return int_type;
+    case TypeKind::Float: return float_type;
+    case TypeKind::String: return string_type;
+    case TypeKind::Bool: return bool_type;
+    case TypeKind::Nil: return nil_type;
+    case TypeKind::Named: return this->named(table.name(type));
+    case TypeKind::Var: {
+      for (auto [from, to] : vars) {
+        if (from == type) return to;
+      }
+      auto var = this->fresh(level);
+      vars.emplace_back(type, var);
+      return var;
+    }
+    case TypeKind::Func: break;
+  }
+
+  auto params = table.params(type);
+  for (auto& param : params) param = this->import(param, table, level, vars);
+  auto result = this->import(table.result(type), table, level, vars);
+  return this->function(params, result);
+}
+
+TypeId TypeStore::export_type(TypeRef type, TypeTable& table) {
+  std::vector<TypeRef> vars;
+  return this->export_type(type, table, vars);
+}
+
+TypeId TypeStore::export_type(TypeRef type, TypeTable& table, std::vector<TypeRef>& vars) {
+  type = this->find(type);
+  const auto& node = this->nodes[type];
+  switch (node.kind) {
+    case TypeKind::Var: {
+      auto index = static_cast<uint32_t>(std::ranges::find(vars, type) - vars.begin());
+      if (index == vars.size()) vars.push_back(type);
+      return table.var(index);
+    }
+    case TypeKind::Int: return TypeTable::int_type;
+    case TypeKind::Float: return TypeTable::float_type;
+    case TypeKind::String: return TypeTable::string_type;
+    case TypeKind::Bool: return TypeTable::bool_type;
+    case TypeKind::Nil: return TypeTable::nil_type;
+    case TypeKind::Named: return table.named(this->names[node.first]);
+    default: break;
+  }
+
+  uint32_t first = node.first, count = node.count;
+  std::vector<TypeId> params(count);
+  for (uint32_t i = 0; i < count; ++i) params[i] = this->export_type(this->args[first + i], table, vars);
+  auto result = this->export_type(this->args[first + count], table, vars);
+  return table.function(params, result);
+}
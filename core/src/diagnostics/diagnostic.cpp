@@ -0,0 +1,32 @@
+#include <ether/diagnostics/diagnostic.hpp>
+#include <iterator>
+
+void DiagnosticList::push_back(Diagnostic diag, std::span<const DiagnosticNote> notes) {
+  diag.first_note = static_cast<uint32_t>(this->notes.size());
+  diag.note_count = static_cast<uint32_t>(notes.size());
+  this->notes.insert(this->notes.end(), notes.begin(), notes.end());
+  this->items.push_back(std::move(diag));
+}
+
+void DiagnosticList::append(DiagnosticList& from, size_t first, size_t count) {
+  if (this->empty() && first == 0 && count == from.size()) {
+    std::swap(this->items, from.items);
+    std::swap(this->notes, from.notes);
+    from.clear();
+    return;
+  }
+
+  this->items.reserve(this->items.size() + count);
+  for (size_t i = first; i < first + count; ++i) {
+    auto& diag = from.items[i];
+    auto notes = from.notes_of(diag);
+    diag.first_note = static_cast<uint32_t>(this->notes.size());
+    this->notes.insert(this->notes.end(), std::make_move_iterator(notes.begin()), std::make_move_iterator(notes.end()));
+    this->items.push_back(std::move(diag));
+  }
+}
+
+void DiagnosticList::clear() {
+  this->items.clear();
+  this->notes.clear();
+}
@@ -1,9 +1,12 @@
 #include <ether/diagnostics/diagnostic_eng.hpp>
 #include <ether/diagnostics/diagnostic.hpp>
 #include <algorithm>
-#include <format>
+#include <charconv>
+#include <cstdlib>
+#include <iterator>
 #include <ostream>
-#include <sstream>
+#include <tuple>
+#include <unistd.h>
 
 namespace {
   constexpr auto RESET   = "\033[0m";
@@ -14,32 +17,147 @@ namespace {
   constexpr auto CYAN    = "\033[36m";
   constexpr auto MAGENTA = "\033[35m";
   constexpr auto BLUE    = "\033[34m";
+
+  std::atomic<uint64_t> next_engine_id{ 1 };
+
+  // The shard this thread last reported to, and the engine it belongs to.
+  struct ShardCache {
+    uint64_t engine = 0;
+    void* shard = nullptr;
+  };
+  thread_local ShardCache last_shard;
+}
+
+bool diagnostic_before(const Diagnostic& a, const Diagnostic& b) {
+  // The no-location sentinel wraps around to 0.
+  uint32_t a_at = a.range.begin + 1, b_at = b.range.begin + 1;
+  return std::tie(a_at, a.phase, a.level, a.message)
+       < std::tie(b_at, b.phase, b.level, b.message);
+}
+
+DiagnosticEngine::DiagnosticEngine()
+: id(next_engine_id.fetch_add(1, std::memory_order_relaxed)) {}
+
+DiagnosticEngine::~DiagnosticEngine() {
+  auto* shard = this->shards.load(std::memory_order_acquire);
+  while (shard) delete std::exchange(shard, shard->next);
+}
+
+void DiagnosticEngine::report(Diagnostic diag, std::initializer_list<DiagnosticNote> notes) {
+  if (!this->admit(diag)) return;
+  this->shard_for_this_thread().diagnostics.push_back(std::move(diag), notes);
 }
 
-void DiagnosticEngine::report(Diagnostic diag) {
-  this->diagnostics.push_back(diag);
+bool DiagnosticEngine::admit(const Diagnostic& diag) {
+  if (diag.level == DiagnosticLevel::Note) return true;
+  if (this->limits.total == 0 && this->limits.per_phase == 0) return true;
+
+  auto& phase = this->phase_counts[static_cast<size_t>(diag.phase)];
+  bool kept = phase.fetch_add(1, std::memory_order_relaxed) < this->limits.per_phase || this->limits.per_phase == 0;
+  if (kept) kept = this->total_count.fetch_add(1, std::memory_order_relaxed) < this->limits.total || this->limits.total == 0;
+  if (kept) return true;
+
+  this->dropped_count.fetch_add(1, std::memory_order_relaxed);
+  if (diag.level == DiagnosticLevel::Fail) this->dropped_error.store(true, std::memory_order_relaxed);
+  return false;
+}
+
+bool DiagnosticEngine::limit_reached(DiagnosticPhase phase) const {
+  auto reached = [](const std::atomic<size_t>& count, size_t limit) {
+    return limit != 0 && count.load(std::memory_order_relaxed) >= limit;
+  };
+  return reached(this->phase_counts[static_cast<size_t>(phase)], this->limits.per_phase)
+      || reached(this->total_count, this->limits.total);
+}
+
+DiagnosticEngine::Shard& DiagnosticEngine::shard_for_this_thread() {
+  if (last_shard.engine == this->id) return *static_cast<Shard*>(last_shard.shard);
+
+  auto me = std::this_thread::get_id();
+  auto* head = this->shards.load(std::memory_order_acquire);
+  Shard* mine = nullptr;
+  for (auto* shard = head; shard && !mine; shard = shard->next) {
+    if (shard->owner == me) mine = shard;
+  }
+
+  // Shards pushed while we looked belong to other threads.
+  if (!mine) {
+    mine = new Shard{ me, {}, head };
+    while (!this->shards.compare_exchange_weak(mine->next, mine, std::memory_order_release, std::memory_order_acquire)) {}
+  }
+
+  last_shard = { this->id, mine };
+  return *mine;
+}
+
+void DiagnosticEngine::merge_shards() const {
+  for (auto* shard = this->shards.load(std::memory_order_acquire); shard; shard = shard->next) {
+    if (shard->diagnostics.empty()) continue;
+    this->diagnostics.append(shard->diagnostics);
+    shard->diagnostics.clear();
+  }
+}
+
+void DiagnosticEngine::absorb(DiagnosticEngine&& other) {
+  other.merge_shards();
+  this->absorb(std::move(other.diagnostics));
+  other.diagnostics.clear();
+
+  this->dropped_count.fetch_add(other.dropped(), std::memory_order_relaxed);
+  if (other.dropped_error.load(std::memory_order_relaxed)) this->dropped_error.store(true, std::memory_order_relaxed);
+}
+
+void DiagnosticEngine::absorb(DiagnosticList&& diagnostics) {
+  this->merge_shards();
+  for (size_t i = 0; i < diagnostics.size(); ++i) {
+    if (this->admit(diagnostics[i])) this->diagnostics.append(diagnostics, i, 1);
+  }
+}
+
+void DiagnosticEngine::splice(size_t first, size_t last, DiagnosticList with) {
+  this->merge_shards();
+  auto& kept = this->diagnostics;
+  if (first == 0 && last == kept.size()) {
+    kept = std::move(with);
+    return;
+  }
+
+  // Notes are flat, so the list is laid out again rather than edited.
+  DiagnosticList laid;
+  laid.append(kept, 0, first);
+  laid.append(with);
+  laid.append(kept, last, kept.size() - last);
+  kept = std::move(laid);
 }
 
 void DiagnosticEngine::set_source(std::string path, std::string text) {
   this->source_path = std::move(path);
-  this->source_lines.clear();
-  std::stringstream ss(text);
-  std::string line;
-  while (std::getline(ss, line)) {
-    if (!line.empty() && line.back() == '\r') line.pop_back();
-    this->source_lines.push_back(std::move(line));
+  this->source_text = std::move(text);
+  this->lines_indexed = false;
+}
+
+const LineIndex& DiagnosticEngine::line_index() {
+  if (!this->lines_indexed) {
+    this->lines = LineIndex(this->source_text);
+    this->lines_indexed = true;
   }
+  return this->lines;
+}
+
+SourcePosition DiagnosticEngine::position(size_t offset) {
+  return this->line_index().position(offset);
 }
 
 bool DiagnosticEngine::has_errors() const {
-  for (const auto& diag: this->diagnostics) {
+  if (this->dropped_error.load(std::memory_order_relaxed)) return true;
+  for (const auto& diag: this->all()) {
     if (diag.level == DiagnosticLevel::Fail) return true;
   }
 
   return false;
 }
 
-static const char* level_to_string(DiagnosticLevel level) {
+const char* level_to_string(DiagnosticLevel level) {
   switch (level) {
     case DiagnosticLevel::Fail: return "error";
     case DiagnosticLevel::Warn: return "warning";
@@ -48,93 +166,190 @@ static const char* level_to_string(DiagnosticLevel level) {
   return "unknown";
 }
 
-static const char* phase_to_string(DiagnosticPhase phase) {
+const char* phase_to_string(DiagnosticPhase phase) {
   switch (phase) {
     case DiagnosticPhase::Tokenizer:   return "tokenizer";
     case DiagnosticPhase::Lexer:       return "lexer";
     case DiagnosticPhase::Parser:      return "parser";
     case DiagnosticPhase::Resolver:    return "resolver";
     case DiagnosticPhase::TypeChecker: return "type-checker";
+    case DiagnosticPhase::Folder:      return "folder";
     case DiagnosticPhase::CodeGen:     return "codegen";
   }
   return "unknown";
 }
 
-static const char* level_color(DiagnosticLevel level) {
-  switch (level) {
-    case DiagnosticLevel::Fail: return RED;
-    case DiagnosticLevel::Warn: return YELLOW;
-    case DiagnosticLevel::Note: return CYAN;
+bool use_color(ColorMode mode, const std::ostream& out) {
+  if (mode != ColorMode::Auto) return mode == ColorMode::Always;
+  if (const char* no_color = std::getenv("NO_COLOR"); no_color && *no_color) return false;
+  if (&out == &std::cout) return isatty(STDOUT_FILENO);
+  if (&out == &std::cerr || &out == &std::clog) return isatty(STDERR_FILENO);
+  return false;
+}
+
+namespace {
+
+// Escape sequences print_all() writes; all empty without color.
+struct Palette {
+  const char* reset;
+  const char* bold;
+  const char* dim;
+  const char* red;
+  const char* yellow;
+  const char* cyan;
+  const char* magenta;
+  const char* blue;
+
+  const char* level(DiagnosticLevel level) const {
+    switch (level) {
+      case DiagnosticLevel::Fail: return this->red;
+      case DiagnosticLevel::Warn: return this->yellow;
+      case DiagnosticLevel::Note: return this->cyan;
+    }
+    return this->reset;
+  }
+};
+
+constexpr Palette colored{ RESET, BOLD, DIM, RED, YELLOW, CYAN, MAGENTA, BLUE };
+constexpr Palette plain{ "", "", "", "", "", "", "", "" };
+
+// Written out whenever it holds this much, so memory stays bounded however
+// many diagnostics there are.
+constexpr size_t render_flush_bytes = 1 << 20;
+
+// Appends to one buffer reused for the whole print.
+class Renderer {
+public:
+  Renderer(std::string& buf, const Palette& p) : buf(buf), p(p) {}
+
+  Renderer& operator<<(std::string_view s) {
+    this->buf.append(s);
+    return *this;
+  }
+
+  Renderer& operator<<(char c) {
+    this->buf.push_back(c);
+    return *this;
   }
-  return RESET;
+
+  Renderer& operator<<(size_t n) {
+    char digits[24];
+    auto [end, _] = std::to_chars(digits, digits + sizeof digits, n);
+    this->buf.append(digits, end);
+    return *this;
+  }
+
+  // `width` columns of line number (or blanks) and the bar after it.
+  void gutter(size_t width, size_t line = 0) {
+    char digits[24];
+    size_t len = 0;
+    if (line > 0) len = std::to_chars(digits, digits + sizeof digits, line).ptr - digits;
+    this->buf.append(width - len, ' ');
+    *this << this->p.blue << std::string_view(digits, len) << " |" << this->p.reset << ' ';
+  }
+
+private:
+  std::string& buf;
+  const Palette& p;
+};
+
+size_t digit_count(size_t n) {
+  size_t digits = 1;
+  while (n >= 10) {
+    n /= 10;
+    digits++;
+  }
+  return digits;
+}
+
 }
 
-static std::string gutter(size_t width, const std::string& content = "") {
-  std::string pad(width - content.size(), ' ');
-  return std::format("{}{}{} |{} ", pad, BLUE, content, RESET);
+std::vector<const Diagnostic*> DiagnosticEngine::sorted() const {
+  std::vector<const Diagnostic*> sorted;
+  sorted.reserve(this->all().size());
+  for (const auto& d : this->diagnostics) sorted.push_back(&d);
+  std::stable_sort(sorted.begin(), sorted.end(),
+    [](const Diagnostic* a, const Diagnostic* b) { return diagnostic_before(*a, *b); });
+  return sorted;
 }
 
-void DiagnosticEngine::print_all(std::ostream& out) {
-  std::sort(diagnostics.begin(), diagnostics.end(),
-    [](const Diagnostic& a, const Diagnostic& b) {
-      if (a.location.line != b.location.line)
-        return a.location.line < b.location.line;
-      return a.location.column < b.location.column;
-    });
+void DiagnosticEngine::print_all(std::ostream& out, ColorMode color) {
+  const auto& lines = this->line_index();
 
-  for (const auto& d : diagnostics) {
-    const char* color = level_color(d.level);
-    const bool has_location = d.location.line > 0;
+  const Palette& p = use_color(color, out) ? colored : plain;
+  std::string& buf = this->render_buffer;
+  buf.clear();
+  Renderer r(buf, p);
+  std::string_view path = this->source_path.empty() ? std::string_view("<source>") : std::string_view(this->source_path);
+
+  for (const auto* dp : this->sorted()) {
+    const auto& d = *dp;
+    const char* color = p.level(d.level);
+    const bool has_location = d.range.has_location();
     const bool can_show_source =
       has_location
-      && !source_lines.empty()
-      && d.location.line <= source_lines.size();
+      && !this->source_text.empty()
+      && d.range.begin <= this->source_text.size();
+    const auto at = has_location ? lines.position(d.range.begin) : SourcePosition{ 0, 0 };
 
-    out
-      << BOLD << color << level_to_string(d.level) << RESET
-      << BOLD << ": " << d.message << RESET << "\n";
+    r << p.bold << color << level_to_string(d.level) << p.reset
+      << p.bold << ": " << d.message << p.reset << '\n';
 
     if (has_location) {
-      out
-        << "  " << BLUE << "-->" << RESET << " "
-        << (source_path.empty() ? "<source>" : source_path)
-        << ":" << d.location.line << ":" << d.location.column
-        << DIM << "  [" << MAGENTA << phase_to_string(d.phase)
-        << RESET << DIM << "]" << RESET << "\n";
+      r << "  " << p.blue << "-->" << p.reset << ' '
+        << path << ':' << at.line << ':' << at.column
+        << p.dim << "  [" << p.magenta << phase_to_string(d.phase)
+        << p.reset << p.dim << ']' << p.reset << '\n';
     } else {
-      out
-        << "  " << BLUE << "-->" << RESET << " "
-        << DIM << "(no source location)  [" << MAGENTA
-        << phase_to_string(d.phase) << RESET << DIM << "]" << RESET << "\n";
+      r << "  " << p.blue << "-->" << p.reset << ' '
+        << p.dim << "(no source location)  [" << p.magenta
+        << phase_to_string(d.phase) << p.reset << p.dim << ']' << p.reset << '\n';
     }
 
     if (can_show_source) {
-      std::string line_str = std::to_string(d.location.line);
-      size_t gutter_w = line_str.size();
-
-      out << gutter(gutter_w) << "\n";
-      out
-        << gutter(gutter_w, line_str)
-        << source_lines[d.location.line - 1] << "\n";
-
-      std::string caret_pad;
-      if (d.location.column > 0) caret_pad.assign(d.location.column - 1, ' ');
-      out
-        << gutter(gutter_w)
-        << caret_pad << color << "^" << RESET << "\n";
+      size_t gutter_w = digit_count(at.line);
+      auto text = lines.line(this->source_text, at.line);
+
+      r.gutter(gutter_w);
+      r << '\n';
+      r.gutter(gutter_w, at.line);
+      r << text << '\n';
+
+      // The whole range, cut off at the end of its first line.
+      size_t width = d.range.end > d.range.begin ? d.range.end - d.range.begin : 1;
+      width = std::clamp<size_t>(width, 1, std::max<size_t>(text.size() + 1, at.column) - at.column + 1);
+      r.gutter(gutter_w);
+      buf.append(at.column - 1, ' ');
+      r << color;
+      buf.append(width, '^');
+      r << p.reset << '\n';
     }
 
-    for (const auto& note : d.related) {
-      out
-        << "  " << CYAN << "= note:" << RESET << " " << note.message;
-      if (note.location.line > 0) {
-        out
-          << DIM << " (" << note.location.line
-          << ":" << note.location.column << ")" << RESET;
+    for (const auto& note : this->diagnostics.notes_of(d)) {
+      r << "  " << p.cyan << "= note:" << p.reset << ' ' << note.message;
+      if (note.range.has_location()) {
+        auto note_at = lines.position(note.range.begin);
+        r << p.dim << " (" << note_at.line
+          << ':' << note_at.column << ')' << p.reset;
       }
-      out << "\n";
+      r << '\n';
+    }
+
+    r << '\n';
+
+    if (buf.size() >= render_flush_bytes) {
+      out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+      buf.clear();
     }
+  }
 
-    out << "\n";
+  if (this->dropped() > 0) {
+    r << p.bold << p.cyan << "note" << p.reset << p.bold << ": "
+      << this->dropped() << " more diagnostic" << (this->dropped() == 1 ? "" : "s")
+      << " not shown (limit reached)" << p.reset << "\n\n";
   }
+
+  out.write(buf.data(), static_cast<std::streamsize>(buf.size()));
+  // Keep the capacity for the next print, not the text.
+  buf.clear();
 }
@@ -0,0 +1,174 @@
+#include <ether/diagnostics/diagnostic_stream.hpp>
+#include <ether/lsp/json.hpp>
+#include <algorithm>
+#include <charconv>
+#include <ostream>
+
+namespace {
+
+void append_number(std::string& out, size_t n) {
+  char buf[24];
+  auto [end, _] = std::to_chars(buf, buf + sizeof buf, n);
+  out.append(buf, end);
+}
+
+// SARIF locations are URIs; absolute paths become file URIs.
+std::string sarif_uri(const std::string& path) {
+  return !path.empty() && path.front() == '/' ? "file://" + path : path;
+}
+
+// Columns a range spans on its first line; at least one.
+size_t width_of(const SourceRange& range) {
+  return range.end > range.begin ? range.end - range.begin : 1;
+}
+
+// Line 0, column 0 for no location.
+SourcePosition position_of(DiagnosticEngine& eng, const SourceRange& range) {
+  return range.has_location() ? eng.position(range.begin) : SourcePosition{ 0, 0 };
+}
+
+// {"startLine":..,"startColumn":..,"endColumn":..}; columns are 1-based
+// and the end is exclusive.
+void append_region(std::string& out, DiagnosticEngine& eng, const SourceRange& range) {
+  auto at = eng.position(range.begin);
+  out += "\"region\":{\"startLine\":";
+  append_number(out, at.line);
+  out += ",\"startColumn\":";
+  append_number(out, at.column);
+  out += ",\"endColumn\":";
+  append_number(out, at.column + width_of(range));
+  out += '}';
+}
+
+}
+
+std::optional<DiagnosticFormat> diagnostic_format_from(std::string_view name) {
+  if (name == "text") return DiagnosticFormat::Text;
+  if (name == "jsonl") return DiagnosticFormat::JsonLines;
+  if (name == "sarif") return DiagnosticFormat::Sarif;
+  return std::nullopt;
+}
+
+void DiagnosticStream::write(DiagnosticEngine& eng) {
+  if (this->format == DiagnosticFormat::Text) {
+    eng.print_all(this->out, this->color);
+    return;
+  }
+
+  this->open();
+  if (this->format == DiagnosticFormat::JsonLines) {
+    for (const auto* d : eng.sorted()) this->write_json_line(*d, eng);
+    return;
+  }
+
+  auto uri = sarif_uri(eng.path());
+  for (const auto* d : eng.sorted()) this->write_sarif_result(*d, eng, uri);
+}
+
+void DiagnosticStream::open() {
+  if (this->opened) return;
+  this->opened = true;
+  if (this->format != DiagnosticFormat::Sarif) return;
+
+  this->out
+    << "{\"$schema\":\"https://json.schemastore.org/sarif-2.1.0.json\",\"version\":\"2.1.0\","
+    << "\"runs\":[{\"tool\":{\"driver\":{\"name\":\"ether\",\"rules\":[";
+  for (auto phase : { DiagnosticPhase::Tokenizer, DiagnosticPhase::Lexer, DiagnosticPhase::Parser,
+                      DiagnosticPhase::Resolver, DiagnosticPhase::TypeChecker, DiagnosticPhase::Folder,
+                      DiagnosticPhase::CodeGen }) {
+    if (phase != DiagnosticPhase::Tokenizer) this->out << ',';
+    this->out << "{\"id\":\"" << phase_to_string(phase) << "\"}";
+  }
+  this->out << "]}},\"results\":[\n";
+}
+
+void DiagnosticStream::finish() {
+  if (this->finished) return;
+  this->finished = true;
+  if (this->format != DiagnosticFormat::Sarif) return;
+
+  this->open();
+  this->out << "]}]}\n";
+  this->out.flush();
+}
+
+void DiagnosticStream::write_json_line(const Diagnostic& d, DiagnosticEngine& eng) {
+  auto& line = this->line;
+  line.clear();
+  auto at = position_of(eng, d.range);
+  line += "{\"file\":";
+  append_json_string(line, eng.path());
+  line += ",\"line\":";
+  append_number(line, at.line);
+  line += ",\"column\":";
+  append_number(line, at.column);
+  line += ",\"width\":";
+  append_number(line, width_of(d.range));
+  line += ",\"level\":\"";
+  line += level_to_string(d.level);
+  line += "\",\"phase\":\"";
+  line += phase_to_string(d.phase);
+  line += "\",\"message\":";
+  append_json_string(line, d.message);
+  line += ",\"related\":[";
+  auto notes = eng.all().notes_of(d);
+  for (size_t i = 0; i < notes.size(); ++i) {
+    const auto& note = notes[i];
+    auto note_at = position_of(eng, note.range);
+    if (i) line += ',';
+    line += "{\"line\":";
+    append_number(line, note_at.line);
+    line += ",\"column\":";
+    append_number(line, note_at.column);
+    line += ",\"message\":";
+    append_json_string(line, note.message);
+    line += '}';
+  }
+  line += "]}\n";
+  this->out << line;
+}
+
+void DiagnosticStream::write_sarif_result(const Diagnostic& d, DiagnosticEngine& eng, const std::string& uri) {
+  auto& line = this->line;
+  line.clear();
+  if (this->results++ > 0) line += ",\n";
+
+  // Related notes carry their message on the location.
+  auto location = [&](const SourceRange& range, const std::string* message) {
+    line += "{\"physicalLocation\":{\"artifactLocation\":{\"uri\":";
+    append_json_string(line, uri);
+    line += '}';
+    if (range.has_location()) {
+      line += ',';
+      append_region(line, eng, range);
+    }
+    line += '}';
+    if (message) {
+      line += ",\"message\":{\"text\":";
+      append_json_string(line, *message);
+      line += '}';
+    }
+    line += '}';
+  };
+
+  line += "{\"ruleId\":\"";
+  line += phase_to_string(d.phase);
+  line += "\",\"level\":\"";
+  line += level_to_string(d.level);
+  line += "\",\"message\":{\"text\":";
+  append_json_string(line, d.message);
+  line += "},\"locations\":[";
+  location(d.range, nullptr);
+  line += "]";
+  auto notes = eng.all().notes_of(d);
+  if (!notes.empty()) {
+    line += ",\"relatedLocations\":[";
+    for (size_t i = 0; i < notes.size(); ++i) {
+      if (i) line += ',';
+      location(notes[i].range, &notes[i].message);
+    }
+    line += "]";
+  }
+  line += '}';
+  this->out << line;
+}
@@ -1,6 +1,7 @@
 #include <ether/import_res/import_res.hpp>
 #include <algorithm>
 #include <cctype>
+#include <string>
 #include <string_view>
 
 bool is_valid_import_path(Token tok) {
@@ -20,3 +21,29 @@ bool is_valid_import_path(Token tok) {
 
   return is_val;
 }
+
+std::filesystem::path import_path_to_file(const std::filesystem::path& root, std::string_view import_path) {
+  std::filesystem::path file = root;
+  size_t start = 0;
+  while (true) {
+    size_t dot = import_path.find('.', start);
+    file /= import_path.substr(start, dot - start);
+    if (dot == std::string_view::npos) break;
+    start = dot + 1;
+  }
+  file += module_file_extension;
+  return file;
+}
+
+std::string file_to_import_path(const std::filesystem::path& root, const std::filesystem::path& file) {
+  auto rel = file.lexically_normal().lexically_relative(root.lexically_normal());
+  if (rel.empty() || *rel.begin() == "..") return file.stem().string();
+
+  std::string import_path;
+  rel.replace_extension();
+  for (const auto& part : rel) {
+    if (!import_path.empty()) import_path += '.';
+    import_path += part.string();
+  }
+  return import_path;
+}
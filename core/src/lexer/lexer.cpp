@@ -7,9 +7,24 @@
 #include <ether/tables/keyword_table.hpp>
 #include <ether/tables/operator_table.hpp>
 
+// Tokens lexed between polls of the cancellation token.
+static constexpr size_t cancel_poll_tokens = 256;
+
 
 void Lexer::scan_tokens() {
   this->set_token_start();
+  this->scan_from_here(nullptr);
+}
+
+std::optional<LexPosition> Lexer::rescan(LexPosition from, const std::function<bool(size_t)>& stop) {
+  this->position = from.offset;
+  this->line_number = from.line;
+  this->column_number = from.column;
+  this->set_token_start();
+  return this->scan_from_here(&stop);
+}
+
+std::optional<LexPosition> Lexer::scan_from_here(const std::function<bool(size_t)>* stop) {
   while(!this->is_file_end()) {
     char c = this->peek();
 
@@ -18,6 +33,19 @@ void Lexer::scan_tokens() {
       continue;
     }
 
+    if (stop && (*stop)(this->position)) {
+      this->lex_diag.flush();
+      return LexPosition{ this->position, this->line_number, this->column_number };
+    }
+
+    if (this->tokens.size() % cancel_poll_tokens == 0 && this->cancel.is_cancelled()) {
+      break;
+    }
+
+    if (this->lex_diag.should_stop()) {
+      break;
+    }
+
     if (this->is_delim(c)) {
       this->set_token_start();
       this->make_token(TokenType::Delim, {','});
@@ -56,11 +84,35 @@ void Lexer::scan_tokens() {
     }
 
     auto tok = this->make_token(TokenType::Unknown, {c});
-    this->lex_diag.unknown_character(tok);
+    this->lex_diag.unknown_character(tok, this->tokens.size() - 1);
     continue;
   }
 
+  this->lex_diag.flush();
   this->make_token(TokenType::EoF, "");
+  return std::nullopt;
+}
+
+void Lexer::scan_imports() {
+  while (!this->is_file_end()) {
+    char c = this->peek();
+
+    if (this->is_whitespace_or_newline(c)) {
+      this->advance();
+      continue;
+    }
+
+    if (!std::isalpha(c)) return;
+
+    // Comments produce no token; anything other than `Load` ends the scan.
+    size_t before = this->tokens.size();
+    this->scan_keyword_or_identifier();
+    if (this->tokens.size() == before) continue;
+    if (this->tokens[before].token_type != TokenType::ImportKeyword) {
+      this->tokens.resize(before);
+      return;
+    }
+  }
 }
 
 void Lexer::scan_keyword_or_identifier() {
@@ -258,7 +310,7 @@ bool Lexer::scan_other_symbol() {
     default:
       this->advance();
       auto tok = this->make_token(TokenType::Unknown, std::string(1, c));
-      this->lex_diag.unknown_character(tok);
+      this->lex_diag.unknown_character(tok, this->tokens.size() - 1);
       return true;
   }
 }
@@ -382,6 +434,7 @@ Token Lexer::make_token(TokenType type, std::string value) {
   tok.token_value = value;
   tok.line_number = this->token_start_line;
   tok.column_number = this->token_start_column;
+  tok.offset = this->token_start_offset;
   this->tokens.push_back(tok);
   return tok;
 }
@@ -413,4 +466,5 @@ size_t Lexer::get_column_number() {
 void Lexer::set_token_start() {
   this->token_start_line = this->get_line_number();
   this->token_start_column = this->get_column_number();
+  this->token_start_offset = this->position;
 }
@@ -1,18 +1,74 @@
 #include <ether/lexer/lexer_diag.hpp>
 #include <format>
 
-void LexerDiagnostics::unknown_character(Token& tok) {
+namespace {
+// Characters (code points) of a run quoted in its message.
+constexpr size_t quoted_run_chars = 16;
+
+bool is_continuation(char c) {
+  return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+size_t code_points(const std::string& text) {
+  size_t n = 0;
+  for (char c : text) n += !is_continuation(c);
+  return n;
+}
+}
+
+void LexerDiagnostics::unknown_character(Token& tok, size_t index) {
+  if (
+    this->run
+    && this->run->last_index + 1 == index
+    && this->run->line == tok.line_number
+  ) {
+    auto& run = *this->run;
+    run.diag.range.end = token_range(tok).end;
+    // Unknown tokens are single bytes, so a character is only ever quoted
+    // whole: its continuation bytes follow it in, or not at all.
+    bool quoting = run.characters.size() == run.count;
+    if (quoting && (is_continuation(tok.token_value[0]) || code_points(run.characters) < quoted_run_chars)) {
+      run.characters += tok.token_value;
+    }
+    run.count++;
+    run.last_index = index;
+    return;
+  }
+
+  this->flush();
+
   Diagnostic diag;
   diag.level = DiagnosticLevel::Warn;
   diag.phase = DiagnosticPhase::Lexer;
-  diag.location = {
-    .line = tok.line_number,
-    .column = tok.column_number,
-  };
-  diag.message = std::format(
-    "Unrecognized token `{}` detected",
-    tok.token_value
-  );
-
-  this->diag_eng.report(diag);
+  diag.range = token_range(tok);
+
+  this->run = UnknownRun{ std::move(diag), tok.token_value, 1, index, tok.line_number };
+}
+
+void LexerDiagnostics::flush() {
+  if (!this->run) return;
+  auto& run = *this->run;
+
+  if (run.count == 1) {
+    run.diag.message = std::format(
+      "Unrecognized token `{}` detected",
+      run.characters
+    );
+  } else {
+    run.diag.message = std::format(
+      "{} unrecognized tokens `{}{}` detected",
+      run.count,
+      run.characters,
+      run.characters.size() < run.count ? "..." : ""
+    );
+  }
+
+  this->diag_eng.report(std::move(run.diag));
+  this->run.reset();
+}
+
+bool LexerDiagnostics::should_stop() {
+  if (!this->diag_eng.should_stop(DiagnosticPhase::Lexer)) return false;
+  this->flush();
+  return true;
 }
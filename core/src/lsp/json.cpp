@@ -0,0 +1,317 @@
+#include <ether/lsp/json.hpp>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+// Deeper nesting than any protocol message has; bounds the recursion on
+// hostile input.
+constexpr size_t max_depth = 256;
+
+class JsonReader {
+public:
+  explicit JsonReader(std::string_view text) : text(text) {}
+
+  std::optional<Json> read_document() {
+    auto v = this->read_value(0);
+    this->skip_space();
+    if (!v || this->pos != this->text.size()) return std::nullopt;
+    return v;
+  }
+
+private:
+  std::string_view text;
+  size_t pos = 0;
+
+  void skip_space() {
+    while (this->pos < this->text.size()) {
+      char c = this->text[this->pos];
+      if (c != ' ' && c != '\t' && c != '\n' && c != '\r') return;
+      ++this->pos;
+    }
+  }
+
+  bool consume(char c) {
+    this->skip_space();
+    if (this->pos < this->text.size() && this->text[this->pos] == c) {
+      ++this->pos;
+      return true;
+    }
+    return false;
+  }
+
+  bool consume_word(std::string_view word) {
+    if (this->text.substr(this->pos, word.size()) != word) return false;
+    this->pos += word.size();
+    return true;
+  }
+
+  std::optional<Json> read_value(size_t depth) {
+    if (depth > max_depth) return std::nullopt;
+    this->skip_space();
+    if (this->pos >= this->text.size()) return std::nullopt;
+
+    switch (this->text[this->pos]) {
+      case '{': return this->read_object(depth);
+      case '[': return this->read_array(depth);
+      case '"': {
+        auto s = this->read_string();
+        if (!s) return std::nullopt;
+        return Json(std::move(*s));
+      }
+      case 't': if (this->consume_word("true")) return Json(true); return std::nullopt;
+      case 'f': if (this->consume_word("false")) return Json(false); return std::nullopt;
+      case 'n': if (this->consume_word("null")) return Json(); return std::nullopt;
+      default: return this->read_number();
+    }
+  }
+
+  std::optional<Json> read_object(size_t depth) {
+    ++this->pos;
+    Json::Object members;
+    if (this->consume('}')) return Json(std::move(members));
+
+    do {
+      this->skip_space();
+      if (this->pos >= this->text.size() || this->text[this->pos] != '"') return std::nullopt;
+      auto key = this->read_string();
+      if (!key || !this->consume(':')) return std::nullopt;
+      auto v = this->read_value(depth + 1);
+      if (!v) return std::nullopt;
+      members.emplace_back(std::move(*key), std::move(*v));
+    } while (this->consume(','));
+
+    if (!this->consume('}')) return std::nullopt;
+    return Json(std::move(members));
+  }
+
+  std::optional<Json> read_array(size_t depth) {
+    ++this->pos;
+    Json::Array elements;
+    if (this->consume(']')) return Json(std::move(elements));
+
+    do {
+      auto v = this->read_value(depth + 1);
+      if (!v) return std::nullopt;
+      elements.push_back(std::move(*v));
+    } while (this->consume(','));
+
+    if (!this->consume(']')) return std::nullopt;
+    return Json(std::move(elements));
+  }
+
+  std::optional<Json> read_number() {
+    size_t start = this->pos;
+    if (this->pos < this->text.size() && this->text[this->pos] == '-') ++this->pos;
+    if (this->pos >= this->text.size() || !std::isdigit(static_cast<unsigned char>(this->text[this->pos]))) {
+      return std::nullopt;
+    }
+    while (this->pos < this->text.size()) {
+      char c = this->text[this->pos];
+      if (!std::isdigit(static_cast<unsigned char>(c)) && c != '.' && c != 'e' && c != 'E' && c != '+' && c != '-') break;
+      ++this->pos;
+    }
+
+    double n = 0;
+    auto [end, ec] = std::from_chars(this->text.data() + start, this->text.data() + this->pos, n);
+    if (ec != std::errc() || end != this->text.data() + this->pos) return std::nullopt;
+    return Json(n);
+  }
+
+  std::optional<uint32_t> read_hex4() {
+    if (this->pos + 4 > this->text.size()) return std::nullopt;
+    uint32_t unit = 0;
+    auto [end, ec] = std::from_chars(this->text.data() + this->pos, this->text.data() + this->pos + 4, unit, 16);
+    if (ec != std::errc() || end != this->text.data() + this->pos + 4) return std::nullopt;
+    this->pos += 4;
+    return unit;
+  }
+
+  static void append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+      out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+      out += static_cast<char>(0xC0 | (cp >> 6));
+      out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+      out += static_cast<char>(0xE0 | (cp >> 12));
+      out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+      out += static_cast<char>(0xF0 | (cp >> 18));
+      out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+      out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+  }
+
+  std::optional<std::string> read_string() {
+    ++this->pos;
+    std::string out;
+    while (this->pos < this->text.size()) {
+      char c = this->text[this->pos++];
+      if (c == '"') return out;
+      if (static_cast<unsigned char>(c) < 0x20) return std::nullopt;
+      if (c != '\\') {
+        out += c;
+        continue;
+      }
+
+      if (this->pos >= this->text.size()) return std::nullopt;
+      switch (this->text[this->pos++]) {
+        case '"':  out += '"';  break;
+        case '\\': out += '\\'; break;
+        case '/':  out += '/';  break;
+        case 'b':  out += '\b'; break;
+        case 'f':  out += '\f'; break;
+        case 'n':  out += '\n'; break;
+        case 'r':  out += '\r'; break;
+        case 't':  out += '\t'; break;
+        case 'u': {
+          auto unit = this->read_hex4();
+          if (!unit) return std::nullopt;
+          uint32_t cp = *unit;
+          // A surrogate pair spells one code point above the BMP.
+          if (cp >= 0xD800 && cp < 0xDC00 && this->consume_word("\\u")) {
+            auto low = this->read_hex4();
+            if (!low || *low < 0xDC00 || *low >= 0xE000) return std::nullopt;
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (*low - 0xDC00);
+          }
+          append_utf8(out, cp);
+          break;
+        }
+        default: return std::nullopt;
+      }
+    }
+    return std::nullopt;
+  }
+};
+
+}
+
+void append_json_string(std::string& out, std::string_view s) {
+  out += '"';
+  for (char c : s) {
+    switch (c) {
+      case '"':  out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n";  break;
+      case '\r': out += "\\r";  break;
+      case '\t': out += "\\t";  break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          char buf[8];
+          std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned>(c));
+          out += buf;
+        } else {
+          out += c;
+        }
+    }
+  }
+  out += '"';
+}
+
+std::optional<Json> Json::parse(std::string_view text) {
+  return JsonReader(text).read_document();
+}
+
+std::string Json::dump() const {
+  std::string out;
+  this->write(out);
+  return out;
+}
+
+void Json::write(std::string& out) const {
+  if (this->is_null()) {
+    out += "null";
+  } else if (auto b = std::get_if<bool>(&this->value)) {
+    out += *b ? "true" : "false";
+  } else if (auto n = std::get_if<double>(&this->value)) {
+    char buf[32];
+    if (auto i = this->integer()) {
+      std::snprintf(buf, sizeof(buf), "%lld", static_cast<long long>(*i));
+    } else if (std::isfinite(*n)) {
+      std::snprintf(buf, sizeof(buf), "%.17g", *n);
+    } else {
+      std::snprintf(buf, sizeof(buf), "null");
+    }
+    out += buf;
+  } else if (auto s = this->string()) {
+    append_json_string(out, *s);
+  } else if (auto a = this->array()) {
+    out += '[';
+    for (size_t i = 0; i < a->size(); ++i) {
+      if (i) out += ',';
+      (*a)[i].write(out);
+    }
+    out += ']';
+  } else if (auto o = this->object()) {
+    out += '{';
+    for (size_t i = 0; i < o->size(); ++i) {
+      if (i) out += ',';
+      append_json_string(out, (*o)[i].first);
+      out += ':';
+      (*o)[i].second.write(out);
+    }
+    out += '}';
+  }
+}
+
+std::optional<bool> Json::boolean() const {
+  if (auto b = std::get_if<bool>(&this->value)) return *b;
+  return std::nullopt;
+}
+
+std::optional<double> Json::number() const {
+  if (auto n = std::get_if<double>(&this->value)) return *n;
+  return std::nullopt;
+}
+
+std::optional<int64_t> Json::integer() const {
+  auto n = this->number();
+  // 2^63 itself does not fit; everything below it that is whole does.
+  if (!n || std::trunc(*n) != *n || *n < -9223372036854775808.0 || *n >= 9223372036854775808.0) {
+    return std::nullopt;
+  }
+  return static_cast<int64_t>(*n);
+}
+
+const Json* Json::find(std::string_view key) const {
+  auto o = this->object();
+  if (!o) return nullptr;
+  for (const auto& [k, v] : *o) {
+    if (k == key) return &v;
+  }
+  return nullptr;
+}
+
+const Json& Json::at(std::initializer_list<std::string_view> keys) const {
+  static const Json null;
+  const Json* v = this;
+  for (auto key : keys) {
+    v = v->find(key);
+    if (!v) return null;
+  }
+  return *v;
+}
+
+Json& Json::set(std::string key, Json member) {
+  if (this->is_null()) this->value = Object{};
+  auto& o = std::get<Object>(this->value);
+  for (auto& [k, v] : o) {
+    if (k == key) {
+      v = std::move(member);
+      return *this;
+    }
+  }
+  o.emplace_back(std::move(key), std::move(member));
+  return *this;
+}
+
+Json& Json::push(Json element) {
+  if (this->is_null()) this->value = Array{};
+  std::get<Array>(this->value).push_back(std::move(element));
+  return *this;
+}
@@ -0,0 +1,483 @@
+#include <ether/lsp/lsp_server.hpp>
+#include <ether/import_res/import_res.hpp>
+#include <ether/lexer/lexer.hpp>
+#include <ether/support/line_index.hpp>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <istream>
+#include <ostream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// JSON-RPC and LSP error codes.
+constexpr int parse_error = -32700;
+constexpr int invalid_request = -32600;
+constexpr int method_not_found = -32601;
+constexpr int server_not_initialized = -32002;
+
+// LSP TextDocumentSyncKind.
+constexpr int sync_incremental = 2;
+
+fs::path uri_to_path(std::string_view uri) {
+  constexpr std::string_view scheme = "file://";
+  if (!uri.starts_with(scheme)) return fs::path(std::string(uri));
+  uri.remove_prefix(scheme.size());
+
+  std::string decoded;
+  for (size_t i = 0; i < uri.size(); ++i) {
+    unsigned value = 0;
+    if (uri[i] == '%' && i + 2 < uri.size()
+        && std::from_chars(uri.data() + i + 1, uri.data() + i + 3, value, 16).ptr == uri.data() + i + 3) {
+      decoded += static_cast<char>(value);
+      i += 2;
+    } else {
+      decoded += uri[i];
+    }
+  }
+#ifdef _WIN32
+  // file:///C:/x -> C:/x
+  if (decoded.size() >= 3 && decoded[0] == '/' && decoded[2] == ':') decoded.erase(0, 1);
+#endif
+  return fs::path(decoded);
+}
+
+size_t utf8_length(unsigned char lead) {
+  return lead < 0xC0 ? 1 : lead < 0xE0 ? 2 : lead < 0xF0 ? 3 : 4;
+}
+
+// LSP counts characters in UTF-16 code units; the lexer counts bytes.
+size_t utf16_length(std::string_view text) {
+  size_t units = 0;
+  for (size_t i = 0; i < text.size(); i += utf8_length(text[i])) {
+    units += utf8_length(text[i]) == 4 ? 2 : 1;
+  }
+  return units;
+}
+
+// Byte offset of an LSP position in `text`, clamped to its line and to the
+// text.
+size_t offset_of(const std::string& text, const Json& position) {
+  int64_t line = position.at({"line"}).integer().value_or(0);
+  int64_t character = position.at({"character"}).integer().value_or(0);
+
+  size_t start = 0;
+  for (; line > 0; --line) {
+    auto nl = static_cast<const char*>(std::memchr(text.data() + start, '\n', text.size() - start));
+    if (!nl) return text.size();
+    start = nl - text.data() + 1;
+  }
+
+  size_t at = start;
+  while (character > 0 && at < text.size() && text[at] != '\n') {
+    size_t len = utf8_length(text[at]);
+    character -= len == 4 ? 2 : 1;
+    at = std::min(at + len, text.size());
+  }
+  return at;
+}
+
+class DocumentRanges {
+public:
+  explicit DocumentRanges(const std::string& text) : text(text), lines(text) {}
+
+  // LSP range of `range`, cut off at the end of its first line. An empty
+  // one covers the word starting there, or one character; no location
+  // means the start of the document.
+  Json of(const SourceRange& range) const {
+    size_t at = range.has_location() ? std::min<size_t>(range.begin, this->text.size()) : 0;
+    auto pos = this->lines.position(at);
+    size_t line_start = at - (pos.column - 1);
+    size_t line_end = line_start + this->lines.line(this->text, pos.line).size();
+
+    size_t begin = std::min(at, line_end);
+    size_t width = range.has_location() && range.end > range.begin ? range.end - range.begin : 0;
+    size_t end = width > 1 ? std::min(begin + width, line_end) : begin;
+    while (width <= 1 && end < line_end && (std::isalnum(static_cast<unsigned char>(this->text[end])) || this->text[end] == '_')) ++end;
+    if (end == begin && end < line_end) end = std::min(end + utf8_length(this->text[end]), line_end);
+
+    auto position = [&](size_t offset) {
+      return Json(Json::Object{
+        { "line", pos.line - 1 },
+        { "character", utf16_length(std::string_view(this->text).substr(line_start, offset - line_start)) },
+      });
+    };
+    return Json(Json::Object{ { "start", position(begin) }, { "end", position(end) } });
+  }
+
+private:
+  const std::string& text;
+  LineIndex lines;
+};
+
+int severity_of(DiagnosticLevel level) {
+  switch (level) {
+    case DiagnosticLevel::Fail: return 1;
+    case DiagnosticLevel::Warn: return 2;
+    case DiagnosticLevel::Note: return 3;
+  }
+  return 1;
+}
+
+std::vector<std::string> imports_of(const std::string& source) {
+  // The pre-scan never reports; real diagnostics come from the check.
+  DiagnosticEngine scratch;
+  Lexer lexer(source, scratch);
+  lexer.scan_imports();
+
+  std::vector<std::string> imports;
+  for (const auto& tok : lexer.get_tokens()) {
+    if (tok.token_type == TokenType::ImportModule) imports.push_back(tok.token_value);
+  }
+  return imports;
+}
+
+}
+
+std::optional<std::string> read_lsp_message(std::istream& in) {
+  std::optional<size_t> length;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.empty()) {
+      if (length) break;
+      continue;
+    }
+
+    auto colon = line.find(':');
+    if (colon == std::string::npos) continue;
+    std::string name = line.substr(0, colon);
+    std::ranges::transform(name, name.begin(), [](unsigned char c) { return std::tolower(c); });
+    if (name != "content-length") continue;
+
+    size_t value_at = line.find_first_not_of(' ', colon + 1);
+    if (value_at == std::string::npos) return std::nullopt;
+    size_t n = 0;
+    auto [end, ec] = std::from_chars(line.data() + value_at, line.data() + line.size(), n);
+    if (ec != std::errc()) return std::nullopt;
+    length = n;
+  }
+  if (!length) return std::nullopt;
+
+  std::string body(*length, '\0');
+  if (!in.read(body.data(), static_cast<std::streamsize>(body.size()))) return std::nullopt;
+  return body;
+}
+
+void write_lsp_message(std::ostream& out, std::string_view body) {
+  out << "Content-Length: " << body.size() << "\r\n\r\n" << body;
+  out.flush();
+}
+
+LspServer::LspServer(std::istream& in, std::ostream& out, LspOptions opts)
+: in(in), out(out), options(std::move(opts)),
+  pool(std::make_unique<TaskPool>(this->options.jobs)) {}
+
+LspServer::~LspServer() = default;
+
+int LspServer::run() {
+  int code = 1;
+  while (auto body = read_lsp_message(this->in)) {
+    auto message = Json::parse(*body);
+    if (!message || !message->is_object()) {
+      this->reply_error(Json(), parse_error, "message is not a JSON object");
+      continue;
+    }
+    if (!this->handle(*message)) {
+      code = this->shutdown_requested ? 0 : 1;
+      break;
+    }
+  }
+
+  // Workers may still be writing; stop them before the streams go away.
+  this->pool.reset();
+  return code;
+}
+
+void LspServer::send(const Json& message) {
+  auto body = message.dump();
+  std::lock_guard lock(this->out_mutex);
+  write_lsp_message(this->out, body);
+}
+
+void LspServer::reply(const Json& id, Json result) {
+  this->send(Json(Json::Object{
+    { "jsonrpc", "2.0" },
+    { "id", id },
+    { "result", std::move(result) },
+  }));
+}
+
+void LspServer::reply_error(const Json& id, int code, std::string message) {
+  this->send(Json(Json::Object{
+    { "jsonrpc", "2.0" },
+    { "id", id },
+    { "error", Json(Json::Object{ { "code", code }, { "message", std::move(message) } }) },
+  }));
+}
+
+bool LspServer::handle(const Json& message) {
+  const auto* method = message.at({"method"}).string();
+  const Json* id = message.find("id");
+  const Json& params = message.at({"params"});
+
+  if (!method) {
+    // A response to a request we never send, or garbage.
+    if (id) this->reply_error(*id, invalid_request, "missing method");
+    return true;
+  }
+
+  if (*method == "exit") return false;
+
+  if (id) {
+    if (*method == "initialize") {
+      this->reply(*id, this->initialize(params));
+    } else if (!this->initialized) {
+      this->reply_error(*id, server_not_initialized, "`initialize` has not been received");
+    } else if (this->shutdown_requested) {
+      this->reply_error(*id, invalid_request, "the server is shutting down");
+    } else if (*method == "shutdown") {
+      // Let checks in flight publish before answering.
+      this->pool->wait_idle();
+      this->shutdown_requested = true;
+      this->reply(*id, Json());
+    } else {
+      this->reply_error(*id, method_not_found, "unsupported method `" + *method + "`");
+    }
+    return true;
+  }
+
+  // Notifications. `$/cancelRequest` needs nothing: requests are answered
+  // as they arrive, and stale checks are dropped as soon as a newer change
+  // shows up.
+  if (!this->initialized || this->shutdown_requested) return true;
+  if (*method == "textDocument/didOpen") {
+    this->did_open(params);
+  } else if (*method == "textDocument/didChange") {
+    this->did_change(params);
+  } else if (*method == "textDocument/didClose") {
+    this->did_close(params);
+  } else if (*method == "textDocument/didSave") {
+    this->did_save();
+  }
+  return true;
+}
+
+Json LspServer::initialize(const Json& params) {
+  this->initialized = true;
+  if (const auto* uri = params.at({"rootUri"}).string()) {
+    this->workspace_root = uri_to_path(*uri);
+  } else if (const auto* path = params.at({"rootPath"}).string()) {
+    this->workspace_root = *path;
+  }
+
+  return Json(Json::Object{
+    { "capabilities", Json(Json::Object{
+      { "textDocumentSync", Json(Json::Object{
+        { "openClose", true },
+        { "change", sync_incremental },
+        { "save", true },
+      }) },
+    }) },
+    { "serverInfo", Json(Json::Object{ { "name", "ether" } }) },
+  });
+}
+
+void LspServer::did_open(const Json& params) {
+  const auto& item = params.at({"textDocument"});
+  const auto* uri = item.at({"uri"}).string();
+  const auto* text = item.at({"text"}).string();
+  if (!uri || !text) return;
+
+  auto doc = std::make_shared<Document>();
+  doc->uri = *uri;
+  doc->path = uri_to_path(*uri);
+  doc->root = !this->options.root.empty() ? this->options.root
+            : !this->workspace_root.empty() ? this->workspace_root
+            : doc->path.parent_path();
+  doc->text = *text;
+  doc->version = item.at({"version"}).integer().value_or(0);
+  doc->reload = *text;
+
+  // Reopening without a close replaces the old document.
+  if (auto it = this->documents.find(*uri); it != this->documents.end()) {
+    std::lock_guard lock(it->second->mutex);
+    it->second->closed = true;
+    it->second->stop.request_stop();
+  }
+  this->documents[*uri] = doc;
+  this->schedule(doc);
+}
+
+void LspServer::did_change(const Json& params) {
+  const auto* uri = params.at({"textDocument", "uri"}).string();
+  const auto* changes = params.at({"contentChanges"}).array();
+  if (!uri || !changes) return;
+  auto it = this->documents.find(*uri);
+  if (it == this->documents.end()) return;
+  auto& doc = it->second;
+
+  {
+    std::lock_guard lock(doc->mutex);
+    doc->version = params.at({"textDocument", "version"}).integer().value_or(doc->version + 1);
+    doc->stop.request_stop();
+
+    for (const auto& change : *changes) {
+      const auto* text = change.at({"text"}).string();
+      if (!text) continue;
+      const auto& range = change.at({"range"});
+
+      if (range.is_null()) {
+        doc->text = *text;
+        doc->reload = *text;
+        doc->pending.clear();
+        continue;
+      }
+
+      size_t begin = offset_of(doc->text, range.at({"start"}));
+      size_t end = std::max(begin, offset_of(doc->text, range.at({"end"})));
+      TextEdit edit{ .offset = begin, .length = end - begin, .text = *text };
+      doc->text.replace(edit.offset, edit.length, edit.text);
+
+      if (doc->reload) {
+        doc->reload->replace(edit.offset, edit.length, edit.text);
+      } else {
+        doc->pending.push_back(std::move(edit));
+      }
+    }
+  }
+  this->schedule(doc);
+}
+
+void LspServer::did_close(const Json& params) {
+  const auto* uri = params.at({"textDocument", "uri"}).string();
+  if (!uri) return;
+  auto it = this->documents.find(*uri);
+  if (it == this->documents.end()) return;
+
+  auto doc = std::move(it->second);
+  this->documents.erase(it);
+
+  std::lock_guard lock(doc->mutex);
+  doc->closed = true;
+  doc->stop.request_stop();
+  this->publish(*doc, doc->version, nullptr);
+}
+
+void LspServer::did_save() {
+  // Any saved file may be a dependency of any open document.
+  for (auto& [uri, doc] : this->documents) {
+    {
+      std::lock_guard lock(doc->mutex);
+      doc->refresh_imports = true;
+      doc->stop.request_stop();
+    }
+    this->schedule(doc);
+  }
+}
+
+void LspServer::schedule(const std::shared_ptr<Document>& doc) {
+  {
+    std::lock_guard lock(doc->mutex);
+    if (doc->scheduled) return;
+    doc->scheduled = true;
+  }
+  this->pool->submit([this, doc] { this->check_document(doc); });
+}
+
+void LspServer::check_document(const std::shared_ptr<Document>& doc) {
+  // One worker at a time owns a scheduled document; it keeps going until it
+  // has caught up with every change.
+  while (true) {
+    std::optional<std::string> reload;
+    std::vector<TextEdit> edits;
+    bool refresh = false;
+    int64_t version = 0;
+    CancellationToken cancel;
+    {
+      std::lock_guard lock(doc->mutex);
+      if (doc->closed || (!doc->reload && doc->pending.empty() && !doc->refresh_imports)) {
+        doc->scheduled = false;
+        return;
+      }
+      reload = std::exchange(doc->reload, std::nullopt);
+      edits = std::exchange(doc->pending, {});
+      refresh = std::exchange(doc->refresh_imports, false);
+      version = doc->version;
+      doc->stop = std::stop_source();
+      cancel = CancellationToken(doc->stop.get_token());
+    }
+
+    // Edits made after a reload are already in its text. Once cancelled,
+    // apply_edit() only splices in the rest of them.
+    if (reload) {
+      doc->module = std::make_unique<Module>(doc->path.string(), std::move(*reload));
+    } else {
+      for (const auto& edit : edits) doc->module->apply_edit(edit, cancel);
+    }
+
+    auto imports = imports_of(doc->module->get_source());
+    if (refresh || !doc->dependencies || imports != doc->imports) {
+      auto dependencies = std::make_unique<ModuleLoader>(doc->root);
+      for (const auto& path : imports) {
+        auto file = import_path_to_file(doc->root, path);
+        std::error_code ec;
+        if (fs::is_regular_file(file, ec)) dependencies->add_entry(file);
+      }
+      dependencies->load();
+
+      // The module may still point into the old loader until this check.
+      doc->module->check(&dependencies->get_registry(), cancel);
+      doc->dependencies = std::move(dependencies);
+      doc->imports = std::move(imports);
+    } else if (reload || !doc->module->is_checked()) {
+      doc->module->check(&doc->dependencies->get_registry(), cancel);
+    }
+
+    std::lock_guard lock(doc->mutex);
+    bool stale = doc->reload || !doc->pending.empty() || doc->refresh_imports;
+    if (!doc->closed && !stale && doc->module->is_checked()) {
+      this->publish(*doc, version, doc->module.get());
+    }
+  }
+}
+
+void LspServer::publish(Document& doc, int64_t version, const Module* mod) {
+  Json diagnostics = Json(Json::Array{});
+  if (mod) {
+    DocumentRanges ranges(mod->get_source());
+    const auto& all = mod->get_diag_engine().all();
+    for (const auto* d : mod->get_diag_engine().sorted()) {
+      Json entry(Json::Object{
+        { "range", ranges.of(d->range) },
+        { "severity", severity_of(d->level) },
+        { "source", "ether" },
+        { "message", d->message },
+      });
+      if (d->note_count > 0) {
+        Json related = Json(Json::Array{});
+        for (const auto& note : all.notes_of(*d)) {
+          related.push(Json(Json::Object{
+            { "location", Json(Json::Object{ { "uri", doc.uri }, { "range", ranges.of(note.range) } }) },
+            { "message", note.message },
+          }));
+        }
+        entry.set("relatedInformation", std::move(related));
+      }
+      diagnostics.push(std::move(entry));
+    }
+  }
+
+  this->send(Json(Json::Object{
+    { "jsonrpc", "2.0" },
+    { "method", "textDocument/publishDiagnostics" },
+    { "params", Json(Json::Object{
+      { "uri", doc.uri },
+      { "version", version },
+      { "diagnostics", std::move(diagnostics) },
+    }) },
+  }));
+}
@@ -1,18 +1,28 @@
 #include <ether/module/module.hpp>
+#include <ether/ast/symbol_resolver/symbol_resolver.hpp>
+#include <ether/ast/type_check/type_check.hpp>
 #include <ether/lexer/lexer.hpp>
 #include <ether/parser/parsers.hpp>
 #include <cstdio>
 #include <utility>
 
-void Module::make_module_ast() {
+Module::Module(std::string path, std::string source)
+: module_path(std::move(path)),
+  source_text(std::move(source)) {}
+
+Module::~Module() = default;
+
+void Module::lex() {
   this->diag.set_source(this->module_path, this->source_text);
 
   Lexer lexer(this->source_text, this->diag);
   lexer.scan_tokens();
-  auto toks = lexer.get_tokens();
+  this->tokens = lexer.take_tokens();
+}
 
+void Module::parse() {
   ParserState state(this->diag);
-  state.set_state(toks);
+  state.set_state(std::exchange(this->tokens, {}));
   state.activate_logs();
   auto parent = run_parser(state);
 
@@ -28,12 +38,30 @@ void Module::attach_visitor(Visitor& visitor) {
   this->module_root.add_visitor(visitor);
 }
 
+void Module::attach_pass(TreePass& pass) {
+  this->module_root.add_pass(pass);
+}
+
 void Module::generate_ast() {
-  this->make_module_ast();
+  this->lex();
+  this->parse();
+}
+
+bool Module::apply_visitors(const CancellationToken& cancel) {
+  return this->module_root.apply_visitors(cancel);
+}
+
+void Module::resolve(SymbolResolver& resolver, size_t jobs) {
+  resolver.resolve_module(this->module_root, jobs);
+}
+
+void Module::replay_diagnostics(DiagnosticList diags) {
+  this->diag.set_source(this->module_path, this->source_text);
+  this->diag.absorb(std::move(diags));
 }
 
-void Module::apply_visitors() {
-  this->module_root.apply_visitors();
+void Module::set_ast(Parent root) {
+  this->module_root.children = std::move(root.children);
 }
 
 void Module::print_errors(std::ostream& out) {
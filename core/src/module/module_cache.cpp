@@ -0,0 +1,303 @@
+#include <ether/module/module_cache.hpp>
+#include <chrono>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <string>
+#include <system_error>
+#include <thread>
+
+namespace {
+constexpr uint32_t record_magic = 0x52435a42;  // "BZCR"
+constexpr uint32_t record_version = 8;
+
+// Native-endian field writer/reader for check records. Unlike interfaces,
+// records are decoded into owning structs, so no alignment is assumed.
+struct RecordWriter {
+  std::string out;
+
+  template <typename T>
+  void put(T value) {
+    this->out.append(reinterpret_cast<const char*>(&value), sizeof value);
+  }
+
+  void put_string(std::string_view s) {
+    this->put(static_cast<uint32_t>(s.size()));
+    this->out.append(s);
+  }
+
+  void put_range(const SourceRange& range) {
+    this->put(range.begin);
+    this->put(range.end);
+  }
+
+  // The diagnostic, then its notes.
+  void put_diagnostic(const DiagnosticList& list, const Diagnostic& diag) {
+    this->put(static_cast<uint8_t>(diag.level));
+    this->put(static_cast<uint8_t>(diag.phase));
+    this->put_range(diag.range);
+    this->put_string(diag.message);
+    this->put(diag.note_count);
+    for (const auto& note : list.notes_of(diag)) {
+      this->put_range(note.range);
+      this->put_string(note.message);
+    }
+  }
+};
+
+struct RecordReader {
+  std::span<const std::byte> bytes;
+  size_t at = 0;
+  bool ok = true;
+
+  template <typename T>
+  T get() {
+    T value{};
+    if (!this->ok || this->bytes.size() - this->at < sizeof value) {
+      this->ok = false;
+      return value;
+    }
+    std::memcpy(&value, this->bytes.data() + this->at, sizeof value);
+    this->at += sizeof value;
+    return value;
+  }
+
+  std::string get_string() {
+    auto size = this->get<uint32_t>();
+    if (!this->ok || this->bytes.size() - this->at < size) {
+      this->ok = false;
+      return {};
+    }
+    std::string s(reinterpret_cast<const char*>(this->bytes.data() + this->at), size);
+    this->at += size;
+    return s;
+  }
+
+  SourceRange get_range() {
+    SourceRange range;
+    range.begin = this->get<uint32_t>();
+    range.end = this->get<uint32_t>();
+    return range;
+  }
+
+  void get_diagnostic(DiagnosticList& into) {
+    Diagnostic diag{};
+    auto level = this->get<uint8_t>();
+    auto phase = this->get<uint8_t>();
+    if (level > static_cast<uint8_t>(DiagnosticLevel::Fail)
+        || phase > static_cast<uint8_t>(DiagnosticPhase::CodeGen)) {
+      this->ok = false;
+    }
+    diag.level = static_cast<DiagnosticLevel>(level);
+    diag.phase = static_cast<DiagnosticPhase>(phase);
+    diag.range = this->get_range();
+    diag.message = this->get_string();
+
+    auto n_notes = this->get<uint32_t>();
+    std::vector<DiagnosticNote> notes;
+    for (uint32_t i = 0; i < n_notes && this->ok; ++i) {
+      auto range = this->get_range();
+      notes.push_back(DiagnosticNote{ range, this->get_string() });
+    }
+    into.push_back(std::move(diag), notes);
+  }
+};
+}
+
+std::filesystem::path ModuleCache::file_for(std::string_view import_path) const {
+  return this->dir / (std::string(import_path) + ".bzi");
+}
+
+std::filesystem::path ModuleCache::record_file_for(std::string_view import_path) const {
+  return this->dir / (std::string(import_path) + ".bzc");
+}
+
+std::filesystem::path ModuleCache::ast_file_for(std::string_view import_path) const {
+  return this->dir / (std::string(import_path) + ".bza");
+}
+
+std::unique_ptr<CachedInterface> ModuleCache::load(std::string_view import_path, uint64_t source_hash) const {
+  MappedFile file(this->file_for(import_path));
+  if (!file.is_open()) return nullptr;
+
+  auto view = InterfaceView::parse(file.bytes());
+  if (!view || view->source_hash() != source_hash) return nullptr;
+
+  // Moving the mapping doesn't move the bytes, so the view stays valid.
+  return std::make_unique<CachedInterface>(CachedInterface{
+    .file = std::move(file),
+    .view = *view,
+  });
+}
+
+bool ModuleCache::store(std::string_view import_path, uint64_t source_hash, const ExportTable& exports) const {
+  return this->write_atomically(this->file_for(import_path), write_interface(exports, source_hash));
+}
+
+SourceStamp SourceStamp::of(const std::filesystem::path& file) {
+  std::error_code ec;
+  auto size = std::filesystem::file_size(file, ec);
+  if (ec) return {};
+  auto mtime = std::filesystem::last_write_time(file, ec);
+  if (ec) return {};
+
+  if (std::filesystem::file_time_type::clock::now() - mtime < std::chrono::seconds(2)) return {};
+  return SourceStamp{ .size = size, .mtime = static_cast<int64_t>(mtime.time_since_epoch().count()) };
+}
+
+std::optional<CheckRecord> ModuleCache::load_record(
+  std::string_view import_path,
+  uint64_t source_hash,
+  uint64_t options_hash
+) const {
+  auto record = this->read_record(import_path);
+  if (!record || record->source_hash != source_hash || record->options_hash != options_hash) {
+    return std::nullopt;
+  }
+  return record;
+}
+
+std::optional<CheckRecord> ModuleCache::load_record(
+  std::string_view import_path,
+  const SourceStamp& stamp,
+  uint64_t options_hash
+) const {
+  if (stamp.empty()) return std::nullopt;
+  auto record = this->read_record(import_path);
+  if (!record || record->stamp != stamp || record->options_hash != options_hash) return std::nullopt;
+  return record;
+}
+
+std::optional<CheckRecord> ModuleCache::read_record(std::string_view import_path) const {
+  MappedFile file(this->record_file_for(import_path));
+  if (!file.is_open()) return std::nullopt;
+
+  RecordReader in{ .bytes = file.bytes() };
+  if (in.get<uint32_t>() != record_magic || in.get<uint32_t>() != record_version) return std::nullopt;
+
+  CheckRecord record;
+  record.source_hash = in.get<uint64_t>();
+  record.stamp.size = in.get<uint64_t>();
+  record.stamp.mtime = in.get<int64_t>();
+  record.options_hash = in.get<uint64_t>();
+  record.interface_hash = in.get<uint64_t>();
+
+  auto n_deps = in.get<uint32_t>();
+  for (uint32_t i = 0; i < n_deps && in.ok; ++i) {
+    CheckRecord::Dependency dep;
+    dep.import_path = in.get_string();
+    dep.line = in.get<uint64_t>();
+    dep.column = in.get<uint64_t>();
+    dep.offset = in.get<uint64_t>();
+    dep.interface_hash = in.get<uint64_t>();
+    record.dependencies.push_back(std::move(dep));
+  }
+
+  auto n_diags = in.get<uint32_t>();
+  for (uint32_t i = 0; i < n_diags && in.ok; ++i) {
+    in.get_diagnostic(record.diagnostics);
+  }
+
+  auto n_uncalled = in.get<uint32_t>();
+  for (uint32_t i = 0; i < n_uncalled && in.ok; ++i) {
+    CheckRecord::Uncalled fn;
+    fn.name = in.get_string();
+    fn.range = in.get_range();
+    record.uncalled.push_back(std::move(fn));
+  }
+
+  auto n_imported = in.get<uint32_t>();
+  for (uint32_t i = 0; i < n_imported && in.ok; ++i) {
+    CheckRecord::ImportedName used;
+    used.import_path = in.get_string();
+    used.name = in.get_string();
+    record.used_imports.push_back(std::move(used));
+  }
+
+  if (!in.ok || in.at != in.bytes.size()) return std::nullopt;
+  return record;
+}
+
+bool ModuleCache::store_record(std::string_view import_path, const CheckRecord& record) const {
+  RecordWriter out;
+  out.put(record_magic);
+  out.put(record_version);
+  out.put(record.source_hash);
+  out.put(record.stamp.size);
+  out.put(record.stamp.mtime);
+  out.put(record.options_hash);
+  out.put(record.interface_hash);
+
+  out.put(static_cast<uint32_t>(record.dependencies.size()));
+  for (const auto& dep : record.dependencies) {
+    out.put_string(dep.import_path);
+    out.put(static_cast<uint64_t>(dep.line));
+    out.put(static_cast<uint64_t>(dep.column));
+    out.put(static_cast<uint64_t>(dep.offset));
+    out.put(dep.interface_hash);
+  }
+
+  out.put(static_cast<uint32_t>(record.diagnostics.size()));
+  for (const auto& diag : record.diagnostics) out.put_diagnostic(record.diagnostics, diag);
+
+  out.put(static_cast<uint32_t>(record.uncalled.size()));
+  for (const auto& fn : record.uncalled) {
+    out.put_string(fn.name);
+    out.put_range(fn.range);
+  }
+
+  out.put(static_cast<uint32_t>(record.used_imports.size()));
+  for (const auto& used : record.used_imports) {
+    out.put_string(used.import_path);
+    out.put_string(used.name);
+  }
+
+  return this->write_atomically(this->record_file_for(import_path), out.out);
+}
+
+std::unique_ptr<CachedAst> ModuleCache::load_ast(std::string_view import_path, uint64_t source_hash) const {
+  MappedFile file(this->ast_file_for(import_path));
+  if (!file.is_open()) return nullptr;
+
+  auto view = AstSnapshotView::parse(file.bytes());
+  if (!view || view->source_hash() != source_hash) return nullptr;
+
+  return std::make_unique<CachedAst>(CachedAst{
+    .file = std::move(file),
+    .view = *view,
+  });
+}
+
+bool ModuleCache::store_ast(std::string_view import_path, uint64_t source_hash, const Parent& root) const {
+  return this->write_atomically(this->ast_file_for(import_path), write_ast_snapshot(root, source_hash));
+}
+
+bool ModuleCache::write_atomically(const std::filesystem::path& target, std::string_view bytes) const {
+  std::error_code ec;
+  std::filesystem::create_directories(this->dir, ec);
+  if (ec) return false;
+
+  auto temp = target;
+  // Unique per writer so concurrent stores of one module don't collide.
+  temp += std::format(
+    ".{:x}{:x}.tmp",
+    std::hash<std::thread::id>{}(std::this_thread::get_id()),
+    std::random_device{}()
+  );
+
+  {
+    std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+    if (!out) return false;
+    out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    if (!out) return false;
+  }
+
+  std::filesystem::rename(temp, target, ec);
+  if (ec) {
+    std::filesystem::remove(temp, ec);
+    return false;
+  }
+  return true;
+}
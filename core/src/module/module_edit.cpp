@@ -0,0 +1,614 @@
+#include <ether/module/module.hpp>
+#include <ether/ast/const_fold/const_fold.hpp>
+#include <ether/ast/symbol_resolver/symbol_resolver.hpp>
+#include <ether/ast/type_check/type_check.hpp>
+#include <ether/lexer/lexer.hpp>
+#include <ether/parser/parsers.hpp>
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace {
+
+// Walks an item's nodes either moving every token by a SourceShift or, with
+// no shift, clearing what the resolver left on them.
+class ItemRewriter : public Visitor {
+public:
+  ItemRewriter() = default;
+  explicit ItemRewriter(const SourceShift& shift) : shift(&shift) {}
+
+  void visit(NDLiteral& n) override {
+    this->node(n);
+    this->token(n.literal);
+  }
+
+  void visit(NDImportDirective& n) override {
+    this->node(n);
+    this->token(n.import_directive);
+  }
+
+  void visit(NDIdentifier& n) override {
+    this->node(n);
+    this->token(n.identifier);
+    if (!this->shift) n.identifier_symbol = nullptr;
+  }
+
+  void visit(NDLetBindExpr& n) override {
+    this->node(n);
+    this->child(n.identifier.get());
+    this->child(n.bound_value.get());
+  }
+
+  void visit(NDConstExpr& n) override {
+    this->node(n);
+    this->child(n.identifier.get());
+    n.literal.accept(*this);
+  }
+
+  void visit(NDCallExpr& n) override {
+    this->node(n);
+    this->child(n.identifier.get());
+    this->children(n.args);
+  }
+
+  void visit(NDCallChain& n) override {
+    this->node(n);
+    this->token(n.start_token);
+    this->children(n.calls);
+  }
+
+  void visit(NDFuncDeclExpr& n) override {
+    this->node(n);
+    this->token(n.func_identifier);
+    this->token(n.return_type);
+    if (!this->shift) n.func_sym = nullptr;
+    for (auto& param : n.func_params) {
+      this->token(param.param_token);
+      this->token(param.param_type);
+      if (!this->shift) param.param_sym = nullptr;
+    }
+    this->children(n.func_body);
+  }
+
+  void visit(NDCaseExpr& n) override {
+    this->node(n);
+    this->token(n.case_keyword);
+    this->children(n.conditions);
+    for (auto& branch : n.branches) {
+      this->children(branch.pattern);
+      this->child(branch.result.get());
+    }
+  }
+
+  void visit(NDBinaryExpr& n) override {
+    this->node(n);
+    this->child(n.lhs.get());
+    this->token(n.op);
+    this->child(n.rhs.get());
+  }
+
+  void visit(NDUnaryExpr& n) override {
+    this->node(n);
+    this->token(n.op);
+    this->child(n.rhs.get());
+  }
+
+  void visit(NDScopeExpr& n) override {
+    this->node(n);
+    this->token(n.open_brace);
+    this->children(n.expressions);
+  }
+
+private:
+  const SourceShift* shift = nullptr;
+
+  void node(Node& n) {
+    this->token(n.type);
+    if (!this->shift) n.is_poisoned = false;
+  }
+
+  void token(Token& tok) {
+    if (this->shift) this->shift->apply(tok);
+  }
+
+  void token(std::optional<Token>& tok) {
+    if (tok) this->token(*tok);
+  }
+
+  void child(Node* n) {
+    if (n) n->accept(*this);
+  }
+
+  void children(std::vector<NDPtr>& nodes) {
+    for (auto& n : nodes) this->child(n.get());
+  }
+};
+
+// What a top-level node declares, as begin_module sees it. Equal keys mean
+// the module scope and `Load` bindings come out the same; a function's
+// parameters and return type may still differ.
+std::string declaration_key(Node& node) {
+  if (auto* load = dynamic_cast<NDImportDirective*>(&node)) {
+    return "Load " + load->import_directive.token_value;
+  }
+  if (auto* func = dynamic_cast<NDFuncDeclExpr*>(&node)) {
+    return "func " + func->func_identifier.token_value;
+  }
+  if (auto* const_expr = dynamic_cast<NDConstExpr*>(&node)) {
+    return "const " + const_expr->identifier->identifier.token_value;
+  }
+  return {};
+}
+
+// The symbol a top-level `func` or `const` declared; null for other nodes
+// and for declarations that were rejected.
+SymbolAttr* declared_symbol(Node& node) {
+  if (auto* func = dynamic_cast<NDFuncDeclExpr*>(&node)) return func->func_sym;
+  if (auto* const_expr = dynamic_cast<NDConstExpr*>(&node)) return const_expr->identifier->identifier_symbol;
+  return nullptr;
+}
+
+bool declares_symbol(Node& node) {
+  return dynamic_cast<NDFuncDeclExpr*>(&node) || dynamic_cast<NDConstExpr*>(&node);
+}
+
+// Hands what `old` declared over to `fresh`, which has the same key.
+void adopt_declaration(Node& old, Node& fresh, SymbolResolver& resolver) {
+  if (auto* func = dynamic_cast<NDFuncDeclExpr*>(&fresh)) {
+    resolver.redeclare(*func, *declared_symbol(old));
+  } else if (auto* const_expr = dynamic_cast<NDConstExpr*>(&fresh)) {
+    resolver.redeclare(*const_expr, *declared_symbol(old));
+  } else if (dynamic_cast<NDImportDirective*>(&fresh)) {
+    // begin_module flags `Load`s it could not bind.
+    fresh.is_poisoned = fresh.is_poisoned || old.is_poisoned;
+  }
+}
+
+void shift_start(LexPosition& start, const SourceShift& shift) {
+  start.offset += shift.delta;
+  if (start.line == shift.line) start.column += shift.columns;
+  start.line += shift.lines;
+}
+
+void shift_diagnostic(DiagnosticEngine& eng, Diagnostic& diag, const SourceShift& shift) {
+  shift.apply(diag.range);
+  for (auto& note : eng.notes_of(diag)) shift.apply(note.range);
+}
+
+// Copies diagnostics [first, last) of `from`.
+void copy(DiagnosticList& to, const DiagnosticList& from, size_t first, size_t last) {
+  for (size_t i = first; i < last; ++i) to.push_back(from[i], from.notes_of(from[i]));
+}
+
+}
+
+Module::ParsedRun Module::collect_run(
+  Parent parsed,
+  const ParserState& state,
+  size_t lexed_end,
+  DiagnosticList lex_diags
+) {
+  const auto& tokens = state.tokens;
+  const auto& marks = state.top_level;
+  const auto& parse_diags = state.diag_eng.all();
+
+  // Start of the token after the last one a parse looked at, or the end of
+  // the lexed text if it looked at the last one.
+  auto looked_until = [&](size_t high_water) {
+    size_t next = high_water + 1;
+    if (next >= tokens.size() || tokens[next].token_type == TokenType::EoF) return lexed_end;
+    return tokens[next].offset;
+  };
+
+  ParsedRun run;
+  run.nodes = std::move(parsed.children);
+  run.items.reserve(marks.size());
+
+  DiagnosticList lead;
+  std::vector<DiagnosticList> syntax(marks.size());
+
+  for (size_t k = 0; k < marks.size(); ++k) {
+    bool last = k + 1 == marks.size();
+    const auto& first = tokens[marks[k].token];
+    size_t diags_end = last ? parse_diags.size() : marks[k + 1].diagnostics;
+
+    run.items.push_back(Item{
+      .start = LexPosition{ first.offset, first.line_number, first.column_number },
+      .lookahead_end = looked_until(last ? state.high_water : marks[k + 1].high_water),
+    });
+    copy(syntax[k], parse_diags, marks[k].diagnostics, diags_end);
+  }
+
+  size_t lead_end = marks.empty() ? parse_diags.size() : marks.front().diagnostics;
+  copy(lead, parse_diags, 0, lead_end);
+  if (!marks.empty() && marks.front().token == 0) {
+    run.lead_lookahead_end = 0;
+  } else {
+    run.lead_lookahead_end = looked_until(marks.empty() ? state.high_water : marks.front().high_water);
+  }
+
+  // Lexer diagnostics go to the item whose text they are in.
+  for (size_t i = 0; i < lex_diags.size(); ++i) {
+    auto it = std::upper_bound(run.items.begin(), run.items.end(), lex_diags[i].range.begin,
+      [](uint32_t at, const Item& item) { return at < item.start.offset; });
+
+    if (it == run.items.begin()) {
+      lead.append(lex_diags, i, 1);
+    } else {
+      syntax[std::prev(it) - run.items.begin()].append(lex_diags, i, 1);
+    }
+  }
+
+  run.lead_count = lead.size();
+  run.diagnostics = std::move(lead);
+  for (size_t k = 0; k < syntax.size(); ++k) {
+    run.items[k].syntax_count = syntax[k].size();
+    run.diagnostics.append(syntax[k]);
+  }
+
+  return run;
+}
+
+DiagnosticList Module::resolve_item(size_t index) {
+  this->module_root.children[index]->accept(*this->resolver);
+  return this->resolver_diag.take_all();
+}
+
+void Module::discard_check() {
+  this->module_root.children.clear();
+  this->items.clear();
+  this->resolver.reset();
+  this->checker.reset();
+  this->checker_diag.take_all();
+  this->type_diag_count = 0;
+  this->arena = SymbolStorage();
+  this->resolver_diag.take_all();
+  this->diag.take_all();
+  this->exported_symbols.clear();
+  this->use_index = UseDefIndex();
+  this->module_diag_count = 0;
+  this->lead_diag_count = 0;
+  this->lead_lookahead_end = 0;
+}
+
+bool Module::resolve_items(const CancellationToken& cancel) {
+  ItemRewriter reset;
+  for (auto& child : this->module_root.children) child->accept(reset);
+
+  this->resolver.reset();
+  // What the checker kept is keyed by the symbols about to go.
+  this->checker.reset();
+  this->arena = SymbolStorage();
+  this->resolver = std::make_unique<SymbolResolver>(this->arena, this->resolver_diag);
+  if (this->registry) this->resolver->set_module_registry(*this->registry);
+
+  // Lay the diagnostics out again with fresh resolver output in place of
+  // the old, keeping the syntax ones.
+  auto old = this->diag.take_all();
+  DiagnosticList laid;
+
+  this->resolver->begin_module(this->module_root);
+  laid = this->resolver_diag.take_all();
+  size_t at = this->module_diag_count;
+  this->module_diag_count = laid.size();
+
+  laid.append(old, at, this->lead_diag_count);
+  at += this->lead_diag_count;
+
+  for (size_t k = 0; k < this->items.size(); ++k) {
+    if (cancel.is_cancelled()) return false;
+    auto& item = this->items[k];
+    at += item.resolve_count;
+    auto resolved = this->resolve_item(k);
+    item.resolve_count = resolved.size();
+    laid.append(resolved);
+    laid.append(old, at, item.syntax_count);
+    at += item.syntax_count;
+  }
+
+  this->diag.splice(0, 0, std::move(laid));
+  this->set_exports(this->resolver->take_exports());
+  return true;
+}
+
+void Module::type_check() {
+  if (!this->checker) this->checker = std::make_unique<TypeChecker>(this->checker_diag);
+  this->checker->check_module(this->module_root);
+  // The tree is kept as written for the next edit, so only the folder's
+  // diagnostics are taken.
+  ConstantFolder folder(this->checker_diag);
+  folder.check_module(this->module_root);
+
+  size_t end = this->diag.all().size();
+  auto found = this->checker_diag.take_all();
+  size_t count = found.size();
+  this->diag.splice(end - this->type_diag_count, end, std::move(found));
+  this->type_diag_count = count;
+}
+
+bool Module::check(const ModuleRegistry* registry, const CancellationToken& cancel) {
+  this->registry = registry;
+
+  DiagnosticEngine lex_diags;
+  Lexer lexer(this->source_text, lex_diags, cancel);
+  lexer.scan_tokens();
+  if (cancel.is_cancelled()) {
+    this->discard_check();
+    return false;
+  }
+
+  DiagnosticEngine parse_diags;
+  ParserState state(parse_diags);
+  state.set_state(lexer.take_tokens());
+  state.cancel = cancel;
+  auto parsed = run_parser(state);
+
+  if (cancel.is_cancelled()) {
+    this->discard_check();
+    return false;
+  }
+
+  auto run = this->collect_run(std::move(*parsed), state, this->source_text.size(), lex_diags.take_all());
+  this->module_root.children = std::move(run.nodes);
+  this->items = std::move(run.items);
+  this->lead_lookahead_end = run.lead_lookahead_end;
+
+  this->diag.take_all();
+  this->diag.set_source(this->module_path, this->source_text);
+  this->diag.splice(0, 0, std::move(run.diagnostics));
+  this->module_diag_count = 0;
+  this->lead_diag_count = run.lead_count;
+  this->type_diag_count = 0;
+
+  if (!this->resolve_items(cancel)) {
+    this->discard_check();
+    return false;
+  }
+  this->set_use_index(this->resolver->build_use_index());
+  this->type_check();
+  return true;
+}
+
+EditStats Module::apply_edit(const TextEdit& edit, const CancellationToken& cancel) {
+  size_t at = std::min(edit.offset, this->source_text.size());
+  size_t length = std::min(edit.length, this->source_text.size() - at);
+
+  if (!this->resolver) {
+    this->source_text.replace(at, length, edit.text);
+    if (!this->check(this->registry, cancel)) return EditStats{ .cancelled = true };
+    return EditStats{
+      .items_reparsed = this->items.size(),
+      .resolved_module = true,
+      .declarations_inferred = this->checker->inferred(),
+    };
+  }
+
+  size_t new_end = at + edit.text.size();
+  auto delta = static_cast<std::ptrdiff_t>(edit.text.size()) - static_cast<std::ptrdiff_t>(length);
+
+  // Relex from the first item whose parse could see the edit: the one whose
+  // text holds it, or an earlier one that looked ahead as far as it.
+  auto holder = std::ranges::upper_bound(this->items, at, {}, [](const Item& item) {
+    return item.start.offset;
+  });
+  bool from_top = holder == this->items.begin() || this->lead_lookahead_end >= at;
+  size_t first = from_top ? 0 : static_cast<size_t>(holder - this->items.begin()) - 1;
+  for (size_t k = 0; k < first; ++k) {
+    if (this->items[k].lookahead_end >= at) {
+      first = k;
+      break;
+    }
+  }
+  LexPosition restart = from_top ? LexPosition{ 0, 1, 1 } : this->items[first].start;
+
+  // Once past the edit, reaching the (moved) start of an old item means the
+  // text from there on lexes and parses as before.
+  auto old_item_at = [&](size_t offset) -> std::optional<size_t> {
+    if (offset < new_end) return std::nullopt;
+    size_t old_offset = offset + length - edit.text.size();
+    auto it = std::ranges::lower_bound(
+      this->items.begin() + first, this->items.end(), old_offset, {},
+      [](const Item& item) { return item.start.offset; }
+    );
+    if (it == this->items.end() || it->start.offset != old_offset) return std::nullopt;
+    return static_cast<size_t>(it - this->items.begin());
+  };
+
+  this->source_text.replace(at, length, edit.text);
+
+  // Lex up to the first old item start past the edit and parse that. If the
+  // parse runs off the end of those tokens (say, an `end` was deleted), lex
+  // on to twice as many old item starts and parse again, until the parser
+  // reaches one of them between items.
+  DiagnosticEngine lex_diags;
+  DiagnosticEngine parse_diags;
+  Lexer lexer(this->source_text, lex_diags, cancel);
+  std::optional<LexPosition> lexed_to = restart;
+  std::optional<ParserState> state;
+  std::optional<Parent> parsed;
+  std::optional<size_t> kept;
+  std::optional<LexPosition> resume;
+
+  for (size_t reach = 1;; reach *= 2) {
+    size_t from = lexed_to->offset;
+    size_t passed = 0;
+    lexed_to = lexer.rescan(*lexed_to, [&](size_t offset) {
+      return offset != from && old_item_at(offset) && ++passed >= reach;
+    });
+
+    parse_diags.take_all();
+    kept.reset();
+    resume.reset();
+    state.emplace(parse_diags);
+    state->set_state(lexer.get_tokens());
+    state->cancel = cancel;
+    state->resync = [&](const Token& tok) {
+      // EoF carries the position of the token before it.
+      if (tok.token_type == TokenType::EoF) return false;
+      kept = old_item_at(tok.offset);
+      if (kept) resume = LexPosition{ tok.offset, tok.line_number, tok.column_number };
+      return kept.has_value();
+    };
+    parsed = run_parser(*state);
+
+    if (!lexed_to) break;
+    if (!state->reached_end) {
+      if (!kept) {
+        kept = old_item_at(lexed_to->offset);
+        resume = lexed_to;
+      }
+      break;
+    }
+  }
+
+  // Nothing has changed but the text yet.
+  if (cancel.is_cancelled()) {
+    this->discard_check();
+    return EditStats{ .cancelled = true };
+  }
+
+  // The type checker's stretch is laid out again at the end.
+  size_t diag_count = this->diag.all().size();
+  this->diag.splice(diag_count - this->type_diag_count, diag_count, {});
+  this->type_diag_count = 0;
+
+  DiagnosticList lexed;
+  const auto& lex_all = lex_diags.all();
+  for (const auto& d : lex_all) {
+    if (!resume || d.range.begin < resume->offset) lexed.push_back(d, lex_all.notes_of(d));
+  }
+
+  size_t lexed_end = lexed_to ? lexed_to->offset : this->source_text.size();
+  auto run = this->collect_run(std::move(*parsed), *state, lexed_end, std::move(lexed));
+  size_t last = kept.value_or(this->items.size());
+
+  // Where the replaced items' diagnostics sit, before anything moves.
+  size_t diag_first = this->module_diag_count + (from_top ? 0 : this->lead_diag_count);
+  for (size_t k = 0; k < first; ++k) {
+    diag_first += this->items[k].resolve_count + this->items[k].syntax_count;
+  }
+  size_t diag_last = diag_first + (from_top ? this->lead_diag_count : 0);
+  for (size_t k = first; k < last; ++k) {
+    diag_last += this->items[k].resolve_count + this->items[k].syntax_count;
+  }
+
+  // Move everything after the replaced items to its new position.
+  std::optional<SourceShift> shift;
+  size_t tail_offset = std::numeric_limits<size_t>::max();
+  if (last < this->items.size()) {
+    tail_offset = this->items[last].start.offset;
+    const auto& old_start = this->items[last].start;
+    shift = SourceShift{
+      .offset = old_start.offset,
+      .line = old_start.line,
+      .delta = delta,
+      .lines = static_cast<std::ptrdiff_t>(resume->line) - static_cast<std::ptrdiff_t>(old_start.line),
+      .columns = static_cast<std::ptrdiff_t>(resume->column) - static_cast<std::ptrdiff_t>(old_start.column),
+    };
+    if (shift->is_identity()) shift.reset();
+  }
+
+  if (shift) {
+    ItemRewriter mover(*shift);
+    for (size_t k = last; k < this->items.size(); ++k) {
+      shift_start(this->items[k].start, *shift);
+      this->items[k].lookahead_end += delta;
+      this->module_root.children[k]->accept(mover);
+    }
+  }
+
+  // Splice the reparsed items in, keeping the old nodes for their symbols.
+  auto& children = this->module_root.children;
+  std::vector<NDPtr> old_nodes(
+    std::make_move_iterator(children.begin() + first),
+    std::make_move_iterator(children.begin() + last)
+  );
+  children.erase(children.begin() + first, children.begin() + last);
+  children.insert(
+    children.begin() + first,
+    std::make_move_iterator(run.nodes.begin()),
+    std::make_move_iterator(run.nodes.end())
+  );
+
+  size_t reparsed = run.items.size();
+  this->items.erase(this->items.begin() + first, this->items.begin() + last);
+  this->items.insert(this->items.begin() + first, run.items.begin(), run.items.end());
+
+  // Diagnostics ahead of the first reparsed item belong to the text before
+  // it, as they would in a full parse; they come first in the new stretch,
+  // right after that text's own.
+  if (from_top) {
+    this->lead_diag_count = run.lead_count;
+    this->lead_lookahead_end = run.lead_lookahead_end;
+  } else if (first == 0) {
+    this->lead_diag_count += run.lead_count;
+    this->lead_lookahead_end = std::max(this->lead_lookahead_end, run.lead_lookahead_end);
+  } else {
+    auto& owner = this->items[first - 1];
+    owner.syntax_count += run.lead_count;
+    owner.lookahead_end = std::max(owner.lookahead_end, run.lead_lookahead_end);
+  }
+
+  // If the reparsed items declare the same names as the old ones, the
+  // module scope stands and only their own bodies need resolving.
+  bool same_declarations = this->module_diag_count == 0 && old_nodes.size() == reparsed;
+  for (size_t k = 0; same_declarations && k < reparsed; ++k) {
+    auto& old_node = *old_nodes[k];
+    same_declarations = declaration_key(old_node) == declaration_key(*children[first + k])
+                     && (!declares_symbol(old_node) || declared_symbol(old_node));
+  }
+
+  EditStats stats{ .items_reparsed = reparsed };
+  DiagnosticList fresh;
+  if (same_declarations) {
+    // Uses and symbols are still at their old positions until shifted.
+    this->resolver->forget_uses(restart.offset, tail_offset);
+    if (shift) {
+      this->resolver->shift_positions(*shift);
+      this->checker->shift_positions(*shift);
+    }
+
+    size_t at = run.lead_count;
+    fresh.append(run.diagnostics, 0, run.lead_count);
+    for (size_t k = 0; k < reparsed; ++k) {
+      if (cancel.is_cancelled()) {
+        this->discard_check();
+        return EditStats{ .items_reparsed = reparsed, .cancelled = true };
+      }
+      auto& item = this->items[first + k];
+      if (auto* sym = declared_symbol(*old_nodes[k])) this->checker->forget(*sym);
+      adopt_declaration(*old_nodes[k], *children[first + k], *this->resolver);
+      auto resolved = this->resolve_item(first + k);
+      item.resolve_count = resolved.size();
+      fresh.append(resolved);
+      fresh.append(run.diagnostics, at, item.syntax_count);
+      at += item.syntax_count;
+    }
+  } else {
+    fresh = std::move(run.diagnostics);
+  }
+
+  size_t fresh_end = diag_first + fresh.size();
+  this->diag.splice(diag_first, diag_last, std::move(fresh));
+  if (shift) {
+    for (auto& d : this->diag.range(fresh_end, this->diag.all().size())) shift_diagnostic(this->diag, d, *shift);
+  }
+  this->diag.set_source(this->module_path, this->source_text);
+
+  if (!same_declarations) {
+    stats.resolved_module = true;
+    if (!this->resolve_items(cancel)) {
+      this->discard_check();
+      stats.cancelled = true;
+      return stats;
+    }
+  }
+
+  this->set_use_index(this->resolver->build_use_index());
+  this->type_check();
+  stats.declarations_inferred = this->checker->inferred();
+  return stats;
+}
@@ -0,0 +1,196 @@
+#include <ether/module/module_interface.hpp>
+#include <ether/support/hash.hpp>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+static_assert(std::is_trivially_copyable_v<InterfaceHeader>);
+static_assert(sizeof(InterfaceHeader) % alignof(InterfaceSymbol) == 0);
+static_assert(sizeof(InterfaceSymbol) % alignof(InterfaceParam) == 0);
+
+namespace {
+struct StringPool {
+  std::string bytes;
+
+  InterfaceStr add(std::string_view s) {
+    InterfaceStr ref{ static_cast<uint32_t>(this->bytes.size()), static_cast<uint32_t>(s.size()) };
+    this->bytes.append(s);
+    return ref;
+  }
+};
+
+template <typename T>
+void append_records(std::string& out, const std::vector<T>& records) {
+  out.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(T));
+}
+
+std::vector<const SymbolAttr*> sorted_exports(const ExportTable& exports) {
+  std::vector<const SymbolAttr*> sorted;
+  sorted.reserve(exports.size());
+  for (const auto& [name, sym] : exports) sorted.push_back(sym);
+  std::ranges::sort(sorted, {}, &SymbolAttr::name);
+  return sorted;
+}
+}
+
+// Types are hashed and written as text: TypeIds are only meaningful within
+// one process.
+uint64_t interface_hash(const ExportTable& exports) {
+  const auto& types = TypeTable::shared();
+  uint64_t h = hash_bytes({}, interface_version);
+  for (const auto* sym : sorted_exports(exports)) {
+    h = hash_combine(h, hash_bytes(sym->name));
+    h = hash_combine(h, static_cast<uint64_t>(sym->symbol_kind));
+    h = hash_combine(h, hash_bytes(types.to_string(sym->type_info.type)));
+
+    if (const auto* fn = std::get_if<FunctionData>(&sym->symbol_data)) {
+      h = hash_combine(h, hash_bytes(types.to_string(fn->function_return_type.type)));
+      h = hash_combine(h, fn->function_params.size());
+      for (const auto& param : fn->function_params) {
+        h = hash_combine(h, hash_bytes(param.param_name));
+        h = hash_combine(h, hash_bytes(types.to_string(param.param_type.type)));
+      }
+    }
+  }
+  return h;
+}
+
+std::string write_interface(const ExportTable& exports, uint64_t source_hash) {
+  auto sorted = sorted_exports(exports);
+  const auto& types = TypeTable::shared();
+
+  StringPool pool;
+  std::vector<InterfaceSymbol> syms;
+  std::vector<InterfaceParam> prms;
+  syms.reserve(sorted.size());
+
+  for (const auto* sym : sorted) {
+    InterfaceSymbol rec{};
+    rec.name = pool.add(sym->name);
+    rec.type = pool.add(types.to_string(sym->type_info.type));
+    rec.line = static_cast<uint32_t>(sym->symbol_token.line_number);
+    rec.column = static_cast<uint32_t>(sym->symbol_token.column_number);
+    rec.offset = static_cast<uint32_t>(sym->symbol_token.offset);
+    rec.kind = static_cast<uint32_t>(sym->symbol_kind);
+    rec.first_param = static_cast<uint32_t>(prms.size());
+
+    if (const auto* fn = std::get_if<FunctionData>(&sym->symbol_data)) {
+      rec.return_type = pool.add(types.to_string(fn->function_return_type.type));
+      for (const auto& param : fn->function_params) {
+        prms.push_back(InterfaceParam{
+          .name = pool.add(param.param_name),
+          .type = pool.add(types.to_string(param.param_type.type)),
+        });
+      }
+    } else {
+      rec.return_type = pool.add({});
+    }
+    rec.param_count = static_cast<uint32_t>(prms.size()) - rec.first_param;
+    syms.push_back(rec);
+  }
+
+  InterfaceHeader header{
+    .magic = interface_magic,
+    .version = interface_version,
+    .source_hash = source_hash,
+    .interface_hash = interface_hash(exports),
+    .symbol_count = static_cast<uint32_t>(syms.size()),
+    .param_count = static_cast<uint32_t>(prms.size()),
+    .strings_size = static_cast<uint32_t>(pool.bytes.size()),
+    .reserved = 0,
+  };
+
+  std::string out;
+  out.reserve(sizeof header + syms.size() * sizeof(InterfaceSymbol)
+            + prms.size() * sizeof(InterfaceParam) + pool.bytes.size());
+  out.append(reinterpret_cast<const char*>(&header), sizeof header);
+  append_records(out, syms);
+  append_records(out, prms);
+  out.append(pool.bytes);
+  return out;
+}
+
+std::optional<InterfaceView> InterfaceView::parse(std::span<const std::byte> bytes) {
+  if (bytes.size() < sizeof(InterfaceHeader)) return std::nullopt;
+  if (reinterpret_cast<uintptr_t>(bytes.data()) % alignof(InterfaceHeader) != 0) return std::nullopt;
+
+  InterfaceView view;
+  view.header = reinterpret_cast<const InterfaceHeader*>(bytes.data());
+  const auto& h = *view.header;
+  if (h.magic != interface_magic || h.version != interface_version) return std::nullopt;
+
+  size_t syms_at = sizeof(InterfaceHeader);
+  size_t prms_at = syms_at + size_t{h.symbol_count} * sizeof(InterfaceSymbol);
+  size_t strings_at = prms_at + size_t{h.param_count} * sizeof(InterfaceParam);
+  if (strings_at + h.strings_size != bytes.size()) return std::nullopt;
+
+  const auto* base = reinterpret_cast<const char*>(bytes.data());
+  view.syms = reinterpret_cast<const InterfaceSymbol*>(base + syms_at);
+  view.prms = reinterpret_cast<const InterfaceParam*>(base + prms_at);
+  view.strings = base + strings_at;
+
+  auto in_pool = [&](InterfaceStr s) {
+    return s.offset <= h.strings_size && s.length <= h.strings_size - s.offset;
+  };
+
+  for (const auto& sym : view.symbols()) {
+    if (!in_pool(sym.name) || !in_pool(sym.type) || !in_pool(sym.return_type)) return std::nullopt;
+    if (sym.first_param > h.param_count || sym.param_count > h.param_count - sym.first_param) {
+      return std::nullopt;
+    }
+    if (sym.kind > static_cast<uint32_t>(SymbolKind::Type)) return std::nullopt;
+  }
+  for (size_t i = 0; i < h.param_count; ++i) {
+    if (!in_pool(view.prms[i].name) || !in_pool(view.prms[i].type)) return std::nullopt;
+  }
+
+  return view;
+}
+
+const InterfaceSymbol* InterfaceView::find(std::string_view name) const {
+  auto syms = this->symbols();
+  auto it = std::ranges::lower_bound(syms, name, {}, [&](const InterfaceSymbol& sym) {
+    return this->str(sym.name);
+  });
+  if (it == syms.end() || this->str(it->name) != name) return nullptr;
+  return &*it;
+}
+
+SymbolAttr InterfaceView::materialize(const InterfaceSymbol& sym) const {
+  std::string name(this->str(sym.name));
+  auto kind = static_cast<SymbolKind>(sym.kind);
+  auto& types = TypeTable::shared();
+
+  SymbolAttr attr{
+    .name = name,
+    .symbol_kind = kind,
+    .type_info = TypeInfo{ .type = types.parse(this->str(sym.type)) },
+    .symbol_token = Token{
+      .token_type = TokenType::Identifier,
+      .token_value = name,
+      .line_number = sym.line,
+      .column_number = sym.column,
+      .offset = sym.offset,
+    },
+    .symbol_data = TypeData{},
+  };
+
+  if (kind == SymbolKind::Function) {
+    FunctionData fn;
+    fn.function_return_type.type = types.parse(this->str(sym.return_type));
+    auto params = this->params(sym);
+    fn.function_params.reserve(params.size());
+    for (size_t i = 0; i < params.size(); ++i) {
+      fn.function_params.push_back(FuncParamData{
+        .index = i,
+        .param_name = std::string(this->str(params[i].name)),
+        .param_type = TypeData{ types.parse(this->str(params[i].type)) },
+      });
+    }
+    attr.symbol_data = std::move(fn);
+  }
+
+  return attr;
+}
@@ -0,0 +1,450 @@
+#include <ether/module/module_loader.hpp>
+#include <ether/ast/const_fold/const_fold.hpp>
+#include <ether/ast/symbol_resolver/symbol_resolver.hpp>
+#include <ether/ast/type_check/type_check.hpp>
+#include <ether/diagnostics/diagnostic.hpp>
+#include <ether/import_res/import_res.hpp>
+#include <ether/lexer/lexer.hpp>
+#include <ether/support/dag_scheduler.hpp>
+#include <ether/support/hash.hpp>
+#include <ether/support/parallel.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+#include <unordered_set>
+#include <utility>
+
+namespace {
+bool read_file(const std::filesystem::path& file, std::string& out) {
+  std::ifstream in(file, std::ios::binary);
+  if (!in.is_open()) return false;
+
+  std::stringstream buffer;
+  buffer << in.rdbuf();
+  out = buffer.str();
+  return true;
+}
+}
+
+ModuleLoader::ModuleLoader(std::filesystem::path root, LoaderOptions opts)
+: root(std::filesystem::absolute(root.empty() ? "." : std::move(root)).lexically_normal()),
+  options(std::move(opts)) {
+  this->passes.add("lex", [](Module& mod) { mod.lex(); });
+  this->passes.add("parse", [this](Module& mod) {
+    mod.parse();
+    this->poison_broken_imports(mod);
+  });
+  this->passes.add("resolve", [this](Module& mod) { this->resolve_symbols(mod); });
+  this->passes.add("type-check", [this](Module& mod) {
+    TypeChecker checker(mod.get_diag_engine(), this->body_jobs);
+    checker.check_module(mod.get_root());
+  });
+  this->passes.add("fold", [this](Module& mod) {
+    ConstantFolder folder(mod.get_diag_engine());
+    if (this->options.keep_ast) {
+      folder.check_module(mod.get_root());
+    } else {
+      folder.fold_module(mod.get_root());
+    }
+  });
+
+  bool complete = true;
+  if (!this->options.stop_after.empty() && this->passes.stop_after(this->options.stop_after)) {
+    complete = this->options.stop_after == this->passes.names().back();
+  }
+  if (this->options.time_passes) this->passes.enable_stats();
+
+  if (complete && !this->options.cache_dir.empty()) this->cache.emplace(this->options.cache_dir);
+  this->options_hash = hash_combine(interface_version, this->options.warn_unused);
+}
+
+bool ModuleLoader::add_entry(const std::filesystem::path& file) {
+  auto abs = std::filesystem::absolute(file).lexically_normal();
+  auto import_path = file_to_import_path(this->root, abs);
+  if (this->by_path.contains(import_path)) return true;
+  return this->add_module(std::move(import_path), abs) != npos;
+}
+
+Module* ModuleLoader::find(std::string_view import_path) const {
+  auto it = this->by_path.find(std::string(import_path));
+  if (it == this->by_path.end()) return nullptr;
+  return this->loaded[it->second].module.get();
+}
+
+void ModuleLoader::load() {
+  this->discover();
+  this->break_cycles();
+  this->resolve_all();
+}
+
+// Only registers the module; it is read in the next discovery round.
+size_t ModuleLoader::add_module(std::string import_path, const std::filesystem::path& file) {
+  std::error_code ec;
+  if (!std::filesystem::is_regular_file(file, ec)) return npos;
+
+  size_t index = this->loaded.size();
+  this->by_path.emplace(import_path, index);
+  this->graph.push_back(Node{ .file = file });
+  this->loaded.push_back(LoadedModule{ .import_path = std::move(import_path) });
+  return index;
+}
+
+// Breadth-first: each round reads, hashes and scans the modules found by the
+// previous one in parallel, then collects their imports serially so indices
+// stay deterministic. Only a file's leading `Load`s are lexed
+// (Lexer::scan_imports), and not even that when a check record for the same
+// source lists them, so the whole graph is known before any full parse.
+void ModuleLoader::discover() {
+  size_t scanned = 0;
+  while (scanned < this->loaded.size()) {
+    size_t begin = scanned;
+    size_t end = this->loaded.size();
+
+    std::vector<std::vector<Token>> imports(end - begin);
+    parallel_for(end - begin, this->options.jobs, [&](size_t i) {
+      this->scan_one(begin + i, imports[i]);
+    });
+
+    for (size_t i = begin; i < end; ++i) this->collect_imports(i, std::move(imports[i - begin]));
+    scanned = end;
+  }
+}
+
+void ModuleLoader::scan_one(size_t index, std::vector<Token>& imports) {
+  auto& node = this->graph[index];
+  auto& entry = this->loaded[index];
+
+  entry.module = std::make_unique<Module>(node.file.string(), std::string{});
+  entry.module->get_diag_engine().set_limits(this->options.diagnostic_limits);
+
+  if (this->cache) {
+    // Taken before the read, so a write racing it shows as a change next run.
+    node.stamp = SourceStamp::of(node.file);
+    node.record = this->cache->load_record(entry.import_path, node.stamp, this->options_hash);
+    if (node.record) {
+      node.source_hash = node.record->source_hash;
+    } else {
+      this->read_source(index);
+      node.record = this->cache->load_record(entry.import_path, node.source_hash, this->options_hash);
+    }
+
+    if (node.record) {
+      for (const auto& dep : node.record->dependencies) {
+        imports.push_back(Token{
+          .token_type = TokenType::ImportModule,
+          .token_value = dep.import_path,
+          .line_number = dep.line,
+          .column_number = dep.column,
+          .offset = dep.offset,
+        });
+      }
+      return;
+    }
+  }
+
+  if (!node.source_read) this->read_source(index);
+
+  // The pre-scan never reports; real diagnostics come from the full lex.
+  DiagnosticEngine scratch;
+  Lexer lexer(entry.module->get_source(), scratch);
+  lexer.scan_imports();
+  imports = lexer.get_tokens();
+}
+
+void ModuleLoader::read_source(size_t index) {
+  auto& node = this->graph[index];
+
+  // A file that vanished since it was found reads as empty.
+  std::string source;
+  read_file(node.file, source);
+  node.source_hash = hash_bytes(source);
+  node.source_read = true;
+  this->loaded[index].module->set_source(std::move(source));
+}
+
+void ModuleLoader::collect_imports(size_t index, std::vector<Token> tokens) {
+  // Invalid paths are left to the resolver to report.
+  std::erase_if(tokens, [](const Token& tok) { return !is_valid_import_path(tok); });
+
+  for (const auto& tok : tokens) {
+    const auto& path = tok.token_value;
+
+    size_t target;
+    if (auto it = this->by_path.find(path); it != this->by_path.end()) {
+      target = it->second;
+    } else {
+      auto file = import_path_to_file(this->root, path);
+      target = this->add_module(path, file);
+      if (target == npos) {
+        this->report_import(
+          index,
+          tok,
+          std::format("Cannot find module `{}` (expected `{}`)", path, file.string())
+        );
+        this->graph[index].broken.push_back(path);
+        continue;
+      }
+    }
+
+    this->graph[index].imports.push_back(Import{ .path = path, .token = tok, .target = target });
+  }
+
+  this->graph[index].import_tokens = std::move(tokens);
+}
+
+// Iterative DFS over the import graph; every back edge closes a cycle. The
+// edge is reported at its `Load` and cut so the rest of the graph still loads.
+void ModuleLoader::break_cycles() {
+  enum class Mark : uint8_t { New, Active, Done };
+  struct Frame {
+    size_t node;
+    size_t next_import;
+  };
+
+  std::vector<Mark> marks(this->loaded.size(), Mark::New);
+  std::vector<Frame> frames;
+
+  for (size_t start = 0; start < this->loaded.size(); ++start) {
+    if (marks[start] != Mark::New) continue;
+    marks[start] = Mark::Active;
+    frames.push_back(Frame{ .node = start, .next_import = 0 });
+
+    while (!frames.empty()) {
+      size_t node = frames.back().node;
+      auto& imports = this->graph[node].imports;
+
+      if (frames.back().next_import == imports.size()) {
+        marks[node] = Mark::Done;
+        frames.pop_back();
+        continue;
+      }
+
+      auto& edge = imports[frames.back().next_import++];
+      if (marks[edge.target] == Mark::New) {
+        marks[edge.target] = Mark::Active;
+        frames.push_back(Frame{ .node = edge.target, .next_import = 0 });
+        continue;
+      }
+      if (marks[edge.target] != Mark::Active) continue;
+
+      std::string cycle;
+      auto first = std::ranges::find_if(frames, [&](const Frame& f) {
+        return f.node == edge.target;
+      });
+      for (auto it = first; it != frames.end(); ++it) {
+        cycle += this->loaded[it->node].import_path;
+        cycle += " -> ";
+      }
+      cycle += edge.path;
+
+      this->report_import(node, edge.token, std::format("Import cycle detected: {}", cycle));
+      this->graph[node].broken.push_back(edge.path);
+      edge.target = npos;
+    }
+  }
+}
+
+void ModuleLoader::resolve_all() {
+  size_t count = this->loaded.size();
+  std::vector<std::vector<size_t>> dependents(count);
+  std::vector<size_t> pending(count, 0);
+
+  for (size_t i = 0; i < count; ++i) {
+    std::vector<size_t> deps;
+    for (const auto& edge : this->graph[i].imports) {
+      if (edge.target != npos) deps.push_back(edge.target);
+    }
+    std::ranges::sort(deps);
+    auto [last, end] = std::ranges::unique(deps);
+    deps.erase(last, end);
+
+    for (size_t dep : deps) dependents[dep].push_back(i);
+    pending[i] = deps.size();
+  }
+
+  this->index_of.clear();
+  for (size_t i = 0; i < count; ++i) this->index_of.emplace(this->loaded[i].module.get(), i);
+
+  // A single module gets the threads for its function bodies instead.
+  this->body_jobs = count == 1 ? this->options.jobs : 1;
+  run_dag(dependents, std::move(pending), this->options.jobs, [&](size_t i) {
+    this->resolve_one(i);
+  });
+
+  if (this->options.warn_unused && this->passes.runs("resolve")) this->report_uncalled_functions();
+}
+
+void ModuleLoader::resolve_one(size_t index) {
+  if (this->cache && this->try_replay(index)) return;
+  if (!this->graph[index].source_read) this->read_source(index);
+
+  auto& entry = this->loaded[index];
+  this->passes.run(*entry.module);
+
+  const auto& diags = entry.module->get_diag_engine();
+  bool cut_short = diags.dropped() > 0
+    || diags.should_stop(DiagnosticPhase::Lexer)
+    || diags.should_stop(DiagnosticPhase::Parser);
+  if (this->cache && !cut_short) this->store_in_cache(index);
+
+  this->registry.publish(entry.import_path, entry.module->get_exported_symbols());
+}
+
+// The resolver skips `Load`s the graph already reported (missing, cyclic).
+void ModuleLoader::poison_broken_imports(Module& mod) {
+  const auto& broken = this->graph[this->index_of.at(&mod)].broken;
+  if (broken.empty()) return;
+
+  for (auto& child : mod.get_root().children) {
+    auto* load = dynamic_cast<NDImportDirective*>(child.get());
+    if (load && std::ranges::find(broken, load->import_directive.token_value) != broken.end()) {
+      load->is_poisoned = true;
+    }
+  }
+}
+
+void ModuleLoader::resolve_symbols(Module& mod) {
+  SymbolResolver resolver(mod.get_symbol_storage(), mod.get_diag_engine());
+  resolver.set_module_registry(this->registry);
+  mod.resolve(resolver, this->body_jobs);
+  if (this->options.warn_unused) {
+    resolver.report_unused_symbols(false);
+
+    auto& node = this->graph[this->index_of.at(&mod)];
+    for (const auto* sym : resolver.uncalled_functions()) {
+      node.uncalled.push_back(CheckRecord::Uncalled{ .name = sym->name, .range = token_range(sym->symbol_token) });
+    }
+    for (auto& used : resolver.used_imports()) {
+      node.used_imports.push_back(CheckRecord::ImportedName{
+        .import_path = std::move(used.import_path),
+        .name = std::move(used.name),
+      });
+    }
+  }
+
+  mod.set_exports(resolver.take_exports());
+  mod.set_use_index(resolver.take_use_index());
+}
+
+// Imports finished before this module started, so reading their interface
+// hashes here is ordered by the scheduler. Cut (cyclic) and missing imports
+// leave the module unreplayable, which also keeps us from reading a cut
+// import that may still be running.
+bool ModuleLoader::try_replay(size_t index) {
+  auto& entry = this->loaded[index];
+  auto& node = this->graph[index];
+  if (!node.record || !node.broken.empty()) return false;
+
+  const auto& deps = node.record->dependencies;
+  if (deps.size() != node.imports.size()) return false;
+  for (size_t i = 0; i < deps.size(); ++i) {
+    size_t target = node.imports[i].target;
+    if (this->graph[target].interface_hash != deps[i].interface_hash) return false;
+  }
+
+  node.cached = this->cache->load(entry.import_path, node.source_hash);
+  if (!node.cached || node.cached->view.interface_hash() != node.record->interface_hash) {
+    node.cached.reset();
+    return false;
+  }
+
+  // Only what is shown needs the source. Reading it may show the file
+  // changed after all.
+  bool shown = !node.record->diagnostics.empty() || !node.record->uncalled.empty();
+  if (shown && !node.source_read) {
+    this->read_source(index);
+    if (node.source_hash != node.record->source_hash) {
+      node.cached.reset();
+      return false;
+    }
+  }
+
+  if (this->options.keep_ast) {
+    auto snapshot = this->cache->load_ast(entry.import_path, node.source_hash);
+    if (!snapshot) {
+      node.cached.reset();
+      return false;
+    }
+    entry.module->set_ast(snapshot->view.materialize());
+  }
+
+  entry.module->replay_diagnostics(std::move(node.record->diagnostics));
+  node.uncalled = std::move(node.record->uncalled);
+  node.used_imports = std::move(node.record->used_imports);
+  entry.from_cache = true;
+  node.interface_hash = node.record->interface_hash;
+  this->registry.publish_interface(entry.import_path, node.cached->view);
+  return true;
+}
+
+void ModuleLoader::store_in_cache(size_t index) {
+  auto& entry = this->loaded[index];
+  auto& node = this->graph[index];
+  const auto& exports = entry.module->get_exported_symbols();
+
+  node.interface_hash = interface_hash(exports);
+  this->cache->store(entry.import_path, node.source_hash, exports);
+  if (this->options.keep_ast) {
+    this->cache->store_ast(entry.import_path, node.source_hash, entry.module->get_root());
+  }
+
+  CheckRecord record{
+    .source_hash = node.source_hash,
+    .stamp = node.stamp,
+    .options_hash = this->options_hash,
+    .interface_hash = node.interface_hash,
+    .diagnostics = entry.module->get_diag_engine().all(),
+    .uncalled = node.uncalled,
+    .used_imports = node.used_imports,
+  };
+  for (const auto& tok : node.import_tokens) {
+    uint64_t dep_hash = 0;
+    if (std::ranges::find(node.broken, tok.token_value) == node.broken.end()) {
+      dep_hash = this->graph[this->by_path.at(tok.token_value)].interface_hash;
+    }
+    record.dependencies.push_back(CheckRecord::Dependency{
+      .import_path = tok.token_value,
+      .line = tok.line_number,
+      .column = tok.column_number,
+      .offset = tok.offset,
+      .interface_hash = dep_hash,
+    });
+  }
+  this->cache->store_record(entry.import_path, record);
+}
+
+// Runs once every module is loaded, as a function one module never calls
+// may be called from any module that imports it.
+void ModuleLoader::report_uncalled_functions() {
+  std::unordered_set<std::string> called;
+  for (const auto& node : this->graph) {
+    for (const auto& used : node.used_imports) called.insert(used.import_path + ':' + used.name);
+  }
+
+  for (size_t i = 0; i < this->loaded.size(); ++i) {
+    for (const auto& fn : this->graph[i].uncalled) {
+      if (called.contains(this->loaded[i].import_path + ':' + fn.name)) continue;
+
+      auto diag = Diagnostic();
+      diag.level = DiagnosticLevel::Warn;
+      diag.phase = DiagnosticPhase::Resolver;
+      diag.range = fn.range;
+      diag.message = std::format("Function `{}` is never called", fn.name);
+
+      this->loaded[i].module->get_diag_engine().report(diag);
+    }
+  }
+}
+
+void ModuleLoader::report_import(size_t index, const Token& at, std::string message) {
+  auto diag = Diagnostic();
+  diag.level = DiagnosticLevel::Fail;
+  diag.phase = DiagnosticPhase::Resolver;
+  diag.range = token_range(at);
+  diag.message = std::move(message);
+
+  this->loaded[index].module->get_diag_engine().report(diag);
+}
@@ -0,0 +1,76 @@
+#include <ether/module/module_registry.hpp>
+#include <ether/module/module_interface.hpp>
+#include <bit>
+#include <functional>
+
+std::optional<SymbolAttr> ModuleExports::find(const std::string& name) const {
+  if (this->view) {
+    auto* sym = this->view->find(name);
+    if (!sym) return std::nullopt;
+    return this->view->materialize(*sym);
+  }
+
+  auto found = this->table.find(name);
+  if (found == this->table.end()) return std::nullopt;
+
+  const SymbolAttr& origin = *found->second;
+  return SymbolAttr{
+    .name = origin.name,
+    .symbol_kind = origin.symbol_kind,
+    .type_info = origin.type_info,
+    .symbol_token = origin.symbol_token,
+    .symbol_data = origin.symbol_data,
+  };
+}
+
+size_t ModuleExports::size() const {
+  return this->view ? this->view->symbols().size() : this->table.size();
+}
+
+ModuleRegistry::ModuleRegistry(size_t bucket_count)
+: mask(std::bit_ceil(bucket_count < 1 ? size_t{1} : bucket_count) - 1),
+  buckets(std::make_unique<std::atomic<const Entry*>[]>(mask + 1)) {
+  for (size_t i = 0; i <= mask; ++i) buckets[i].store(nullptr, std::memory_order_relaxed);
+}
+
+std::atomic<const ModuleRegistry::Entry*>& ModuleRegistry::bucket_for(std::string_view path) const {
+  return this->buckets[std::hash<std::string_view>{}(path) & this->mask];
+}
+
+bool ModuleRegistry::publish(std::string path, ExportTable exports) {
+  return this->publish_entry(std::move(path), ModuleExports(std::move(exports)));
+}
+
+bool ModuleRegistry::publish_interface(std::string path, const InterfaceView& view) {
+  return this->publish_entry(std::move(path), ModuleExports(view));
+}
+
+bool ModuleRegistry::publish_entry(std::string path, ModuleExports exports) {
+  std::lock_guard lock(this->publish_mutex);
+  auto& bucket = this->bucket_for(path);
+
+  const Entry* head = bucket.load(std::memory_order_relaxed);
+  for (const Entry* e = head; e; e = e->next) {
+    if (e->path == path) return false;
+  }
+
+  auto entry = std::make_unique<Entry>(Entry{
+    .path = std::move(path),
+    .exports = std::move(exports),
+    .next = head,
+  });
+
+  // The release store makes the fully built entry (and, transitively, every
+  // entry it links to) visible to readers that acquire the bucket head.
+  bucket.store(entry.get(), std::memory_order_release);
+  this->entries.push_back(std::move(entry));
+  this->published.fetch_add(1, std::memory_order_release);
+  return true;
+}
+
+const ModuleExports* ModuleRegistry::find(std::string_view path) const {
+  for (const Entry* e = this->bucket_for(path).load(std::memory_order_acquire); e; e = e->next) {
+    if (e->path == path) return &e->exports;
+  }
+  return nullptr;
+}
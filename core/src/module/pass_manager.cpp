@@ -0,0 +1,114 @@
+#include <ether/module/pass_manager.hpp>
+#include <ether/nodes/tree_pass.hpp>
+#include <ether/support/alloc_stats.hpp>
+#include <algorithm>
+#include <format>
+#include <ostream>
+#include <utility>
+
+namespace {
+
+class NodeCounter final : public TreePass {
+public:
+  size_t count = 0;
+
+  std::string_view name() const override { return "count-nodes"; }
+  void enter(Node&) override { this->count++; }
+};
+
+size_t count_nodes(Module& mod) {
+  NodeCounter counter;
+  run_tree_passes(mod.get_root(), { &counter });
+  return counter.count;
+}
+
+}
+
+void PassManager::add(std::string name, PassFn run) {
+  this->totals.push_back(PassStats{ .name = name });
+  this->passes.push_back(Pass{ std::move(name), std::move(run) });
+}
+
+bool PassManager::contains(std::string_view name) const {
+  return std::ranges::any_of(this->passes, [&](const Pass& p) { return p.name == name; });
+}
+
+std::vector<std::string> PassManager::names() const {
+  std::vector<std::string> out;
+  for (const auto& p : this->passes) out.push_back(p.name);
+  return out;
+}
+
+bool PassManager::stop_after(std::string_view name) {
+  auto it = std::ranges::find(this->passes, name, &Pass::name);
+  if (it == this->passes.end()) return false;
+  this->last = static_cast<size_t>(it - this->passes.begin()) + 1;
+  return true;
+}
+
+bool PassManager::runs(std::string_view name) const {
+  auto it = std::ranges::find(this->passes, name, &Pass::name);
+  if (it == this->passes.end()) return false;
+  return static_cast<size_t>(it - this->passes.begin()) < this->last.value_or(this->passes.size());
+}
+
+void PassManager::run(Module& mod) {
+  size_t end = this->last.value_or(this->passes.size());
+  if (!this->record) {
+    for (size_t i = 0; i < end; ++i) this->passes[i].run(mod);
+    return;
+  }
+
+  std::vector<PassStats> local(end);
+  for (size_t i = 0; i < end; ++i) {
+    auto allocs_before = thread_alloc_counts();
+    auto start = std::chrono::steady_clock::now();
+    this->passes[i].run(mod);
+    local[i].wall = std::chrono::steady_clock::now() - start;
+    auto allocs_after = thread_alloc_counts();
+
+    local[i].allocations = allocs_after.allocations - allocs_before.allocations;
+    local[i].allocated_bytes = allocs_after.bytes - allocs_before.bytes;
+    local[i].nodes = count_nodes(mod);
+  }
+
+  std::lock_guard lock(this->stats_mutex);
+  for (size_t i = 0; i < end; ++i) {
+    auto& total = this->totals[i];
+    total.modules++;
+    total.wall += local[i].wall;
+    total.allocations += local[i].allocations;
+    total.allocated_bytes += local[i].allocated_bytes;
+    total.nodes += local[i].nodes;
+  }
+}
+
+std::vector<PassStats> PassManager::stats() const {
+  std::lock_guard lock(this->stats_mutex);
+  return this->totals;
+}
+
+void PassManager::print_stats(std::ostream& out) const {
+  auto rows = this->stats();
+  std::erase_if(rows, [](const PassStats& s) { return s.modules == 0; });
+
+  PassStats total{ .name = "total" };
+  for (const auto& row : rows) {
+    total.modules = std::max(total.modules, row.modules);
+    total.wall += row.wall;
+    total.allocations += row.allocations;
+    total.allocated_bytes += row.allocated_bytes;
+  }
+
+  out << std::format("{:<12} {:>8} {:>11} {:>11} {:>13} {:>10}\n",
+                     "pass", "modules", "time (ms)", "allocs", "bytes", "nodes");
+  auto line = [&](const PassStats& s, bool nodes) {
+    out << std::format("{:<12} {:>8} {:>11.3f} {:>11} {:>13} {:>10}\n",
+                       s.name, s.modules,
+                       std::chrono::duration<double, std::milli>(s.wall).count(),
+                       s.allocations, s.allocated_bytes,
+                       nodes ? std::to_string(s.nodes) : "");
+  };
+  for (const auto& row : rows) line(row, true);
+  line(total, false);
+}
@@ -1,5 +1,6 @@
 #include <ether/nodes/node_expr.hpp>
 #include <ether/nodes/node_visitor.hpp>
+#include <ether/nodes/tree_pass.hpp>
 
 void NDLiteral::accept(Visitor& v) { v.visit(*this); }
 
@@ -24,3 +25,15 @@ void NDBinaryExpr::accept(Visitor& v) { v.visit(*this); }
 void NDUnaryExpr::accept(Visitor& v) { v.visit(*this); }
 
 void NDScopeExpr::accept(Visitor& v) { v.visit(*this); }
+
+bool Parent::apply_visitors(const CancellationToken& cancel) {
+  for (auto& visitor : this->visitors) visitor->begin_module(*this);
+  for (auto& node : this->children) {
+    if (cancel.is_cancelled()) return false;
+    for (auto& visitor : this->visitors) {
+      node->accept(*visitor);
+    }
+  }
+  if (this->passes.empty()) return true;
+  return run_tree_passes(*this, this->passes, cancel);
+}
@@ -0,0 +1,496 @@
+#include <ether/nodes/node_snapshot.hpp>
+#include <ether/nodes/node_visitor.hpp>
+#include <algorithm>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+static_assert(std::is_trivially_copyable_v<SnapshotHeader>);
+static_assert(sizeof(SnapshotHeader) % alignof(SnapshotNode) == 0);
+static_assert(sizeof(SnapshotNode) % alignof(SnapshotToken) == 0);
+static_assert(sizeof(SnapshotToken) % alignof(uint32_t) == 0);
+
+namespace {
+template <typename T>
+void append_records(std::string& out, const std::vector<T>& records) {
+  out.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(T));
+}
+
+class SnapshotWriter final : public Visitor {
+public:
+  std::vector<SnapshotNode> nodes;
+  std::vector<SnapshotToken> tokens;
+  std::vector<uint32_t> links;
+  std::string strings;
+
+  // Visitors take nodes by mutable reference; the writer only reads them.
+  uint32_t write(const Node* node) {
+    if (!node) return snapshot_none;
+    const_cast<Node*>(node)->accept(*this);
+    return this->last;
+  }
+
+  SnapshotRange add_links(const std::vector<uint32_t>& list) {
+    SnapshotRange range{ static_cast<uint32_t>(this->links.size()), static_cast<uint32_t>(list.size()) };
+    this->links.insert(this->links.end(), list.begin(), list.end());
+    return range;
+  }
+
+  void visit(NDLiteral& n) override {
+    auto i = this->begin(SnapshotKind::Literal, &n);
+    this->nodes[i].token = this->add_token(n.literal);
+    this->last = i;
+  }
+
+  void visit(NDImportDirective& n) override {
+    auto i = this->begin(SnapshotKind::ImportDirective, &n);
+    this->nodes[i].token = this->add_token(n.import_directive);
+    this->last = i;
+  }
+
+  void visit(NDIdentifier& n) override {
+    auto i = this->begin(SnapshotKind::Identifier, &n);
+    this->nodes[i].token = this->add_token(n.identifier);
+    this->last = i;
+  }
+
+  void visit(NDUnaryExpr& n) override {
+    auto i = this->begin(SnapshotKind::UnaryExpr, &n);
+    this->nodes[i].token = this->add_token(n.op);
+    this->finish(i, { this->write(n.rhs.get()) });
+  }
+
+  void visit(NDBinaryExpr& n) override {
+    auto i = this->begin(SnapshotKind::BinaryExpr, &n);
+    this->nodes[i].token = this->add_token(n.op);
+    auto lhs = this->write(n.lhs.get());
+    this->finish(i, { lhs, this->write(n.rhs.get()) });
+  }
+
+  void visit(NDScopeExpr& n) override {
+    auto i = this->begin(SnapshotKind::ScopeExpr, &n);
+    this->nodes[i].token = this->add_token(n.open_brace);
+    this->finish(i, this->write_all(n.expressions));
+  }
+
+  void visit(NDLetBindExpr& n) override {
+    auto i = this->begin(SnapshotKind::LetBindExpr, &n);
+    auto identifier = this->write(n.identifier.get());
+    this->finish(i, { identifier, this->write(n.bound_value.get()) });
+  }
+
+  void visit(NDConstExpr& n) override {
+    auto i = this->begin(SnapshotKind::ConstExpr, &n);
+    auto identifier = this->write(n.identifier.get());
+    this->finish(i, { identifier, this->write(&n.literal) });
+  }
+
+  void visit(NDCallExpr& n) override {
+    auto i = this->begin(SnapshotKind::CallExpr, &n);
+    std::vector<uint32_t> children{ this->write(n.identifier.get()) };
+    for (const auto& arg : n.args) children.push_back(this->write(arg.get()));
+    this->finish(i, children);
+  }
+
+  void visit(NDCallChain& n) override {
+    auto i = this->begin(SnapshotKind::CallChain, &n);
+    this->nodes[i].token = this->add_token(n.start_token);
+    this->finish(i, this->write_all(n.calls));
+  }
+
+  void visit(NDFuncDeclExpr& n) override {
+    auto i = this->begin(SnapshotKind::FuncDecl, &n);
+    this->nodes[i].token = this->add_token(n.func_identifier);
+
+    std::vector<uint32_t> toks{ this->add_token(n.return_type) };
+    for (const auto& param : n.func_params) {
+      toks.push_back(this->add_token(param.param_token));
+      toks.push_back(this->add_token(param.param_type));
+    }
+    this->nodes[i].tokens = this->add_links(toks);
+    this->finish(i, this->write_all(n.func_body));
+  }
+
+  void visit(NDCaseExpr& n) override {
+    auto i = this->begin(SnapshotKind::CaseExpr, &n);
+    this->nodes[i].token = this->add_token(n.case_keyword);
+
+    auto children = this->write_all(n.conditions);
+    for (const auto& branch : n.branches) {
+      auto b = this->begin(SnapshotKind::CaseBranch, nullptr);
+      std::vector<uint32_t> parts{ this->write(branch.result.get()) };
+      for (const auto& pattern : branch.pattern) parts.push_back(this->write(pattern.get()));
+      this->finish(b, parts);
+      children.push_back(b);
+    }
+    this->finish(i, children);
+  }
+
+private:
+  uint32_t last = snapshot_none;
+  // Token values repeat a lot (names, operators); each is pooled once.
+  std::unordered_map<std::string_view, SnapshotStr> pooled;
+
+  uint32_t begin(SnapshotKind kind, const Node* node) {
+    SnapshotNode rec{};
+    rec.kind = static_cast<uint16_t>(kind);
+    rec.token = snapshot_none;
+    rec.type = snapshot_none;
+    if (node) {
+      rec.flags = node->is_poisoned ? snapshot_poisoned : 0;
+      rec.type = this->add_token(node->type);
+    }
+    this->nodes.push_back(rec);
+    return static_cast<uint32_t>(this->nodes.size() - 1);
+  }
+
+  void finish(uint32_t index, const std::vector<uint32_t>& children) {
+    this->nodes[index].children = this->add_links(children);
+    this->last = index;
+  }
+
+  std::vector<uint32_t> write_all(const std::vector<NDPtr>& list) {
+    std::vector<uint32_t> out;
+    out.reserve(list.size());
+    for (const auto& node : list) out.push_back(this->write(node.get()));
+    return out;
+  }
+
+  SnapshotStr add_string(std::string_view s) {
+    auto [it, fresh] = this->pooled.try_emplace(s);
+    if (fresh) {
+      it->second = SnapshotStr{ static_cast<uint32_t>(this->strings.size()), static_cast<uint32_t>(s.size()) };
+      this->strings.append(s);
+    }
+    return it->second;
+  }
+
+  uint32_t add_token(const Token& tok) {
+    this->tokens.push_back(SnapshotToken{
+      .type = static_cast<uint32_t>(tok.token_type),
+      .line = static_cast<uint32_t>(tok.line_number),
+      .column = static_cast<uint32_t>(tok.column_number),
+      .offset = static_cast<uint32_t>(tok.offset),
+      .value = this->add_string(tok.token_value),
+    });
+    return static_cast<uint32_t>(this->tokens.size() - 1);
+  }
+
+  uint32_t add_token(const std::optional<Token>& tok) {
+    return tok ? this->add_token(*tok) : snapshot_none;
+  }
+};
+
+bool kind_is(const AstSnapshotView& view, uint32_t index, SnapshotKind kind) {
+  return index != snapshot_none && view.nodes()[index].kind == static_cast<uint16_t>(kind);
+}
+
+// Shape rules from the table in node_snapshot.hpp. Every index is already
+// known to be in bounds.
+bool valid_shape(const AstSnapshotView& view, const SnapshotNode& node) {
+  using K = SnapshotKind;
+  auto kind = static_cast<K>(node.kind);
+  auto children = view.links(node.children);
+  auto toks = view.links(node.tokens);
+
+  auto identifier_or_none = [&](uint32_t i) { return i == snapshot_none || kind_is(view, i, K::Identifier); };
+  // Branches are only meaningful inside a CaseExpr, after its conditions.
+  auto no_branches = [&](std::span<const uint32_t> list) {
+    for (auto i : list) {
+      if (kind_is(view, i, K::CaseBranch)) return false;
+    }
+    return true;
+  };
+
+  bool needs_token = kind != K::UnaryExpr && kind != K::LetBindExpr
+                  && kind != K::ConstExpr && kind != K::CallExpr && kind != K::CaseBranch;
+  if (needs_token && node.token == snapshot_none) return false;
+  if (kind != K::FuncDecl && !toks.empty()) return false;
+
+  switch (kind) {
+    case K::Literal:
+    case K::ImportDirective:
+    case K::Identifier:
+      return children.empty();
+    case K::UnaryExpr:
+      return children.size() == 1 && no_branches(children);
+    case K::BinaryExpr:
+      return children.size() == 2 && no_branches(children);
+    case K::LetBindExpr:
+      return children.size() == 2 && identifier_or_none(children[0]) && no_branches(children);
+    case K::ConstExpr:
+      return children.size() == 2 && identifier_or_none(children[0]) && kind_is(view, children[1], K::Literal);
+    case K::CallExpr:
+      return !children.empty() && identifier_or_none(children[0]) && no_branches(children);
+    case K::ScopeExpr:
+    case K::CallChain:
+    case K::CaseBranch:
+      return (kind != K::CaseBranch || !children.empty()) && no_branches(children);
+    case K::FuncDecl:
+      if (toks.size() % 2 != 1) return false;
+      for (size_t i = 1; i < toks.size(); i += 2) {
+        if (toks[i] == snapshot_none) return false;
+      }
+      return no_branches(children);
+    case K::CaseExpr: {
+      size_t i = 0;
+      while (i < children.size() && !kind_is(view, children[i], K::CaseBranch)) ++i;
+      return std::ranges::all_of(children.subspan(i), [&](uint32_t c) { return kind_is(view, c, K::CaseBranch); });
+    }
+  }
+  return false;
+}
+
+class Materializer {
+public:
+  explicit Materializer(const AstSnapshotView& view) : view(view) {}
+
+  NDPtr node(uint32_t index) {
+    if (index == snapshot_none) return nullptr;
+    const auto& rec = this->view.nodes()[index];
+    auto children = this->view.links(rec.children);
+
+    switch (static_cast<SnapshotKind>(rec.kind)) {
+      case SnapshotKind::Literal:
+        return std::make_unique<NDLiteral>(this->literal(index));
+      case SnapshotKind::ImportDirective: {
+        auto n = this->make<NDImportDirective>(rec);
+        n->import_directive = this->view.token(rec.token);
+        return n;
+      }
+      case SnapshotKind::Identifier:
+        return this->identifier(index);
+      case SnapshotKind::UnaryExpr: {
+        auto n = this->make<NDUnaryExpr>(rec);
+        n->op = this->optional_token(rec.token);
+        n->rhs = this->node(children[0]);
+        return n;
+      }
+      case SnapshotKind::BinaryExpr: {
+        auto n = this->make<NDBinaryExpr>(rec);
+        n->lhs = this->node(children[0]);
+        n->op = this->view.token(rec.token);
+        n->rhs = this->node(children[1]);
+        return n;
+      }
+      case SnapshotKind::ScopeExpr: {
+        auto n = this->make<NDScopeExpr>(rec);
+        n->open_brace = this->view.token(rec.token);
+        n->expressions = this->nodes(children);
+        return n;
+      }
+      case SnapshotKind::LetBindExpr: {
+        auto n = this->make<NDLetBindExpr>(rec);
+        n->identifier = this->identifier(children[0]);
+        n->bound_value = this->node(children[1]);
+        return n;
+      }
+      case SnapshotKind::ConstExpr: {
+        auto n = this->make<NDConstExpr>(rec);
+        n->identifier = this->identifier(children[0]);
+        n->literal = this->literal(children[1]);
+        return n;
+      }
+      case SnapshotKind::CallExpr: {
+        auto n = this->make<NDCallExpr>(rec);
+        n->identifier = this->identifier(children[0]);
+        n->args = this->nodes(children.subspan(1));
+        return n;
+      }
+      case SnapshotKind::CallChain: {
+        auto n = this->make<NDCallChain>(rec);
+        n->start_token = this->view.token(rec.token);
+        n->calls = this->nodes(children);
+        return n;
+      }
+      case SnapshotKind::FuncDecl: {
+        auto n = this->make<NDFuncDeclExpr>(rec);
+        auto toks = this->view.links(rec.tokens);
+        n->func_identifier = this->view.token(rec.token);
+        n->return_type = this->optional_token(toks[0]);
+        for (size_t i = 1; i < toks.size(); i += 2) {
+          n->func_params.push_back(FuncParam{
+            .param_token = this->view.token(toks[i]),
+            .param_type = this->optional_token(toks[i + 1]),
+          });
+        }
+        n->func_body = this->nodes(children);
+        return n;
+      }
+      case SnapshotKind::CaseExpr: {
+        auto n = this->make<NDCaseExpr>(rec);
+        n->case_keyword = this->view.token(rec.token);
+        for (auto child : children) {
+          if (!kind_is(this->view, child, SnapshotKind::CaseBranch)) {
+            n->conditions.push_back(this->node(child));
+            continue;
+          }
+          auto parts = this->view.links(this->view.nodes()[child].children);
+          n->branches.push_back(NDCaseExpr::Branch{
+            .pattern = this->nodes(parts.subspan(1)),
+            .result = this->node(parts[0]),
+          });
+        }
+        return n;
+      }
+      case SnapshotKind::CaseBranch:
+        break;
+    }
+    return nullptr;
+  }
+
+  std::vector<NDPtr> nodes(std::span<const uint32_t> list) {
+    std::vector<NDPtr> out;
+    out.reserve(list.size());
+    for (auto i : list) out.push_back(this->node(i));
+    return out;
+  }
+
+private:
+  const AstSnapshotView& view;
+
+  template <typename T>
+  std::unique_ptr<T> make(const SnapshotNode& rec) {
+    auto n = std::make_unique<T>();
+    this->init(*n, rec);
+    return n;
+  }
+
+  void init(Node& n, const SnapshotNode& rec) {
+    n.is_poisoned = (rec.flags & snapshot_poisoned) != 0;
+    n.type = this->optional_token(rec.type);
+  }
+
+  std::optional<Token> optional_token(uint32_t index) {
+    if (index == snapshot_none) return std::nullopt;
+    return this->view.token(index);
+  }
+
+  NDLiteral literal(uint32_t index) {
+    const auto& rec = this->view.nodes()[index];
+    NDLiteral n;
+    this->init(n, rec);
+    n.literal = this->view.token(rec.token);
+    return n;
+  }
+
+  std::unique_ptr<NDIdentifier> identifier(uint32_t index) {
+    if (index == snapshot_none) return nullptr;
+    const auto& rec = this->view.nodes()[index];
+    auto n = this->make<NDIdentifier>(rec);
+    n->identifier = this->view.token(rec.token);
+    return n;
+  }
+};
+}
+
+std::string write_ast_snapshot(const Parent& root, uint64_t source_hash) {
+  SnapshotWriter writer;
+  std::vector<uint32_t> roots;
+  roots.reserve(root.children.size());
+  for (const auto& child : root.children) roots.push_back(writer.write(child.get()));
+  auto root_range = writer.add_links(roots);
+
+  SnapshotHeader header{
+    .magic = ast_snapshot_magic,
+    .version = ast_snapshot_version,
+    .source_hash = source_hash,
+    .node_count = static_cast<uint32_t>(writer.nodes.size()),
+    .token_count = static_cast<uint32_t>(writer.tokens.size()),
+    .link_count = static_cast<uint32_t>(writer.links.size()),
+    .strings_size = static_cast<uint32_t>(writer.strings.size()),
+    .roots = root_range,
+  };
+
+  std::string out;
+  out.reserve(sizeof header + writer.nodes.size() * sizeof(SnapshotNode)
+            + writer.tokens.size() * sizeof(SnapshotToken)
+            + writer.links.size() * sizeof(uint32_t) + writer.strings.size());
+  out.append(reinterpret_cast<const char*>(&header), sizeof header);
+  append_records(out, writer.nodes);
+  append_records(out, writer.tokens);
+  append_records(out, writer.links);
+  out.append(writer.strings);
+  return out;
+}
+
+std::optional<AstSnapshotView> AstSnapshotView::parse(std::span<const std::byte> bytes) {
+  if (bytes.size() < sizeof(SnapshotHeader)) return std::nullopt;
+  if (reinterpret_cast<uintptr_t>(bytes.data()) % alignof(SnapshotHeader) != 0) return std::nullopt;
+
+  AstSnapshotView view;
+  view.header = reinterpret_cast<const SnapshotHeader*>(bytes.data());
+  const auto& h = *view.header;
+  if (h.magic != ast_snapshot_magic || h.version != ast_snapshot_version) return std::nullopt;
+
+  size_t nodes_at = sizeof(SnapshotHeader);
+  size_t tokens_at = nodes_at + size_t{h.node_count} * sizeof(SnapshotNode);
+  size_t links_at = tokens_at + size_t{h.token_count} * sizeof(SnapshotToken);
+  size_t strings_at = links_at + size_t{h.link_count} * sizeof(uint32_t);
+  if (strings_at + h.strings_size != bytes.size()) return std::nullopt;
+
+  const auto* base = reinterpret_cast<const char*>(bytes.data());
+  view.node_records = reinterpret_cast<const SnapshotNode*>(base + nodes_at);
+  view.token_records = reinterpret_cast<const SnapshotToken*>(base + tokens_at);
+  view.link_records = reinterpret_cast<const uint32_t*>(base + links_at);
+  view.strings = base + strings_at;
+
+  auto range_ok = [&](SnapshotRange r) {
+    return r.first <= h.link_count && r.count <= h.link_count - r.first;
+  };
+  auto token_ok = [&](uint32_t t) { return t == snapshot_none || t < h.token_count; };
+
+  for (const auto& tok : view.tokens()) {
+    if (tok.type > static_cast<uint32_t>(TokenType::Unknown)) return std::nullopt;
+    if (tok.value.offset > h.strings_size || tok.value.length > h.strings_size - tok.value.offset) {
+      return std::nullopt;
+    }
+  }
+
+  if (!range_ok(h.roots)) return std::nullopt;
+  for (auto root : view.roots()) {
+    if (root >= h.node_count || kind_is(view, root, SnapshotKind::CaseBranch)) return std::nullopt;
+  }
+
+  auto nodes = view.nodes();
+  for (uint32_t i = 0; i < nodes.size(); ++i) {
+    const auto& node = nodes[i];
+    if (node.kind > static_cast<uint16_t>(SnapshotKind::CaseBranch)) return std::nullopt;
+    if (!token_ok(node.token) || !token_ok(node.type)) return std::nullopt;
+    if (!range_ok(node.children) || !range_ok(node.tokens)) return std::nullopt;
+
+    // Children strictly after their parent rule out cycles.
+    for (auto child : view.links(node.children)) {
+      if (child != snapshot_none && (child <= i || child >= h.node_count)) return std::nullopt;
+    }
+    for (auto tok : view.links(node.tokens)) {
+      if (!token_ok(tok)) return std::nullopt;
+    }
+  }
+  // Shapes look at child kinds, so only once every index is known good.
+  for (const auto& node : nodes) {
+    if (!valid_shape(view, node)) return std::nullopt;
+  }
+
+  return view;
+}
+
+Token AstSnapshotView::token(uint32_t index) const {
+  const auto& rec = this->token_records[index];
+  return Token{
+    .token_type = static_cast<TokenType>(rec.type),
+    .token_value = std::string(this->str(rec.value)),
+    .line_number = rec.line,
+    .column_number = rec.column,
+    .offset = rec.offset,
+  };
+}
+
+Parent AstSnapshotView::materialize() const {
+  Materializer builder(*this);
+  Parent root;
+  root.children = builder.nodes(this->roots());
+  return root;
+}
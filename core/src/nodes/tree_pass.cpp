@@ -0,0 +1,161 @@
+#include <ether/nodes/tree_pass.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <stdexcept>
+
+namespace {
+
+// Walks the tree once, calling every pass's hooks at each node.
+class FusedWalker final : public Visitor {
+public:
+  explicit FusedWalker(const std::vector<TreePass*>& passes) : passes(passes) {}
+
+  void visit(NDLiteral& n) override {
+    this->enter(n);
+    this->exit(n);
+  }
+
+  void visit(NDImportDirective& n) override {
+    this->enter(n);
+    this->exit(n);
+  }
+
+  void visit(NDIdentifier& n) override {
+    this->enter(n);
+    this->exit(n);
+  }
+
+  void visit(NDLetBindExpr& n) override {
+    this->enter(n);
+    this->child(n.identifier.get());
+    this->child(n.bound_value.get());
+    this->exit(n);
+  }
+
+  void visit(NDConstExpr& n) override {
+    this->enter(n);
+    this->child(n.identifier.get());
+    n.literal.accept(*this);
+    this->exit(n);
+  }
+
+  void visit(NDCallExpr& n) override {
+    this->enter(n);
+    this->child(n.identifier.get());
+    this->children(n.args);
+    this->exit(n);
+  }
+
+  void visit(NDCallChain& n) override {
+    this->enter(n);
+    this->children(n.calls);
+    this->exit(n);
+  }
+
+  void visit(NDFuncDeclExpr& n) override {
+    this->enter(n);
+    this->children(n.func_body);
+    this->exit(n);
+  }
+
+  void visit(NDCaseExpr& n) override {
+    this->enter(n);
+    this->children(n.conditions);
+    for (auto& branch : n.branches) {
+      this->children(branch.pattern);
+      this->child(branch.result.get());
+    }
+    this->exit(n);
+  }
+
+  void visit(NDBinaryExpr& n) override {
+    this->enter(n);
+    this->child(n.lhs.get());
+    this->child(n.rhs.get());
+    this->exit(n);
+  }
+
+  void visit(NDUnaryExpr& n) override {
+    this->enter(n);
+    this->child(n.rhs.get());
+    this->exit(n);
+  }
+
+  void visit(NDScopeExpr& n) override {
+    this->enter(n);
+    this->children(n.expressions);
+    this->exit(n);
+  }
+
+private:
+  const std::vector<TreePass*>& passes;
+
+  template <typename N>
+  void enter(N& n) {
+    for (auto* pass : this->passes) pass->enter(n);
+  }
+
+  template <typename N>
+  void exit(N& n) {
+    for (auto it = this->passes.rbegin(); it != this->passes.rend(); ++it) (*it)->exit(n);
+  }
+
+  void child(Node* n) {
+    if (n) n->accept(*this);
+  }
+
+  void children(std::vector<NDPtr>& nodes) {
+    for (auto& n : nodes) this->child(n.get());
+  }
+};
+
+}
+
+// Depth-first over after(), so a pass is placed once everything it names
+// is, wherever that was attached.
+std::vector<size_t> schedule_tree_passes(const std::vector<TreePass*>& passes) {
+  enum class State : uint8_t { Unplaced, Placing, Placed };
+  std::vector<State> state(passes.size(), State::Unplaced);
+  std::vector<size_t> walk(passes.size(), 0);
+
+  auto place = [&](auto& self, size_t i) -> void {
+    if (state[i] == State::Placed) return;
+    if (state[i] == State::Placing) {
+      throw std::invalid_argument(std::format("tree pass `{}` is part of an after() cycle", passes[i]->name()));
+    }
+    state[i] = State::Placing;
+    for (auto dep : passes[i]->after()) {
+      for (size_t j = 0; j < passes.size(); ++j) {
+        if (passes[j]->name() != dep) continue;
+        self(self, j);
+        walk[i] = std::max(walk[i], walk[j] + 1);
+      }
+    }
+    state[i] = State::Placed;
+  };
+  for (size_t i = 0; i < passes.size(); ++i) place(place, i);
+  return walk;
+}
+
+bool run_tree_passes(Parent& root, const std::vector<TreePass*>& passes, const CancellationToken& cancel) {
+  auto walk = schedule_tree_passes(passes);
+  size_t walks = walk.empty() ? 0 : *std::ranges::max_element(walk) + 1;
+
+  std::vector<TreePass*> group;
+  for (size_t w = 0; w < walks; ++w) {
+    group.clear();
+    for (size_t i = 0; i < passes.size(); ++i) {
+      if (walk[i] == w) group.push_back(passes[i]);
+    }
+
+    for (auto* pass : group) pass->begin_module(root);
+    FusedWalker walker(group);
+    for (auto& node : root.children) {
+      if (cancel.is_cancelled()) return false;
+      node->accept(walker);
+    }
+    for (auto* pass : group) pass->end_module(root);
+  }
+  return true;
+}
@@ -19,11 +19,17 @@ static bool is_top_level_sync_token(TokenType t) {
 
 PResult<Parent> run_parser(ParserState& state) {
   Parent parent;
-  while(!state.is_at_end()) {
+  while(state.pos < state.tokens.size()) {
+    if (state.resync && state.resync(state.tokens[state.pos])) break;
+    if (state.cancel.is_cancelled()) break;
+    if (state.diag_eng.should_stop(DiagnosticPhase::Parser)) break;
+
     size_t before = state.pos;
+    TopLevelMark mark{ before, state.diag_eng.all().size(), state.high_water };
     PResult<NDPtr> ptr = run(parse_expression(), state);
     if (ptr) {
       parent.children.push_back(std::move(ptr.value()));
+      state.top_level.push_back(mark);
       continue;
     }
 
@@ -0,0 +1,25 @@
+#include <ether/support/alloc_stats.hpp>
+
+namespace {
+// Constant-initialized, so safe to touch from allocations made before
+// main() or during thread exit.
+thread_local AllocCounts counts;
+bool counting = false;
+}
+
+AllocCounts thread_alloc_counts() {
+  return counts;
+}
+
+bool alloc_counting_enabled() {
+  return counting;
+}
+
+void enable_alloc_counting() {
+  counting = true;
+}
+
+void count_allocation(size_t bytes) {
+  counts.allocations++;
+  counts.bytes += bytes;
+}
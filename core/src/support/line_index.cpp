@@ -0,0 +1,23 @@
+#include <ether/support/line_index.hpp>
+#include <algorithm>
+
+LineIndex::LineIndex(std::string_view text) {
+  for (size_t at = text.find('\n'); at != std::string_view::npos; at = text.find('\n', at + 1)) {
+    if (at + 1 < text.size()) this->starts.push_back(at + 1);
+  }
+}
+
+SourcePosition LineIndex::position(size_t offset) const {
+  auto after = std::upper_bound(this->starts.begin(), this->starts.end(), offset);
+  size_t line = static_cast<size_t>(after - this->starts.begin());
+  return { line, offset - this->starts[line - 1] + 1 };
+}
+
+std::string_view LineIndex::line(std::string_view text, size_t line) const {
+  size_t start = std::min(this->starts[line - 1], text.size());
+  size_t end = line < this->starts.size() ? this->starts[line] : text.size();
+  auto out = text.substr(start, end - start);
+  if (!out.empty() && out.back() == '\n') out.remove_suffix(1);
+  if (!out.empty() && out.back() == '\r') out.remove_suffix(1);
+  return out;
+}
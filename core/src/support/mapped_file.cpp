@@ -0,0 +1,82 @@
+#include <ether/support/mapped_file.hpp>
+#include <utility>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+MappedFile::MappedFile(const std::filesystem::path& file) {
+  HANDLE handle = CreateFileW(
+    file.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+    OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr
+  );
+  if (handle == INVALID_HANDLE_VALUE) return;
+
+  LARGE_INTEGER size;
+  if (GetFileSizeEx(handle, &size) && size.QuadPart > 0) {
+    HANDLE mapping = CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping) {
+      void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+      if (view) {
+        this->data = static_cast<const std::byte*>(view);
+        this->length = static_cast<size_t>(size.QuadPart);
+      }
+      CloseHandle(mapping);
+    }
+  }
+  CloseHandle(handle);
+}
+
+void MappedFile::close() {
+  if (this->data) UnmapViewOfFile(this->data);
+  this->data = nullptr;
+  this->length = 0;
+}
+
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::filesystem::path& file) {
+  int fd = ::open(file.c_str(), O_RDONLY);
+  if (fd < 0) return;
+
+  struct stat st;
+  if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+    void* view = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (view != MAP_FAILED) {
+      this->data = static_cast<const std::byte*>(view);
+      this->length = static_cast<size_t>(st.st_size);
+    }
+  }
+  // The mapping keeps the file contents alive on its own.
+  ::close(fd);
+}
+
+void MappedFile::close() {
+  if (this->data) ::munmap(const_cast<std::byte*>(this->data), this->length);
+  this->data = nullptr;
+  this->length = 0;
+}
+#endif
+
+MappedFile::~MappedFile() {
+  this->close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+: data(std::exchange(other.data, nullptr)),
+  length(std::exchange(other.length, 0)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+  if (this != &other) {
+    this->close();
+    this->data = std::exchange(other.data, nullptr);
+    this->length = std::exchange(other.length, 0);
+  }
+  return *this;
+}
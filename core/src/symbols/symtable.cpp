@@ -32,6 +32,12 @@ SymbolAttr* SymbolTable::lookup(const std::string& name) {
       return found->second;
     }
   }
+
+  if (this->outer) {
+    if (auto found = this->outer->find(name); found != this->outer->end()) {
+      return found->second;
+    }
+  }
   return nullptr;
 }
 
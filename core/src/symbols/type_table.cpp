@@ -0,0 +1,233 @@
+#include <ether/symbols/type_table.hpp>
+#include <ether/support/hash.hpp>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <limits>
+#include <mutex>
+
+uint64_t TypeTable::Key::hash() const {
+  uint64_t h = hash_combine(static_cast<uint64_t>(this->kind), this->index);
+  if (!this->name.empty()) h = hash_combine(h, hash_bytes(this->name));
+  for (auto arg : this->args) h = hash_combine(h, arg);
+  return h;
+}
+
+TypeTable& TypeTable::shared() {
+  static TypeTable table;
+  return table;
+}
+
+TypeTable::TypeTable() {
+  this->slots.assign(64, empty_slot);
+  for (auto kind : { TypeKind::Unknown, TypeKind::Int, TypeKind::Float, TypeKind::String, TypeKind::Bool, TypeKind::Nil }) {
+    this->intern(Key{ .kind = kind });
+  }
+}
+
+TypeId TypeTable::annotation(std::string_view name) {
+  if (name.empty()) return unknown;
+  if (name == "Int") return int_type;
+  if (name == "Float") return float_type;
+  if (name == "String") return string_type;
+  if (name == "Bool") return bool_type;
+  if (name == "Nil") return nil_type;
+  return this->named(name);
+}
+
+TypeId TypeTable::named(std::string_view name) {
+  return this->intern(Key{ .kind = TypeKind::Named, .name = name });
+}
+
+TypeId TypeTable::function(std::span<const TypeId> params, TypeId result) {
+  std::vector<TypeId> key_args(params.begin(), params.end());
+  key_args.push_back(result);
+  return this->intern(Key{ .kind = TypeKind::Func, .args = key_args });
+}
+
+TypeId TypeTable::var(uint32_t index) {
+  return this->intern(Key{ .kind = TypeKind::Var, .index = index });
+}
+
+TypeKind TypeTable::kind(TypeId type) const {
+  if (type <= nil_type) return static_cast<TypeKind>(type);
+  std::shared_lock lock(this->mutex);
+  return this->entries[type].kind;
+}
+
+std::vector<TypeId> TypeTable::params(TypeId func) const {
+  std::shared_lock lock(this->mutex);
+  const auto& entry = this->entries[func];
+  auto first = this->args.begin() + entry.first;
+  return { first, first + entry.count };
+}
+
+TypeId TypeTable::result(TypeId func) const {
+  std::shared_lock lock(this->mutex);
+  const auto& entry = this->entries[func];
+  return this->args[entry.first + entry.count];
+}
+
+std::string TypeTable::name(TypeId named) const {
+  std::shared_lock lock(this->mutex);
+  return this->names[this->entries[named].first];
+}
+
+uint32_t TypeTable::var_index(TypeId var) const {
+  std::shared_lock lock(this->mutex);
+  return this->entries[var].first;
+}
+
+size_t TypeTable::size() const {
+  std::shared_lock lock(this->mutex);
+  return this->entries.size();
+}
+
+// Looked up under the shared lock first: most types asked for exist.
+TypeId TypeTable::intern(const Key& key) {
+  uint64_t hash = key.hash();
+  {
+    std::shared_lock lock(this->mutex);
+    if (auto id = this->find(key, hash); id != empty_slot) return id;
+  }
+
+  std::unique_lock lock(this->mutex);
+  if (auto id = this->find(key, hash); id != empty_slot) return id;
+
+  Entry entry{ .kind = key.kind, .first = key.index, .count = 0, .hash = hash };
+  if (key.kind == TypeKind::Named) {
+    entry.first = static_cast<uint32_t>(this->names.size());
+    this->names.emplace_back(key.name);
+  } else if (key.kind == TypeKind::Func) {
+    entry.first = static_cast<uint32_t>(this->args.size());
+    entry.count = static_cast<uint32_t>(key.args.size() - 1);
+    this->args.insert(this->args.end(), key.args.begin(), key.args.end());
+  }
+
+  auto id = static_cast<TypeId>(this->entries.size());
+  this->entries.push_back(entry);
+  if (this->entries.size() * 2 > this->slots.size()) {
+    this->slots.assign(this->slots.size() * 2, empty_slot);
+    for (TypeId i = 0; i < id; ++i) this->insert_slot(i);
+  }
+  this->insert_slot(id);
+  return id;
+}
+
+TypeId TypeTable::find(const Key& key, uint64_t hash) const {
+  size_t mask = this->slots.size() - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    TypeId id = this->slots[i];
+    if (id == empty_slot) return empty_slot;
+    const auto& entry = this->entries[id];
+    if (entry.hash == hash && this->matches(entry, key)) return id;
+  }
+}
+
+bool TypeTable::matches(const Entry& entry, const Key& key) const {
+  if (entry.kind != key.kind) return false;
+  switch (entry.kind) {
+    case TypeKind::Named: return this->names[entry.first] == key.name;
+    case TypeKind::Var: return entry.first == key.index;
+    case TypeKind::Func:
+      return entry.count + 1 == key.args.size()
+          && std::equal(key.args.begin(), key.args.end(), this->args.begin() + entry.first);
+    default: return true;
+  }
+}
+
+void TypeTable::insert_slot(TypeId id) {
+  size_t mask = this->slots.size() - 1;
+  size_t i = this->entries[id].hash & mask;
+  while (this->slots[i] != empty_slot) i = (i + 1) & mask;
+  this->slots[i] = id;
+}
+
+std::string TypeTable::to_string(TypeId type) const {
+  std::string out;
+  std::shared_lock lock(this->mutex);
+  this->append(out, type);
+  return out;
+}
+
+void TypeTable::append(std::string& out, TypeId type) const {
+  const auto& entry = this->entries[type];
+  switch (entry.kind) {
+    case TypeKind::Unknown: return;
+    case TypeKind::Int: out += "Int"; return;
+    case TypeKind::Float: out += "Float"; return;
+    case TypeKind::String: out += "String"; return;
+    case TypeKind::Bool: out += "Bool"; return;
+    case TypeKind::Nil: out += "Nil"; return;
+    case TypeKind::Named: out += this->names[entry.first]; return;
+    case TypeKind::Var:
+      out += '\'';
+      out += static_cast<char>('a' + entry.first % 26);
+      if (entry.first >= 26) out += std::to_string(entry.first / 26);
+      return;
+    case TypeKind::Func: break;
+  }
+
+  out += '(';
+  for (uint32_t i = 0; i < entry.count; ++i) {
+    if (i) out += ", ";
+    this->append(out, this->args[entry.first + i]);
+  }
+  out += ") :> ";
+  this->append(out, this->args[entry.first + entry.count]);
+}
+
+TypeId TypeTable::parse(std::string_view text) {
+  auto type = this->parse_type(text);
+  return text.empty() ? type : unknown;
+}
+
+// Consumes one type from the front of `text`.
+TypeId TypeTable::parse_type(std::string_view& text) {
+  auto skip = [&](std::string_view s) {
+    if (!text.starts_with(s)) return false;
+    text.remove_prefix(s.size());
+    return true;
+  };
+  auto word = [&] {
+    size_t n = 0;
+    while (n < text.size() && (std::isalnum(static_cast<unsigned char>(text[n])) || text[n] == '_')) ++n;
+    auto w = text.substr(0, n);
+    text.remove_prefix(n);
+    return w;
+  };
+
+  if (skip("(")) {
+    std::vector<TypeId> params;
+    if (!skip(")")) {
+      do {
+        auto param = this->parse_type(text);
+        if (param == unknown) return unknown;
+        params.push_back(param);
+      } while (skip(", "));
+      if (!skip(")")) return unknown;
+    }
+    if (!skip(" :> ")) return unknown;
+    auto result = this->parse_type(text);
+    if (result == unknown) return unknown;
+    return this->function(params, result);
+  }
+
+  if (skip("'")) {
+    auto w = word();
+    if (w.empty() || w[0] < 'a' || w[0] > 'z') return unknown;
+    uint32_t index = static_cast<uint32_t>(w[0] - 'a');
+    if (w.size() > 1) {
+      // Text from a damaged interface file may hold any number here.
+      auto rest = w.substr(1);
+      uint32_t cycle = 0;
+      auto [end, ec] = std::from_chars(rest.data(), rest.data() + rest.size(), cycle);
+      if (ec != std::errc() || end != rest.data() + rest.size()) return unknown;
+      if (cycle > (std::numeric_limits<uint32_t>::max() - index) / 26) return unknown;
+      index += 26 * cycle;
+    }
+    return this->var(index);
+  }
+
+  return this->annotation(word());
+}
@@ -0,0 +1,37 @@
+#include <ether/symbols/use_index.hpp>
+#include <algorithm>
+
+UseDefIndex UseDefIndex::build(const std::vector<SymbolUse>& uses, size_t symbol_count) {
+  UseDefIndex index;
+  index.starts.assign(symbol_count + 1, 0);
+  index.offsets.resize(uses.size());
+
+  // Counting sort by symbol id: one pass to size each bucket, one to fill.
+  for (const auto& use : uses) index.starts[use.symbol->id + 1]++;
+  for (size_t i = 1; i < index.starts.size(); ++i) {
+    index.starts[i] += index.starts[i - 1];
+  }
+
+  std::vector<uint32_t> cursor(index.starts.begin(), index.starts.end() - 1);
+  for (const auto& use : uses) {
+    index.offsets[cursor[use.symbol->id]++] = use.offset;
+  }
+
+  // Uses are recorded in visit order, which is almost always source order;
+  // only buckets that came out of order need sorting.
+  for (size_t i = 0; i < symbol_count; ++i) {
+    auto first = index.offsets.begin() + index.starts[i];
+    auto last = index.offsets.begin() + index.starts[i + 1];
+    if (!std::is_sorted(first, last)) std::sort(first, last);
+  }
+
+  return index;
+}
+
+std::span<const uint32_t> UseDefIndex::references(const SymbolAttr& sym) const {
+  if (sym.id + 1 >= starts.size()) return {};
+  return std::span<const uint32_t>(
+    offsets.data() + starts[sym.id],
+    starts[sym.id + 1] - starts[sym.id]
+  );
+}
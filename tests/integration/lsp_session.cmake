@@ -0,0 +1,56 @@
+# Scripted LSP client: pipes a whole session into `ether lsp` over stdio and
+# checks what comes back. Run by ctest as
+#
+#   cmake -DETHER=<path to ether> -DWORK_DIR=<scratch dir> -P lsp_session.cmake
+
+if(NOT ETHER OR NOT WORK_DIR)
+  message(FATAL_ERROR "usage: cmake -DETHER=<ether> -DWORK_DIR=<dir> -P lsp_session.cmake")
+endif()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+file(WRITE "${WORK_DIR}/lib.bz" "func helper()\n  1\nend\n")
+
+set(root_uri "file://${WORK_DIR}")
+set(main_uri "${root_uri}/main.bz")
+
+# Frames the concatenation of its arguments as one message.
+set(session "")
+function(client_send)
+  string(CONCAT body ${ARGV})
+  string(LENGTH "${body}" length)
+  set(session "${session}Content-Length: ${length}\r\n\r\n${body}" PARENT_SCOPE)
+endfunction()
+
+client_send([[{"jsonrpc":"2.0","id":1,"method":"initialize","params":{"rootUri":"]] "${root_uri}" [["}}]])
+client_send([[{"jsonrpc":"2.0","method":"initialized","params":{}}]])
+# `missing()` is not declared anywhere.
+client_send([[{"jsonrpc":"2.0","method":"textDocument/didOpen","params":{"textDocument":{"uri":"]] "${main_uri}" [[","languageId":"benzene","version":1,"text":"Load lib\n\nfunc main()\n  helper()\n  missing()\nend\n"}}}]])
+client_send([[{"jsonrpc":"2.0","id":2,"method":"shutdown"}]])
+client_send([[{"jsonrpc":"2.0","method":"exit"}]])
+
+file(WRITE "${WORK_DIR}/session.in" "${session}")
+execute_process(
+  COMMAND "${ETHER}" lsp -j 2
+  INPUT_FILE "${WORK_DIR}/session.in"
+  OUTPUT_VARIABLE replies
+  ERROR_VARIABLE errors
+  RESULT_VARIABLE code
+)
+
+if(NOT code EQUAL 0)
+  message(FATAL_ERROR "ether lsp exited with ${code}\n${errors}\n${replies}")
+endif()
+
+foreach(expected
+    [["id":1,"result":{"capabilities":]]
+    [["method":"textDocument/publishDiagnostics","params":{"uri":"]]
+    [["range":{"start":{"line":4,"character":2},"end":{"line":4,"character":9}}]]
+    [["id":2,"result":null]])
+  string(FIND "${replies}" "${expected}" found)
+  if(found EQUAL -1)
+    message(FATAL_ERROR "missing `${expected}` in the server's replies:\n${replies}")
+  endif()
+endforeach()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
@@ -79,6 +79,17 @@ TEST_SUITE("integration / module pipeline") {
     CHECK(exports.contains("chain"));
   }
 
+  TEST_CASE("top-level functions and consts may be used before they are declared") {
+    auto src = read_sample("forward_calls.bz");
+    auto pl = run_full(src, "forward_calls.bz");
+    CHECK_FALSE(pl.module->get_diag_engine().has_errors());
+
+    const auto& exports = pl.module->get_exported_symbols();
+    CHECK(exports.contains("main"));
+    CHECK(exports.contains("helper"));
+    CHECK(exports.contains("limit"));
+  }
+
   TEST_CASE("print_errors writes to stdout when diagnostics exist") {
     auto src = read_sample("duplicate_const.bz");
     auto pl = run_full(src, "duplicate_const.bz");
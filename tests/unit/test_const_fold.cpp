@@ -0,0 +1,165 @@
+#include <doctest/doctest.h>
+
+#include "fixtures.hpp"
+
+#include <ether/ast/const_fold/const_fold.hpp>
+#include <ether/ast/symbol_resolver/symbol_resolver.hpp>
+#include <ether/module/module.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace ether::test;
+
+namespace {
+
+struct FoldedModule {
+  std::unique_ptr<Module> module;
+  size_t folded = 0;
+
+  // The body of the function declared `index`th.
+  std::vector<NDPtr>& body(size_t index) const {
+    auto& func = dynamic_cast<NDFuncDeclExpr&>(*this->module->get_root().children.at(index));
+    return func.func_body;
+  }
+
+  std::vector<std::string> errors() const {
+    std::vector<std::string> out;
+    for (const auto& d : this->module->get_diag_engine().all()) {
+      if (d.phase == DiagnosticPhase::Folder) out.push_back(d.message);
+    }
+    return out;
+  }
+};
+
+FoldedModule fold(const std::string& src) {
+  FoldedModule fm;
+  fm.module = std::make_unique<Module>("<test>", src);
+  fm.module->generate_ast();
+  SymbolResolver resolver(fm.module->get_symbol_storage(), fm.module->get_diag_engine());
+  fm.module->attach_visitor(resolver);
+  fm.module->apply_visitors();
+
+  ConstantFolder folder(fm.module->get_diag_engine());
+  folder.fold_module(fm.module->get_root());
+  fm.folded = folder.folded();
+  return fm;
+}
+
+// The literal `node` was folded to, as "<text>: <token type>".
+std::string literal_of(const NDPtr& node) {
+  auto* lit = dynamic_cast<NDLiteral*>(node.get());
+  if (!lit) return "<not a literal>";
+  return lit->literal.token_value + ": " + token_type_to_str(lit->literal.token_type);
+}
+
+}  // namespace
+
+TEST_SUITE("const fold") {
+  TEST_CASE("operators over literals become the literal they evaluate to") {
+    auto fm = fold(
+      "func f()\n"
+      "  let i = 10 * 12 + 3 - 2\n"
+      "  let x = 1.5 * 2.0 - 0.25\n"
+      "  let s = \"eth\" + \"er\"\n"
+      "  let b = 1 < 2 && ~False\n"
+      "  let n = -{ 7 / 2 }\n"
+      "  Nil == Nil\n"
+      "end\n"
+    );
+    CHECK(fm.errors().empty());
+    auto& body = fm.body(0);
+    auto bound = [&](size_t i) -> NDPtr& { return dynamic_cast<NDLetBindExpr&>(*body[i]).bound_value; };
+    CHECK_EQ(literal_of(bound(0)), "121: IntegerLiteral");
+    CHECK_EQ(literal_of(bound(1)), "2.75: FloatLiteral");
+    CHECK_EQ(literal_of(bound(2)), "ether: StringLiteral");
+    CHECK_EQ(literal_of(bound(3)), "True: TrueLiteral");
+    CHECK_EQ(literal_of(bound(4)), "-3: IntegerLiteral");
+    CHECK_EQ(literal_of(body[5]), "True: TrueLiteral");
+  }
+
+  TEST_CASE("a scope of literals folds; one with a name folds only inside") {
+    auto fm = fold(
+      "func f(n: Int)\n"
+      "  let a = { 2 + 3 }\n"
+      "  n * { 4 * 4 }\n"
+      "end\n"
+    );
+    CHECK(fm.errors().empty());
+    auto& body = fm.body(0);
+    CHECK_EQ(literal_of(dynamic_cast<NDLetBindExpr&>(*body[0]).bound_value), "5: IntegerLiteral");
+
+    auto* product = dynamic_cast<NDBinaryExpr*>(body[1].get());
+    REQUIRE(product);
+    CHECK(dynamic_cast<NDIdentifier*>(product->lhs.get()));
+    CHECK_EQ(literal_of(product->rhs), "16: IntegerLiteral");
+  }
+
+  TEST_CASE("a folded literal starts where the expression did") {
+    auto fm = fold("func f()\n  2.0 * 4.0\nend\n");
+    auto* lit = dynamic_cast<NDLiteral*>(fm.body(0)[0].get());
+    REQUIRE(lit);
+    CHECK_EQ(lit->literal.token_value, "8.0");
+    CHECK(lit->literal.line_number == 2);
+    CHECK(lit->literal.column_number == 3);
+    CHECK(lit->literal.offset == 11);
+  }
+
+  TEST_CASE("overflow and division by zero are reported and left as written") {
+    // 1e308, as the lexer reads no exponents.
+    std::string huge = "1" + std::string(308, '0') + ".0";
+    auto fm = fold(
+      "func f()\n"
+      "  let a = 9223372036854775807 + 1\n"
+      "  let b = 1 / 0\n"
+      "  let c = 5.0 / 0.0\n"
+      "  let d = 99999999999999999999\n"
+      "  let e = " + huge + " * 10.0\n"
+      "end\n"
+    );
+    std::vector<std::string> expected{
+      "`9223372036854775807 + 1` overflows `Int`",
+      "`1 / 0` divides by zero",
+      "`5.0 / 0.0` divides by zero",
+      "`99999999999999999999` does not fit in `Int`",
+      "`1e+308 * 10.0` overflows `Float`",
+    };
+    CHECK_EQ(fm.errors(), expected);
+    CHECK(fm.folded == 0);
+
+    auto& body = fm.body(0);
+    CHECK(dynamic_cast<NDBinaryExpr*>(dynamic_cast<NDLetBindExpr&>(*body[0]).bound_value.get()));
+
+    // The whole of `9223372036854775807 + 1`.
+    const auto& first = fm.module->get_diag_engine().all()[0];
+    CHECK(first.range.begin == 19);
+    CHECK(first.range.end == 42);
+  }
+
+  TEST_CASE("the smallest Int can be written as a negated literal") {
+    auto fm = fold(
+      "func f()\n"
+      "  let a = -9223372036854775808\n"
+      "  let b = -9223372036854775809\n"
+      "end\n"
+    );
+    std::vector<std::string> expected{ "`-9223372036854775809` does not fit in `Int`" };
+    CHECK_EQ(fm.errors(), expected);
+    auto& body = fm.body(0);
+    CHECK_EQ(literal_of(dynamic_cast<NDLetBindExpr&>(*body[0]).bound_value), "-9223372036854775808: IntegerLiteral");
+    CHECK(dynamic_cast<NDUnaryExpr*>(dynamic_cast<NDLetBindExpr&>(*body[1]).bound_value.get()));
+  }
+
+  TEST_CASE("mismatched operands are left to the type checker") {
+    auto fm = fold(
+      "func f()\n"
+      "  let a = 1 + \"b\"\n"
+      "  let b = ~3\n"
+      "  let c = 1 + 2.0\n"
+      "end\n"
+    );
+    CHECK(fm.errors().empty());
+    CHECK(fm.folded == 0);
+  }
+}
@@ -5,17 +5,38 @@
 #include <ether/diagnostics/diagnostic.hpp>
 #include <ether/diagnostics/diagnostic_eng.hpp>
 
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
 using namespace ether::test;
 
 namespace {
-Diagnostic make_diag(DiagnosticLevel level, std::string msg, size_t line = 1, size_t col = 1) {
+Diagnostic make_diag(DiagnosticLevel level, std::string msg, size_t offset = 0, size_t length = 1) {
   Diagnostic d;
   d.level = level;
   d.phase = DiagnosticPhase::Lexer;
-  d.location = { .line = line, .column = col };
+  d.range = SourceRange::at(offset, length);
   d.message = std::move(msg);
   return d;
 }
+
+// `threads` threads (at most 10) each report `per_thread` diagnostics at
+// once, one per byte of an imaginary file, so that every thread reports at
+// each position.
+void report_from_threads(DiagnosticEngine& eng, size_t threads, size_t per_thread) {
+  std::vector<std::thread> pool;
+  for (size_t t = 0; t < threads; ++t) {
+    pool.emplace_back([&eng, t, per_thread] {
+      for (size_t i = 0; i < per_thread; ++i) {
+        auto level = i % 3 == 0 ? DiagnosticLevel::Fail : DiagnosticLevel::Warn;
+        eng.report(make_diag(level, "t" + std::to_string(t) + " #" + std::to_string(i), i));
+      }
+    });
+  }
+  for (auto& th : pool) th.join();
+}
 }
 
 TEST_SUITE("diagnostics / engine") {
@@ -40,7 +61,7 @@ TEST_SUITE("diagnostics / engine") {
   TEST_CASE("print_all renders header, location, and source line") {
     DiagnosticEngine eng;
     eng.set_source("test.bz", "first line\nsecond line\n");
-    eng.report(make_diag(DiagnosticLevel::Fail, "bad token", 2, 8));
+    eng.report(make_diag(DiagnosticLevel::Fail, "bad token", 18));
 
     CoutSink sink;
     eng.print_all();
@@ -52,12 +73,12 @@ TEST_SUITE("diagnostics / engine") {
     CHECK(out.find("second line") != std::string::npos);
   }
 
-  TEST_CASE("print_all sorts diagnostics by line then column") {
+  TEST_CASE("print_all sorts diagnostics by where they start") {
     DiagnosticEngine eng;
     eng.set_source("t.bz", "a\nb\nc\n");
-    eng.report(make_diag(DiagnosticLevel::Fail, "third",  3, 1));
-    eng.report(make_diag(DiagnosticLevel::Fail, "first",  1, 1));
-    eng.report(make_diag(DiagnosticLevel::Fail, "second", 2, 1));
+    eng.report(make_diag(DiagnosticLevel::Fail, "third",  4));
+    eng.report(make_diag(DiagnosticLevel::Fail, "first",  0));
+    eng.report(make_diag(DiagnosticLevel::Fail, "second", 2));
 
     CoutSink sink;
     eng.print_all();
@@ -76,7 +97,7 @@ TEST_SUITE("diagnostics / engine") {
   TEST_CASE("set_source handles trailing CR (Windows newlines)") {
     DiagnosticEngine eng;
     eng.set_source("t.bz", "alpha\r\nbeta\r\n");
-    eng.report(make_diag(DiagnosticLevel::Fail, "x", 2, 1));
+    eng.report(make_diag(DiagnosticLevel::Fail, "x", 7));
 
     CoutSink sink;
     eng.print_all();
@@ -84,4 +105,182 @@ TEST_SUITE("diagnostics / engine") {
     CHECK(out.find("beta\r") == std::string::npos);
     CHECK(out.find("beta") != std::string::npos);
   }
+
+  TEST_CASE("ties on a position are broken by phase, level and message") {
+    DiagnosticEngine eng;
+    auto parse = make_diag(DiagnosticLevel::Fail, "b", 9);
+    parse.phase = DiagnosticPhase::Parser;
+    eng.report(parse);
+    eng.report(make_diag(DiagnosticLevel::Fail, "z", 9));
+    eng.report(make_diag(DiagnosticLevel::Warn, "a", 9));
+
+    auto sorted = eng.sorted();
+    REQUIRE(sorted.size() == 3);
+    CHECK(sorted[0]->message == "a");
+    CHECK(sorted[1]->message == "z");
+    CHECK(sorted[2]->message == "b");
+  }
+
+  TEST_CASE("reads see diagnostics reported since the last one") {
+    DiagnosticEngine eng;
+    eng.report(make_diag(DiagnosticLevel::Warn, "one"));
+    CHECK(eng.all().size() == 1);
+    eng.report(make_diag(DiagnosticLevel::Fail, "two"));
+    CHECK(eng.has_errors());
+
+    DiagnosticEngine other;
+    other.report(make_diag(DiagnosticLevel::Note, "three"));
+    eng.absorb(std::move(other));
+    auto all = eng.take_all();
+    REQUIRE(all.size() == 3);
+    CHECK(all[0].message == "one");
+    CHECK(all[2].message == "three");
+    CHECK(other.all().empty());
+    CHECK(eng.all().empty());
+  }
+
+  TEST_CASE("stress: a million diagnostics from many threads") {
+    constexpr size_t threads = 8, per_thread = 125'000;
+    DiagnosticEngine eng;
+    report_from_threads(eng, threads, per_thread);
+
+    const auto& all = eng.all();
+    REQUIRE(all.size() == threads * per_thread);
+    CHECK(eng.has_errors());
+
+    // Each thread's diagnostics keep their report order.
+    std::vector<size_t> next(threads, 0);
+    bool in_order = true;
+    for (const auto& d : all) {
+      size_t t = d.message[1] - '0';
+      in_order = in_order && d.range.begin == next[t];
+      next[t]++;
+    }
+    CHECK(in_order);
+  }
+
+  TEST_CASE("stress: the printed order does not depend on how threads interleave") {
+    DiagnosticEngine eng, again;
+    report_from_threads(eng, 8, 10'000);
+    report_from_threads(again, 8, 10'000);
+
+    auto first = eng.sorted(), second = again.sorted();
+    REQUIRE(first.size() == second.size());
+    bool same = true;
+    for (size_t i = 0; i < first.size() && same; ++i) {
+      same = first[i]->message == second[i]->message;
+      if (i > 0) same = same && !diagnostic_before(*first[i], *first[i - 1]);
+    }
+    CHECK(same);
+  }
+
+  TEST_CASE("past a phase's limit diagnostics are dropped and counted") {
+    DiagnosticEngine eng;
+    eng.set_limits({ .per_phase = 2 });
+    eng.report(make_diag(DiagnosticLevel::Warn, "one"));
+    eng.report(make_diag(DiagnosticLevel::Note, "a note does not count"));
+    CHECK_FALSE(eng.limit_reached(DiagnosticPhase::Lexer));
+    eng.report(make_diag(DiagnosticLevel::Warn, "two"));
+    CHECK(eng.limit_reached(DiagnosticPhase::Lexer));
+    CHECK_FALSE(eng.limit_reached(DiagnosticPhase::Parser));
+    CHECK_FALSE(eng.should_stop(DiagnosticPhase::Lexer));
+
+    eng.report(make_diag(DiagnosticLevel::Fail, "three"));
+    auto parse = make_diag(DiagnosticLevel::Warn, "parser");
+    parse.phase = DiagnosticPhase::Parser;
+    eng.report(parse);
+
+    CHECK(eng.all().size() == 4);
+    CHECK(eng.dropped() == 1);
+    // The dropped error still counts.
+    CHECK(eng.has_errors());
+
+    CoutSink sink;
+    eng.print_all();
+    CHECK(sink.str().find("1 more diagnostic not shown") != std::string::npos);
+  }
+
+  TEST_CASE("the total limit spans phases and applies to absorbed diagnostics") {
+    DiagnosticEngine eng;
+    eng.set_limits({ .total = 3, .stop_early = true });
+    eng.report(make_diag(DiagnosticLevel::Warn, "lexer"));
+
+    DiagnosticEngine task;
+    for (int i = 0; i < 4; ++i) {
+      auto d = make_diag(DiagnosticLevel::Fail, "resolver");
+      d.phase = DiagnosticPhase::Resolver;
+      task.report(d);
+    }
+    eng.absorb(std::move(task));
+
+    CHECK(eng.all().size() == 3);
+    CHECK(eng.dropped() == 2);
+    CHECK(eng.should_stop(DiagnosticPhase::Parser));
+  }
+
+  TEST_CASE("a ranged diagnostic underlines its width") {
+    DiagnosticEngine eng;
+    eng.set_source("t.bz", "x @@@ y\n");
+    eng.report(make_diag(DiagnosticLevel::Warn, "run", 2, 3));
+
+    CoutSink sink;
+    eng.print_all();
+    CHECK(sink.str().find("^^^") != std::string::npos);
+    CHECK(sink.str().find("^^^^") == std::string::npos);
+  }
+
+  TEST_CASE("color is used when asked for, never by default off a terminal") {
+    DiagnosticEngine eng;
+    eng.set_source("t.bz", "a\nb\n");
+    eng.report(make_diag(DiagnosticLevel::Fail, "boom", 2));
+
+    std::ostringstream plain, colored, never;
+    eng.print_all(plain);
+    eng.print_all(colored, ColorMode::Always);
+    eng.print_all(never, ColorMode::Never);
+
+    CHECK(plain.str().find('\033') == std::string::npos);
+    CHECK(never.str() == plain.str());
+    CHECK(colored.str().find("\033[31m") != std::string::npos);
+    CHECK(plain.str().find("error: boom\n  --> t.bz:2:1  [lexer]\n  | \n2 | b\n  | ^\n") == 0);
+  }
+
+  TEST_CASE("notes stay with their diagnostic through absorb and splice") {
+    DiagnosticEngine eng;
+    eng.set_source("t.bz", "let a = 1\nlet a = 2\n");
+    eng.report(make_diag(DiagnosticLevel::Warn, "first"));
+
+    DiagnosticEngine task;
+    auto dup = make_diag(DiagnosticLevel::Fail, "`a` is already declared", 14);
+    task.report(dup, { DiagnosticNote{ SourceRange::at(4, 1), "first declared here" } });
+    eng.absorb(std::move(task));
+
+    DiagnosticList lead;
+    lead.push_back(make_diag(DiagnosticLevel::Note, "lead"), { DiagnosticNote{ SourceRange::at(0, 3), "here" } });
+    eng.splice(0, 1, std::move(lead));
+
+    const auto& all = eng.all();
+    REQUIRE(all.size() == 2);
+    REQUIRE(all.notes_of(all[0]).size() == 1);
+    CHECK(all.notes_of(all[0])[0].message == "here");
+    REQUIRE(all.notes_of(all[1]).size() == 1);
+    CHECK(all.notes_of(all[1])[0].message == "first declared here");
+
+    CoutSink sink;
+    eng.print_all();
+    CHECK(sink.str().find("--> t.bz:2:5") != std::string::npos);
+    CHECK(sink.str().find("= note: first declared here (1:5)") != std::string::npos);
+  }
+
+  TEST_CASE("diagnostics without a location come first") {
+    DiagnosticEngine eng;
+    eng.report(make_diag(DiagnosticLevel::Fail, "at the start"));
+    auto nowhere = make_diag(DiagnosticLevel::Fail, "nowhere");
+    nowhere.range = {};
+    eng.report(nowhere);
+
+    auto sorted = eng.sorted();
+    REQUIRE(sorted.size() == 2);
+    CHECK(sorted[0]->message == "nowhere");
+  }
 }
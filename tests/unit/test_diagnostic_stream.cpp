@@ -0,0 +1,133 @@
+#include <doctest/doctest.h>
+
+#include "fixtures.hpp"
+
+#include <ether/diagnostics/diagnostic_stream.hpp>
+#include <ether/lsp/json.hpp>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ether::test;
+
+namespace {
+
+Diagnostic make_diag(DiagnosticLevel level, DiagnosticPhase phase, std::string msg, size_t offset, size_t length = 1) {
+  Diagnostic d;
+  d.level = level;
+  d.phase = phase;
+  d.range = SourceRange::at(offset, length);
+  d.message = std::move(msg);
+  return d;
+}
+
+// Two modules' worth: a redeclaration with a note, then a lexer warning.
+void fill(DiagnosticEngine& a, DiagnosticEngine& b) {
+  a.set_source("/src/a.bz", "let x = 1\nlet x = 2\n");
+  auto redecl = make_diag(DiagnosticLevel::Fail, DiagnosticPhase::Resolver, "`x` is already \"declared\"", 14);
+  a.report(redecl, { DiagnosticNote{ SourceRange::at(4, 1), "declared here" } });
+
+  b.set_source("b.bz", "x @@@\n");
+  b.report(make_diag(DiagnosticLevel::Warn, DiagnosticPhase::Lexer, "3 unrecognized tokens `@@@` detected", 2, 3));
+}
+
+std::vector<Json> json_lines(const std::string& text) {
+  std::vector<Json> out;
+  std::istringstream in(text);
+  std::string line;
+  while (std::getline(in, line)) {
+    auto value = Json::parse(line);
+    REQUIRE_MESSAGE(value, line);
+    out.push_back(*value);
+  }
+  return out;
+}
+
+}  // namespace
+
+TEST_SUITE("diagnostics / stream") {
+  TEST_CASE("format names") {
+    CHECK(diagnostic_format_from("text") == DiagnosticFormat::Text);
+    CHECK(diagnostic_format_from("jsonl") == DiagnosticFormat::JsonLines);
+    CHECK(diagnostic_format_from("sarif") == DiagnosticFormat::Sarif);
+    CHECK_FALSE(diagnostic_format_from("xml"));
+  }
+
+  TEST_CASE("JSON Lines: one object per diagnostic, module by module") {
+    DiagnosticEngine a, b;
+    fill(a, b);
+    std::ostringstream out;
+    DiagnosticStream stream(DiagnosticFormat::JsonLines, out);
+    stream.write(a);
+    stream.write(b);
+    stream.finish();
+
+    auto lines = json_lines(out.str());
+    REQUIRE(lines.size() == 2);
+    CHECK(*lines[0].at({ "file" }).string() == "/src/a.bz");
+    CHECK(lines[0].at({ "line" }).integer() == 2);
+    CHECK(*lines[0].at({ "level" }).string() == "error");
+    CHECK(*lines[0].at({ "phase" }).string() == "resolver");
+    CHECK(*lines[0].at({ "message" }).string() == "`x` is already \"declared\"");
+    REQUIRE(lines[0].at({ "related" }).array()->size() == 1);
+
+    CHECK(*lines[1].at({ "file" }).string() == "b.bz");
+    CHECK(lines[1].at({ "width" }).integer() == 3);
+    CHECK(*lines[1].at({ "level" }).string() == "warning");
+  }
+
+  TEST_CASE("SARIF: one run, a result per diagnostic") {
+    DiagnosticEngine a, b;
+    fill(a, b);
+    std::ostringstream out;
+    {
+      DiagnosticStream stream(DiagnosticFormat::Sarif, out);
+      stream.write(a);
+      stream.write(b);
+    }
+
+    auto log = Json::parse(out.str());
+    REQUIRE(log);
+    CHECK(*log->at({ "version" }).string() == "2.1.0");
+    const auto& run = (*log->at({ "runs" }).array())[0];
+    CHECK(*run.at({ "tool", "driver", "name" }).string() == "ether");
+
+    const auto& results = *run.at({ "results" }).array();
+    REQUIRE(results.size() == 2);
+    CHECK(*results[0].at({ "ruleId" }).string() == "resolver");
+    CHECK(*results[0].at({ "level" }).string() == "error");
+    CHECK(*results[0].at({ "message", "text" }).string() == "`x` is already \"declared\"");
+
+    const auto& at = (*results[0].at({ "locations" }).array())[0];
+    CHECK(*at.at({ "physicalLocation", "artifactLocation", "uri" }).string() == "file:///src/a.bz");
+    CHECK(at.at({ "physicalLocation", "region", "startLine" }).integer() == 2);
+
+    const auto& note = (*results[0].at({ "relatedLocations" }).array())[0];
+    CHECK(*note.at({ "message", "text" }).string() == "declared here");
+    CHECK(note.at({ "physicalLocation", "region", "startLine" }).integer() == 1);
+
+    const auto& run_at = (*results[1].at({ "locations" }).array())[0];
+    CHECK(*run_at.at({ "physicalLocation", "artifactLocation", "uri" }).string() == "b.bz");
+    CHECK(run_at.at({ "physicalLocation", "region", "startColumn" }).integer() == 3);
+    CHECK(run_at.at({ "physicalLocation", "region", "endColumn" }).integer() == 6);
+  }
+
+  TEST_CASE("SARIF with nothing to report is still a complete log") {
+    std::ostringstream out;
+    DiagnosticStream stream(DiagnosticFormat::Sarif, out);
+    stream.finish();
+    auto log = Json::parse(out.str());
+    REQUIRE(log);
+    CHECK((*log->at({ "runs" }).array())[0].at({ "results" }).array()->empty());
+  }
+
+  TEST_CASE("text is what print_all prints") {
+    DiagnosticEngine a, b;
+    fill(a, b);
+    std::ostringstream out, expected;
+    DiagnosticStream(DiagnosticFormat::Text, out).write(a);
+    a.print_all(expected);
+    CHECK(out.str() == expected.str());
+  }
+}
@@ -5,6 +5,8 @@
 #include <ether/import_res/import_res.hpp>
 #include <ether/tokens/token_types.hpp>
 
+#include <filesystem>
+
 using namespace ether::test;
 
 TEST_SUITE("import_res / is_valid_import_path") {
@@ -33,3 +35,19 @@ TEST_SUITE("import_res / is_valid_import_path") {
     CHECK_FALSE(is_valid_import_path(t));
   }
 }
+
+TEST_SUITE("import_res / module files") {
+  TEST_CASE("dotted paths map to nested .bz files under the root") {
+    CHECK(import_path_to_file("/proj", "benzene.list") == std::filesystem::path("/proj/benzene/list.bz"));
+    CHECK(import_path_to_file("/proj", "main") == std::filesystem::path("/proj/main.bz"));
+  }
+
+  TEST_CASE("files under the root map back to their import path") {
+    CHECK(file_to_import_path("/proj", "/proj/benzene/list.bz") == "benzene.list");
+    CHECK(file_to_import_path("/proj/", "/proj/./main.bz") == "main");
+  }
+
+  TEST_CASE("files outside the root fall back to their stem") {
+    CHECK(file_to_import_path("/proj", "/elsewhere/tool.bz") == "tool");
+  }
+}
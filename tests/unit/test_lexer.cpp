@@ -227,6 +227,47 @@ TEST_SUITE("lexer / imports") {
   }
 }
 
+namespace {
+std::vector<Token> scan_imports(const std::string& source, DiagnosticEngine& diag) {
+  Lexer lexer(source, diag);
+  lexer.scan_imports();
+  return lexer.get_tokens();
+}
+}  // namespace
+
+TEST_SUITE("lexer / import pre-scan") {
+  TEST_CASE("leading Load directives are returned in pairs") {
+    DiagnosticEngine diag;
+    auto toks = scan_imports("Load a.b\n\nCmt header\nLoad c\nfunc main()\n  1\nend", diag);
+    REQUIRE(toks.size() == 4);
+    CHECK(toks[0].token_type == TokenType::ImportKeyword);
+    CHECK(toks[1].token_type == TokenType::ImportModule);
+    CHECK(toks[1].token_value == "a.b");
+    CHECK(toks[3].token_value == "c");
+    CHECK(toks[3].line_number == 4);
+  }
+
+  TEST_CASE("the scan stops at the first other top-level item") {
+    DiagnosticEngine diag;
+    auto toks = scan_imports("Load a\nconst x = 1\nLoad b", diag);
+    REQUIRE(toks.size() == 2);
+    CHECK(toks[1].token_value == "a");
+  }
+
+  TEST_CASE("input after the imports is never lexed") {
+    DiagnosticEngine diag;
+    auto toks = scan_imports("Load a\n@ $ `", diag);
+    CHECK(toks.size() == 2);
+    CHECK(diag.all().empty());
+  }
+
+  TEST_CASE("a module without imports yields nothing") {
+    DiagnosticEngine diag;
+    CHECK(scan_imports("func main()\n  1\nend", diag).empty());
+    CHECK(scan_imports("", diag).empty());
+  }
+}
+
 TEST_SUITE("lexer / diagnostics") {
   TEST_CASE("unknown character generates a lexer warning") {
     DiagnosticEngine diag;
@@ -239,6 +280,66 @@ TEST_SUITE("lexer / diagnostics") {
     CHECK_FALSE(diag.has_errors());
   }
 
+  TEST_CASE("a run of unknown characters is reported once, over its whole width") {
+    DiagnosticEngine diag;
+    auto toks = lex_all("x @@`@ y", diag);
+    CHECK(toks.size() == 7);
+    REQUIRE(diag.all().size() == 1);
+    const auto& d = diag.all()[0];
+    CHECK(d.range.begin == 2);
+    CHECK(d.range.end == 6);
+    CHECK(d.message == "4 unrecognized tokens `@@`@` detected");
+  }
+
+  TEST_CASE("another token or a new line ends a run") {
+    DiagnosticEngine diag;
+    lex_all("@@ x @\n@", diag);
+    REQUIRE(diag.all().size() == 3);
+    CHECK(diag.all()[0].range.end == 2);
+    CHECK(diag.all()[1].message == "Unrecognized token `@` detected");
+    CHECK(diag.all()[2].range.begin == 7);
+  }
+
+  TEST_CASE("a long run quotes only its start") {
+    DiagnosticEngine diag;
+    lex_all(std::string(10'000, '@'), diag);
+    REQUIRE(diag.all().size() == 1);
+    CHECK(diag.all()[0].range.end == 10'000);
+    CHECK(diag.all()[0].message == "10000 unrecognized tokens `" + std::string(16, '@') + "...` detected");
+  }
+
+  TEST_CASE("a run is quoted by whole characters, not bytes") {
+    DiagnosticEngine diag;
+    std::string e_acute = "\xC3\xA9";
+    std::string nine;
+    for (int i = 0; i < 9; ++i) nine += e_acute;
+    lex_all("@" + nine, diag);
+    REQUIRE(diag.all().size() == 1);
+    CHECK(diag.all()[0].message == "19 unrecognized tokens `@" + nine + "` detected");
+
+    DiagnosticEngine long_run;
+    std::string sixteen;
+    for (int i = 0; i < 16; ++i) sixteen += e_acute;
+    lex_all(sixteen + e_acute + e_acute, long_run);
+    REQUIRE(long_run.all().size() == 1);
+    CHECK(long_run.all()[0].message == "36 unrecognized tokens `" + sixteen + "...` detected");
+  }
+
+  TEST_CASE("lexing stops early once the lexer's limit is reached") {
+    DiagnosticEngine diag;
+    diag.set_limits({ .per_phase = 2, .stop_early = true });
+    auto toks = lex_all("@ x\n@ x\n@ x\n@ x\n@ x\n", diag);
+    CHECK(diag.all().size() == 2);
+    CHECK(diag.dropped() == 1);
+    REQUIRE(toks.size() == 6);
+    CHECK(toks.back().token_type == TokenType::EoF);
+
+    DiagnosticEngine keep_going;
+    keep_going.set_limits({ .per_phase = 2 });
+    CHECK(lex_all("@ x\n@ x\n@ x\n@ x\n@ x\n", keep_going).size() == 11);
+    CHECK(keep_going.dropped() == 3);
+  }
+
   TEST_CASE("token line and column are recorded") {
     auto toks = lex_all("\n  let");
     // Expect [LetKeyword, EoF]
@@ -248,3 +349,28 @@ TEST_SUITE("lexer / diagnostics") {
     CHECK(toks[0].column_number == 3);
   }
 }
+
+TEST_SUITE("lexer / cancellation") {
+  TEST_CASE("a cancelled scan stops early and still ends with EoF") {
+    std::string source;
+    for (int i = 0; i < 200; ++i) source += "let x = 1\n";
+
+    std::stop_source stop;
+    stop.request_stop();
+    DiagnosticEngine diag;
+    Lexer lex(source, diag, CancellationToken(stop.get_token()));
+    lex.scan_tokens();
+    auto toks = lex.get_tokens();
+    REQUIRE(toks.size() == 1);
+    CHECK(toks[0].token_type == TokenType::EoF);
+
+    CHECK(lex_all(source).size() == 801);
+  }
+
+  TEST_CASE("a passed deadline cancels, a later one does not") {
+    auto now = CancellationToken::Clock::now();
+    CHECK(CancellationToken().with_deadline(now).is_cancelled());
+    CHECK_FALSE(CancellationToken().with_deadline(now + std::chrono::hours(1)).is_cancelled());
+    CHECK_FALSE(CancellationToken().is_cancelled());
+  }
+}
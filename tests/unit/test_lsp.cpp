@@ -0,0 +1,368 @@
+#include <doctest/doctest.h>
+
+#include <ether/lsp/json.hpp>
+#include <ether/lsp/lsp_server.hpp>
+#include <ether/module/module.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// A throwaway workspace directory, removed when the test ends.
+struct TempWorkspace {
+  fs::path root;
+
+  TempWorkspace() {
+    static std::atomic<int> counter{0};
+    root = fs::temp_directory_path()
+         / std::format("ether_lsp_{}_{}", std::random_device{}(), counter.fetch_add(1));
+    fs::remove_all(root);
+    fs::create_directories(root);
+  }
+  ~TempWorkspace() { fs::remove_all(root); }
+
+  void write(const std::string& rel, const std::string& src) const {
+    std::ofstream(root / rel) << src;
+  }
+
+  std::string uri(const std::string& rel) const {
+    return "file://" + (root / rel).generic_string();
+  }
+};
+
+Json request(int id, const std::string& method, Json params = Json(Json::Object{})) {
+  return Json(Json::Object{
+    { "jsonrpc", "2.0" }, { "id", id }, { "method", method }, { "params", std::move(params) },
+  });
+}
+
+Json notification(const std::string& method, Json params = Json(Json::Object{})) {
+  return Json(Json::Object{
+    { "jsonrpc", "2.0" }, { "method", method }, { "params", std::move(params) },
+  });
+}
+
+Json initialize(const std::string& root_uri = {}) {
+  Json params(Json::Object{});
+  if (!root_uri.empty()) params.set("rootUri", root_uri);
+  return request(1, "initialize", std::move(params));
+}
+
+Json did_open(const std::string& uri, const std::string& text, int version = 1) {
+  return notification("textDocument/didOpen", Json(Json::Object{
+    { "textDocument", Json(Json::Object{
+      { "uri", uri }, { "languageId", "benzene" }, { "version", version }, { "text", text },
+    }) },
+  }));
+}
+
+Json position(int line, int character) {
+  return Json(Json::Object{ { "line", line }, { "character", character } });
+}
+
+// Replaces [from, to) (LSP positions) with `text`.
+Json did_change(const std::string& uri, int version, Json from, Json to, const std::string& text) {
+  return notification("textDocument/didChange", Json(Json::Object{
+    { "textDocument", Json(Json::Object{ { "uri", uri }, { "version", version } }) },
+    { "contentChanges", Json(Json::Array{
+      Json(Json::Object{
+        { "range", Json(Json::Object{ { "start", std::move(from) }, { "end", std::move(to) } }) },
+        { "text", text },
+      }),
+    }) },
+  }));
+}
+
+std::vector<Json> shutdown_and_exit() {
+  return { request(99, "shutdown"), notification("exit") };
+}
+
+struct Served {
+  int code;
+  std::vector<Json> messages;
+};
+
+// Plays the client: frames `messages`, runs a server over them and reads
+// back everything it wrote.
+Served serve(std::vector<Json> messages, LspOptions opts = {}) {
+  std::ostringstream framed;
+  for (const auto& m : messages) write_lsp_message(framed, m.dump());
+
+  std::istringstream in(framed.str());
+  std::ostringstream out;
+  Served served;
+  {
+    LspServer server(in, out, std::move(opts));
+    served.code = server.run();
+  }
+
+  std::istringstream replies(out.str());
+  while (auto body = read_lsp_message(replies)) {
+    auto message = Json::parse(*body);
+    REQUIRE(message);
+    served.messages.push_back(std::move(*message));
+  }
+  return served;
+}
+
+std::vector<Json> concat(std::vector<Json> a, const std::vector<Json>& b) {
+  a.insert(a.end(), b.begin(), b.end());
+  return a;
+}
+
+// The diagnostics last published for `uri`.
+const Json* published(const Served& served, const std::string& uri) {
+  const Json* last = nullptr;
+  for (const auto& m : served.messages) {
+    const auto* method = m.at({"method"}).string();
+    const auto* target = m.at({"params", "uri"}).string();
+    if (method && *method == "textDocument/publishDiagnostics" && target && *target == uri) {
+      last = &m.at({"params"});
+    }
+  }
+  return last;
+}
+
+const Json* reply_to(const Served& served, int id) {
+  for (const auto& m : served.messages) {
+    if (m.at({"id"}).integer() == id) return &m;
+  }
+  return nullptr;
+}
+
+std::vector<std::string> messages_of(const Json& params) {
+  std::vector<std::string> out;
+  for (const auto& d : *params.at({"diagnostics"}).array()) out.push_back(*d.at({"message"}).string());
+  std::ranges::sort(out);
+  return out;
+}
+
+const std::string duplicate_let =
+  "func main()\n"
+  "  let x = 1\n"
+  "  let x = 2\n"
+  "  x\n"
+  "end\n";
+
+}  // namespace
+
+TEST_SUITE("lsp / json") {
+  TEST_CASE("parses and writes back protocol messages") {
+    auto text = R"({"jsonrpc":"2.0","id":7,"params":{"a":[1,-2.5,true,false,null],"s":"q\"\\\n"}})";
+    auto value = Json::parse(text);
+    REQUIRE(value);
+    CHECK_EQ(value->dump(), text);
+    CHECK_EQ(value->at({"id"}).integer(), 7);
+    CHECK_EQ(value->at({"params", "a"}).array()->at(1).number(), -2.5);
+    CHECK(value->at({"params", "missing", "deeper"}).is_null());
+  }
+
+  TEST_CASE("decodes escapes to UTF-8") {
+    auto value = Json::parse(R"(["\u00e9", "\ud83d\ude00", "\/"])");
+    REQUIRE(value);
+    CHECK_EQ(*value->array()->at(0).string(), "\xC3\xA9");
+    CHECK_EQ(*value->array()->at(1).string(), "\xF0\x9F\x98\x80");
+    CHECK_EQ(*value->array()->at(2).string(), "/");
+    CHECK_EQ(Json(std::string("\x01")).dump(), "\"\\u0001\"");
+  }
+
+  TEST_CASE("rejects malformed documents") {
+    for (auto bad : { "", "{", "[1,]", "{\"a\" 1}", "01x", "\"open", "tru", "{} {}", "\"\\q\"", "-" }) {
+      CHECK_MESSAGE(!Json::parse(bad), bad);
+    }
+    CHECK_FALSE(Json::parse(std::string(1000, '[') + std::string(1000, ']')));
+    CHECK_FALSE(Json(1.5).integer());
+  }
+}
+
+TEST_SUITE("lsp / server") {
+  TEST_CASE("frames are read by Content-Length, whatever other headers say") {
+    std::istringstream in(
+      "content-length: 2\r\nContent-Type: application/vscode-jsonrpc; charset=utf-8\r\n\r\n{}"
+      "Content-Length: 4\r\n\r\nnull"
+    );
+    CHECK_EQ(read_lsp_message(in), "{}");
+    CHECK_EQ(read_lsp_message(in), "null");
+    CHECK_FALSE(read_lsp_message(in));
+  }
+
+  TEST_CASE("an opened document's diagnostics are published with its version") {
+    std::string uri = "file:///ws/main.bz";
+    auto served = serve(concat({ initialize(), did_open(uri, duplicate_let, 3) }, shutdown_and_exit()));
+    CHECK_EQ(served.code, 0);
+
+    auto* init = reply_to(served, 1);
+    REQUIRE(init);
+    CHECK_EQ(init->at({"result", "capabilities", "textDocumentSync", "change"}).integer(), 2);
+
+    auto* params = published(served, uri);
+    REQUIRE(params);
+    CHECK_EQ(params->at({"version"}).integer(), 3);
+    const auto& diags = *params->at({"diagnostics"}).array();
+    REQUIRE_EQ(diags.size(), 1u);
+    CHECK_EQ(diags[0].at({"severity"}).integer(), 1);
+    CHECK_EQ(diags[0].at({"range", "start"}), position(2, 6));
+    CHECK_EQ(diags[0].at({"range", "end"}), position(2, 7));
+
+    const auto& related = *diags[0].at({"relatedInformation"}).array();
+    REQUIRE_EQ(related.size(), 1u);
+    CHECK_EQ(related[0].at({"location", "range", "start"}), position(1, 6));
+  }
+
+  TEST_CASE("incremental changes are applied and re-checked") {
+    std::string uri = "file:///ws/main.bz";
+    auto served = serve(concat({
+      initialize(),
+      did_open(uri, duplicate_let),
+      did_change(uri, 2, position(2, 6), position(2, 7), "y"),
+    }, shutdown_and_exit()));
+
+    auto* params = published(served, uri);
+    REQUIRE(params);
+    CHECK_EQ(params->at({"version"}).integer(), 2);
+    CHECK(params->at({"diagnostics"}).array()->empty());
+  }
+
+  TEST_CASE("positions count UTF-16 code units") {
+    // `é` is two bytes but one UTF-16 unit, so `$` sits at character 14.
+    std::string uri = "file:///ws/main.bz";
+    std::string text = "func main()\n  let s = \"\xC3\xA9\" $\n  s\nend\n";
+
+    auto opened = serve(concat({ initialize(), did_open(uri, text) }, shutdown_and_exit()));
+    auto* params = published(opened, uri);
+    REQUIRE(params);
+    REQUIRE_EQ(params->at({"diagnostics"}).array()->size(), 1u);
+    CHECK_EQ(params->at({"diagnostics"}).array()->at(0).at({"range", "start"}), position(1, 14));
+
+    auto edited = serve(concat({
+      initialize(),
+      did_open(uri, text),
+      did_change(uri, 2, position(1, 13), position(1, 15), ""),
+    }, shutdown_and_exit()));
+    params = published(edited, uri);
+    REQUIRE(params);
+    CHECK(params->at({"diagnostics"}).array()->empty());
+  }
+
+  TEST_CASE("`Load`s resolve under the workspace root") {
+    TempWorkspace ws;
+    ws.write("lib.bz", "func helper()\n  1\nend\n");
+    auto uri = ws.uri("main.bz");
+    std::string text = "Load lib\n\nfunc main()\n  helper()\nend\n";
+
+    auto served = serve(concat({ initialize(ws.uri("")), did_open(uri, text) }, shutdown_and_exit()));
+    auto* params = published(served, uri);
+    REQUIRE(params);
+    CHECK(params->at({"diagnostics"}).array()->empty());
+
+    served = serve(concat({
+      initialize(ws.uri("")),
+      did_open(uri, text),
+      did_change(uri, 2, position(0, 5), position(0, 8), "missing"),
+    }, shutdown_and_exit()));
+    params = published(served, uri);
+    REQUIRE(params);
+    auto messages = messages_of(*params);
+    CHECK(std::ranges::find(messages, "Module `missing` has not been loaded") != messages.end());
+  }
+
+  TEST_CASE("closing a document clears its diagnostics") {
+    std::string uri = "file:///ws/main.bz";
+    auto served = serve(concat({
+      initialize(),
+      did_open(uri, duplicate_let),
+      notification("textDocument/didClose", Json(Json::Object{
+        { "textDocument", Json(Json::Object{ { "uri", uri } }) },
+      })),
+    }, shutdown_and_exit()));
+
+    auto* params = published(served, uri);
+    REQUIRE(params);
+    CHECK(params->at({"diagnostics"}).array()->empty());
+  }
+
+  TEST_CASE("protocol errors") {
+    auto served = serve({
+      request(5, "textDocument/hover"),
+      initialize(),
+      request(6, "textDocument/hover"),
+      notification("exit"),
+    });
+    CHECK_EQ(served.code, 1);
+
+    auto* early = reply_to(served, 5);
+    REQUIRE(early);
+    CHECK_EQ(early->at({"error", "code"}).integer(), -32002);
+    auto* unknown = reply_to(served, 6);
+    REQUIRE(unknown);
+    CHECK_EQ(unknown->at({"error", "code"}).integer(), -32601);
+
+    std::ostringstream framed;
+    write_lsp_message(framed, "{not json");
+    std::istringstream in(framed.str());
+    std::ostringstream out;
+    LspServer server(in, out);
+    CHECK_EQ(server.run(), 1);
+    std::istringstream replies(out.str());
+    auto body = read_lsp_message(replies);
+    REQUIRE(body);
+    CHECK_EQ(Json::parse(*body)->at({"error", "code"}).integer(), -32700);
+  }
+
+  TEST_CASE("many documents edited at once end up matching a full check") {
+    const std::string base =
+      "const limit: Int = 10\n"
+      "\n"
+      "func twice(n: Int) :> Int\n"
+      "  let doubled = n * 2\n"
+      "  doubled\n"
+      "end\n";
+
+    std::vector<Json> session{ initialize() };
+    std::vector<std::string> uris, texts;
+    for (int d = 0; d < 6; ++d) {
+      uris.push_back(std::format("file:///ws/doc{}.bz", d));
+      texts.push_back(base);
+      session.push_back(did_open(uris.back(), base));
+    }
+
+    // Type into every document in turn, char by char at the end of line 3
+    // (`  let doubled = n * 2`).
+    const std::string typed = " + n * limit $ - twice(n)";
+    const size_t line_end = base.find("n * 2\n") + 5;
+    for (size_t i = 0; i < typed.size(); ++i) {
+      int at = 21 + static_cast<int>(i);
+      for (int d = 0; d < 6; ++d) {
+        texts[d].insert(line_end + i, 1, typed[i]);
+        session.push_back(did_change(uris[d], static_cast<int>(i) + 2, position(3, at), position(3, at),
+                                     std::string(1, typed[i])));
+      }
+    }
+
+    auto served = serve(concat(std::move(session), shutdown_and_exit()), LspOptions{ .jobs = 4 });
+    CHECK_EQ(served.code, 0);
+
+    for (int d = 0; d < 6; ++d) {
+      Module fresh(uris[d], texts[d]);
+      fresh.check();
+      std::vector<std::string> want;
+      for (const auto& diag : fresh.get_diag_engine().all()) want.push_back(diag.message);
+      std::ranges::sort(want);
+
+      auto* params = published(served, uris[d]);
+      REQUIRE(params);
+      CHECK_EQ(params->at({"version"}).integer(), static_cast<int64_t>(typed.size()) + 1);
+      CHECK_EQ(messages_of(*params), want);
+    }
+  }
+}
@@ -0,0 +1,265 @@
+#include <doctest/doctest.h>
+
+#include "fixtures.hpp"
+
+#include <ether/module/module_cache.hpp>
+#include <ether/module/module_interface.hpp>
+#include <ether/support/hash.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <random>
+#include <span>
+#include <string>
+#include <variant>
+#include <vector>
+
+using namespace ether::test;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+SymbolAttr make_function(std::string name, std::vector<std::string> params, std::string ret = "") {
+  FunctionData fn;
+  auto& types = TypeTable::shared();
+  fn.function_return_type.type = types.annotation(ret);
+  for (size_t i = 0; i < params.size(); ++i) {
+    fn.function_params.push_back(FuncParamData{ .index = i, .param_name = params[i], .param_type = TypeData{ TypeTable::int_type } });
+  }
+  std::vector<TypeId> param_types(params.size(), TypeTable::int_type);
+  return SymbolAttr{
+    .name = name,
+    .symbol_kind = SymbolKind::Function,
+    .type_info = TypeInfo{ types.function(param_types, ret.empty() ? types.var(0) : types.annotation(ret)) },
+    .symbol_token = make_tok(TokenType::Identifier, name, 3, 6),
+    .symbol_data = std::move(fn),
+  };
+}
+
+// Interface bytes copied into 8-byte aligned storage, as a mapping would be.
+struct Buffer {
+  std::vector<uint64_t> words;
+  size_t size;
+
+  explicit Buffer(const std::string& bytes)
+  : words((bytes.size() + 7) / 8), size(bytes.size()) {
+    std::memcpy(words.data(), bytes.data(), bytes.size());
+  }
+  std::span<const std::byte> bytes() const {
+    return { reinterpret_cast<const std::byte*>(words.data()), size };
+  }
+};
+
+std::string small_interface() {
+  SymbolStorage arena;
+  auto* f = arena.allocate(make_function("f", { "a" }));
+  return write_interface({ { "f", f } }, 1);
+}
+
+struct TempDir {
+  fs::path path;
+
+  TempDir() {
+    static std::atomic<int> counter{0};
+    path = fs::temp_directory_path()
+         / std::format("ether_cache_{}_{}", std::random_device{}(), counter.fetch_add(1));
+  }
+  ~TempDir() { fs::remove_all(path); }
+};
+
+}  // namespace
+
+TEST_SUITE("support / hash") {
+  TEST_CASE("equal inputs hash equally and small edits change the hash") {
+    CHECK(hash_bytes("func main()\n  1\nend") == hash_bytes("func main()\n  1\nend"));
+    CHECK(hash_bytes("func main()\n  1\nend") != hash_bytes("func main()\n  2\nend"));
+    CHECK(hash_bytes("") != hash_bytes(std::string_view("\0", 1)));
+    CHECK(hash_bytes("abc", 1) != hash_bytes("abc", 2));
+  }
+
+  TEST_CASE("every input length takes a distinct path") {
+    std::string s;
+    std::vector<uint64_t> seen;
+    for (int i = 0; i < 40; ++i) {
+      seen.push_back(hash_bytes(s));
+      s.push_back('a');
+    }
+    std::ranges::sort(seen);
+    CHECK(std::ranges::adjacent_find(seen) == seen.end());
+  }
+}
+
+TEST_SUITE("module / interface") {
+  TEST_CASE("exports round-trip through the binary format") {
+    SymbolStorage arena;
+    auto* len = arena.allocate(make_function("len", { "list" }, "Int"));
+    auto* map = arena.allocate(make_function("map", { "list", "fn" }));
+    auto* max = arena.allocate(SymbolAttr{
+      .name = "max_len",
+      .symbol_kind = SymbolKind::Constant,
+      .symbol_token = make_tok(TokenType::Identifier, "max_len", 1, 7),
+    });
+
+    Buffer buf(write_interface({ { "len", len }, { "map", map }, { "max_len", max } }, 0xfeed));
+    auto view = InterfaceView::parse(buf.bytes());
+    REQUIRE(view);
+    CHECK(view->source_hash() == 0xfeed);
+    CHECK(view->symbols().size() == 3);
+
+    auto* rec = view->find("map");
+    REQUIRE(rec);
+    CHECK(view->str(rec->name) == "map");
+    REQUIRE(view->params(*rec).size() == 2);
+    CHECK(view->str(view->params(*rec)[1].name) == "fn");
+
+    auto attr = view->materialize(*rec);
+    CHECK(attr.name == "map");
+    CHECK(attr.symbol_kind == SymbolKind::Function);
+    CHECK(attr.symbol_token.line_number == 3);
+    auto* fn = std::get_if<FunctionData>(&attr.symbol_data);
+    REQUIRE(fn);
+    CHECK(fn->function_params.size() == 2);
+    CHECK(fn->function_params[0].param_name == "list");
+    CHECK(fn->function_params[0].param_type.type == TypeTable::int_type);
+    CHECK(TypeTable::shared().to_string(attr.type_info.type) == "(Int, Int) :> 'a");
+
+    auto len_attr = view->materialize(*view->find("len"));
+    CHECK(std::get<FunctionData>(len_attr.symbol_data).function_return_type.type == TypeTable::int_type);
+    CHECK(view->materialize(*view->find("max_len")).symbol_kind == SymbolKind::Constant);
+    CHECK(view->find("missing") == nullptr);
+  }
+
+  TEST_CASE("an empty export table is a valid interface") {
+    Buffer buf(write_interface({}, 7));
+    auto view = InterfaceView::parse(buf.bytes());
+    REQUIRE(view);
+    CHECK(view->symbols().empty());
+    CHECK(view->find("x") == nullptr);
+  }
+
+  TEST_CASE("truncated interfaces are rejected") {
+    auto good = small_interface();
+    Buffer buf(good.substr(0, good.size() - 1));
+    CHECK_FALSE(InterfaceView::parse(buf.bytes()));
+  }
+
+  TEST_CASE("interfaces with a bad magic are rejected") {
+    auto bad = small_interface();
+    bad[0] ^= 0x20;
+    Buffer buf(bad);
+    CHECK_FALSE(InterfaceView::parse(buf.bytes()));
+  }
+
+  TEST_CASE("string references outside the pool are rejected") {
+    auto bad = small_interface();
+    InterfaceSymbol sym;
+    std::memcpy(&sym, bad.data() + sizeof(InterfaceHeader), sizeof sym);
+    sym.name.length = 1000;
+    std::memcpy(bad.data() + sizeof(InterfaceHeader), &sym, sizeof sym);
+    Buffer buf(bad);
+    CHECK_FALSE(InterfaceView::parse(buf.bytes()));
+  }
+}
+
+TEST_SUITE("module / cache") {
+  TEST_CASE("stored interfaces load back only for the same source hash") {
+    TempDir dir;
+    ModuleCache cache(dir.path);
+    SymbolStorage arena;
+    auto* f = arena.allocate(make_function("f", {}));
+
+    CHECK(cache.load("lib.util", 42) == nullptr);
+    REQUIRE(cache.store("lib.util", 42, { { "f", f } }));
+
+    auto hit = cache.load("lib.util", 42);
+    REQUIRE(hit);
+    CHECK(hit->view.find("f"));
+    CHECK(cache.load("lib.util", 43) == nullptr);
+    CHECK(cache.load("lib.other", 42) == nullptr);
+  }
+
+  TEST_CASE("a corrupt cache file is a miss, not an error") {
+    TempDir dir;
+    ModuleCache cache(dir.path);
+    fs::create_directories(dir.path);
+    std::ofstream(cache.file_for("lib.util"), std::ios::binary) << "not an interface";
+    CHECK(cache.load("lib.util", 42) == nullptr);
+  }
+
+  TEST_CASE("check records round-trip for the same source and options") {
+    TempDir dir;
+    ModuleCache cache(dir.path);
+
+    DiagnosticNote note{ .range = SourceRange::at(6, 3), .message = "first declared here" };
+    Diagnostic error{ .level = DiagnosticLevel::Fail, .phase = DiagnosticPhase::Resolver,
+                      .range = SourceRange::at(20, 3), .message = "`one` is already declared" };
+    DiagnosticList diagnostics;
+    diagnostics.push_back(error, { note });
+
+    CheckRecord record{
+      .source_hash = 42,
+      .options_hash = 7,
+      .interface_hash = 99,
+      .dependencies = { { .import_path = "lib.math", .line = 1, .column = 6, .offset = 5, .interface_hash = 3 } },
+      .diagnostics = diagnostics,
+    };
+
+    CHECK_FALSE(cache.load_record("main", 42, 7));
+    REQUIRE(cache.store_record("main", record));
+
+    auto hit = cache.load_record("main", 42, 7);
+    REQUIRE(hit);
+    CHECK(hit->interface_hash == 99);
+    REQUIRE(hit->dependencies.size() == 1);
+    CHECK(hit->dependencies[0].import_path == "lib.math");
+    CHECK(hit->dependencies[0].offset == 5);
+    CHECK(hit->dependencies[0].interface_hash == 3);
+    REQUIRE(hit->diagnostics.size() == 1);
+    CHECK(hit->diagnostics[0].message == error.message);
+    CHECK(hit->diagnostics[0].level == DiagnosticLevel::Fail);
+    CHECK(hit->diagnostics[0].range.begin == 20);
+    auto notes = hit->diagnostics.notes_of(hit->diagnostics[0]);
+    REQUIRE(notes.size() == 1);
+    CHECK(notes[0].range.end == 9);
+    CHECK(notes[0].message == note.message);
+
+    CHECK_FALSE(cache.load_record("main", 43, 7));
+    CHECK_FALSE(cache.load_record("main", 42, 8));
+  }
+
+  TEST_CASE("check records are also found by the source's size and mtime") {
+    TempDir dir;
+    ModuleCache cache(dir.path);
+    CheckRecord record{ .source_hash = 42, .stamp = { .size = 120, .mtime = 1234 }, .options_hash = 7 };
+    REQUIRE(cache.store_record("main", record));
+
+    auto hit = cache.load_record("main", SourceStamp{ .size = 120, .mtime = 1234 }, 7);
+    REQUIRE(hit);
+    CHECK(hit->source_hash == 42);
+    CHECK_FALSE(cache.load_record("main", SourceStamp{ .size = 121, .mtime = 1234 }, 7));
+    CHECK_FALSE(cache.load_record("main", SourceStamp{ .size = 120, .mtime = 1235 }, 7));
+    CHECK_FALSE(cache.load_record("main", SourceStamp{ .size = 120, .mtime = 1234 }, 8));
+
+    // A record made from a file too fresh to stamp is only found by hash.
+    REQUIRE(cache.store_record("fresh", CheckRecord{ .source_hash = 5 }));
+    CHECK_FALSE(cache.load_record("fresh", SourceStamp{}, 0));
+    CHECK(cache.load_record("fresh", 5, 0));
+  }
+
+  TEST_CASE("a truncated check record is a miss") {
+    TempDir dir;
+    ModuleCache cache(dir.path);
+    CheckRecord record{ .source_hash = 1 };
+    record.diagnostics.push_back(Diagnostic{ .message = "x" });
+    REQUIRE(cache.store_record("main", record));
+
+    auto file = cache.record_file_for("main");
+    fs::resize_file(file, fs::file_size(file) - 1);
+    CHECK_FALSE(cache.load_record("main", 1, 0));
+  }
+}
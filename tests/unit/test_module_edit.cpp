@@ -0,0 +1,424 @@
+#include <doctest/doctest.h>
+
+#include "fixtures.hpp"
+
+#include <ether/module/module.hpp>
+#include <ether/module/module_registry.hpp>
+#include <ether/nodes/node_snapshot.hpp>
+#include <ether/support/line_index.hpp>
+#include <ether/symbols/type_table.hpp>
+
+#include <algorithm>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+using namespace ether::test;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string read_file(const fs::path& path) {
+  std::ifstream f(path, std::ios::binary);
+  std::stringstream ss;
+  ss << f.rdbuf();
+  return ss.str();
+}
+
+std::string describe(const DiagnosticList& list, const Diagnostic& d) {
+  auto text = std::format("{}-{} [{}] {}", d.range.begin, d.range.end,
+                          static_cast<int>(d.phase), d.message);
+  for (const auto& note : list.notes_of(d)) {
+    text += std::format(" / {}-{} {}", note.range.begin, note.range.end, note.message);
+  }
+  return text;
+}
+
+// Everything apply_edit has to keep up to date, in a form that doesn't
+// depend on symbol ids or report order. The AST goes through a snapshot so
+// token positions and poison flags are compared too.
+struct CheckResult {
+  std::string ast;
+  std::vector<std::string> diagnostics;
+  std::vector<std::string> exports;
+  size_t uses;
+
+  bool operator==(const CheckResult&) const = default;
+};
+
+CheckResult result_of(Module& mod) {
+  CheckResult r;
+  r.ast = write_ast_snapshot(mod.get_root(), 0);
+  const auto& diags = mod.get_diag_engine().all();
+  for (const auto& d : diags) r.diagnostics.push_back(describe(diags, d));
+  std::ranges::sort(r.diagnostics);
+
+  for (const auto& [name, sym] : mod.get_exported_symbols()) {
+    auto text = std::format("{} {}:{}@{} {} refs {}:", name, sym->symbol_token.line_number,
+                            sym->symbol_token.column_number, sym->symbol_token.offset,
+                            TypeTable::shared().to_string(sym->type_info.type), sym->ref_count);
+    for (auto offset : mod.get_use_index().references(*sym)) text += std::format(" {}", offset);
+    r.exports.push_back(text);
+  }
+  std::ranges::sort(r.exports);
+  r.uses = mod.get_use_index().size();
+  return r;
+}
+
+CheckResult fresh_check(const std::string& source) {
+  Module mod("test.bz", source);
+  mod.check();
+  return result_of(mod);
+}
+
+// Replaces the first occurrence of `from` in the module's source.
+EditStats replace(Module& mod, const std::string& from, const std::string& to) {
+  auto at = mod.get_source().find(from);
+  REQUIRE_MESSAGE(at != std::string::npos, from);
+  return mod.apply_edit(TextEdit{ .offset = at, .length = from.size(), .text = to });
+}
+
+void check_matches_fresh(Module& mod) {
+  auto got = result_of(mod);
+  auto want = fresh_check(mod.get_source());
+  CHECK_MESSAGE(got.ast == want.ast, mod.get_source());
+  CHECK_EQ(got.diagnostics, want.diagnostics);
+  CHECK_EQ(got.exports, want.exports);
+  CHECK_EQ(got.uses, want.uses);
+}
+
+const std::string program =
+  "const limit: Int = 10\n"
+  "\n"
+  "func small(n: Int) :> Bool\n"
+  "  n < limit\n"
+  "end\n"
+  "\n"
+  "func twice(n: Int) :> Int\n"
+  "  let doubled = n * 2\n"
+  "  doubled\n"
+  "end\n"
+  "\n"
+  "func main()\n"
+  "  small(twice(limit))\n"
+  "end\n";
+
+CancellationToken cancelled() {
+  std::stop_source stop;
+  stop.request_stop();
+  return CancellationToken(stop.get_token());
+}
+
+// Counts the top-level nodes it is shown and cancels after `limit`.
+struct StoppingVisitor : Visitor {
+  std::stop_source stop;
+  size_t limit = 0;
+  size_t seen = 0;
+
+  void count() {
+    if (++this->seen == this->limit) this->stop.request_stop();
+  }
+
+  void visit(NDLiteral&) override { count(); }
+  void visit(NDImportDirective&) override { count(); }
+  void visit(NDIdentifier&) override { count(); }
+  void visit(NDLetBindExpr&) override { count(); }
+  void visit(NDConstExpr&) override { count(); }
+  void visit(NDCallExpr&) override { count(); }
+  void visit(NDCallChain&) override { count(); }
+  void visit(NDFuncDeclExpr&) override { count(); }
+  void visit(NDCaseExpr&) override { count(); }
+  void visit(NDBinaryExpr&) override { count(); }
+  void visit(NDUnaryExpr&) override { count(); }
+  void visit(NDScopeExpr&) override { count(); }
+};
+
+}  // namespace
+
+TEST_SUITE("module / edit") {
+  TEST_CASE("a body edit reparses and resolves only its item") {
+    Module mod("test.bz", program);
+    mod.check();
+
+    auto stats = replace(mod, "n * 2", "n * 2 + n");
+    CHECK(stats.items_reparsed <= 2);
+    CHECK_FALSE(stats.resolved_module);
+    check_matches_fresh(mod);
+  }
+
+  TEST_CASE("later items move with the edit") {
+    Module mod("test.bz", program);
+    mod.check();
+
+    replace(mod, "func small", "Cmt { a comment }\n\nfunc small");
+    replace(mod, "n < limit", "n <\n    limit");
+    check_matches_fresh(mod);
+
+    const auto& exports = mod.get_exported_symbols();
+    REQUIRE(exports.contains("main"));
+    CHECK(exports.at("main")->symbol_token.line_number == 15);
+  }
+
+  TEST_CASE("a rename resolves the whole module, a new parameter does not") {
+    Module mod("test.bz", program);
+    mod.check();
+
+    auto stats = replace(mod, "func twice(n: Int)", "func twice(n: Int, m)");
+    CHECK_FALSE(stats.resolved_module);
+    check_matches_fresh(mod);
+
+    stats = replace(mod, "func main", "func start");
+    CHECK(stats.resolved_module);
+    check_matches_fresh(mod);
+    CHECK_FALSE(mod.get_exported_symbols().contains("main"));
+  }
+
+  TEST_CASE("a body edit that keeps its signature does not recheck the callers") {
+    Module mod("test.bz", program);
+    mod.check();
+    CHECK(mod.get_diag_engine().all().empty());
+
+    auto stats = replace(mod, "n * 2", "n * 3");
+    CHECK(stats.declarations_inferred == 1);
+    check_matches_fresh(mod);
+
+    // The annotation still gives `twice` its signature.
+    stats = replace(mod, "  doubled\n", "  doubled > 4\n");
+    CHECK(stats.declarations_inferred == 1);
+    CHECK(mod.get_diag_engine().all().size() == 1);
+    check_matches_fresh(mod);
+  }
+
+  TEST_CASE("a signature that changes rechecks what uses it, and no further") {
+    Module mod("test.bz",
+      "func twice(n)\n"
+      "  n * 2\n"
+      "end\n"
+      "\n"
+      "func main() :> Int\n"
+      "  twice(4) + 1\n"
+      "end\n"
+      "\n"
+      "func other()\n"
+      "  main()\n"
+      "end\n");
+    mod.check();
+    CHECK(mod.get_diag_engine().all().empty());
+
+    // `twice` is now `(Int) :> Bool`; `main` is still `() :> Int`.
+    auto stats = replace(mod, "n * 2", "n > 2");
+    CHECK_FALSE(stats.resolved_module);
+    CHECK(stats.declarations_inferred == 2);
+    CHECK_FALSE(mod.get_diag_engine().all().empty());
+    check_matches_fresh(mod);
+
+    // Every item moves; only the one edited is inferred again.
+    stats = replace(mod, "func twice", "Cmt { twice }\nfunc twice");
+    CHECK(stats.declarations_inferred == 1);
+    check_matches_fresh(mod);
+  }
+
+  TEST_CASE("folder diagnostics are reported and kept up to date, the tree left as written") {
+    Module mod("test.bz", program);
+    mod.check();
+    CHECK(mod.get_diag_engine().all().empty());
+
+    replace(mod, "n * 2", "4 / 0");
+    const auto& diags = mod.get_diag_engine().all();
+    REQUIRE(diags.size() == 1);
+    CHECK(diags[0].phase == DiagnosticPhase::Folder);
+    CHECK(diags[0].message == "`4 / 0` divides by zero");
+    auto& twice = dynamic_cast<NDFuncDeclExpr&>(*mod.get_root().children.at(2));
+    CHECK(dynamic_cast<NDBinaryExpr*>(dynamic_cast<NDLetBindExpr&>(*twice.func_body.at(0)).bound_value.get()));
+    check_matches_fresh(mod);
+
+    replace(mod, "4 / 0", "4 / 2");
+    CHECK(mod.get_diag_engine().all().empty());
+    check_matches_fresh(mod);
+  }
+
+  TEST_CASE("deleting an `end` reparses until items line up again") {
+    Module mod("test.bz", program);
+    mod.check();
+
+    replace(mod, "  n < limit\nend\n", "  n < limit\n");
+    check_matches_fresh(mod);
+
+    replace(mod, "  n < limit\n", "  n < limit\nend\n");
+    check_matches_fresh(mod);
+    CHECK(result_of(mod) == fresh_check(program));
+  }
+
+  TEST_CASE("unterminated strings and comments") {
+    Module mod("test.bz", program);
+    mod.check();
+
+    replace(mod, "doubled\nend", "\"doubled\nend");
+    check_matches_fresh(mod);
+    replace(mod, "\"doubled", "doubled");
+    check_matches_fresh(mod);
+
+    // An unclosed multi-line comment swallows the rest of the module.
+    replace(mod, "func twice", "Cmt { func twice");
+    check_matches_fresh(mod);
+    CHECK_FALSE(mod.get_exported_symbols().contains("main"));
+    replace(mod, "Cmt { ", "");
+    check_matches_fresh(mod);
+  }
+
+  TEST_CASE("edits ahead of the first item and between items") {
+    Module mod("test.bz", program);
+    mod.check();
+
+    mod.apply_edit(TextEdit{ .offset = 0, .length = 0, .text = "$ ? junk\n" });
+    check_matches_fresh(mod);
+    mod.apply_edit(TextEdit{ .offset = 0, .length = 9, .text = "" });
+    check_matches_fresh(mod);
+
+    replace(mod, "end\n\nfunc twice", "end\n\n1 + \n\nfunc twice");
+    check_matches_fresh(mod);
+    replace(mod, "end\n\n1 + \n", "end\n");
+    check_matches_fresh(mod);
+  }
+
+  TEST_CASE("duplicate declarations keep pointing at the earlier one") {
+    Module mod("test.bz", program);
+    mod.check();
+
+    replace(mod, "  doubled\nend", "  let doubled = 3\n  doubled\nend");
+    check_matches_fresh(mod);
+
+    auto dup = std::ranges::find_if(mod.get_diag_engine().all(), [](const Diagnostic& d) {
+      return d.message.find("Duplicate") != std::string::npos;
+    });
+    REQUIRE(dup != mod.get_diag_engine().all().end());
+    auto notes = mod.get_diag_engine().all().notes_of(*dup);
+    REQUIRE(notes.size() == 1);
+    CHECK(LineIndex(mod.get_source()).position(notes[0].range.begin).line == 8);
+
+    // Moving the function moves the note with it.
+    replace(mod, "func small", "\n\nfunc small");
+    check_matches_fresh(mod);
+  }
+
+  TEST_CASE("`Load`s are bound through the registry") {
+    ModuleRegistry registry;
+    Module lib("lib.bz", "func helper()\n  1\nend\n");
+    lib.check();
+    registry.publish("lib", lib.get_exported_symbols());
+
+    Module mod("main.bz", "Load lib\n\nfunc main()\n  helper()\nend\n");
+    mod.check(&registry);
+    CHECK_FALSE(mod.get_diag_engine().has_errors());
+
+    auto stats = replace(mod, "helper()\n", "helper()\n  helper()\n");
+    CHECK_FALSE(stats.resolved_module);
+    CHECK_FALSE(mod.get_diag_engine().has_errors());
+
+    stats = replace(mod, "Load lib", "Load missing");
+    CHECK(stats.resolved_module);
+    CHECK(mod.get_diag_engine().has_errors());
+  }
+
+  TEST_CASE("random edits match a full check") {
+    std::vector<std::string> sources{ program };
+    for (const auto& entry : fs::directory_iterator(ETHER_TEST_SAMPLES_DIR)) {
+      if (entry.path().extension() == ".bz") sources.push_back(read_file(entry.path()));
+    }
+
+    const std::vector<std::string> snippets{
+      "", " ", "\n", "end", "end\n", "func f(a)\n", "let x = 1\n", "const c = 2\n",
+      "(", ")", "{", "}", "\"", "Cmt ", "Cmt {", "x", "+ 1", ":>", "|=>", "case ", "True :> 1\n",
+    };
+
+    std::mt19937 rng(2024);
+    for (const auto& source : sources) {
+      Module mod("test.bz", source);
+      mod.check();
+
+      for (int step = 0; step < 40; ++step) {
+        const auto& text = mod.get_source();
+        size_t at = std::uniform_int_distribution<size_t>(0, text.size())(rng);
+        size_t length = std::min<size_t>(std::uniform_int_distribution<size_t>(0, 6)(rng), text.size() - at);
+        const auto& snippet = snippets[std::uniform_int_distribution<size_t>(0, snippets.size() - 1)(rng)];
+
+        mod.apply_edit(TextEdit{ .offset = at, .length = length, .text = snippet });
+        auto got = result_of(mod);
+        auto want = fresh_check(mod.get_source());
+        REQUIRE_MESSAGE(got == want, mod.get_source());
+      }
+    }
+  }
+}
+
+TEST_SUITE("module / cancellation") {
+  TEST_CASE("a cancelled check leaves the module unchecked") {
+    Module mod("test.bz", program);
+    CHECK_FALSE(mod.check(nullptr, cancelled()));
+    CHECK_FALSE(mod.is_checked());
+    CHECK(mod.get_root().children.empty());
+    CHECK(mod.get_diag_engine().all().empty());
+    CHECK(mod.get_exported_symbols().empty());
+
+    CHECK(mod.check());
+    CHECK(mod.is_checked());
+    check_matches_fresh(mod);
+  }
+
+  TEST_CASE("a cancelled edit keeps its text and the next edit checks in full") {
+    Module mod("test.bz", program);
+    mod.check();
+
+    auto at = mod.get_source().find("n * 2");
+    auto stats = mod.apply_edit(TextEdit{ .offset = at, .length = 5, .text = "n * 3" }, cancelled());
+    CHECK(stats.cancelled);
+    CHECK_FALSE(mod.is_checked());
+    CHECK(mod.get_source().find("n * 3") != std::string::npos);
+
+    stats = replace(mod, "n < limit", "n <= limit");
+    CHECK_FALSE(stats.cancelled);
+    CHECK(stats.resolved_module);
+    check_matches_fresh(mod);
+  }
+
+  TEST_CASE("visitors stop at the next top-level item") {
+    Module mod("test.bz", program);
+    mod.generate_ast();
+    REQUIRE(mod.get_root().children.size() == 4);
+
+    StoppingVisitor visitor;
+    visitor.limit = 2;
+    mod.attach_visitor(visitor);
+    CHECK_FALSE(mod.apply_visitors(CancellationToken(visitor.stop.get_token())));
+    CHECK(visitor.seen == 2);
+  }
+
+  TEST_CASE("edits cancelled at random still converge on a full check") {
+    const std::vector<std::string> snippets{ "", "\n", "end\n", "func f(a)\n", "let x = 1\n", "x", "(" };
+
+    std::mt19937 rng(38);
+    Module mod("test.bz", program);
+    mod.check();
+    for (int step = 0; step < 60; ++step) {
+      const auto& text = mod.get_source();
+      size_t at = std::uniform_int_distribution<size_t>(0, text.size())(rng);
+      size_t length = std::min<size_t>(std::uniform_int_distribution<size_t>(0, 4)(rng), text.size() - at);
+      const auto& snippet = snippets[std::uniform_int_distribution<size_t>(0, snippets.size() - 1)(rng)];
+      bool cancel = std::uniform_int_distribution<int>(0, 2)(rng) == 0;
+
+      TextEdit edit{ .offset = at, .length = length, .text = snippet };
+      auto stats = cancel ? mod.apply_edit(edit, cancelled()) : mod.apply_edit(edit);
+      CHECK(stats.cancelled == cancel);
+      if (!cancel) {
+        auto got = result_of(mod);
+        REQUIRE_MESSAGE(got == fresh_check(mod.get_source()), mod.get_source());
+      }
+    }
+  }
+}
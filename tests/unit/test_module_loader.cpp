@@ -0,0 +1,468 @@
+#include <doctest/doctest.h>
+
+#include "fixtures.hpp"
+
+#include <ether/module/module_loader.hpp>
+#include <ether/support/line_index.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+using namespace ether::test;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// A throwaway project directory, removed when the test ends.
+struct TempProject {
+  fs::path root;
+
+  TempProject() {
+    static std::atomic<int> counter{0};
+    root = fs::temp_directory_path()
+         / std::format("ether_loader_{}_{}", std::random_device{}(), counter.fetch_add(1));
+    fs::remove_all(root);
+    fs::create_directories(root);
+  }
+  ~TempProject() { fs::remove_all(root); }
+
+  fs::path write(const std::string& rel, const std::string& src) const {
+    auto file = root / rel;
+    fs::create_directories(file.parent_path());
+    std::ofstream(file) << src;
+    return file;
+  }
+};
+
+std::vector<std::string> messages(const Module& mod) {
+  std::vector<std::string> out;
+  for (const auto& d : mod.get_diag_engine().all()) out.push_back(d.message);
+  return out;
+}
+
+}  // namespace
+
+TEST_SUITE("module / loader") {
+  TEST_CASE("an entry's imports are found under the root and resolved first") {
+    fs::path root = fs::path(ETHER_TEST_SAMPLES_DIR) / "project";
+    ModuleLoader loader(root);
+    REQUIRE(loader.add_entry(root / "main.bz"));
+    loader.load();
+
+    REQUIRE(loader.modules().size() == 3);
+    CHECK(loader.modules()[0].import_path == "main");
+    CHECK(loader.find("lib.math"));
+    CHECK(loader.find("lib.consts"));
+    CHECK(loader.get_registry().size() == 3);
+
+    for (const auto& loaded : loader.modules()) {
+      CHECK_MESSAGE(messages(*loaded.module).empty(), loaded.import_path);
+    }
+    CHECK(loader.find("lib.math")->get_exported_symbols().contains("square"));
+  }
+
+  TEST_CASE("a missing module is reported at its Load") {
+    TempProject p;
+    auto main = p.write("main.bz", "Load util.strings\n\nfunc main()\n  trim()\nend\n");
+
+    ModuleLoader loader(p.root);
+    REQUIRE(loader.add_entry(main));
+    loader.load();
+
+    REQUIRE(loader.modules().size() == 1);
+    const auto& diags = loader.modules()[0].module->get_diag_engine().all();
+    REQUIRE_FALSE(diags.empty());
+    CHECK(diags[0].message.starts_with("Cannot find module `util.strings`"));
+    CHECK(LineIndex(loader.modules()[0].module->get_source()).position(diags[0].range.begin).line == 1);
+    // The import itself is reported once; the resolver doesn't repeat it.
+    for (size_t i = 1; i < diags.size(); ++i) {
+      CHECK(diags[i].message.find("has not been loaded") == std::string::npos);
+    }
+  }
+
+  TEST_CASE("import cycles are reported and cut without deadlocking") {
+    fs::path samples = ETHER_TEST_SAMPLES_DIR;
+    ModuleLoader loader(samples, LoaderOptions{ .jobs = 4 });
+    REQUIRE(loader.add_entry(samples / "cycle" / "a.bz"));
+    loader.load();
+
+    REQUIRE(loader.modules().size() == 2);
+    auto* b = loader.find("cycle.b");
+    REQUIRE(b);
+    CHECK(messages(*b) == std::vector<std::string>{ "Import cycle detected: cycle.a -> cycle.b -> cycle.a" });
+    CHECK(messages(*loader.find("cycle.a")).empty());
+    CHECK(loader.get_registry().size() == 2);
+  }
+
+  TEST_CASE("a module that loads itself is a cycle") {
+    TempProject p;
+    auto main = p.write("main.bz", "Load main\n\nfunc main()\n  1\nend\n");
+
+    ModuleLoader loader(p.root);
+    REQUIRE(loader.add_entry(main));
+    loader.load();
+
+    CHECK(messages(*loader.modules()[0].module) == std::vector<std::string>{ "Import cycle detected: main -> main" });
+  }
+
+  TEST_CASE("discovery only follows the leading Loads") {
+    TempProject p;
+    p.write("late.bz", "const x = 1\n");
+    auto main = p.write("main.bz", "func main()\n  x\nend\nLoad late\n");
+
+    ModuleLoader loader(p.root);
+    REQUIRE(loader.add_entry(main));
+    loader.load();
+
+    CHECK(loader.modules().size() == 1);
+    CHECK(loader.find("late") == nullptr);
+    auto msgs = messages(*loader.modules()[0].module);
+    CHECK(std::ranges::find(msgs, "`Load late` must come before any other top-level item") != msgs.end());
+  }
+
+  TEST_CASE("shared dependencies are loaded once") {
+    TempProject p;
+    p.write("base.bz", "const one = 1\n");
+    p.write("left.bz", "Load base\n\nfunc left()\n  one\nend\n");
+    p.write("right.bz", "Load base\n\nfunc right()\n  one\nend\n");
+    auto top = p.write("top.bz", "Load left\nLoad right\nLoad left\n\nfunc top()\n  left()\n  right()\nend\n");
+
+    ModuleLoader loader(p.root);
+    REQUIRE(loader.add_entry(top));
+    loader.load();
+
+    CHECK(loader.modules().size() == 4);
+    for (const auto& loaded : loader.modules()) {
+      CHECK_MESSAGE(messages(*loaded.module).empty(), loaded.import_path);
+    }
+  }
+
+  TEST_CASE("parallel loading matches serial loading on a layered graph") {
+    TempProject p;
+    // Layer k module i imports every module of layer k-1. Import paths
+    // can't contain digits, so layers and modules are lettered.
+    constexpr int layers = 6, width = 8;
+    auto path = [](int k, int i) {
+      return std::format("l{}.m{}", char('a' + k), char('a' + i));
+    };
+    auto file = [](int k, int i) {
+      return std::format("l{}/m{}.bz", char('a' + k), char('a' + i));
+    };
+
+    for (int k = 0; k < layers; ++k) {
+      for (int i = 0; i < width; ++i) {
+        std::string src;
+        if (k > 0) {
+          for (int j = 0; j < width; ++j) src += std::format("Load {}\n", path(k - 1, j));
+        }
+        src += std::format("\nfunc f{}x{}()\n", k, i);
+        src += k > 0 ? std::format("  f{}x{}()\n", k - 1, i) : "  1\n";
+        src += "end\n";
+        p.write(file(k, i), src);
+      }
+    }
+    std::string main_src;
+    for (int i = 0; i < width; ++i) main_src += std::format("Load {}\n", path(layers - 1, i));
+    main_src += std::format("\nfunc main()\n  f{}x0()\nend\n", layers - 1);
+    p.write("main.bz", main_src);
+
+    auto run = [&](size_t jobs) {
+      auto loader = std::make_unique<ModuleLoader>(p.root, LoaderOptions{ .jobs = jobs });
+      REQUIRE(loader->add_entry(p.root / "main.bz"));
+      loader->load();
+      return loader;
+    };
+
+    auto serial = run(1);
+    auto parallel = run(4);
+
+    REQUIRE(serial->modules().size() == 1 + layers * width);
+    REQUIRE(parallel->modules().size() == serial->modules().size());
+    CHECK(parallel->get_registry().size() == serial->modules().size());
+    for (size_t i = 0; i < serial->modules().size(); ++i) {
+      const auto& s = serial->modules()[i];
+      const auto& q = parallel->modules()[i];
+      CHECK(s.import_path == q.import_path);
+      CHECK(messages(*q.module).empty());
+      CHECK(messages(*q.module) == messages(*s.module));
+    }
+  }
+
+  TEST_CASE("an unchanged project is replayed from the cache") {
+    TempProject p;
+    p.write("base.bz", "const one = 1\n");
+    p.write("mid.bz", "Load base\n\nfunc mid(x)\n  one\nend\n");
+    auto main = p.write("main.bz", "Load mid\n\nfunc main()\n  mid(1)\nend\n");
+    LoaderOptions opts{ .cache_dir = p.root / ".cache" };
+
+    {
+      ModuleLoader cold(p.root, opts);
+      REQUIRE(cold.add_entry(main));
+      cold.load();
+      CHECK(cold.modules().size() == 3);
+      for (const auto& loaded : cold.modules()) CHECK_FALSE(loaded.from_cache);
+    }
+
+    ModuleLoader warm(p.root, opts);
+    REQUIRE(warm.add_entry(main));
+    warm.load();
+
+    REQUIRE(warm.modules().size() == 3);
+    for (const auto& loaded : warm.modules()) {
+      CHECK(loaded.from_cache);
+      CHECK(messages(*loaded.module).empty());
+    }
+
+    auto* exports = warm.get_registry().find("mid");
+    REQUIRE(exports);
+    CHECK(exports->is_cached());
+    auto mid = exports->find("mid");
+    REQUIRE(mid);
+    CHECK(std::get<FunctionData>(mid->symbol_data).function_params.size() == 1);
+  }
+
+  TEST_CASE("a bare file name is found under the current directory") {
+    TempProject p;
+    p.write("util.bz", "func helper()\n  1\nend\n");
+    p.write("main.bz", "Load util\n\nfunc main()\n  helper()\nend\n");
+
+    auto previous = fs::current_path();
+    fs::current_path(p.root);
+    // `ether check main.bz` has no parent directory to root at.
+    ModuleLoader loader(fs::path("main.bz").parent_path());
+    bool added = loader.add_entry("main.bz");
+    if (added) loader.load();
+    fs::current_path(previous);
+
+    REQUIRE(added);
+    REQUIRE(loader.modules().size() == 2);
+    CHECK(loader.modules()[0].import_path == "main");
+    CHECK(loader.modules()[1].import_path == "util");
+    CHECK(messages(*loader.find("main")).empty());
+  }
+
+  TEST_CASE("files whose size and mtime match their record are not read") {
+    TempProject p;
+    auto old = fs::file_time_type::clock::now() - std::chrono::hours(1);
+    auto write_old = [&](const std::string& rel, const std::string& src) {
+      auto file = p.write(rel, src);
+      fs::last_write_time(file, old);
+      return file;
+    };
+    write_old("base.bz", "const one = 1\nconst one = 2\n");
+    auto main = write_old("main.bz", "Load base\n\nfunc main()\n  one + 111\nend\n");
+    LoaderOptions opts{ .cache_dir = p.root / ".cache" };
+
+    auto run = [&]() {
+      auto loader = std::make_unique<ModuleLoader>(p.root, opts);
+      REQUIRE(loader->add_entry(main));
+      loader->load();
+      return loader;
+    };
+    run();
+
+    auto warm = run();
+    CHECK(warm->modules()[0].from_cache);
+    CHECK(warm->find("main")->get_source().empty());
+    // Its diagnostic is shown, so its source is read.
+    CHECK(warm->modules()[1].from_cache);
+    CHECK_FALSE(warm->find("base")->get_source().empty());
+    CHECK(messages(*warm->find("base")).size() == 1);
+
+    // Same size, other mtime: read, hashed and checked again.
+    write_old("main.bz", "Load base\n\nfunc main()\n  one + \"1\"\nend\n");
+    fs::last_write_time(main, old + std::chrono::minutes(1));
+    auto edited = run();
+    CHECK_FALSE(edited->modules()[0].from_cache);
+    CHECK(messages(*edited->find("main")).size() == 1);
+  }
+
+  TEST_CASE("an interface change re-checks the module and its importers") {
+    TempProject p;
+    p.write("lib.bz", "func f()\n  1\nend\n");
+    auto main = p.write("main.bz", "Load lib\n\nfunc main()\n  f()\nend\n");
+    LoaderOptions opts{ .cache_dir = p.root / ".cache" };
+
+    {
+      ModuleLoader cold(p.root, opts);
+      REQUIRE(cold.add_entry(main));
+      cold.load();
+    }
+    p.write("lib.bz", "func g()\n  1\nend\n");
+
+    ModuleLoader warm(p.root, opts);
+    REQUIRE(warm.add_entry(main));
+    warm.load();
+    CHECK_FALSE(warm.modules()[0].from_cache);
+    CHECK_FALSE(warm.modules()[1].from_cache);
+    CHECK_FALSE(messages(*warm.modules()[0].module).empty());
+  }
+
+  TEST_CASE("a body-only edit leaves importers replayed") {
+    TempProject p;
+    p.write("lib.bz", "func f(a)\n  1\nend\n");
+    auto main = p.write("main.bz", "Load lib\n\nfunc main()\n  f(1)\nend\n");
+    LoaderOptions opts{ .cache_dir = p.root / ".cache" };
+
+    {
+      ModuleLoader cold(p.root, opts);
+      REQUIRE(cold.add_entry(main));
+      cold.load();
+    }
+    // Moved, with a new body of the same type.
+    p.write("lib.bz", "\n\nfunc f(a)\n  1 + 1\nend\n");
+
+    ModuleLoader warm(p.root, opts);
+    REQUIRE(warm.add_entry(main));
+    warm.load();
+    CHECK(warm.modules()[0].from_cache);
+    CHECK_FALSE(warm.modules()[1].from_cache);
+  }
+
+  TEST_CASE("an edit that changes an inferred type rechecks importers") {
+    TempProject p;
+    p.write("lib.bz", "func f(a)\n  1\nend\n");
+    auto main = p.write("main.bz", "Load lib\n\nfunc main()\n  f(1) + 1\nend\n");
+    LoaderOptions opts{ .cache_dir = p.root / ".cache" };
+
+    {
+      ModuleLoader cold(p.root, opts);
+      REQUIRE(cold.add_entry(main));
+      cold.load();
+      CHECK(messages(*cold.modules()[0].module).empty());
+    }
+    p.write("lib.bz", "func f(a)\n  \"one\"\nend\n");
+
+    ModuleLoader warm(p.root, opts);
+    REQUIRE(warm.add_entry(main));
+    warm.load();
+    CHECK_FALSE(warm.modules()[0].from_cache);
+    auto msgs = messages(*warm.modules()[0].module);
+    REQUIRE(msgs.size() == 1);
+    CHECK(msgs[0].find("`+` needs operands of one type") != std::string::npos);
+  }
+
+  TEST_CASE("recorded diagnostics are replayed") {
+    TempProject p;
+    p.write("base.bz", "const one = 1\nconst one = 2\n");
+    p.write("mid.bz", "Load base\n\nfunc mid()\n  one\nend\n");
+    auto main = p.write("main.bz", "Load mid\nLoad nowhere\n\nfunc main()\n  mid()\nend\n");
+    LoaderOptions opts{ .cache_dir = p.root / ".cache" };
+
+    std::vector<std::vector<std::string>> first;
+    for (int run = 0; run < 2; ++run) {
+      ModuleLoader loader(p.root, opts);
+      REQUIRE(loader.add_entry(main));
+      loader.load();
+      REQUIRE(loader.modules().size() == 3);
+
+      std::vector<std::vector<std::string>> seen;
+      for (const auto& loaded : loader.modules()) seen.push_back(messages(*loaded.module));
+      if (run == 0) {
+        first = seen;
+        continue;
+      }
+
+      CHECK(seen == first);
+      CHECK(loader.find("base")->get_diag_engine().has_errors());
+      CHECK(loader.modules()[1].from_cache);
+      CHECK(loader.modules()[2].from_cache);
+      // The missing import is reported again, so `main` is checked again.
+      CHECK_FALSE(loader.modules()[0].from_cache);
+    }
+  }
+
+  TEST_CASE("records made under other options are not replayed") {
+    TempProject p;
+    auto main = p.write("main.bz", "func main(unused)\n  1\nend\n");
+
+    auto run = [&](bool warn_unused) {
+      ModuleLoader loader(p.root, LoaderOptions{ .warn_unused = warn_unused, .cache_dir = p.root / ".cache" });
+      REQUIRE(loader.add_entry(main));
+      loader.load();
+      return std::pair(loader.modules()[0].from_cache, messages(*loader.modules()[0].module).size());
+    };
+
+    CHECK(run(false) == std::pair(false, size_t{0}));
+    CHECK(run(true) == std::pair(false, size_t{1}));
+    CHECK(run(true) == std::pair(true, size_t{1}));
+  }
+
+  TEST_CASE("functions another module calls are not reported as never called") {
+    TempProject p;
+    p.write("lib.bz", "func used()\n  1\nend\nfunc unused()\n  2\nend\n");
+    auto main = p.write("main.bz", "Load lib\n\nfunc main()\n  used()\nend\n");
+
+    // The second run replays both modules from their records.
+    for (int run = 0; run < 2; ++run) {
+      ModuleLoader loader(p.root, LoaderOptions{ .warn_unused = true, .cache_dir = p.root / ".cache" });
+      REQUIRE(loader.add_entry(main));
+      loader.load();
+
+      CHECK(loader.modules()[1].from_cache == (run == 1));
+      CHECK(messages(*loader.find("main")).empty());
+      CHECK_EQ(messages(*loader.find("lib")), std::vector<std::string>{ "Function `unused` is never called" });
+    }
+  }
+
+  TEST_CASE("keep_ast replays trees from snapshots") {
+    TempProject p;
+    p.write("lib.bz", "func f(a)\n  a\nend\n");
+    auto main = p.write("main.bz", "Load lib\n\nfunc main()\n  f(1)\nend\n");
+
+    {
+      // Records without snapshots don't satisfy a keep_ast run.
+      ModuleLoader plain(p.root, LoaderOptions{ .cache_dir = p.root / ".cache" });
+      REQUIRE(plain.add_entry(main));
+      plain.load();
+    }
+
+    LoaderOptions opts{ .cache_dir = p.root / ".cache", .keep_ast = true };
+    for (int run = 0; run < 2; ++run) {
+      ModuleLoader loader(p.root, opts);
+      REQUIRE(loader.add_entry(main));
+      loader.load();
+
+      for (const auto& loaded : loader.modules()) CHECK(loaded.from_cache == (run == 1));
+      CHECK(loader.find("main")->get_root().children.size() == 2);
+      CHECK(loader.find("lib")->get_root().children.size() == 1);
+    }
+  }
+
+  TEST_CASE("keep_ast keeps trees as written but still reports what folding finds") {
+    TempProject p;
+    auto main = p.write("main.bz", "func main()\n  let a = 2.0 * 3.0\n  1 / 0\nend\n");
+
+    auto bound_value = [](Module& mod) -> NDPtr& {
+      auto& func = dynamic_cast<NDFuncDeclExpr&>(*mod.get_root().children.at(0));
+      return dynamic_cast<NDLetBindExpr&>(*func.func_body.at(0)).bound_value;
+    };
+
+    for (bool keep_ast : { false, true }) {
+      ModuleLoader loader(p.root, LoaderOptions{ .keep_ast = keep_ast });
+      REQUIRE(loader.add_entry(main));
+      loader.load();
+
+      auto& mod = *loader.find("main");
+      CHECK_MESSAGE(messages(mod) == std::vector<std::string>{ "`1 / 0` divides by zero" }, keep_ast);
+      CHECK_MESSAGE((dynamic_cast<NDBinaryExpr*>(bound_value(mod).get()) != nullptr) == keep_ast, keep_ast);
+    }
+  }
+
+  TEST_CASE("an unreadable entry is rejected") {
+    TempProject p;
+    ModuleLoader loader(p.root);
+    CHECK_FALSE(loader.add_entry(p.root / "nope.bz"));
+  }
+}
@@ -0,0 +1,227 @@
+#include <doctest/doctest.h>
+
+#include "fixtures.hpp"
+
+#include <ether/ast/symbol_resolver/symbol_resolver.hpp>
+#include <ether/module/module.hpp>
+#include <ether/module/module_registry.hpp>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+using namespace ether::test;
+
+namespace {
+
+// Resolves `src` as the module published under `path` (if non-empty).
+std::unique_ptr<Module> load_module(
+  ModuleRegistry& registry,
+  const std::string& path,
+  const std::string& src,
+  size_t jobs = 1
+) {
+  auto mod = std::make_unique<Module>(path.empty() ? "<test>" : path, src);
+  mod->generate_ast();
+  SymbolResolver resolver(mod->get_symbol_storage(), mod->get_diag_engine());
+  resolver.set_module_registry(registry);
+  mod->resolve(resolver, jobs);
+  mod->set_exports(resolver.take_exports());
+  if (!path.empty()) registry.publish(path, mod->get_exported_symbols());
+  return mod;
+}
+
+}  // namespace
+
+TEST_SUITE("module / registry") {
+  TEST_CASE("published exports are found by dotted path") {
+    ModuleRegistry registry;
+    SymbolStorage arena;
+    auto* sym = arena.allocate(SymbolAttr{ .name = "len", .symbol_kind = SymbolKind::Function });
+
+    CHECK(registry.find("benzene.list") == nullptr);
+    CHECK(registry.publish("benzene.list", { { "len", sym } }));
+
+    auto* exports = registry.find("benzene.list");
+    REQUIRE(exports);
+    CHECK(exports->symbols().at("len") == sym);
+    CHECK(registry.size() == 1);
+  }
+
+  TEST_CASE("a path can only be published once") {
+    ModuleRegistry registry;
+    CHECK(registry.publish("a.b", {}));
+    CHECK_FALSE(registry.publish("a.b", {}));
+    CHECK(registry.size() == 1);
+  }
+
+  TEST_CASE("readers see every module once it is published") {
+    ModuleRegistry registry(8);
+    constexpr int n_modules = 2000;
+    std::atomic<bool> done{false};
+    std::atomic<size_t> misses{0};
+
+    std::vector<std::jthread> readers;
+    for (int r = 0; r < 4; ++r) {
+      readers.emplace_back([&]() {
+        while (!done.load(std::memory_order_acquire)) {
+          size_t seen = registry.size();
+          for (size_t i = 0; i < seen; ++i) {
+            if (!registry.find("mod.m" + std::to_string(i))) misses++;
+          }
+        }
+      });
+    }
+
+    for (int i = 0; i < n_modules; ++i) {
+      registry.publish("mod.m" + std::to_string(i), {});
+    }
+    done.store(true, std::memory_order_release);
+    readers.clear();
+
+    CHECK(misses.load() == 0);
+    CHECK(registry.size() == n_modules);
+  }
+}
+
+TEST_SUITE("sym_res / imports") {
+  TEST_CASE("loaded functions and constants resolve across modules") {
+    ModuleRegistry registry;
+    auto lib = load_module(registry, "benzene.list", "const max_len = 10\nfunc len(l)\n  l\nend");
+    auto app = load_module(registry, "",
+      "Load benzene.list\n"
+      "func main()\n"
+      "  len(max_len)\n"
+      "end"
+    );
+
+    CHECK_FALSE(app->get_diag_engine().has_errors());
+
+    auto ast = app->get_ast();
+    auto* main = dynamic_cast<NDFuncDeclExpr*>(ast.children[1].get());
+    REQUIRE(main);
+    auto* call = dynamic_cast<NDCallExpr*>(main->func_body[0].get());
+    REQUIRE(call);
+    auto* callee = call->identifier->identifier_symbol;
+    REQUIRE(callee);
+    CHECK(callee->name == "len");
+    CHECK(callee->symbol_kind == SymbolKind::Function);
+    // The importer gets its own stand-in; the exporter is left untouched.
+    CHECK(callee != lib->get_exported_symbols().at("len"));
+    CHECK(lib->get_exported_symbols().at("len")->ref_count == 0);
+  }
+
+  TEST_CASE("local declarations shadow imported names") {
+    ModuleRegistry registry;
+    auto lib = load_module(registry, "lib.util", "func helper()\n  1\nend");
+    auto app = load_module(registry, "",
+      "Load lib.util\n"
+      "func helper()\n  2\nend\n"
+      "func main()\n  helper()\nend"
+    );
+    CHECK_FALSE(app->get_diag_engine().has_errors());
+    CHECK(app->get_exported_symbols().at("helper")->ref_count == 1);
+  }
+
+  TEST_CASE("names from modules that were not loaded stay unresolved") {
+    ModuleRegistry registry;
+    auto lib = load_module(registry, "lib.util", "func helper()\n  1\nend");
+    auto app = load_module(registry, "", "func main()\n  helper()\nend");
+    CHECK(app->get_diag_engine().has_errors());
+  }
+
+  TEST_CASE("loading an unpublished module is an error") {
+    ModuleRegistry registry;
+    auto app = load_module(registry, "", "Load benzene.missing\nfunc main()\n  1\nend");
+    CHECK(app->get_diag_engine().has_errors());
+
+    auto ast = app->get_ast();
+    CHECK(ast.children[0]->is_poisoned);
+  }
+
+  TEST_CASE("a Load after another top-level item is rejected") {
+    ModuleRegistry registry;
+    auto lib = load_module(registry, "lib.util", "func helper()\n  1\nend");
+    auto app = load_module(registry, "", "func main()\n  helper()\nend\nLoad lib.util");
+
+    const auto& diags = app->get_diag_engine().all();
+    REQUIRE_FALSE(diags.empty());
+    CHECK(diags[0].message == "`Load lib.util` must come before any other top-level item");
+
+    auto ast = app->get_ast();
+    CHECK(ast.children[1]->is_poisoned);
+  }
+
+  TEST_CASE("invalid import paths are rejected") {
+    ModuleRegistry registry;
+    auto app = load_module(registry, "", "Load benzene.cpu2\nfunc main()\n  1\nend");
+    CHECK(app->get_diag_engine().has_errors());
+  }
+
+  TEST_CASE("imports are visible to bodies resolved in parallel") {
+    ModuleRegistry registry;
+    auto lib = load_module(registry, "lib.util", "func helper()\n  1\nend");
+
+    std::string src = "Load lib.util\n";
+    for (int i = 0; i < 200; ++i) {
+      src += "func f" + std::to_string(i) + "()\n  helper()\nend\n";
+    }
+    auto app = load_module(registry, "", src, 4);
+    CHECK_FALSE(app->get_diag_engine().has_errors());
+  }
+
+  TEST_CASE("an imported name is one symbol however many jobs resolve its uses") {
+    ModuleRegistry registry;
+    // Names nothing uses get no proxy, with one job or many.
+    std::string lib_src = "func helper()\n  1\nend\nconst limit = 2\n";
+    for (int i = 0; i < 50; ++i) lib_src += "const unused" + std::to_string(i) + " = 0\n";
+    auto lib = load_module(registry, "lib.util", lib_src);
+
+    std::string src = "Load lib.util\n";
+    for (int i = 0; i < 100; ++i) {
+      src += "func f" + std::to_string(i) + "()\n  helper()\n  limit\nend\n";
+    }
+
+    struct Seen {
+      std::vector<uint32_t> references;
+      size_t ref_count;
+      size_t symbols;
+      uint32_t helper_id;
+    };
+    auto resolve_with = [&](size_t jobs) {
+      Module app("<test>", src);
+      app.generate_ast();
+      SymbolResolver resolver(app.get_symbol_storage(), app.get_diag_engine());
+      resolver.set_module_registry(registry);
+      app.resolve(resolver, jobs);
+      auto index = resolver.take_use_index();
+      CHECK_FALSE(app.get_diag_engine().has_errors());
+
+      // Every call names the same proxy.
+      std::unordered_set<const SymbolAttr*> helpers;
+      for (auto& child : app.get_root().children) {
+        auto* func = dynamic_cast<NDFuncDeclExpr*>(child.get());
+        if (!func) continue;
+        auto* call = dynamic_cast<NDCallExpr*>(func->func_body[0].get());
+        REQUIRE(call);
+        helpers.insert(call->identifier->identifier_symbol);
+      }
+      REQUIRE(helpers.size() == 1);
+
+      const auto& helper = **helpers.begin();
+      auto refs = index.references(helper);
+      return Seen{ { refs.begin(), refs.end() }, helper.ref_count, app.get_symbol_storage().size(), helper.id };
+    };
+
+    auto serial = resolve_with(1);
+    auto parallel = resolve_with(8);
+    CHECK(serial.ref_count == 100);
+    CHECK(parallel.ref_count == serial.ref_count);
+    CHECK(parallel.references == serial.references);
+    CHECK(parallel.symbols == serial.symbols);
+    CHECK(resolve_with(8).helper_id == parallel.helper_id);
+  }
+}
@@ -0,0 +1,177 @@
+#include <doctest/doctest.h>
+
+#include "fixtures.hpp"
+
+#include <ether/ast/print/print.hpp>
+#include <ether/ast/symbol_resolver/symbol_resolver.hpp>
+#include <ether/module/module.hpp>
+#include <ether/nodes/node_snapshot.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ether::test;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Snapshot bytes copied into 8-byte aligned storage, as a mapping would be.
+struct Buffer {
+  std::vector<uint64_t> words;
+  size_t size;
+
+  explicit Buffer(const std::string& bytes)
+  : words((bytes.size() + 7) / 8), size(bytes.size()) {
+    std::memcpy(words.data(), bytes.data(), bytes.size());
+  }
+  std::span<const std::byte> bytes() const {
+    return { reinterpret_cast<const std::byte*>(words.data()), size };
+  }
+};
+
+std::string read_file(const fs::path& path) {
+  std::ifstream f(path, std::ios::binary);
+  std::stringstream ss;
+  ss << f.rdbuf();
+  return ss.str();
+}
+
+// Parses and resolves, so the tree carries the poison flags a real check
+// leaves behind.
+std::unique_ptr<Module> checked(const std::string& path, const std::string& source) {
+  auto mod = std::make_unique<Module>(path, source);
+  mod->generate_ast();
+  SymbolResolver resolver(mod->get_symbol_storage(), mod->get_diag_engine());
+  mod->resolve(resolver);
+  return mod;
+}
+
+std::string print_tree(Parent& root) {
+  std::ostringstream out;
+  TreePrinter printer(out);
+  for (auto& child : root.children) child->accept(printer);
+  return out.str();
+}
+
+std::vector<fs::path> sample_files() {
+  std::vector<fs::path> files;
+  for (const auto& entry : fs::recursive_directory_iterator(ETHER_TEST_SAMPLES_DIR)) {
+    if (entry.path().extension() == ".bz") files.push_back(entry.path());
+  }
+  std::ranges::sort(files);
+  return files;
+}
+
+std::string snapshot_of(const std::string& source) {
+  auto mod = checked("test.bz", source);
+  return write_ast_snapshot(mod->get_root(), 7);
+}
+
+}  // namespace
+
+TEST_SUITE("nodes / snapshot") {
+  TEST_CASE("every sample round-trips through a snapshot") {
+    auto files = sample_files();
+    REQUIRE(files.size() >= 8);
+
+    for (const auto& file : files) {
+      auto mod = checked(file.string(), read_file(file));
+      auto bytes = write_ast_snapshot(mod->get_root(), 1);
+
+      Buffer buf(bytes);
+      auto view = AstSnapshotView::parse(buf.bytes());
+      REQUIRE_MESSAGE(view, file.string());
+      CHECK(view->roots().size() == mod->get_root().children.size());
+
+      auto copy = view->materialize();
+      CHECK_MESSAGE(print_tree(copy) == print_tree(mod->get_root()), file.string());
+      // Positions and types aren't printed; writing the copy again covers them.
+      CHECK_MESSAGE(write_ast_snapshot(copy, 1) == bytes, file.string());
+    }
+  }
+
+  TEST_CASE("the view reads nodes and tokens in place") {
+    Buffer buf(snapshot_of("func add(a: Int, b) :> Int\n  a + b\nend\n"));
+    auto view = AstSnapshotView::parse(buf.bytes());
+    REQUIRE(view);
+    CHECK(view->source_hash() == 7);
+
+    REQUIRE(view->roots().size() == 1);
+    const auto& func = view->nodes()[view->roots()[0]];
+    CHECK(func.kind == static_cast<uint16_t>(SnapshotKind::FuncDecl));
+    CHECK(view->str(view->tokens()[func.token].value) == "add");
+
+    // Return type, then a (name, type) pair per parameter.
+    auto toks = view->links(func.tokens);
+    REQUIRE(toks.size() == 5);
+    CHECK(view->token(toks[0]).token_value == "Int");
+    CHECK(view->token(toks[1]).token_value == "a");
+    CHECK(toks[4] == snapshot_none);
+
+    auto body = view->links(func.children);
+    REQUIRE(body.size() == 1);
+    auto op = view->token(view->nodes()[body[0]].token);
+    CHECK(op.token_value == "+");
+    CHECK(op.line_number == 2);
+    CHECK(op.column_number == 5);
+    CHECK(op.offset == 31);
+  }
+
+  TEST_CASE("poison flags survive a round trip") {
+    Buffer buf(snapshot_of("const one = 1\nLoad lib\n"));
+    auto view = AstSnapshotView::parse(buf.bytes());
+    REQUIRE(view);
+    CHECK(std::ranges::any_of(view->nodes(), [](const SnapshotNode& n) { return n.flags & snapshot_poisoned; }));
+  }
+
+  TEST_CASE("an empty module is a valid snapshot") {
+    Buffer buf(write_ast_snapshot(Parent{}, 0));
+    auto view = AstSnapshotView::parse(buf.bytes());
+    REQUIRE(view);
+    CHECK(view->nodes().empty());
+    CHECK(view->materialize().children.empty());
+  }
+
+  TEST_CASE("truncated snapshots are rejected") {
+    auto good = snapshot_of("func main()\n  1\nend\n");
+    Buffer buf(good.substr(0, good.size() - 1));
+    CHECK_FALSE(AstSnapshotView::parse(buf.bytes()));
+  }
+
+  TEST_CASE("a child link back to an ancestor is rejected") {
+    auto bad = snapshot_of("func main()\n  1 + 2\nend\n");
+    SnapshotHeader header;
+    std::memcpy(&header, bad.data(), sizeof header);
+
+    // Point the function's body at the function itself.
+    size_t links_at = sizeof(SnapshotHeader) + header.node_count * sizeof(SnapshotNode)
+                    + header.token_count * sizeof(SnapshotToken);
+    SnapshotNode func;
+    std::memcpy(&func, bad.data() + sizeof(SnapshotHeader), sizeof func);
+    REQUIRE(func.children.count == 1);
+    uint32_t self = 0;
+    std::memcpy(bad.data() + links_at + func.children.first * sizeof(uint32_t), &self, sizeof self);
+
+    Buffer buf(bad);
+    CHECK_FALSE(AstSnapshotView::parse(buf.bytes()));
+  }
+
+  TEST_CASE("a node with the wrong shape is rejected") {
+    auto bad = snapshot_of("const one = 1\n");
+    // ConstExpr is node 0; turn it into a BinaryExpr, which needs an op.
+    SnapshotNode node;
+    std::memcpy(&node, bad.data() + sizeof(SnapshotHeader), sizeof node);
+    node.kind = static_cast<uint16_t>(SnapshotKind::BinaryExpr);
+    std::memcpy(bad.data() + sizeof(SnapshotHeader), &node, sizeof node);
+
+    Buffer buf(bad);
+    CHECK_FALSE(AstSnapshotView::parse(buf.bytes()));
+  }
+}
@@ -299,4 +299,39 @@ TEST_SUITE("parser / recovery") {
     }
     CHECK(found_let);
   }
+
+  TEST_CASE("parsing stops early once the parser's limit is reached") {
+    std::string source = "let a = 1\n";
+    for (int i = 0; i < 10; ++i) source += "let x 1\nlet y = 2\n";
+
+    DiagnosticEngine all;
+    auto full = parse_source(source, all);
+    REQUIRE(full.has_value());
+    REQUIRE(all.all().size() >= 10);
+
+    DiagnosticEngine diag;
+    diag.set_limits({ .per_phase = 3, .stop_early = true });
+    auto p = parse_source(source, diag);
+    REQUIRE(p.has_value());
+    CHECK(diag.all().size() == 3);
+    CHECK(p->children.size() < full->children.size());
+  }
+}
+
+TEST_SUITE("parser / cancellation") {
+  TEST_CASE("a cancelled parse stops before the next top-level item") {
+    DiagnosticEngine diag;
+    Lexer lex("let x = 1\nlet y = 2\n", diag);
+    lex.scan_tokens();
+
+    std::stop_source stop;
+    stop.request_stop();
+    ParserState state(diag);
+    state.set_state(lex.get_tokens());
+    state.cancel = CancellationToken(stop.get_token());
+    auto p = run_parser(state);
+    REQUIRE(p.has_value());
+    CHECK(p->children.empty());
+    CHECK(state.pos == 0);
+  }
 }
@@ -0,0 +1,145 @@
+#include <doctest/doctest.h>
+
+#include "fixtures.hpp"
+
+#include <ether/module/module_loader.hpp>
+#include <ether/module/pass_manager.hpp>
+#include <ether/support/alloc_stats.hpp>
+
+#include <filesystem>
+#include <format>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ether::test;
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const std::string program =
+  "func twice(n: Int) :> Int\n"
+  "  n * 2\n"
+  "end\n"
+  "\n"
+  "let x = twice(4)\n";
+
+// lex and parse, then a pass that only records that it ran.
+void add_front_end(PassManager& pm, std::vector<std::string>& ran) {
+  pm.add("lex", [&](Module& mod) { ran.push_back("lex"); mod.lex(); });
+  pm.add("parse", [&](Module& mod) { ran.push_back("parse"); mod.parse(); });
+  pm.add("noop", [&](Module&) { ran.push_back("noop"); });
+}
+
+}  // namespace
+
+TEST_SUITE("module / pass manager") {
+  TEST_CASE("passes run in order, up to the one to stop after") {
+    std::vector<std::string> ran;
+    PassManager pm;
+    add_front_end(pm, ran);
+    CHECK(pm.contains("parse"));
+    CHECK_FALSE(pm.contains("resolve"));
+    CHECK(pm.runs("noop"));
+
+    Module mod("test.bz", program);
+    pm.run(mod);
+    CHECK(ran == std::vector<std::string>{ "lex", "parse", "noop" });
+    CHECK(mod.get_root().children.size() == 2);
+
+    ran.clear();
+    REQUIRE(pm.stop_after("parse"));
+    CHECK(pm.runs("parse"));
+    CHECK_FALSE(pm.runs("noop"));
+    Module again("test.bz", program);
+    pm.run(again);
+    CHECK(ran == std::vector<std::string>{ "lex", "parse" });
+  }
+
+  TEST_CASE("an unknown pass to stop after changes nothing") {
+    std::vector<std::string> ran;
+    PassManager pm;
+    add_front_end(pm, ran);
+    CHECK_FALSE(pm.stop_after("codegen"));
+    CHECK(pm.runs("noop"));
+  }
+
+  TEST_CASE("stats add up over modules") {
+    std::vector<std::string> ran;
+    PassManager pm;
+    add_front_end(pm, ran);
+    pm.enable_stats();
+    // So that recording a run allocates nothing.
+    ran.reserve(16);
+
+    for (int i = 0; i < 3; ++i) {
+      Module mod("test.bz", program);
+      pm.run(mod);
+    }
+
+    auto stats = pm.stats();
+    REQUIRE(stats.size() == 3);
+    CHECK(stats[0].name == "lex");
+    for (const auto& s : stats) CHECK(s.modules == 3);
+
+    // twice, n * 2, n, 2, let, x, twice(4), twice, 4
+    CHECK(stats[0].nodes == 0);
+    CHECK(stats[1].nodes == 3 * 9);
+    CHECK(stats[2].nodes == 3 * 9);
+
+    if (alloc_counting_enabled()) {
+      CHECK(stats[1].allocations > 0);
+      CHECK(stats[1].allocated_bytes > 0);
+    }
+    CHECK(stats[2].allocations == 0);
+
+    std::ostringstream out;
+    pm.print_stats(out);
+    CHECK(out.str().find("parse") != std::string::npos);
+    CHECK(out.str().find("total") != std::string::npos);
+  }
+
+  TEST_CASE("stats stay empty unless enabled") {
+    std::vector<std::string> ran;
+    PassManager pm;
+    add_front_end(pm, ran);
+    Module mod("test.bz", program);
+    pm.run(mod);
+    for (const auto& s : pm.stats()) CHECK(s.modules == 0);
+  }
+
+  TEST_CASE("the loader stops after parsing and leaves the cache alone") {
+    fs::path root = fs::path(ETHER_TEST_SAMPLES_DIR) / "project";
+    auto cache_dir = fs::temp_directory_path() / std::format("ether_passes_{}", std::random_device{}());
+
+    ModuleLoader loader(root, LoaderOptions{ .cache_dir = cache_dir, .stop_after = "parse", .time_passes = true });
+    REQUIRE(loader.add_entry(root / "main.bz"));
+    loader.load();
+
+    REQUIRE(loader.modules().size() == 3);
+    for (const auto& loaded : loader.modules()) {
+      CHECK_FALSE(loaded.module->get_root().children.empty());
+      CHECK(loaded.module->get_exported_symbols().empty());
+    }
+    CHECK_FALSE(fs::exists(cache_dir));
+
+    auto stats = loader.get_passes().stats();
+    REQUIRE(stats.size() == 5);
+    CHECK(stats[1].name == "parse");
+    CHECK(stats[1].modules == 3);
+    CHECK(stats[2].modules == 0);
+  }
+
+  TEST_CASE("the loader runs every pass by default") {
+    fs::path root = fs::path(ETHER_TEST_SAMPLES_DIR) / "project";
+    ModuleLoader loader(root);
+    REQUIRE(loader.add_entry(root / "main.bz"));
+    loader.load();
+
+    std::vector<std::string> all{ "lex", "parse", "resolve", "type-check", "fold" };
+    CHECK_EQ(loader.get_passes().names(), all);
+    CHECK(loader.find("lib.math")->get_exported_symbols().contains("square"));
+  }
+}
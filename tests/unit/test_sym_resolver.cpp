@@ -6,8 +6,13 @@
 #include <ether/diagnostics/diagnostic_eng.hpp>
 #include <ether/module/module.hpp>
 #include <ether/nodes/node_expr.hpp>
+#include <ether/support/line_index.hpp>
 
+#include <algorithm>
+#include <format>
 #include <memory>
+#include <string>
+#include <vector>
 
 using namespace ether::test;
 
@@ -35,6 +40,51 @@ ResolvedModule resolve(const std::string& src) {
   return rm;
 }
 
+ResolvedModule resolve_parallel(const std::string& src, size_t jobs) {
+  ResolvedModule rm;
+  rm.module = std::make_unique<Module>("<test>", src);
+  rm.module->generate_ast();
+  rm.resolver = std::make_unique<SymbolResolver>(
+    rm.module->get_symbol_storage(),
+    rm.module->get_diag_engine()
+  );
+  rm.module->resolve(*rm.resolver, jobs);
+  rm.exports = rm.resolver->take_exports();
+  return rm;
+}
+
+// `count` functions, each calling the one declared before it; every tenth
+// body also contains a duplicate `let` so there is something to report.
+std::string many_functions(size_t count) {
+  std::string src = "func f0()\n  1\nend\n";
+  for (size_t i = 1; i < count; ++i) {
+    src += std::format("func f{}(a, b)\n  let x = a\n", i);
+    if (i % 10 == 0) src += "  let x = b\n";
+    src += std::format("  f{}()\nend\n", i - 1);
+  }
+  return src;
+}
+
+ResolvedModule resolve_with_unused(const std::string& src, size_t jobs = 1) {
+  ResolvedModule rm;
+  rm.module = std::make_unique<Module>("<test>", src);
+  rm.module->generate_ast();
+  rm.resolver = std::make_unique<SymbolResolver>(
+    rm.module->get_symbol_storage(),
+    rm.module->get_diag_engine()
+  );
+  rm.module->resolve(*rm.resolver, jobs);
+  rm.resolver->report_unused_symbols();
+  rm.exports = rm.resolver->take_exports();
+  return rm;
+}
+
+std::vector<std::string> messages(const ResolvedModule& rm) {
+  std::vector<std::string> out;
+  for (const auto& d : rm.module->get_diag_engine().all()) out.push_back(d.message);
+  return out;
+}
+
 template <typename T>
 T* first_of(Parent& p) {
   for (auto& c : p.children) {
@@ -132,4 +182,178 @@ TEST_SUITE("sym_res / function calls") {
     );
     CHECK_FALSE(rm.has_errors());
   }
+
+  TEST_CASE("calling a function declared later succeeds") {
+    auto rm = resolve(
+      "func f()\n  g()\nend\n"
+      "func g()\n  1\nend"
+    );
+    CHECK_FALSE(rm.has_errors());
+
+    auto ast = rm.module->get_ast();
+    auto* f = first_of<NDFuncDeclExpr>(ast);
+    REQUIRE(f);
+    auto* call = dynamic_cast<NDCallExpr*>(f->func_body[0].get());
+    REQUIRE(call);
+    CHECK(call->identifier->identifier_symbol == rm.exports.at("g"));
+  }
+
+  TEST_CASE("a const may be referenced before its declaration") {
+    auto rm = resolve("func f()\n  limit\nend\nconst limit = 3");
+    CHECK_FALSE(rm.has_errors());
+
+    auto ast = rm.module->get_ast();
+    auto* f = first_of<NDFuncDeclExpr>(ast);
+    REQUIRE(f);
+    auto* ident = dynamic_cast<NDIdentifier*>(f->func_body[0].get());
+    REQUIRE(ident);
+    CHECK(ident->identifier_symbol == rm.exports.at("limit"));
+  }
+
+  TEST_CASE("nested functions are not hoisted") {
+    auto rm = resolve(
+      "func f()\n"
+      "  g()\n"
+      "  func g()\n    1\n  end\n"
+      "end"
+    );
+    CHECK(rm.has_errors());
+  }
+
+  TEST_CASE("the later of two duplicate declarations is the one reported") {
+    auto rm = resolve("func f()\n  1\nend\nfunc f()\n  2\nend");
+    const auto& diags = rm.module->get_diag_engine().all();
+    REQUIRE(diags.size() == 1);
+    CHECK(LineIndex(rm.module->get_source()).position(diags[0].range.begin).line == 4);
+
+    auto ast = rm.module->get_ast();
+    auto* second = dynamic_cast<NDFuncDeclExpr*>(ast.children[1].get());
+    REQUIRE(second);
+    CHECK(second->is_poisoned);
+    CHECK(second->func_sym == nullptr);
+  }
+}
+
+TEST_SUITE("sym_res / parallel resolution") {
+  TEST_CASE("parallel resolution matches serial diagnostics and exports") {
+    auto src = many_functions(500);
+    auto serial = resolve_parallel(src, 1);
+    auto parallel = resolve_parallel(src, 4);
+
+    CHECK(serial.exports.size() == 500);
+    CHECK(parallel.exports.size() == serial.exports.size());
+    CHECK(messages(parallel) == messages(serial));
+    CHECK(messages(parallel).size() == 49);
+  }
+
+  TEST_CASE("parallel resolution links calls to module-level functions") {
+    auto rm = resolve_parallel(many_functions(100), 4);
+    auto ast = rm.module->get_ast();
+
+    size_t linked = 0;
+    for (auto& child : ast.children) {
+      auto* func = dynamic_cast<NDFuncDeclExpr*>(child.get());
+      REQUIRE(func);
+      CHECK(func->func_sym == rm.exports.at(func->func_identifier.token_value));
+      for (auto& body : func->func_body) {
+        auto* call = dynamic_cast<NDCallExpr*>(body.get());
+        if (!call) continue;
+        REQUIRE(call->identifier->identifier_symbol);
+        CHECK(call->identifier->identifier_symbol->symbol_kind == SymbolKind::Function);
+        ++linked;
+      }
+    }
+    CHECK(linked == 99);
+  }
+
+  TEST_CASE("forward references resolve alike with one job and many") {
+    // Each function calls the one declared after it.
+    std::string src;
+    for (size_t i = 0; i < 100; ++i) src += std::format("func f{}()\n  f{}()\nend\n", i, i + 1);
+    src += "func f100()\n  1\nend\n";
+
+    for (size_t jobs : { 1, 8 }) {
+      auto rm = resolve_parallel(src, jobs);
+      CHECK_FALSE(rm.has_errors());
+      CHECK(rm.exports.at("f100")->ref_count == 1);
+    }
+  }
+
+  TEST_CASE("symbols declared in parallel bodies land in the module arena") {
+    auto rm = resolve_parallel(many_functions(100), 4);
+    // 100 functions + 2 params and one `let` in each of the 99 callers.
+    CHECK(rm.module->get_symbol_storage().size() == 100 + 99 * 3);
+  }
+
+  TEST_CASE("scope errors are still reported from parallel bodies") {
+    auto rm = resolve_parallel("func f()\n  const x = 1\nend\nfunc g()\n  f()\nend", 2);
+    CHECK(rm.has_errors());
+  }
+}
+
+TEST_SUITE("sym_res / unused symbols") {
+  TEST_CASE("unused let binding is a warning, not an error") {
+    auto rm = resolve_with_unused("func main()\n  let x = 1\nend\nfunc f()\n  main()\nend");
+    CHECK_FALSE(rm.has_errors());
+    auto msgs = messages(rm);
+    CHECK(std::ranges::count(msgs, std::string("Unused binding `x`")) == 1);
+
+    for (const auto& d : rm.module->get_diag_engine().all()) {
+      CHECK(d.level == DiagnosticLevel::Warn);
+    }
+  }
+
+  TEST_CASE("read bindings and parameters are not reported") {
+    auto rm = resolve_with_unused(
+      "func f(a)\n"
+      "  let x = a\n"
+      "  x\n"
+      "end\n"
+      "func g()\n  f(1)\nend"
+    );
+    auto msgs = messages(rm);
+    CHECK(std::ranges::count(msgs, std::string("Unused binding `x`")) == 0);
+    CHECK(std::ranges::count(msgs, std::string("Unused function parameter `a`")) == 0);
+  }
+
+  TEST_CASE("only the unread parameter is reported") {
+    auto rm = resolve_with_unused("func f(a, b)\n  b\nend\nfunc g()\n  f(1, 2)\nend");
+    auto msgs = messages(rm);
+    CHECK(std::ranges::count(msgs, std::string("Unused function parameter `a`")) == 1);
+    CHECK(std::ranges::count(msgs, std::string("Unused function parameter `b`")) == 0);
+  }
+
+  TEST_CASE("only never-called top-level functions are reported") {
+    auto rm = resolve_with_unused(
+      "func used()\n  1\nend\n"
+      "func unused()\n  used()\nend"
+    );
+    auto msgs = messages(rm);
+    CHECK(std::ranges::count(msgs, std::string("Function `unused` is never called")) == 1);
+    CHECK(std::ranges::count(msgs, std::string("Function `used` is never called")) == 0);
+  }
+
+  TEST_CASE("main is not reported as never called") {
+    auto rm = resolve_with_unused(
+      "func helper()\n  1\nend\n"
+      "func main()\n  helper()\nend"
+    );
+    CHECK(messages(rm).empty());
+  }
+
+  TEST_CASE("reference counts agree between serial and parallel resolution") {
+    auto src = many_functions(300);
+    auto serial = resolve_with_unused(src, 1);
+    auto parallel = resolve_with_unused(src, 4);
+
+    auto sorted = [](std::vector<std::string> v) {
+      std::ranges::sort(v);
+      return v;
+    };
+    CHECK(sorted(messages(parallel)) == sorted(messages(serial)));
+    CHECK(serial.exports.at("f0")->ref_count == 1);
+    CHECK(parallel.exports.at("f0")->ref_count == 1);
+    CHECK(parallel.exports.at("f298")->ref_count == 1);
+    CHECK(parallel.exports.at("f299")->ref_count == 0);
+  }
 }
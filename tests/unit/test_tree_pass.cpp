@@ -0,0 +1,164 @@
+#include <doctest/doctest.h>
+
+#include "fixtures.hpp"
+
+#include <ether/module/module.hpp>
+#include <ether/nodes/tree_pass.hpp>
+
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace ether::test;
+
+namespace {
+
+const std::string program =
+  "func twice(n: Int) :> Int\n"
+  "  n * 2\n"
+  "end\n"
+  "\n"
+  "let x = twice(4)\n";
+
+// Logs its hooks as "<name>+<kind>" and "<name>-<kind>".
+class LoggingPass : public TreePass {
+public:
+  LoggingPass(std::string name, std::vector<std::string>& log, std::vector<std::string_view> deps = {})
+  : pass_name(std::move(name)), log(log), deps(std::move(deps)) {}
+
+  std::string_view name() const override { return this->pass_name; }
+  std::vector<std::string_view> after() const override { return this->deps; }
+
+  void begin_module(Parent&) override { this->log.push_back(this->pass_name + " begin"); }
+  void end_module(Parent&) override { this->log.push_back(this->pass_name + " end"); }
+
+  void enter(NDFuncDeclExpr&) override { this->log.push_back(this->pass_name + "+func"); }
+  void exit(NDFuncDeclExpr&) override { this->log.push_back(this->pass_name + "-func"); }
+  void enter(NDIdentifier&) override { this->log.push_back(this->pass_name + "+id"); }
+  void exit(NDIdentifier&) override { this->log.push_back(this->pass_name + "-id"); }
+
+private:
+  std::string pass_name;
+  std::vector<std::string>& log;
+  std::vector<std::string_view> deps;
+};
+
+// Counts identifiers; a pass scheduled after it reads the total.
+class IdentifierCount final : public TreePass {
+public:
+  size_t count = 0;
+  std::string_view name() const override { return "ids"; }
+  void enter(NDIdentifier&) override { this->count++; }
+};
+
+class ReadsCount final : public TreePass {
+public:
+  explicit ReadsCount(const IdentifierCount& ids) : ids(ids) {}
+  size_t seen = 0;
+  std::string_view name() const override { return "reads"; }
+  std::vector<std::string_view> after() const override { return { "ids" }; }
+  void begin_module(Parent&) override { this->seen = this->ids.count; }
+
+private:
+  const IdentifierCount& ids;
+};
+
+class CountAll final : public TreePass {
+public:
+  size_t entered = 0, exited = 0;
+  std::string_view name() const override { return "all"; }
+  void enter(Node&) override { this->entered++; }
+  void exit(Node&) override { this->exited++; }
+};
+
+Parent parsed(const std::string& source) {
+  Module mod("test.bz", source);
+  mod.generate_ast();
+  return mod.get_ast();
+}
+
+}  // namespace
+
+TEST_SUITE("nodes / tree passes") {
+  TEST_CASE("passes share one walk, entering in order and exiting in reverse") {
+    auto root = parsed("func f()\n  g\nend\n");
+    std::vector<std::string> log;
+    LoggingPass a("a", log), b("b", log);
+    REQUIRE(run_tree_passes(root, { &a, &b }));
+
+    std::vector<std::string> expected{
+      "a begin", "b begin",
+      "a+func", "b+func",
+      "a+id", "b+id", "b-id", "a-id",
+      "b-func", "a-func",
+      "a end", "b end",
+    };
+    CHECK_EQ(log, expected);
+  }
+
+  TEST_CASE("a pass runs after the ones it names, in a later walk") {
+    std::vector<std::string> log;
+    LoggingPass a("a", log), b("b", log, { "a" }), c("c", log), d("d", log, { "b", "unknown" });
+    auto walks = schedule_tree_passes({ &a, &b, &c, &d });
+    CHECK_EQ(walks, std::vector<size_t>({ 0, 1, 0, 2 }));
+
+    // Passes attached later count too.
+    LoggingPass first("first", log, { "second" }), second("second", log, { "third" }), third("third", log);
+    CHECK_EQ(schedule_tree_passes({ &first, &second, &third }), std::vector<size_t>({ 2, 1, 0 }));
+  }
+
+  TEST_CASE("a pass named by one attached before it still runs first") {
+    auto root = parsed(program);
+    IdentifierCount ids;
+    ReadsCount reads(ids);
+    REQUIRE(run_tree_passes(root, { &reads, &ids }));
+    CHECK(ids.count > 0);
+    CHECK(reads.seen == ids.count);
+  }
+
+  TEST_CASE("passes that name each other in a cycle are rejected") {
+    std::vector<std::string> log;
+    LoggingPass a("a", log, { "b" }), b("b", log, { "a" }), self("self", log, { "self" });
+    std::vector<TreePass*> cycle{ &a, &b }, loop{ &self };
+    CHECK_THROWS_AS(schedule_tree_passes(cycle), std::invalid_argument);
+    CHECK_THROWS_AS(schedule_tree_passes(loop), std::invalid_argument);
+
+    auto root = parsed(program);
+    CHECK_THROWS_AS(run_tree_passes(root, cycle), std::invalid_argument);
+    CHECK(log.empty());
+  }
+
+  TEST_CASE("a dependent pass sees the whole module done") {
+    auto root = parsed(program);
+    IdentifierCount ids;
+    ReadsCount reads(ids);
+    REQUIRE(run_tree_passes(root, { &ids, &reads }));
+    CHECK(ids.count > 0);
+    CHECK(reads.seen == ids.count);
+  }
+
+  TEST_CASE("the Node& hooks see every node") {
+    auto root = parsed(program);
+    CountAll all;
+    REQUIRE(run_tree_passes(root, { &all }));
+    // twice, n * 2, n, 2, let, x, twice(4), twice, 4
+    CHECK(all.entered == 9);
+    CHECK(all.exited == 9);
+  }
+
+  TEST_CASE("attached passes run with the visitors and stop when cancelled") {
+    Module mod("test.bz", program);
+    mod.generate_ast();
+    CountAll all;
+    mod.attach_pass(all);
+    CHECK(mod.apply_visitors());
+    CHECK(all.entered == 9);
+
+    std::stop_source stop;
+    stop.request_stop();
+    CHECK_FALSE(mod.apply_visitors(CancellationToken(stop.get_token())));
+    CHECK(all.entered == 9);
+  }
+}
@@ -0,0 +1,304 @@
+#include <doctest/doctest.h>
+
+#include "fixtures.hpp"
+
+#include <ether/ast/symbol_resolver/symbol_resolver.hpp>
+#include <ether/ast/type_check/type_check.hpp>
+#include <ether/module/module.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace ether::test;
+
+namespace {
+
+struct CheckedModule {
+  std::unique_ptr<Module> module;
+  std::unique_ptr<TypeChecker> checker;
+  std::unordered_map<std::string, SymbolAttr*> exports;
+
+  std::string type_of(const std::string& name) const {
+    auto it = this->exports.find(name);
+    return it == this->exports.end() ? "<none>" : this->checker->type_of(*it->second);
+  }
+
+  std::vector<std::string> errors() const {
+    std::vector<std::string> out;
+    for (const auto& d : this->module->get_diag_engine().all()) {
+      if (d.phase == DiagnosticPhase::TypeChecker) out.push_back(d.message);
+    }
+    return out;
+  }
+};
+
+CheckedModule check(const std::string& src, size_t jobs = 1) {
+  CheckedModule cm;
+  cm.module = std::make_unique<Module>("<test>", src);
+  cm.module->generate_ast();
+  SymbolResolver resolver(cm.module->get_symbol_storage(), cm.module->get_diag_engine());
+  cm.module->attach_visitor(resolver);
+  cm.module->apply_visitors();
+  cm.exports = resolver.take_exports();
+
+  cm.checker = std::make_unique<TypeChecker>(cm.module->get_diag_engine(), jobs);
+  cm.checker->check_module(cm.module->get_root());
+  return cm;
+}
+
+}  // namespace
+
+TEST_SUITE("type check / inference") {
+  TEST_CASE("literals, operators and lets") {
+    auto cm = check(
+      "const limit = 10\n"
+      "func name()\n"
+      "  let s = \"ether\" + \"!\"\n"
+      "  s\n"
+      "end\n"
+      "func big()\n"
+      "  limit * 2 > 3\n"
+      "end\n"
+      "func ratio()\n"
+      "  let r: Float = 0.5\n"
+      "  r\n"
+      "end\n"
+      "func nothing()\n"
+      "end\n"
+    );
+    CHECK(cm.errors().empty());
+    CHECK_EQ(cm.type_of("limit"), "Int");
+    CHECK_EQ(cm.type_of("name"), "() :> String");
+    CHECK_EQ(cm.type_of("big"), "() :> Bool");
+    CHECK_EQ(cm.type_of("ratio"), "() :> Float");
+    CHECK_EQ(cm.type_of("nothing"), "() :> Nil");
+  }
+
+  TEST_CASE("annotations that disagree with the value are reported") {
+    auto cm = check(
+      "func f()\n"
+      "  let n: Int = \"one\"\n"
+      "  n\n"
+      "end\n"
+      "func g() :> String\n"
+      "  1\n"
+      "end\n"
+    );
+    std::vector<std::string> expected{
+      "Type mismatch: expected `Int`, found `String`",
+      "Type mismatch: expected `String`, found `Int`",
+    };
+    CHECK_EQ(cm.errors(), expected);
+    CHECK_EQ(cm.type_of("f"), "() :> Int");
+    CHECK_EQ(cm.type_of("g"), "() :> String");
+  }
+
+  TEST_CASE("functions are generalized") {
+    auto cm = check(
+      "func id(x)\n"
+      "  x\n"
+      "end\n"
+      "func first(a, b)\n"
+      "  a\n"
+      "end\n"
+      "func uses()\n"
+      "  let n = id(1) + 2\n"
+      "  let s = id(\"a\") + \"b\"\n"
+      "  first(n, s)\n"
+      "end\n"
+    );
+    CHECK(cm.errors().empty());
+    CHECK_EQ(cm.type_of("id"), "('a) :> 'a");
+    CHECK_EQ(cm.type_of("first"), "('a, 'b) :> 'a");
+    CHECK_EQ(cm.type_of("uses"), "() :> Int");
+  }
+
+  TEST_CASE("functions may be used before they are declared, and recursively") {
+    auto cm = check(
+      "func early()\n"
+      "  twice(3)\n"
+      "end\n"
+      "func twice(n)\n"
+      "  n * 2\n"
+      "end\n"
+      "func ping(n)\n"
+      "  let m = n - 1\n"
+      "  pong(m)\n"
+      "end\n"
+      "func pong(n)\n"
+      "  let m = n * 2\n"
+      "  ping(m)\n"
+      "end\n"
+    );
+    CHECK(cm.errors().empty());
+    CHECK_EQ(cm.type_of("early"), "() :> Int");
+    CHECK_EQ(cm.type_of("twice"), "(Int) :> Int");
+    CHECK_EQ(cm.type_of("ping"), "(Int) :> 'a");
+    CHECK_EQ(cm.type_of("pong"), "(Int) :> 'a");
+  }
+
+  TEST_CASE("a pipe passes each value as the next call's first argument") {
+    auto cm = check(
+      "func start()\n"
+      "  1\n"
+      "end\n"
+      "func add(a, b)\n"
+      "  a + b\n"
+      "end\n"
+      "func show(n: Int) :> String\n"
+      "  \"n\"\n"
+      "end\n"
+      "func out()\n"
+      "  start() |=> add(2) |=> show()\n"
+      "end\n"
+    );
+    CHECK(cm.errors().empty());
+    CHECK_EQ(cm.type_of("out"), "() :> String");
+
+    auto bad = check(
+      "func start()\n"
+      "  \"s\"\n"
+      "end\n"
+      "func show(n: Int)\n"
+      "  n\n"
+      "end\n"
+      "func out()\n"
+      "  start() |=> show()\n"
+      "end\n"
+    );
+    CHECK_EQ(bad.errors(), std::vector<std::string>{ "Type mismatch: expected `Int`, found `String`" });
+  }
+
+  TEST_CASE("case branches must agree") {
+    auto cm = check(
+      "func f(b: Bool)\n"
+      "  case b:\n"
+      "    True :> 1\n"
+      "    False :> \"no\"\n"
+      "  end\n"
+      "end\n"
+    );
+    CHECK_EQ(cm.errors(), std::vector<std::string>{ "Type mismatch: expected `Int`, found `String`" });
+    CHECK_EQ(cm.type_of("f"), "(Bool) :> Int");
+  }
+
+  TEST_CASE("operators reject the wrong operand types") {
+    auto cm = check(
+      "func f()\n"
+      "  let a = \"a\" - \"b\"\n"
+      "  let b = 1 + \"b\"\n"
+      "  let c = 1 && True\n"
+      "  let d = ~3\n"
+      "end\n"
+    );
+    std::vector<std::string> expected{
+      "`-` is not defined for `String`",
+      "`+` needs operands of one type, found `Int` and `String`",
+      "Type mismatch: expected `Bool`, found `Int`",
+      "Type mismatch: expected `Bool`, found `Int`",
+    };
+    CHECK_EQ(cm.errors(), expected);
+  }
+
+  TEST_CASE("an operator on a type left open is not reported") {
+    auto cm = check(
+      "func neg(x)\n"
+      "  -x\n"
+      "end\n"
+      "func f()\n"
+      "  neg(1)\n"
+      "end\n"
+    );
+    CHECK(cm.errors().empty());
+    CHECK_EQ(cm.type_of("neg"), "('a) :> 'a");
+    CHECK_EQ(cm.type_of("f"), "() :> Int");
+  }
+
+  TEST_CASE("calls check arity and callee") {
+    auto cm = check(
+      "const one = 1\n"
+      "func two(a, b)\n"
+      "  a\n"
+      "end\n"
+      "func f()\n"
+      "  let x = two(1)\n"
+      "  one(2)\n"
+      "end\n"
+    );
+    std::vector<std::string> expected{
+      "`two` takes 2 arguments but 1 was given",
+      "`one` is not a function; its type is `Int`",
+    };
+    CHECK_EQ(cm.errors(), expected);
+  }
+
+  TEST_CASE("a value applied to itself is an infinite type") {
+    auto cm = check(
+      "func f(x)\n"
+      "  x(x)\n"
+      "end\n"
+    );
+    CHECK_EQ(cm.errors(), std::vector<std::string>{ "`x` cannot be called with itself as an argument" });
+  }
+
+  TEST_CASE("unresolved names do not cascade") {
+    // The shape of bench/synthetic.hpp's functions; `g` is not declared.
+    auto cm = check(
+      "const limit: Int = 10\n"
+      "func fa(a: Int, b) :> Int\n"
+      "  let x = a * 2 + -b\n"
+      "  let y = { x }\n"
+      "  g(x, y) |=> g(y, x)\n"
+      "  case x > limit:\n"
+      "    True :> x\n"
+      "    False :> y\n"
+      "  end\n"
+      "end\n"
+    );
+    CHECK(cm.errors().empty());
+    CHECK_EQ(cm.type_of("fa"), "(Int, Int) :> Int");
+  }
+
+  TEST_CASE("a recursive group is generalized once, after all of it is inferred") {
+    auto cm = check(
+      "func even(x, n)\n"
+      "  let m = n - 1\n"
+      "  odd(x, m)\n"
+      "  x\n"
+      "end\n"
+      "func odd(x, n)\n"
+      "  even(x, n)\n"
+      "end\n"
+      "func both()\n"
+      "  let a = even(1, 2)\n"
+      "  let b = odd(\"s\", 3)\n"
+      "  b + \"!\"\n"
+      "end\n"
+    );
+    CHECK(cm.errors().empty());
+    CHECK_EQ(cm.type_of("even"), "('a, Int) :> 'a");
+    CHECK_EQ(cm.type_of("odd"), "('a, Int) :> 'a");
+    CHECK_EQ(cm.type_of("both"), "() :> String");
+  }
+
+  TEST_CASE("checking components concurrently changes neither types nor diagnostics") {
+    std::string src = "const limit = 10\n";
+    for (int i = 0; i < 24; ++i) {
+      auto n = std::to_string(i);
+      src += "func f_" + n + "(a)\n  a * limit\nend\n";
+      src += "func g_" + n + "()\n  f_" + n + "(2) + \"x\"\nend\n";
+    }
+    src += "func h_0()\n  h_1(1)\nend\nfunc h_1(n)\n  h_0()\nend\n";
+
+    auto serial = check(src);
+    REQUIRE(serial.errors().size() == 24);
+    for (size_t jobs : { 2, 4, 8 }) {
+      auto parallel = check(src, jobs);
+      CHECK_EQ(parallel.errors(), serial.errors());
+      for (const auto& [name, sym] : serial.exports) CHECK_EQ(parallel.type_of(name), serial.type_of(name));
+    }
+    CHECK_EQ(serial.type_of("f_3"), "(Int) :> Int");
+    CHECK_EQ(serial.type_of("h_1"), "(Int) :> 'a");
+  }
+}
@@ -0,0 +1,78 @@
+#include <doctest/doctest.h>
+
+#include "fixtures.hpp"
+
+#include <ether/symbols/type_table.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ether::test;
+
+TEST_SUITE("symbols / TypeTable") {
+  TEST_CASE("annotations name the built-in types or a named one") {
+    TypeTable table;
+    CHECK(table.annotation("Int") == TypeTable::int_type);
+    CHECK(table.annotation("Nil") == TypeTable::nil_type);
+    CHECK(table.annotation("") == TypeTable::unknown);
+
+    auto foo = table.annotation("Foo");
+    CHECK(table.kind(foo) == TypeKind::Named);
+    CHECK(table.name(foo) == "Foo");
+    CHECK(table.annotation("Foo") == foo);
+    CHECK(table.annotation("Bar") != foo);
+  }
+
+  TEST_CASE("equal types are one entry") {
+    TypeTable table;
+    size_t before = table.size();
+    std::vector<TypeId> params{ TypeTable::int_type, table.var(0) };
+    auto f = table.function(params, table.var(0));
+    auto g = table.function(params, table.var(0));
+    CHECK(f == g);
+    CHECK(table.size() == before + 2);
+
+    CHECK(table.function(params, table.var(1)) != f);
+    CHECK(table.function({}, TypeTable::int_type) != table.function({}, TypeTable::float_type));
+    CHECK(table.params(f) == params);
+    CHECK(table.result(f) == table.var(0));
+  }
+
+  TEST_CASE("types read back from their text") {
+    TypeTable table;
+    for (std::string text : { "Int", "Foo", "'a", "'c2", "() :> Nil", "(Int, ('a) :> 'b) :> ('b, String) :> 'a" }) {
+      auto type = table.parse(text);
+      CHECK(type != TypeTable::unknown);
+      CHECK_EQ(table.to_string(type), text);
+    }
+    CHECK(table.parse("(Int") == TypeTable::unknown);
+    CHECK(table.parse("Int Float") == TypeTable::unknown);
+    CHECK(table.parse("") == TypeTable::unknown);
+  }
+
+  TEST_CASE("a type variable index too large for the table reads as unknown") {
+    TypeTable table;
+    CHECK(table.to_string(table.parse("'b165191048")) == "'b165191048");
+    CHECK(table.parse("'a99999999999999999999") == TypeTable::unknown);
+    CHECK(table.parse("'z165191049") == TypeTable::unknown);
+    CHECK(table.parse("(Int) :> 'c4294967296") == TypeTable::unknown);
+  }
+
+  TEST_CASE("threads interning the same types get the same ids") {
+    TypeTable table;
+    auto build = [&](std::vector<TypeId>& out) {
+      for (uint32_t i = 0; i < 500; ++i) {
+        std::vector<TypeId> params{ table.var(i % 7), table.named("T" + std::to_string(i % 13)) };
+        out.push_back(table.function(params, table.var(i % 5)));
+      }
+    };
+
+    std::vector<std::vector<TypeId>> seen(4);
+    {
+      std::vector<std::jthread> threads;
+      for (auto& out : seen) threads.emplace_back([&] { build(out); });
+    }
+    for (const auto& out : seen) CHECK(out == seen[0]);
+  }
+}
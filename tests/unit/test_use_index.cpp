@@ -0,0 +1,101 @@
+#include <doctest/doctest.h>
+
+#include "fixtures.hpp"
+
+#include <ether/ast/symbol_resolver/symbol_resolver.hpp>
+#include <ether/module/module.hpp>
+#include <ether/symbols/use_index.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace ether::test;
+
+namespace {
+
+struct Indexed {
+  std::unique_ptr<Module> module;
+  std::unordered_map<std::string, SymbolAttr*> exports;
+  UseDefIndex index;
+};
+
+Indexed index_source(const std::string& src, size_t jobs = 1) {
+  Indexed ix;
+  ix.module = std::make_unique<Module>("<test>", src);
+  ix.module->generate_ast();
+  SymbolResolver resolver(ix.module->get_symbol_storage(), ix.module->get_diag_engine());
+  ix.module->resolve(resolver, jobs);
+  ix.exports = resolver.take_exports();
+  ix.index = resolver.take_use_index();
+  return ix;
+}
+
+std::vector<uint32_t> refs(const Indexed& ix, const std::string& name) {
+  auto refs = ix.index.references(*ix.exports.at(name));
+  return { refs.begin(), refs.end() };
+}
+
+}  // namespace
+
+TEST_SUITE("symbols / use-def index") {
+  TEST_CASE("tokens carry their byte offset") {
+    auto toks = lex_no_eof("let  x = 1");
+    REQUIRE(toks.size() == 4);
+    CHECK(toks[0].offset == 0);
+    CHECK(toks[1].offset == 5);
+    CHECK(toks[3].offset == 9);
+  }
+
+  TEST_CASE("references of a function are its call sites in source order") {
+    //                 0         1         2         3         4
+    //                 0123456789012345678901234567890123456789012345
+    auto ix = index_source("func g()\n  1\nend\nfunc f()\n  g()\n  g()\nend");
+    CHECK(refs(ix, "g") == std::vector<uint32_t>{ 28, 34 });
+    CHECK(refs(ix, "f").empty());
+    CHECK(ix.index.size() == 2);
+  }
+
+  TEST_CASE("identifier references to constants and bindings are indexed") {
+    auto ix = index_source(
+      "const limit = 3\n"
+      "func f(a)\n"
+      "  let x = limit\n"
+      "  x\n"
+      "end"
+    );
+    CHECK(refs(ix, "limit").size() == 1);
+    CHECK(ix.index.size() == 2);
+
+    auto ast = ix.module->get_ast();
+    auto* f = dynamic_cast<NDFuncDeclExpr*>(ast.children[1].get());
+    REQUIRE(f);
+    REQUIRE(f->func_params[0].param_sym);
+    CHECK(ix.index.is_unused(*f->func_params[0].param_sym));
+
+    auto* let = dynamic_cast<NDLetBindExpr*>(f->func_body[0].get());
+    REQUIRE(let);
+    REQUIRE(let->identifier->identifier_symbol);
+    CHECK(ix.index.reference_count(*let->identifier->identifier_symbol) == 1);
+  }
+
+  TEST_CASE("parallel resolution produces the same index as serial") {
+    std::string src = "func f0()\n  1\nend\n";
+    for (int i = 1; i < 200; ++i) {
+      src += "func f" + std::to_string(i) + "()\n  f0()\n  f" + std::to_string(i - 1) + "()\nend\n";
+    }
+    auto serial = index_source(src, 1);
+    auto parallel = index_source(src, 4);
+
+    CHECK(parallel.index.size() == serial.index.size());
+    CHECK(refs(parallel, "f0") == refs(serial, "f0"));
+    CHECK(refs(parallel, "f0").size() == 200);
+    CHECK(refs(parallel, "f198") == refs(serial, "f198"));
+  }
+
+  TEST_CASE("index memory is one word per symbol and reference") {
+    auto ix = index_source("func g()\n  1\nend\nfunc f()\n  g()\nend");
+    CHECK(ix.index.memory_bytes() >= (ix.index.symbol_count() + 1 + ix.index.size()) * 4);
+    CHECK(ix.index.symbol_count() == ix.module->get_symbol_storage().size());
+  }
+}